@@ -0,0 +1,47 @@
+def _nan_boxed_value_transition_impl(settings, attr):
+    _ignore = (settings, attr)
+
+    return {
+        "@valdi//bzl/runtime_flags:enable_nan_boxed_value": True,
+    }
+
+# Rebuilds the test and all its dependencies with the NaN-boxed Valdi::Value layout.
+nan_boxed_value_transition = transition(
+    implementation = _nan_boxed_value_transition_impl,
+    inputs = [],
+    outputs = [
+        "@valdi//bzl/runtime_flags:enable_nan_boxed_value",
+    ],
+)
+
+def _nan_boxed_value_test_impl(ctx):
+    test = ctx.attr.test[0]
+    test_executable = test[DefaultInfo].files_to_run.executable
+
+    executable = ctx.actions.declare_file(ctx.label.name)
+    ctx.actions.symlink(
+        output = executable,
+        target_file = test_executable,
+        is_executable = True,
+    )
+
+    runfiles = ctx.runfiles(files = [test_executable]).merge(test[DefaultInfo].default_runfiles)
+
+    return [DefaultInfo(executable = executable, runfiles = runfiles)]
+
+# Runs the given test with --@valdi//bzl/runtime_flags:enable_nan_boxed_value=true,
+# so that the NaN-boxed layout gets tested without a separate bazel invocation.
+nan_boxed_value_test = rule(
+    implementation = _nan_boxed_value_test_impl,
+    test = True,
+    attrs = {
+        "test": attr.label(
+            mandatory = True,
+            executable = True,
+            cfg = nan_boxed_value_transition,
+        ),
+        "_allowlist_function_transition": attr.label(
+            default = "@bazel_tools//tools/allowlists/function_transition_allowlist",
+        ),
+    },
+)
@@ -396,6 +396,12 @@ void FontManager::registerTypeface(const String& fontFamilyName,
     _typefaceRegistry.registerTypeface(fontFamilyName, fontStyle, canUseAsFallback, loadableTypeface);
     // Clear fallback font family cache, so that we can pickup our new typeface
     _fallbackFontFamilies.clear();
+    _typefacesRevision++;
+}
+
+uint64_t FontManager::getTypefacesRevision() const {
+    std::lock_guard<Valdi::Mutex> guard(_mutex);
+    return _typefacesRevision;
 }
 
 void FontManager::onFontResolveFailed(const String& fontName, const Valdi::Error& error) {
@@ -109,6 +109,12 @@ public:
                           bool canUseAsFallback,
                           const Ref<LoadableTypeface>& loadableTypeface) override;
 
+    /**
+     * Returns a number which changes whenever a typeface is registered, and thus whenever
+     * text might resolve to different fonts.
+     */
+    uint64_t getTypefacesRevision() const;
+
     const Ref<TextShaper>& getTextShaper() const;
 
     const sk_sp<SkFontMgr>& getSkValue();
@@ -129,6 +135,7 @@ private:
     Ref<TextShaper> _textShaper;
     Valdi::StringBox _defaultFontFamilyName;
     Ref<IFontManagerListener> _listener;
+    uint64_t _typefacesRevision = 0;
 
     std::unique_lock<Valdi::Mutex> lock();
     std::unique_lock<Valdi::Mutex> lock(bool shouldInitIfNeeded, bool* didInit);
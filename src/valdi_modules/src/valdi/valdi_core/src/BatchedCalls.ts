@@ -0,0 +1,127 @@
+import { ValdiRuntime } from './ValdiRuntime';
+
+declare const runtime: ValdiRuntime;
+
+// Each call starts with [functionId, parametersCount, valuesMask]
+const CALL_HEADER_SLOTS = 3;
+const MAX_PARAMETERS = 8;
+
+/**
+ * Enqueues calls to native functions into a buffer owned by the runtime, so that
+ * they can be dispatched in a single JS to native crossing when flush() is called.
+ * Number parameters are written directly into the buffer, any other parameter
+ * is passed through an attached values array.
+ *
+ * A single instance is shared by all callers, as the runtime has a single call buffer.
+ * Callers that depend on the side effects of enqueued calls must flush() first.
+ */
+export class BatchedCalls {
+  private callBuffer: Float64Array;
+  private results: Float64Array;
+  private values: any[] = [];
+  private callCount = 0;
+  private position = 0;
+
+  constructor() {
+    this.callBuffer = new Float64Array(runtime.getBatchedCallBuffer());
+    this.results = new Float64Array(runtime.getBatchedCallResultBuffer());
+  }
+
+  /**
+   * Returns the number of calls waiting to be flushed.
+   */
+  size(): number {
+    return this.callCount;
+  }
+
+  /**
+   * Enqueues a call to the function with the given id, as returned by registerBatchedFunction().
+   * Returns the index of the call, at which its result will be available once flushed,
+   * or -1 if the buffer is full, in which case flush() needs to be called first.
+   */
+  enqueue(functionId: number, ...parameters: any[]): number {
+    const parametersCount = parameters.length;
+    if (parametersCount > MAX_PARAMETERS) {
+      throw Error(`Batched calls support up to ${MAX_PARAMETERS} parameters`);
+    }
+
+    const callIndex = this.callCount;
+    const position = this.position;
+    const callBuffer = this.callBuffer;
+    if (callIndex >= this.results.length || position + CALL_HEADER_SLOTS + parametersCount > callBuffer.length) {
+      return -1;
+    }
+
+    let valuesMask = 0;
+    let current = position + CALL_HEADER_SLOTS;
+    for (let i = 0; i < parametersCount; i++) {
+      const parameter = parameters[i];
+      if (typeof parameter === 'number') {
+        callBuffer[current++] = parameter;
+      } else {
+        const values = this.values;
+        valuesMask |= 1 << i;
+        callBuffer[current++] = values.length;
+        values.push(parameter);
+      }
+    }
+
+    callBuffer[position] = functionId;
+    callBuffer[position + 1] = parametersCount;
+    callBuffer[position + 2] = valuesMask;
+
+    this.position = current;
+    this.callCount = callIndex + 1;
+
+    return callIndex;
+  }
+
+  /**
+   * Dispatches all the enqueued calls and returns their results, indexed by call index.
+   * Results which are not numbers or booleans are NaN. The returned array is only valid
+   * until the next flush.
+   */
+  flush(): Float64Array {
+    const callCount = this.callCount;
+    if (callCount) {
+      const values = this.values;
+      this.callCount = 0;
+      this.position = 0;
+      this.values = [];
+
+      runtime.submitBatchedCalls(callCount, values.length ? values : undefined);
+    }
+
+    return this.results;
+  }
+}
+
+let batchedCalls: BatchedCalls | undefined;
+
+/**
+ * Registers the given function so that it can be enqueued into the BatchedCalls instance.
+ * Returns undefined if the function cannot be batched, in which case it should be called directly.
+ */
+export function registerBatchedFunction(fn: (...parameters: any[]) => any): number | undefined {
+  return runtime.registerBatchedFunction(fn);
+}
+
+/**
+ * Returns the BatchedCalls instance, in which the functions registered with
+ * registerBatchedFunction() can be enqueued.
+ */
+export function getBatchedCalls(): BatchedCalls {
+  if (!batchedCalls) {
+    batchedCalls = new BatchedCalls();
+  }
+  return batchedCalls;
+}
+
+/**
+ * Dispatches the pending batched calls, if any.
+ */
+export function flushBatchedCalls(): void {
+  if (batchedCalls && batchedCalls.size()) {
+    batchedCalls.flush();
+  }
+}
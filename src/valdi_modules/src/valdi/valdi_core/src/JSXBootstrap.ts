@@ -26,7 +26,7 @@ import {
 } from './debugging/DaemonClientManager';
 import { DaemonClientMessageType, DumpHeapRequest, Messages } from './debugging/Messages';
 import { toError } from './utils/ErrorUtils';
-import { PropertyList, removeProperty } from './utils/PropertyList';
+import { enumeratePropertyList, PropertyList, removeProperty } from './utils/PropertyList';
 
 /**
  * TypeScript to Native interactions
@@ -67,7 +67,7 @@ class JSXModule implements IDaemonClientManagerListener, RendererFactory {
     }
 
     this.stringCache = new StringCache(runtime.internString);
-    this.attributeCache = new StringCache(runtime.getAttributeId);
+    this.attributeCache = new StringCache(runtime.getAttributeId, true);
     this.injectedAttributeCache = new StringCache((str: string) => this.attributeCache.get(str.substr(1)));
     this.daemonClientManager = new DaemonClientManager();
 
@@ -260,6 +260,10 @@ class JSXModule implements IDaemonClientManagerListener, RendererFactory {
   // Factory methods
 
   makeNodePrototype(className: string, attributes?: PropertyList): NodePrototype {
+    if (attributes) {
+      this.prefetchAttributeIds(attributes);
+    }
+
     if (className === 'custom-view') {
       let androidClass: string | undefined;
       let iosClass: string | undefined;
@@ -294,6 +298,16 @@ class JSXModule implements IDaemonClientManagerListener, RendererFactory {
     return new NodePrototype(className, viewClass, attributes);
   }
 
+  // Resolves the ids of the static attributes of a prototype in a single native call,
+  // instead of one call per attribute when they are first rendered.
+  private prefetchAttributeIds(attributes: PropertyList) {
+    const attributeNames: string[] = [];
+    enumeratePropertyList(attributes, name => {
+      attributeNames.push(name[0] === '$' ? name.substr(1) : name);
+    });
+    this.attributeCache.prefetch(attributeNames);
+  }
+
   makeComponentPrototype(attributes?: PropertyList) {
     return ComponentPrototype.instanceWithNewId(attributes);
   }
@@ -33,10 +33,53 @@ const enum RenderRequestEntryType {
   END_ANIMATIONS = 15,
   ON_LAYOUT_COMPLETE = 16,
   CANCEL_ANIMATION = 17,
+  SET_ATTRIBUTE_INTERNED_STRING = 18,
 }
 
+// Attribute strings up to this length are sent as interned string ids instead of
+// attached values, as long as the number of interned strings stays under the limit.
+const MAX_INTERNED_ATTRIBUTE_STRING_LENGTH = 32;
+const MAX_INTERNED_STRINGS = 4096;
+
 const bufferPool = [new Buffer(512)];
 
+// Memory owned by the runtime, in which a render request can be written and then
+// parsed in place when submitted. Only one render can use it at a time, the others
+// use a buffer from the pool.
+let transportArrayBuffer: ArrayBuffer | undefined;
+let transportBuffer: Buffer | undefined;
+let transportBufferInUse = false;
+
+function acquireRenderBuffer(): Buffer {
+  if (!transportBufferInUse) {
+    if (!transportBuffer) {
+      transportArrayBuffer = runtime.getRenderRequestTransportBuffer();
+      if (transportArrayBuffer) {
+        transportBuffer = new Buffer(transportArrayBuffer);
+      }
+    }
+
+    if (transportBuffer) {
+      transportBufferInUse = true;
+      return transportBuffer;
+    }
+  }
+
+  return bufferPool.pop() || new Buffer(512);
+}
+
+function releaseRenderBuffer(buffer: Buffer) {
+  if (buffer === transportBuffer) {
+    transportBufferInUse = false;
+    if (buffer.inner() === transportArrayBuffer) {
+      return;
+    }
+    // The render outgrew the transport buffer, the grown buffer joins the pool
+    transportBuffer = new Buffer(transportArrayBuffer!);
+  }
+  bufferPool.push(buffer);
+}
+
 export class JSXRendererDelegate implements IRendererDelegate {
   private treeId: string;
   private destroyed: boolean;
@@ -180,8 +223,30 @@ export class JSXRendererDelegate implements IRendererDelegate {
     buffer.putFloat64(value);
   }
 
-  onElementAttributeChangeString(id: number, attributeName: string, value: string): void {
-    const attributeNameParam = this.attributeCache.get(attributeName);
+  private getInternedStringId(value: string): number | undefined {
+    const stringCache = this.stringCache;
+    const stringId = stringCache.find(value);
+    if (stringId !== undefined) {
+      return stringId;
+    }
+
+    if (value.length > MAX_INTERNED_ATTRIBUTE_STRING_LENGTH || stringCache.size() >= MAX_INTERNED_STRINGS) {
+      return undefined;
+    }
+
+    return stringCache.get(value);
+  }
+
+  private putAttributeString(id: number, attributeNameParam: number, value: string) {
+    const stringId = this.getInternedStringId(value);
+    if (stringId !== undefined) {
+      this.buffer.putUint32_3(
+        RenderRequestEntryType.SET_ATTRIBUTE_INTERNED_STRING | (id << 8),
+        attributeNameParam,
+        stringId,
+      );
+      return;
+    }
 
     let index = this.attachedValueIndexByString[value];
     if (!index) {
@@ -194,6 +259,10 @@ export class JSXRendererDelegate implements IRendererDelegate {
     this.buffer.putUint32_3(RenderRequestEntryType.SET_ATTRIBUTE_ATTACHED_VALUE | (id << 8), attributeNameParam, index);
   }
 
+  onElementAttributeChangeString(id: number, attributeName: string, value: string): void {
+    this.putAttributeString(id, this.attributeCache.get(attributeName), value);
+  }
+
   onElementAttributeChangeTrue(id: number, attributeName: string): void {
     const attributeNameParam = this.attributeCache.get(attributeName);
     this.buffer.putUint32_2(RenderRequestEntryType.SET_ATTRIBUTE_TRUE | (id << 8), attributeNameParam);
@@ -253,6 +322,8 @@ export class JSXRendererDelegate implements IRendererDelegate {
     } else if (typeof attributeValue === 'number') {
       buffer.putUint32_2(RenderRequestEntryType.SET_ATTRIBUTE_DOUBLE | (id << 8), attributeNameParam);
       buffer.putFloat64(attributeValue);
+    } else if (typeof attributeValue === 'string') {
+      this.putAttributeString(id, attributeNameParam, attributeValue);
     } else if (Array.isArray(attributeValue)) {
       buffer.putUint32_3(
         RenderRequestEntryType.SET_ATTRIBUTE_ARRAY | (id << 8),
@@ -287,7 +358,7 @@ export class JSXRendererDelegate implements IRendererDelegate {
 
   onRenderStart(): void {
     this.renderStartTime = new Date().getTime();
-    this.buffer = this.getRenderBuffer();
+    this.buffer = acquireRenderBuffer();
   }
 
   onRenderEnd(): void {
@@ -296,7 +367,7 @@ export class JSXRendererDelegate implements IRendererDelegate {
 
     if (this.destroyed || (this.buffer.empty() && !visibilityObserver && !frameObserver)) {
       this.buffer.rewind();
-      this.releaseRenderBuffer(this.buffer);
+      releaseRenderBuffer(this.buffer);
       return;
     }
 
@@ -320,6 +391,23 @@ export class JSXRendererDelegate implements IRendererDelegate {
     // this.buffer may change in submitRawRenderRequest() if it re-enters JS code
     const buffer = this.buffer;
 
+    if (descriptor === transportArrayBuffer) {
+      // Fast path: the descriptor is parsed in place, and only the non primitive
+      // values need to be marshalled.
+      try {
+        runtime.submitRenderRequestFromTransportBuffer(
+          this.treeId,
+          descriptorSize,
+          values.length ? values : undefined,
+          visibilityObserver,
+          frameObserver,
+        );
+      } finally {
+        releaseRenderBuffer(buffer);
+      }
+      return;
+    }
+
     runtime.submitRawRenderRequest(
       {
         treeId: this.treeId,
@@ -330,7 +418,7 @@ export class JSXRendererDelegate implements IRendererDelegate {
         frameObserver,
       },
       () => {
-        this.releaseRenderBuffer(buffer);
+        releaseRenderBuffer(buffer);
         // const renderDuration = new Date().getTime() - renderStartTime;
         // console.log(
         //   `Completed render in ${renderEndTime -
@@ -342,14 +430,6 @@ export class JSXRendererDelegate implements IRendererDelegate {
     );
   }
 
-  private getRenderBuffer(): Buffer {
-    return bufferPool.pop() || new Buffer(512);
-  }
-
-  private releaseRenderBuffer(buffer: Buffer) {
-    bufferPool.push(buffer);
-  }
-
   registerVisibilityObserver(observer: VisibilityObserver) {
     this.pendingVisibilityObserver = (
       appearingElements,
@@ -1,14 +1,25 @@
 import { StringMap } from 'coreutils/src/StringMap';
+import { getBatchedCalls, registerBatchedFunction } from './BatchedCalls';
 
 export type StringInterner = (str: string) => number;
 
 export class StringCache {
   private interner: StringInterner;
+  private batchedInternerId: number | undefined;
   private cache: StringMap<number>;
+  private count = 0;
 
-  constructor(interner: StringInterner) {
+  /**
+   * @param interner The function used to intern a string.
+   * @param batchable Whether the interner can be called through batched calls,
+   * which are used by prefetch() to intern multiple strings at once.
+   */
+  constructor(interner: StringInterner, batchable?: boolean) {
     this.interner = interner;
     this.cache = {};
+    if (batchable) {
+      this.batchedInternerId = registerBatchedFunction(interner);
+    }
   }
 
   get(str: string): number {
@@ -19,7 +30,80 @@ export class StringCache {
 
     id = this.interner(str);
     this.cache[str] = id;
+    this.count++;
 
     return id;
   }
+
+  /**
+   * Returns the id of the given string if it was already interned.
+   */
+  find(str: string): number | undefined {
+    return this.cache[str];
+  }
+
+  /**
+   * Interns the given strings which are not cached yet, using a single
+   * native call when the interner is batchable.
+   */
+  prefetch(strs: readonly string[]): void {
+    const batchedInternerId = this.batchedInternerId;
+    if (batchedInternerId === undefined) {
+      return;
+    }
+
+    const cache = this.cache;
+    const batchedCalls = getBatchedCalls();
+    let pendingStrings: string[] | undefined;
+    let pendingCallIndexes: number[] | undefined;
+
+    for (const str of strs) {
+      if (cache[str] !== undefined) {
+        continue;
+      }
+
+      let callIndex = batchedCalls.enqueue(batchedInternerId, str);
+      if (callIndex < 0) {
+        this.onPrefetched(pendingStrings, pendingCallIndexes, batchedCalls.flush());
+        pendingStrings = undefined;
+        pendingCallIndexes = undefined;
+        callIndex = batchedCalls.enqueue(batchedInternerId, str);
+      }
+
+      if (!pendingStrings || !pendingCallIndexes) {
+        pendingStrings = [];
+        pendingCallIndexes = [];
+      }
+      pendingStrings.push(str);
+      pendingCallIndexes.push(callIndex);
+    }
+
+    if (pendingStrings) {
+      this.onPrefetched(pendingStrings, pendingCallIndexes, batchedCalls.flush());
+    }
+  }
+
+  private onPrefetched(
+    strs: string[] | undefined,
+    callIndexes: number[] | undefined,
+    results: ArrayLike<number>,
+  ): void {
+    if (!strs || !callIndexes) {
+      return;
+    }
+
+    const cache = this.cache;
+    for (let i = 0; i < strs.length; i++) {
+      const str = strs[i];
+      // The same string might have been enqueued more than once
+      if (cache[str] === undefined) {
+        cache[str] = results[callIndexes[i]];
+        this.count++;
+      }
+    }
+  }
+
+  size(): number {
+    return this.count;
+  }
 }
@@ -5,7 +5,7 @@ import { NativeView } from 'valdi_tsx/src/NativeView';
 import { Asset, PlatformAssetOverrides } from './Asset';
 import { ElementId } from './IRenderedElement';
 import { IRootComponentsManager } from './IRootComponentsManager';
-import { RenderRequest } from './RenderRequest';
+import { NativeFrameObserver, NativeVisibilityObserver, RenderRequest } from './RenderRequest';
 import { SubmitDebugMessageFunc } from './debugging/DebugMessage';
 import { AnyFunction } from './utils/Callback';
 import { PropertyList } from './utils/PropertyList';
@@ -34,15 +34,58 @@ interface MessageEvent<T = unknown> {
 
 export type OnMessageFunc<T> = (msg: MessageEvent<T>) => void;
 
+/**
+ * ArrayBuffers to move to the receiving runtime instead of copying them.
+ * Typed arrays move the whole ArrayBuffer they are backed by.
+ */
+export type WorkerTransferList = (ArrayBuffer | ArrayBufferView)[];
+
 export interface NativeWorker {
-  postMessage<T>(data: T): void;
+  postMessage<T>(data: T, transfer?: WorkerTransferList): void;
   setOnMessage<T>(f: OnMessageFunc<T>): void;
   terminate(): void;
 }
 
+export interface NativeWorkerPool {
+  submit<T, R>(data: T, transfer: WorkerTransferList | undefined, completion: (error: any, result?: R) => void): void;
+  getSize(): number;
+  terminate(): void;
+}
+
 export interface RuntimeMemoryStatistics {
   memoryUsageBytes: number;
   objectsCount: number;
+  /**
+   * Number of native value arena chunks kept alive by values which outlived
+   * the render pass or JS call that allocated them.
+   */
+  valueArenaPinnedChunksCount: number;
+  valueArenaPinnedBytes: number;
+}
+
+export interface RuntimeQueueLatencyStatistics {
+  count: number;
+  meanUs: number;
+  p50Us: number;
+  p90Us: number;
+  p99Us: number;
+  maxUs: number;
+}
+
+export interface RuntimeQueueStatistics {
+  name: string;
+  /**
+   * Highest number of tasks that were ready to run at the same time.
+   */
+  maxDepth: number;
+  /**
+   * Time between when tasks were due and when they started running.
+   */
+  waitTime: RuntimeQueueLatencyStatistics;
+  /**
+   * Time spent running the tasks.
+   */
+  runTime: RuntimeQueueLatencyStatistics;
 }
 
 export const enum ExceptionHandlerResult {
@@ -110,9 +153,30 @@ export interface ValdiRuntime extends RuntimeBase {
   getLayoutDebugInfo(contextId: string, elementId: ElementId, callback: (layoutInfo: string | undefined) => void): void;
   performSyncWithMainThread(func: () => void): void;
   createWorker(url: string): NativeWorker;
+  /**
+   * Creates a pool of workers running the given script. The size defaults
+   * to the number of cores minus one when omitted.
+   */
+  createWorkerPool(url: string, size?: number): NativeWorkerPool;
 
   // Rendering
   submitRawRenderRequest(renderRequest: RenderRequest, callback: () => void): void;
+  /**
+   * Returns an ArrayBuffer backed by memory owned by the runtime, in which a render request
+   * descriptor can be written and then submitted with submitRenderRequestFromTransportBuffer().
+   */
+  getRenderRequestTransportBuffer(): ArrayBuffer | undefined;
+  /**
+   * Submits the render request whose descriptor was written at the start of the transport buffer.
+   * The descriptor is parsed synchronously, the buffer can be reused as soon as this call returns.
+   */
+  submitRenderRequestFromTransportBuffer(
+    treeId: string,
+    descriptorSize: number,
+    values: any[] | undefined,
+    visibilityObserver: NativeVisibilityObserver | undefined,
+    frameObserver: NativeFrameObserver | undefined,
+  ): void;
 
   createContext(manager?: IRootComponentsManager): string;
   destroyContext(contextId: string): void;
@@ -133,6 +197,27 @@ export interface ValdiRuntime extends RuntimeBase {
   internString(str: string): number;
   getAttributeId(attributeName: string): number;
 
+  /**
+   * Registers a native function so that calls to it can be enqueued in the batched call buffer.
+   * Returns the id of the function, or undefined if the function is not implemented natively.
+   */
+  registerBatchedFunction(fn: (...parameters: any[]) => any): number | undefined;
+  /**
+   * Returns an ArrayBuffer backed by memory owned by the runtime, in which calls to registered
+   * functions are written as float64 slots: [functionId, parametersCount, valuesMask, ...parameters].
+   */
+  getBatchedCallBuffer(): ArrayBuffer;
+  /**
+   * Returns an ArrayBuffer in which the result of each dispatched call is written as a float64,
+   * at the index of the call.
+   */
+  getBatchedCallResultBuffer(): ArrayBuffer;
+  /**
+   * Dispatches the given number of calls from the batched call buffer in a single native call.
+   * Parameters flagged in the valuesMask of a call are resolved from the given values array.
+   */
+  submitBatchedCalls(callCount: number, values: any[] | undefined): void;
+
   protectNativeRefs(contextId: string | number): () => void;
 
   getBackendRenderingTypeForContextId(contextId: string | number): BackendRenderingType;
@@ -153,6 +238,11 @@ export interface ValdiRuntime extends RuntimeBase {
 
   startTraceRecording(): number;
   stopTraceRecording(id: number): any[];
+  /**
+   * Stops the given trace recording and returns the captured traces as a Chrome trace
+   * event JSON document, which can be opened in Perfetto or chrome://tracing.
+   */
+  stopTraceRecordingAsChromeTrace(id: number): ArrayBuffer;
 
   submitDebugMessage: SubmitDebugMessageFunc;
 
@@ -202,11 +292,22 @@ export interface ValdiRuntime extends RuntimeBase {
   ): void;
 
   dumpMemoryStatistics(): RuntimeMemoryStatistics;
+  /**
+   * Returns the statistics of the instrumented dispatch queues.
+   * Queues are only instrumented when the VALDI_ENABLE_QUEUE_INSTRUMENTATION tweak is set.
+   */
+  dumpQueueStatistics(): RuntimeQueueStatistics[];
 
   performGC(): void;
 
   dumpHeap?(): ArrayBuffer;
 
+  /**
+   * Streams a heap dump into a file with the given name inside the disk cache,
+   * without holding the dump in memory, and returns the absolute path of the file.
+   */
+  dumpHeapToDiskCache?(fileName: string): string;
+
   isDebugEnabled: boolean;
 
   buildType: string;
@@ -6,8 +6,13 @@ export class Buffer {
   private array: DataView;
   private pos: number;
 
-  constructor(initialCapacity: number) {
-    const buffer = new ArrayBuffer(initialCapacity);
+  /**
+   * When given an ArrayBuffer, the Buffer writes into it
+   * until it needs to grow past its size.
+   */
+  constructor(initialCapacityOrBuffer: number | ArrayBuffer) {
+    const buffer =
+      typeof initialCapacityOrBuffer === 'number' ? new ArrayBuffer(initialCapacityOrBuffer) : initialCapacityOrBuffer;
     this.array = new DataView(buffer);
     this.pos = 0;
   }
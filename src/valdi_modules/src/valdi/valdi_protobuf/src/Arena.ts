@@ -1,3 +1,4 @@
+import { flushBatchedCalls, getBatchedCalls, registerBatchedFunction } from 'valdi_core/src/BatchedCalls';
 import { makeSingleCallInterruptibleCallback } from 'valdi_core/src/utils/FunctionUtils';
 import { getProtobufModule } from './ValdiProtobufModule';
 import { IArena, IMessage, IMessageConstructor, JSONPrintOptions } from './types';
@@ -51,9 +52,22 @@ export const enum EncodingMode {
   INCLUDE_ALL_FIELDS = 1,
 }
 
+// The protobuf module for which batchedSetMessageFieldId was resolved
+let batchedProtobufModule: ValdiProtobufModule | undefined;
+let batchedSetMessageFieldId: number | undefined;
+
+function getBatchedSetMessageFieldId(protobuf: ValdiProtobufModule): number | undefined {
+  if (batchedProtobufModule !== protobuf) {
+    batchedProtobufModule = protobuf;
+    batchedSetMessageFieldId = registerBatchedFunction(protobuf.setMessageField);
+  }
+  return batchedSetMessageFieldId;
+}
+
 export class Arena implements IArena {
   private protobuf: ValdiProtobufModule;
   private $native: INativeMessageArena;
+  private batchedUpdatesDepth = 0;
 
   constructor(decodingMode?: DecodingMode, encodingMode?: EncodingMode) {
     this.protobuf = getProtobufModule();
@@ -118,10 +132,12 @@ export class Arena implements IArena {
   }
 
   encodeMessage(message: IMessage): Uint8Array {
+    flushBatchedCalls();
     return this.protobuf.encodeMessage(this.$native, message.$index);
   }
 
   encodeMessageAsync(message: IMessage<any>): Promise<Uint8Array> {
+    flushBatchedCalls();
     return new Promise((resolve, reject) => {
       this.protobuf.encodeMessageAsync(
         this.$native,
@@ -138,6 +154,7 @@ export class Arena implements IArena {
   }
 
   batchEncodeMessageAsync(messages: readonly IMessage<any>[]): Promise<Uint8Array[]> {
+    flushBatchedCalls();
     const messageIndexes = messages.map(fn => fn.$index);
     return new Promise((resolve, reject) => {
       this.protobuf.batchEncodeMessageAsync(
@@ -155,22 +172,53 @@ export class Arena implements IArena {
   }
 
   encodeMessageToJSON(message: IMessage<any>, printOptions: JSONPrintOptions | undefined): string {
+    flushBatchedCalls();
     return this.protobuf.encodeMessageToJSON(this.$native, message.$index, printOptions ?? 0);
   }
 
   getMessageFields(message: IMessage): any[] {
+    flushBatchedCalls();
     return this.protobuf.getMessageFields(this.$native, message.$index);
   }
 
   setMessageField(message: IMessage, fieldIndex: number, totalFieldsLength: number, fieldValue: any): void {
+    if (this.batchedUpdatesDepth) {
+      const functionId = getBatchedSetMessageFieldId(this.protobuf);
+      if (functionId !== undefined) {
+        const batchedCalls = getBatchedCalls();
+        if (batchedCalls.enqueue(functionId, this.$native, message.$index, fieldIndex, fieldValue) < 0) {
+          batchedCalls.flush();
+          batchedCalls.enqueue(functionId, this.$native, message.$index, fieldIndex, fieldValue);
+        }
+        return;
+      }
+    }
+
     this.protobuf.setMessageField(this.$native, message.$index, fieldIndex, fieldValue);
   }
 
+  /**
+   * Starts batching the field updates made on the messages of this Arena, so that
+   * they are applied in a single native call when endBatchedUpdates() is called.
+   * Calls can be nested, updates are applied when the outermost batch ends.
+   */
+  beginBatchedUpdates(): void {
+    this.batchedUpdatesDepth++;
+  }
+
+  endBatchedUpdates(): void {
+    this.batchedUpdatesDepth--;
+    if (!this.batchedUpdatesDepth) {
+      flushBatchedCalls();
+    }
+  }
+
   getMessageInstance(constructor: IMessageConstructor, messageIndex: INativeMessageIndex): IMessage {
     return new constructor(this, messageIndex);
   }
 
   copyMessage(message: IMessage): IMessage {
+    flushBatchedCalls();
     const otherArena = message.$arena;
     if (!(otherArena instanceof Arena)) {
       throw Error('Can only copy messages from an Arena instance');
@@ -1,4 +1,5 @@
 import { StringMap } from 'coreutils/src/StringMap';
+import { Arena } from './Arena';
 import { makeMessageFields } from './FieldFactory';
 import { Message } from './Message';
 import { IArena, IDescriptor, IDescriptorPool, IMessage, IMessageConstructor } from './types';
@@ -26,12 +27,24 @@ export default class Descriptor implements IDescriptor {
   ) {}
 
   setProperties(arena: IArena, message: IMessage, properties: StringMap<any>) {
-    for (const field of this.fields) {
-      const value = properties[field.name];
-      if (value) {
-        (message as any)[field.name] = value;
+    // Fields are set through a single native call when the arena supports it
+    const batchingArena = arena instanceof Arena ? arena : undefined;
+    batchingArena?.beginBatchedUpdates();
+    try {
+      for (const field of this.fields) {
+        const value = properties[field.name];
+        if (value) {
+          (message as any)[field.name] = value;
+        }
       }
+    } catch (error) {
+      // Applying the updates enqueued so far can fail as well, the original error is the one to report
+      try {
+        batchingArena?.endBatchedUpdates();
+      } catch {}
+      throw error;
     }
+    batchingArena?.endBatchedUpdates();
   }
 
   getConstructor(): IMessageConstructor {
@@ -108,6 +108,30 @@ class Runtime {
     console.log("submitRawRenderRequest", renderRequest);
   }
 
+  getRenderRequestTransportBuffer() {
+    return undefined;
+  }
+
+  submitRenderRequestFromTransportBuffer(treeId, descriptorSize, values, visibilityObserver, frameObserver) {
+    console.log("submitRenderRequestFromTransportBuffer", treeId, descriptorSize, values);
+  }
+
+  registerBatchedFunction(fn) {
+    return undefined;
+  }
+
+  getBatchedCallBuffer() {
+    return new ArrayBuffer(0);
+  }
+
+  getBatchedCallResultBuffer() {
+    return new ArrayBuffer(0);
+  }
+
+  submitBatchedCalls(callCount, values) {
+    console.log("submitBatchedCalls", callCount, values);
+  }
+
   createContext(manager) {
     console.log("createContext", manager);
     return "contextId";
@@ -196,6 +220,18 @@ class Runtime {
     };
   }
 
+  createWorkerPool(url, size) {
+    return {
+      submit(data, transfer, completion) {
+        completion(new Error('Worker pools are not supported on web'));
+      },
+      getSize() {
+        return 0;
+      },
+      terminate() {},
+    };
+  }
+
   destroyContext(contextId) {}
 
   measureContext(contextId, maxWidth, widthMode, maxHeight, heightMode, rtl) {
@@ -1,4 +1,4 @@
-import { ValdiRuntime, NativeWorker, OnMessageFunc } from 'valdi_core/src/ValdiRuntime';
+import { ValdiRuntime, NativeWorker, OnMessageFunc, WorkerTransferList } from 'valdi_core/src/ValdiRuntime';
 
 declare const runtime: ValdiRuntime;
 
@@ -19,9 +19,14 @@ export class Worker {
     }
   }
 
-  public postMessage<T>(data: T): void {
+  /**
+   * Sends the given data to the worker. The data is cloned, except for the
+   * ArrayBuffers given in the transfer list which are moved to the worker and
+   * become unusable on this side.
+   */
+  public postMessage<T>(data: T, transfer?: WorkerTransferList): void {
     if (this.nativeWorker) {
-      this.nativeWorker.postMessage(data);
+      this.nativeWorker.postMessage(data, transfer);
     }
   }
 
@@ -0,0 +1,61 @@
+import { ValdiRuntime, NativeWorkerPool, WorkerTransferList } from 'valdi_core/src/ValdiRuntime';
+
+declare const runtime: ValdiRuntime;
+
+/**
+ * A fixed set of workers running the same script, to which tasks can be submitted.
+ * Each task is handed over to the next idle worker, which runs it by calling
+ * the onmessage function of the script with the task as data. The value returned
+ * by onmessage, or the value it resolves to, is the result of the task.
+ * The workers share the compiled modules of the script, so that adding workers
+ * to the pool does not add to the loading time of each of them.
+ */
+export class WorkerPool {
+  private nativeWorkerPool: NativeWorkerPool | null;
+
+  /**
+   * Creates a pool of the given size, which defaults to the number of
+   * cores minus one.
+   */
+  public constructor(url: string, size?: number) {
+    this.nativeWorkerPool = runtime.createWorkerPool(url, size);
+  }
+
+  public get size(): number {
+    return this.nativeWorkerPool ? this.nativeWorkerPool.getSize() : 0;
+  }
+
+  /**
+   * Runs the given task on the next idle worker, and returns a promise resolving
+   * with its result. The data is cloned, except for the ArrayBuffers given in the
+   * transfer list which are moved to the worker.
+   */
+  public submit<T, R>(data: T, transfer?: WorkerTransferList): Promise<R> {
+    const nativeWorkerPool = this.nativeWorkerPool;
+    if (!nativeWorkerPool) {
+      return Promise.reject(new Error('Worker pool was terminated'));
+    }
+
+    return new Promise<R>((resolve, reject) => {
+      nativeWorkerPool.submit<T, R>(data, transfer, (error, result) => {
+        if (error) {
+          reject(error);
+        } else {
+          resolve(result as R);
+        }
+      });
+    });
+  }
+
+  /**
+   * Terminates the workers, the tasks which did not complete yet are rejected.
+   */
+  public terminate(): void {
+    if (this.nativeWorkerPool) {
+      this.nativeWorkerPool.terminate();
+      this.nativeWorkerPool = null;
+    }
+  }
+}
+
+export default WorkerPool;
@@ -1,5 +1,6 @@
 import 'jasmine/src/jasmine';
 import { Worker, inWorker } from 'worker/src/Worker';
+import { WorkerPool } from 'worker/src/WorkerPool';
 
 function timeout(ms: number): Promise<void> {
   // eslint-disable-next-line @snap/valdi/assign-timer-id
@@ -47,4 +48,38 @@ describe('worker', () => {
     });
     expect(await pong).toEqual(echoValue);
   }, 100);
+
+  it('transfers ArrayBuffers', async () => {
+    const worker = new Worker('worker/test_workers/TransferWorker');
+    const bytes = new Uint8Array([1, 2, 3, 4]);
+    const echo = new Promise<{ label: string; bytes: Uint8Array }>(resolve => {
+      worker.onmessage = e => {
+        resolve(e.data as { label: string; bytes: Uint8Array });
+      };
+      worker.postMessage({ label: 'bytes', bytes }, [bytes.buffer]);
+    });
+    // The buffer was moved to the worker
+    expect(bytes.byteLength).toEqual(0);
+
+    const answer = await echo;
+    expect(answer.label).toEqual('bytes');
+    expect(Array.from(answer.bytes)).toEqual([1, 2, 3, 4]);
+  }, 1000);
+
+  it('runs tasks on a worker pool', async () => {
+    const pool = new WorkerPool('worker/test_workers/PoolWorker', 2);
+    expect(pool.size).toEqual(2);
+
+    const results = await Promise.all([
+      pool.submit<{ value: number }, number>({ value: 1 }),
+      pool.submit<{ value: number; delay: number }, number>({ value: 2, delay: 10 }),
+      pool.submit<{ value: number }, number>({ value: 3 }),
+    ]);
+    expect(results).toEqual([2, 4, 6]);
+
+    await expectAsync(pool.submit({ value: 4, fail: true })).toBeRejected();
+
+    pool.terminate();
+    await expectAsync(pool.submit({ value: 5 })).toBeRejected();
+  }, 1000);
 });
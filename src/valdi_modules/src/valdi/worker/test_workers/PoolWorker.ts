@@ -0,0 +1,11 @@
+onmessage = e => {
+  const data = e.data as { value: number; delay?: number; fail?: boolean };
+  if (data.fail) {
+    throw new Error('task failed');
+  }
+  if (data.delay) {
+    // eslint-disable-next-line @snap/valdi/assign-timer-id
+    return new Promise(resolve => setTimeout(() => resolve(data.value * 2), data.delay));
+  }
+  return data.value * 2;
+};
@@ -0,0 +1,5 @@
+onmessage = e => {
+  const data = e.data as { label: string; bytes: Uint8Array };
+  postMessage(data, { transfer: [data.bytes.buffer] });
+  close();
+};
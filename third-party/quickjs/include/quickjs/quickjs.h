@@ -866,6 +866,9 @@ uint8_t* JS_WriteObject2(
 #define JS_READ_OBJ_SAB (1 << 2)       /* allow SharedArrayBuffer */
 #define JS_READ_OBJ_REFERENCE (1 << 3) /* allow object references */
 JSValue JS_ReadObject(JSContext* ctx, const uint8_t* buf, size_t buf_len, int flags);
+/* version of the bytecode produced by JS_WriteObject(), bytecode
+   written with a different version cannot be read back */
+int JS_GetBytecodeVersion(void);
 /* instantiate and evaluate a bytecode function. Only used when
    reading a script or module with JS_ReadObject() */
 JSValue JS_EvalFunction(JSContext* ctx, JSValue fun_obj);
@@ -34695,6 +34695,10 @@ JSValue JS_ReadObject(JSContext* ctx, const uint8_t* buf, size_t buf_len, int fl
     return obj;
 }
 
+int JS_GetBytecodeVersion(void) {
+    return BC_VERSION;
+}
+
 /*******************************************************************/
 /* runtime functions & objects */
 
@@ -0,0 +1,107 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi/quickjs/QuickJSBytecodeCache.hpp"
+
+#include "valdi/runtime/Utils/BytesUtils.hpp"
+#include "valdi_core/cpp/Constants.hpp"
+#include "valdi_core/cpp/Utils/ByteBuffer.hpp"
+
+#include <cstring>
+
+namespace ValdiQuickJS {
+
+static constexpr uint32_t kEntryMagic = 0x32424A51; // QJB2
+// Size of a SHA-256 digest
+static constexpr size_t kHashSize = 32;
+
+struct QuickJSBytecodeCacheEntryHeader {
+    uint32_t magic;
+    uint32_t bytecodeVersion;
+    // QuickJS can change without bumping its bytecode version, so entries are also tied to the Valdi build
+    int64_t valdiVersion;
+    uint64_t bytecodeSize;
+    Valdi::Byte sourceHash[kHashSize];
+    // Protects against entries corrupted on disk, which JS_ReadObject() does not detect
+    Valdi::Byte bytecodeHash[kHashSize];
+};
+
+static Valdi::Path getEntryPath(const std::string_view& sourceFilename) {
+    return Valdi::Path(Valdi::BytesUtils::sha256String(reinterpret_cast<const Valdi::Byte*>(sourceFilename.data()),
+                                                       sourceFilename.size()));
+}
+
+QuickJSBytecodeCache::QuickJSBytecodeCache(const Valdi::Ref<Valdi::IDiskCache>& diskCache, uint32_t bytecodeVersion)
+    : _diskCache(diskCache), _bytecodeVersion(bytecodeVersion) {}
+
+QuickJSBytecodeCache::~QuickJSBytecodeCache() = default;
+
+Valdi::BytesView QuickJSBytecodeCache::hashSource(const std::string_view& source) {
+    return Valdi::BytesUtils::sha256(reinterpret_cast<const Valdi::Byte*>(source.data()), source.size())->toBytesView();
+}
+
+std::optional<Valdi::BytesView> QuickJSBytecodeCache::load(const std::string_view& sourceFilename,
+                                                           const Valdi::BytesView& sourceHash) {
+    if (sourceHash.size() != kHashSize) {
+        return std::nullopt;
+    }
+
+    auto entryPath = getEntryPath(sourceFilename);
+    if (!_diskCache->exists(entryPath)) {
+        return std::nullopt;
+    }
+
+    auto loadResult = _diskCache->load(entryPath);
+    if (!loadResult) {
+        return std::nullopt;
+    }
+
+    const auto& entry = loadResult.value();
+    if (entry.size() < sizeof(QuickJSBytecodeCacheEntryHeader)) {
+        return std::nullopt;
+    }
+
+    QuickJSBytecodeCacheEntryHeader header;
+    std::memcpy(&header, entry.data(), sizeof(header));
+
+    // The bytecode size also protects against truncated writes
+    if (header.magic != kEntryMagic || header.bytecodeVersion != _bytecodeVersion ||
+        header.valdiVersion != Valdi::valdiVersion || header.bytecodeSize != entry.size() - sizeof(header) ||
+        std::memcmp(header.sourceHash, sourceHash.data(), kHashSize) != 0) {
+        return std::nullopt;
+    }
+
+    auto bytecode = entry.subrange(sizeof(header), static_cast<size_t>(header.bytecodeSize));
+    auto bytecodeHash = Valdi::BytesUtils::sha256(bytecode);
+    if (std::memcmp(header.bytecodeHash, bytecodeHash->data(), kHashSize) != 0) {
+        return std::nullopt;
+    }
+
+    return bytecode;
+}
+
+void QuickJSBytecodeCache::store(const std::string_view& sourceFilename,
+                                 const Valdi::BytesView& sourceHash,
+                                 const Valdi::BytesView& bytecode) {
+    if (sourceHash.size() != kHashSize) {
+        return;
+    }
+
+    QuickJSBytecodeCacheEntryHeader header;
+    header.magic = kEntryMagic;
+    header.bytecodeVersion = _bytecodeVersion;
+    header.valdiVersion = Valdi::valdiVersion;
+    header.bytecodeSize = static_cast<uint64_t>(bytecode.size());
+    std::memcpy(header.sourceHash, sourceHash.data(), kHashSize);
+    std::memcpy(header.bytecodeHash, Valdi::BytesUtils::sha256(bytecode)->data(), kHashSize);
+
+    auto entry = Valdi::makeShared<Valdi::ByteBuffer>();
+    entry->reserve(sizeof(header) + bytecode.size());
+    entry->append(reinterpret_cast<const Valdi::Byte*>(&header),
+                  reinterpret_cast<const Valdi::Byte*>(&header) + sizeof(header));
+    entry->append(bytecode.begin(), bytecode.end());
+
+    // A failed store only means the source will be compiled again next time
+    static_cast<void>(_diskCache->store(getEntryPath(sourceFilename), entry->toBytesView()));
+}
+
+} // namespace ValdiQuickJS
@@ -0,0 +1,43 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "valdi/runtime/Interfaces/IDiskCache.hpp"
+#include "valdi_core/cpp/Utils/Bytes.hpp"
+#include "valdi_core/cpp/Utils/Shared.hpp"
+
+#include <optional>
+#include <string_view>
+
+namespace ValdiQuickJS {
+
+/**
+ Persists the bytecode of the JS sources compiled by the QuickJS context,
+ so that modules which were not precompiled at build time are only parsed
+ once. Entries are keyed by source filename and hold the hash of the source
+ they were compiled from, the QuickJS bytecode version and the Valdi version.
+ An entry is ignored when any of them does not match, or when its bytecode does
+ not match the digest stored alongside it.
+ */
+class QuickJSBytecodeCache : public Valdi::SimpleRefCountable {
+public:
+    QuickJSBytecodeCache(const Valdi::Ref<Valdi::IDiskCache>& diskCache, uint32_t bytecodeVersion);
+    ~QuickJSBytecodeCache() override;
+
+    /**
+     Returns the content hash of the given source, to be passed to load() and store()
+     */
+    static Valdi::BytesView hashSource(const std::string_view& source);
+
+    std::optional<Valdi::BytesView> load(const std::string_view& sourceFilename, const Valdi::BytesView& sourceHash);
+
+    void store(const std::string_view& sourceFilename,
+               const Valdi::BytesView& sourceHash,
+               const Valdi::BytesView& bytecode);
+
+private:
+    Valdi::Ref<Valdi::IDiskCache> _diskCache;
+    uint32_t _bytecodeVersion;
+};
+
+} // namespace ValdiQuickJS
@@ -12,6 +12,7 @@
 #include "valdi/runtime/JavaScript/JavaScriptUtils.hpp"
 #include "valdi_core/cpp/Threading/Thread.hpp"
 
+#include "valdi/quickjs/QuickJSBytecodeCache.hpp"
 #include "valdi/quickjs/QuickJSUtils.hpp"
 #include "valdi_core/cpp/Constants.hpp"
 #include "valdi_core/cpp/Utils/ByteBuffer.hpp"
@@ -270,6 +271,10 @@ bool QuickJSJavaScriptContext::supportsPreCompilation() const {
     return true;
 }
 
+uint32_t QuickJSJavaScriptContext::getPreCompilationVersion() const {
+    return static_cast<uint32_t>(JS_GetBytecodeVersion());
+}
+
 Valdi::BytesView QuickJSJavaScriptContext::preCompile(const std::string_view& script,
                                                       const std::string_view& sourceFilename,
                                                       Valdi::JSExceptionTracker& exceptionTracker) {
@@ -322,11 +327,59 @@ Valdi::JSValueRef QuickJSJavaScriptContext::evaluate(const std::string& script,
                                                      const std::string_view& sourceFilename,
                                                      Valdi::JSExceptionTracker& exceptionTracker) {
     auto guard = _threadAccessChecker.guard();
+    // Anonymous scripts are typically evaluated once, caching them would only grow the cache
+    if (_bytecodeCache != nullptr && !sourceFilename.empty()) {
+        return evaluateWithBytecodeCache(script, sourceFilename, exceptionTracker);
+    }
+
     return checkCallAndGetValue(
         exceptionTracker,
         JS_Eval(_context, reinterpret_cast<const char*>(script.data()), script.size(), sourceFilename.data(), 0));
 }
 
+Valdi::JSValueRef QuickJSJavaScriptContext::evaluateWithBytecodeCache(const std::string& script,
+                                                                      const std::string_view& sourceFilename,
+                                                                      Valdi::JSExceptionTracker& exceptionTracker) {
+    auto sourceHash = QuickJSBytecodeCache::hashSource(script);
+
+    auto cachedBytecode = _bytecodeCache->load(sourceFilename, sourceHash);
+    if (cachedBytecode) {
+        auto function = JS_ReadObject(_context,
+                                      reinterpret_cast<const uint8_t*>(cachedBytecode.value().data()),
+                                      cachedBytecode.value().size(),
+                                      JS_READ_OBJ_BYTECODE);
+        if (!JS_IsException(function)) {
+            return checkCallAndGetValue(exceptionTracker, JS_EvalFunction(_context, function));
+        }
+
+        // The entry could not be read, compile the source again which will replace it
+        JS_FreeValue(_context, JS_GetException(_context));
+    }
+
+    auto function = checkCallAndGetValue(exceptionTracker,
+                                         JS_Eval(_context,
+                                                 reinterpret_cast<const char*>(script.data()),
+                                                 script.size(),
+                                                 sourceFilename.data(),
+                                                 JS_EVAL_FLAG_COMPILE_ONLY));
+    if (!exceptionTracker) {
+        return Valdi::JSValueRef();
+    }
+
+    size_t bytecodeSize = 0;
+    auto* bytecode = JS_WriteObject(_context, &bytecodeSize, fromValdiJSValue(function.get()), JS_WRITE_OBJ_BYTECODE);
+    if (bytecode != nullptr) {
+        _bytecodeCache->store(sourceFilename,
+                              sourceHash,
+                              Valdi::BytesView(nullptr, reinterpret_cast<const Valdi::Byte*>(bytecode), bytecodeSize));
+        js_free(_context, bytecode);
+    }
+
+    auto retainedFunction = JS_DupValue(_context, fromValdiJSValue(function.get()));
+
+    return checkCallAndGetValue(exceptionTracker, JS_EvalFunction(_context, retainedFunction));
+}
+
 Valdi::JSValueRef QuickJSJavaScriptContext::evaluateNative(const std::string_view& sourceFilename,
                                                            Valdi::JSExceptionTracker& exceptionTracker) {
     auto guard = _threadAccessChecker.guard();
@@ -560,6 +613,20 @@ Valdi::JSValueRef QuickJSJavaScriptContext::newArrayBuffer(const Valdi::BytesVie
     }
 }
 
+bool QuickJSJavaScriptContext::detachArrayBuffer(const Valdi::JSValue& arrayBuffer,
+                                                 Valdi::JSExceptionTracker& exceptionTracker) {
+    auto guard = _threadAccessChecker.guard();
+    auto jsValue = fromValdiJSValue(arrayBuffer);
+
+    if (JS_IsArrayBuffer(_context, jsValue) == 0) {
+        checkCallAndGetValue(exceptionTracker, JS_ThrowTypeError(_context, "value is not an ArrayBuffer"));
+        return false;
+    }
+
+    JS_DetachArrayBuffer(_context, jsValue);
+    return true;
+}
+
 Valdi::JSValueRef QuickJSJavaScriptContext::newTypedArrayFromArrayBuffer(const Valdi::TypedArrayType& type,
                                                                          const Valdi::JSValue& arrayBuffer,
                                                                          Valdi::JSExceptionTracker& exceptionTracker) {
@@ -617,6 +684,27 @@ Valdi::JSValueRef QuickJSJavaScriptContext::getObjectProperty(const Valdi::JSVal
         exceptionTracker, JS_GetProperty(_context, fromValdiJSValue(object), fromValdiJSPropertyName(propertyName)));
 }
 
+// The cache is handed over as is to QuickJS, which reads and updates it through JS_PropCache_tsn
+static_assert(sizeof(JS_PropCache_tsn) <= sizeof(Valdi::JSPropertyCache));
+static_assert(offsetof(JS_PropCache_tsn, shape_cookie) == offsetof(Valdi::JSPropertyCache, shapeId));
+static_assert(offsetof(JS_PropCache_tsn, proto_cookie) == offsetof(Valdi::JSPropertyCache, protoShapeId));
+static_assert(offsetof(JS_PropCache_tsn, proto_ptr) == offsetof(Valdi::JSPropertyCache, protoObject));
+static_assert(offsetof(JS_PropCache_tsn, prop_offset) == offsetof(Valdi::JSPropertyCache, slotOffset));
+
+Valdi::JSValueRef QuickJSJavaScriptContext::getObjectPropertyWithCache(const Valdi::JSValue& object,
+                                                                       const Valdi::JSPropertyName& propertyName,
+                                                                       Valdi::JSPropertyCache& propertyCache,
+                                                                       Valdi::JSExceptionTracker& exceptionTracker) {
+    auto guard = _threadAccessChecker.guard();
+    auto jsObject = fromValdiJSValue(object);
+    return checkCallAndGetValue(exceptionTracker,
+                                JS_GetProperty_tsn(_context,
+                                                   jsObject,
+                                                   fromValdiJSPropertyName(propertyName),
+                                                   jsObject,
+                                                   reinterpret_cast<JS_PropCache_tsn*>(&propertyCache)));
+}
+
 Valdi::JSValueRef QuickJSJavaScriptContext::getObjectPropertyForIndex(const Valdi::JSValue& object,
                                                                       size_t index,
                                                                       Valdi::JSExceptionTracker& exceptionTracker) {
@@ -1061,6 +1149,15 @@ Valdi::JavaScriptContextMemoryStatistics QuickJSJavaScriptContext::dumpMemorySta
     return out;
 }
 
+void QuickJSJavaScriptContext::setBytecodeDiskCache(const Valdi::Ref<Valdi::IDiskCache>& diskCache) {
+    if (diskCache == nullptr) {
+        _bytecodeCache = nullptr;
+        return;
+    }
+
+    _bytecodeCache = Valdi::makeShared<QuickJSBytecodeCache>(diskCache, getPreCompilationVersion());
+}
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wunneeded-internal-declaration"
 
@@ -22,6 +22,7 @@ class JavaScriptHeapDumpBuilder;
 
 namespace ValdiQuickJS {
 
+class QuickJSBytecodeCache;
 class QuickJSValue;
 class QuickJSValueGlobalRefManager;
 class WeakReference;
@@ -46,6 +47,7 @@ public:
                                 Valdi::JSExceptionTracker& exceptionTracker) override;
 
     bool supportsPreCompilation() const override;
+    uint32_t getPreCompilationVersion() const override;
 
     Valdi::JSValueRef evaluate(const std::string& script,
                                const std::string_view& sourceFilename,
@@ -79,6 +81,8 @@ public:
     Valdi::JSValueRef newArrayBuffer(const Valdi::BytesView& buffer,
                                      Valdi::JSExceptionTracker& exceptionTracker) override;
 
+    bool detachArrayBuffer(const Valdi::JSValue& arrayBuffer, Valdi::JSExceptionTracker& exceptionTracker) override;
+
     Valdi::JSValueRef newTypedArrayFromArrayBuffer(const Valdi::TypedArrayType& type,
                                                    const Valdi::JSValue& arrayBuffer,
                                                    Valdi::JSExceptionTracker& exceptionTracker) override;
@@ -96,6 +100,11 @@ public:
                                         const Valdi::JSPropertyName& propertyName,
                                         Valdi::JSExceptionTracker& exceptionTracker) override;
 
+    Valdi::JSValueRef getObjectPropertyWithCache(const Valdi::JSValue& object,
+                                                 const Valdi::JSPropertyName& propertyName,
+                                                 Valdi::JSPropertyCache& propertyCache,
+                                                 Valdi::JSExceptionTracker& exceptionTracker) override;
+
     Valdi::JSValueRef getObjectPropertyForIndex(const Valdi::JSValue& object,
                                                 size_t index,
                                                 Valdi::JSExceptionTracker& exceptionTracker) override;
@@ -177,6 +186,8 @@ public:
     void garbageCollect() override;
     Valdi::JavaScriptContextMemoryStatistics dumpMemoryStatistics() override;
 
+    void setBytecodeDiskCache(const Valdi::Ref<Valdi::IDiskCache>& diskCache) override;
+
     void dumpHeap(Valdi::JavaScriptHeapDumpBuilder& heapDumpBuilder);
 
     void enqueueMicrotask(const Valdi::JSValue& value, Valdi::JSExceptionTracker& exceptionTracker) override;
@@ -236,6 +247,7 @@ private:
 
     std::deque<QuickJSRejectedPromise> _rejectedPromises;
     Valdi::FlatMap<size_t, JSValue> _weakReferences;
+    Valdi::Ref<QuickJSBytecodeCache> _bytecodeCache;
 
     size_t associateWeakReference(const JSValue& value, Valdi::JSExceptionTracker& exceptionTracker);
 
@@ -244,6 +256,10 @@ private:
                                        const JSValue& propertyValue,
                                        Valdi::JSExceptionTracker& exceptionTracker);
 
+    Valdi::JSValueRef evaluateWithBytecodeCache(const std::string& script,
+                                                const std::string_view& sourceFilename,
+                                                Valdi::JSExceptionTracker& exceptionTracker);
+
     Valdi::JSValueRef checkCallAndGetValue(Valdi::JSExceptionTracker& exceptionTracker, const JSValue& value);
     bool checkCall(Valdi::JSExceptionTracker& exceptionTracker, int retValue);
     void setExceptionToTracker(Valdi::JSExceptionTracker& exceptionTracker);
@@ -11,6 +11,9 @@
 
 namespace ValdiQuickJS {
 
+// Maximum number of nodes and edges kept in memory when streaming a heap dump
+static constexpr size_t kHeapDumpMaxBufferedEntries = 16384;
+
 QuickJSJavaScriptContextFactory::QuickJSJavaScriptContextFactory() = default;
 
 const char* QuickJSJavaScriptContextFactory::getName() {
@@ -42,4 +45,24 @@ Valdi::BytesView QuickJSJavaScriptContextFactory::dumpHeap(std::span<Valdi::IJav
     }
 }
 
+void QuickJSJavaScriptContextFactory::dumpHeapToOutput(std::span<Valdi::IJavaScriptContext*> jsContexts,
+                                                       const Valdi::Path& spillDirectory,
+                                                       Valdi::JavaScriptHeapDumpOutput& output,
+                                                       Valdi::JSExceptionTracker& exceptionTracker) {
+    if constexpr (Valdi::shouldEnableJsHeapDump()) {
+        Valdi::JavaScriptHeapDumpBuilder heapDumpBuilder(kHeapDumpMaxBufferedEntries, spillDirectory);
+
+        for (auto* jsContext : jsContexts) {
+            dynamic_cast<QuickJSJavaScriptContext*>(jsContext)->dumpHeap(heapDumpBuilder);
+        }
+
+        auto result = heapDumpBuilder.build(output);
+        if (!result) {
+            exceptionTracker.onError(result.moveError());
+        }
+    } else {
+        exceptionTracker.onError("Heap dump support not enabled");
+    }
+}
+
 } // namespace ValdiQuickJS
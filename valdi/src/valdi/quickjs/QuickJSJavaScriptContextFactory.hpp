@@ -25,6 +25,11 @@ public:
 
     Valdi::BytesView dumpHeap(std::span<Valdi::IJavaScriptContext*> jsContexts,
                               Valdi::JSExceptionTracker& exceptionTracker) final;
+
+    void dumpHeapToOutput(std::span<Valdi::IJavaScriptContext*> jsContexts,
+                          const Valdi::Path& spillDirectory,
+                          Valdi::JavaScriptHeapDumpOutput& output,
+                          Valdi::JSExceptionTracker& exceptionTracker) final;
 };
 
 } // namespace ValdiQuickJS
@@ -30,6 +30,17 @@ public:
     AssetMeasureDelegate() = default;
     ~AssetMeasureDelegate() override = default;
 
+    bool canMeasureConcurrently() const override {
+        // Assets measure themselves from their loaded size
+        return true;
+    }
+
+    bool canCacheMeasurement() const override {
+        // The measured size depends on whether the asset is loaded, which can change
+        // without the srcOnLoad attribute changing
+        return false;
+    }
+
     Valdi::Size onMeasure(const Valdi::Ref<Valdi::ValueMap>& attributes,
                           float width,
                           Valdi::MeasureMode widthMode,
@@ -15,6 +15,8 @@
 #include "valdi_core/cpp/Utils/LoggerUtils.hpp"
 #include "valdi_core/cpp/Utils/Trace.hpp"
 
+#include <algorithm>
+
 namespace Valdi {
 
 AttributeHandler::AttributeHandler() = default;
@@ -97,7 +99,7 @@ Result<PreprocessedValue> AttributeHandler::preprocess(const Value& value) const
     }
 
     if (_preprocessorCache != nullptr) {
-        auto cacheKey = PreprocessorCacheKey(value);
+        auto cacheKey = PreprocessorCacheKey(_preprocessorCacheScope, value);
 
         auto result = _preprocessorCache->get(cacheKey);
         if (result) {
@@ -141,25 +143,43 @@ void AttributeHandler::resetAttribute(ViewTransactionScope& viewTransactionScope
 }
 
 void AttributeHandler::appendPreprocessor(Result<Value> (*preprocessor)(const Value&), bool isTrivial) {
-    appendPreprocessor(AttributePreprocessor(preprocessor), isTrivial);
+    appendPreprocessor(
+        AttributePreprocessor(preprocessor), isTrivial, AttributePreprocessorIdentity::fromFunction(preprocessor));
 }
 
 void AttributeHandler::preprendPreprocessor(Result<Value> (*preprocessor)(const Value&), bool isTrivial) {
-    preprendPreprocessor(AttributePreprocessor(preprocessor), isTrivial);
+    preprendPreprocessor(
+        AttributePreprocessor(preprocessor), isTrivial, AttributePreprocessorIdentity::fromFunction(preprocessor));
 }
 
 void AttributeHandler::appendPreprocessor(Valdi::AttributePreprocessor preprocessor, bool isTrivial) {
+    appendPreprocessor(std::move(preprocessor), isTrivial, AttributePreprocessorIdentity());
+}
+
+void AttributeHandler::preprendPreprocessor(AttributePreprocessor preprocessor, bool isTrivial) {
+    preprendPreprocessor(std::move(preprocessor), isTrivial, AttributePreprocessorIdentity());
+}
+
+void AttributeHandler::appendPreprocessor(AttributePreprocessor preprocessor,
+                                          bool isTrivial,
+                                          const AttributePreprocessorIdentity& identity) {
     _preprocessors.emplace_back(std::move(preprocessor));
+    _preprocessorIdentities.emplace_back(identity);
     if (!isTrivial) {
         _preprocessingTrivial = false;
     }
+    updatePreprocessorCache();
 }
 
-void AttributeHandler::preprendPreprocessor(AttributePreprocessor preprocessor, bool isTrivial) {
+void AttributeHandler::preprendPreprocessor(AttributePreprocessor preprocessor,
+                                            bool isTrivial,
+                                            const AttributePreprocessorIdentity& identity) {
     _preprocessors.emplace(_preprocessors.begin(), std::move(preprocessor));
+    _preprocessorIdentities.emplace(_preprocessorIdentities.begin(), identity);
     if (!isTrivial) {
         _preprocessingTrivial = false;
     }
+    updatePreprocessorCache();
 }
 
 void AttributeHandler::appendPostprocessor(AttributePostprocessor postprocessor) {
@@ -172,7 +192,7 @@ bool AttributeHandler::hasPreprocessors() const {
 
 void AttributeHandler::clearPreprocessorCache() {
     if (_preprocessorCache != nullptr) {
-        _preprocessorCache->clear();
+        _preprocessorCache->clearScope(_preprocessorCacheScope);
     }
 }
 
@@ -203,29 +223,47 @@ AttributeId AttributeHandler::getId() const {
 AttributeHandler AttributeHandler::withDelegate(const Ref<AttributeHandlerDelegate>& delegate) const {
     AttributeHandler handler(_id, _name, delegate, _compositeAttribute, _requiresView, _shouldInvalidateLayoutOnChange);
 
-    if (_preprocessorCache != nullptr) {
-        handler.setEnablePreprocessorCache(true);
-    }
-
     if (_shouldReevaluateOnColorPaletteChange) {
         handler.setShouldReevaluateOnColorPaletteChange(true);
     }
 
     handler._preprocessors = _preprocessors;
+    handler._preprocessorIdentities = _preprocessorIdentities;
     if (!_preprocessingTrivial) {
         handler._preprocessingTrivial = false;
     }
 
+    if (_preprocessorCacheEnabled) {
+        handler.setEnablePreprocessorCache(true);
+    }
+
     return handler;
 }
 
 void AttributeHandler::setEnablePreprocessorCache(bool enablePreprocessorCache) {
-    if (enablePreprocessorCache) {
-        if (_preprocessorCache == nullptr) {
-            _preprocessorCache = Valdi::makeShared<PreprocessorCache>();
-        }
-    } else {
+    _preprocessorCacheEnabled = enablePreprocessorCache;
+    updatePreprocessorCache();
+}
+
+void AttributeHandler::updatePreprocessorCache() {
+    if (!_preprocessorCacheEnabled) {
         _preprocessorCache = nullptr;
+        _preprocessorCacheScope = 0;
+        return;
+    }
+
+    auto canUseGlobalCache =
+        std::none_of(_preprocessorIdentities.begin(),
+                     _preprocessorIdentities.end(),
+                     [](const AttributePreprocessorIdentity& identity) { return identity.isEmpty(); });
+
+    if (canUseGlobalCache) {
+        _preprocessorCache = PreprocessorCache::getGlobal();
+        _preprocessorCacheScope = PreprocessorCache::resolveScope(_preprocessorIdentities);
+    } else if (_preprocessorCache == nullptr || _preprocessorCache == PreprocessorCache::getGlobal()) {
+        // The values of unidentified preprocessors can only be shared by the users of this handler
+        _preprocessorCache = Valdi::makeShared<PreprocessorCache>();
+        _preprocessorCacheScope = 0;
     }
 }
 
@@ -245,4 +283,16 @@ bool AttributeHandler::isPreprocessingTrivial() const {
     return _preprocessingTrivial;
 }
 
+bool AttributeHandler::hasPreprocessorCache() const {
+    return _preprocessorCache != nullptr;
+}
+
+bool AttributeHandler::usesGlobalPreprocessorCache() const {
+    return _preprocessorCache != nullptr && _preprocessorCache == PreprocessorCache::getGlobal();
+}
+
+size_t AttributeHandler::getPreprocessorCacheScope() const {
+    return _preprocessorCacheScope;
+}
+
 } // namespace Valdi
@@ -59,8 +59,14 @@ public:
 
     void appendPreprocessor(Result<Value> (*preprocessor)(const Value&), bool isTrivial);
     void appendPreprocessor(AttributePreprocessor preprocessor, bool isTrivial);
+    void appendPreprocessor(AttributePreprocessor preprocessor,
+                            bool isTrivial,
+                            const AttributePreprocessorIdentity& identity);
     void preprendPreprocessor(Result<Value> (*preprocessor)(const Value&), bool isTrivial);
     void preprendPreprocessor(AttributePreprocessor preprocessor, bool isTrivial);
+    void preprendPreprocessor(AttributePreprocessor preprocessor,
+                              bool isTrivial,
+                              const AttributePreprocessorIdentity& identity);
 
     void appendPostprocessor(AttributePostprocessor postprocessor);
 
@@ -93,6 +99,23 @@ public:
      */
     bool isPreprocessingTrivial() const;
 
+    /**
+     Whether the preprocessed values are stored in a cache shared by all the users of this handler.
+     */
+    bool hasPreprocessorCache() const;
+
+    /**
+     Whether the preprocessed values are stored in the global PreprocessorCache, which
+     is the case when all the preprocessors of this handler have an identity.
+     */
+    bool usesGlobalPreprocessorCache() const;
+
+    /**
+     The scope in which the preprocessed values are stored in the preprocessor cache.
+     Handlers using the global cache with the same scope produce the same values.
+     */
+    size_t getPreprocessorCacheScope() const;
+
     bool requiresView() const;
     bool shouldInvalidateLayoutOnChange() const;
     bool hasPreprocessors() const;
@@ -111,14 +134,19 @@ private:
     StringBox _name;
     Ref<AttributeHandlerDelegate> _delegate;
     SmallVector<AttributePreprocessor, 1> _preprocessors;
+    std::vector<AttributePreprocessorIdentity> _preprocessorIdentities;
     std::vector<AttributePostprocessor> _postprocessors;
     Ref<CompositeAttribute> _compositeAttribute;
     Shared<PreprocessorCache> _preprocessorCache;
+    size_t _preprocessorCacheScope = 0;
     bool _requiresView = false;
     bool _shouldInvalidateLayoutOnChange = false;
     bool _shouldReevaluateOnColorPaletteChange = false;
     bool _isCompositePart = false;
     bool _preprocessingTrivial = true;
+    bool _preprocessorCacheEnabled = false;
+
+    void updatePreprocessorCache();
 };
 
 } // namespace Valdi
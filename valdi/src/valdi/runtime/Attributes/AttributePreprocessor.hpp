@@ -11,8 +11,47 @@
 #include "valdi_core/cpp/Utils/Result.hpp"
 #include "valdi_core/cpp/Utils/Value.hpp"
 
+#include <functional>
+
 namespace Valdi {
 
 using AttributePreprocessor = Function<Result<Value>(const Value&)>;
 
-}
+/**
+ Identifies the computation done by a preprocessor, as the function it calls and the
+ id of the context it calls it with, like the id of a ColorPalette. Context ids must
+ never be reused by another context. Preprocessors with the same identity must return
+ the same output for the same input, which lets their values be shared in the global
+ PreprocessorCache across handlers and runtimes.
+ An empty identity means that the preprocessor cannot be identified.
+ */
+struct AttributePreprocessorIdentity {
+    const void* function = nullptr;
+    uint64_t contextId = 0;
+
+    AttributePreprocessorIdentity() = default;
+    AttributePreprocessorIdentity(const void* function, uint64_t contextId)
+        : function(function), contextId(contextId) {}
+
+    template<typename F>
+    static AttributePreprocessorIdentity fromFunction(F* function, uint64_t contextId = 0) {
+        return AttributePreprocessorIdentity(reinterpret_cast<const void*>(function), contextId);
+    }
+
+    bool isEmpty() const {
+        return function == nullptr;
+    }
+
+    bool operator==(const AttributePreprocessorIdentity& other) const {
+        return function == other.function && contextId == other.contextId;
+    }
+
+    bool operator<(const AttributePreprocessorIdentity& other) const {
+        if (function != other.function) {
+            return std::less<const void*>()(function, other.function);
+        }
+        return contextId < other.contextId;
+    }
+};
+
+} // namespace Valdi
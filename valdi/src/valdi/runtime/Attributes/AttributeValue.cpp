@@ -9,13 +9,16 @@
 #include "valdi/runtime/Attributes/AttributeHandler.hpp"
 #include "valdi/runtime/Attributes/AttributeOwner.hpp"
 #include "valdi_core/cpp/Utils/StringCache.hpp"
+#include "valdi_core/cpp/Utils/ValueArena.hpp"
 #include "valdi_core/cpp/Utils/ValueMap.hpp"
 
 #include <limits>
 
 namespace Valdi {
 
-AttributeValue::AttributeValue(const AttributeOwner* owner, Value&& value) : owner(owner), value(std::move(value)) {}
+// Attribute values live as long as the ViewNode, they are moved out of the arena so that they don't pin it
+AttributeValue::AttributeValue(const AttributeOwner* owner, Value&& value)
+    : owner(owner), value(ValueArena::copyToHeap(value)) {}
 
 AttributeValueCollection::AttributeValueCollection() : resolvedValueIndex(std::numeric_limits<size_t>::max()) {}
 
@@ -54,6 +57,9 @@ Result<Value> AttributeValue::preprocessValue(const AttributeHandler* handler) {
     if (preprocessedValue.empty()) {
         // Value has not been preprocessed yet, do it now.
         preprocessedValue = handler->preprocess(value);
+        if (preprocessedValue) {
+            preprocessedValue.value().value = ValueArena::copyToHeap(preprocessedValue.value().value);
+        }
     }
 
     if (!preprocessedValue) {
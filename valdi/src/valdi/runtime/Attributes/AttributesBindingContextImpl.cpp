@@ -50,6 +50,24 @@ static Result<Value> preprocessString(const Value& value) {
     return ValueConverter::toString(value).map<Value>();
 }
 
+static Result<Value> preprocessColor(const ColorPalette& colorPalette, const Value& value) {
+    auto color = ValueConverter::toColor(colorPalette, value);
+    if (!color) {
+        return color.moveError();
+    }
+
+    return Value(color.value().value);
+}
+
+static Result<Value> preprocessText(const ColorPalette& colorPalette, ILogger& logger, const Value& value) {
+    if (value.isString()) {
+        return value;
+    }
+    // strict parsing for non production build
+    auto strict = !snap::kIsAppstoreBuild;
+    return TextAttributeValueParser::parse(colorPalette, value, logger, strict);
+}
+
 AttributesBindingContextImpl::AttributesBindingContextImpl(AttributeIds& attributeIds,
                                                            const Ref<ColorPalette>& colorPalette,
                                                            ILogger& logger)
@@ -113,16 +131,13 @@ AttributeId AttributesBindingContextImpl::bindTextAttribute(const StringBox& att
                                                             bool invalidateLayoutOnChange,
                                                             const Ref<AttributeHandlerDelegate>& delegate) {
     auto& registeredHandler = registerHandler(attribute, invalidateLayoutOnChange, delegate);
+    // The logger is only used to report parsing errors, the output only depends on the palette
     registeredHandler.appendPreprocessor(
         [colorPalette = _colorPalette, logger = &_logger](const Value& value) -> Result<Value> {
-            if (value.isString()) {
-                return value;
-            }
-            // strict parsing for non production build
-            auto strict = !snap::kIsAppstoreBuild;
-            return TextAttributeValueParser::parse(*colorPalette, value, *logger, strict);
+            return preprocessText(*colorPalette, *logger, value);
         },
-        false);
+        false,
+        AttributePreprocessorIdentity::fromFunction(&preprocessText, _colorPalette->getId()));
     registeredHandler.setEnablePreprocessorCache(true);
 
     return registeredHandler.getId();
@@ -263,14 +278,10 @@ const AttributeHandlerById& AttributesBindingContextImpl::getHandlers() const {
 void AttributesBindingContextImpl::registerColorPreprocessor(AttributeHandler& handler) {
     handler.appendPreprocessor(
         [colorPalette = _colorPalette](const Value& value) -> Result<Value> {
-            auto color = ValueConverter::toColor(*colorPalette, value);
-            if (!color) {
-                return color.moveError();
-            }
-
-            return Value(color.value().value);
+            return preprocessColor(*colorPalette, value);
         },
-        false);
+        false,
+        AttributePreprocessorIdentity::fromFunction(&preprocessColor, _colorPalette->getId()));
     handler.setShouldReevaluateOnColorPaletteChange(true);
 }
 
@@ -10,12 +10,16 @@
 #include "valdi/runtime/Attributes/AttributesBindingContextImpl.hpp"
 #include "valdi/runtime/Attributes/DefaultAttributes.hpp"
 #include "valdi/runtime/Attributes/Yoga/YogaAttributes.hpp"
+#include "valdi/runtime/CSS/CSSDocument.hpp"
 #include "valdi/runtime/Interfaces/IViewManager.hpp"
 #include "valdi/runtime/Views/MeasureDelegate.hpp"
+#include "valdi_core/cpp/Utils/SmallVector.hpp"
 #include "valdi_core/cpp/Utils/Trace.hpp"
 
 #include "valdi_core/cpp/Utils/LoggerUtils.hpp"
 
+#include <algorithm>
+
 namespace Valdi {
 
 AttributesManager::AttributesManager(IViewManager& viewManager,
@@ -34,18 +38,20 @@ void AttributesManager::registerPreprocessor(AttributeId attributeId,
     registerPreprocessor(attributeId,
                          [colorPalette = _colorPalette, preprocessor](const Value& value) -> Result<Value> {
                              return preprocessor(colorPalette, value);
-                         });
+                         },
+                         AttributePreprocessorIdentity::fromFunction(preprocessor, _colorPalette->getId()));
 }
 
 void AttributesManager::registerPreprocessor(AttributeId attributeId,
                                              const Valdi::AttributePreprocessor& preprocessor) {
+    registerPreprocessor(attributeId, preprocessor, AttributePreprocessorIdentity());
+}
+
+void AttributesManager::registerPreprocessor(AttributeId attributeId,
+                                             const AttributePreprocessor& preprocessor,
+                                             const AttributePreprocessorIdentity& identity) {
     std::lock_guard<std::mutex> guard(_mutex);
-    auto it = _preprocessors.find(attributeId);
-    if (it == _preprocessors.end()) {
-        _preprocessors[attributeId].emplace_back(preprocessor);
-    } else {
-        it->second.emplace_back(preprocessor);
-    }
+    _preprocessors[attributeId].emplace_back(preprocessor, identity);
 }
 
 void AttributesManager::registerPostprocessor(AttributeId attributeId,
@@ -59,6 +65,50 @@ FlatMap<StringBox, SharedBoundAttributes> AttributesManager::getAllBoundAttribut
     return _boundAttributesByClass;
 }
 
+size_t AttributesManager::warmUpPreprocessorCache(const CSSDocument& cssDocument) {
+    VALDI_TRACE("Valdi.warmUpPreprocessorCache");
+
+    auto allBoundAttributes = getAllBoundAttributes();
+
+    // Only the values stored in the global cache are kept alive after being preprocessed.
+    // Handlers of different classes with the same scope produce the same values, so a single
+    // one of them is kept per scope.
+    FlatMap<AttributeId, SmallVector<const AttributeHandler*, 2>> handlersById;
+    for (const auto& it : allBoundAttributes) {
+        for (const auto& handlerIt : it.second->getHandlers()) {
+            const auto& handler = handlerIt.second;
+            if (handler.isPreprocessingTrivial() || !handler.usesGlobalPreprocessorCache()) {
+                continue;
+            }
+
+            auto& handlers = handlersById[handlerIt.first];
+            auto hasScope = std::any_of(handlers.begin(), handlers.end(), [&](const AttributeHandler* other) {
+                return other->getPreprocessorCacheScope() == handler.getPreprocessorCacheScope();
+            });
+            if (!hasScope) {
+                handlers.emplace_back(&handler);
+            }
+        }
+    }
+
+    size_t preprocessedValuesCount = 0;
+    cssDocument.forEachStyleDeclaration([&](const CSSStyleDeclaration& styleDeclaration) {
+        const auto& it = handlersById.find(styleDeclaration.attribute.id);
+        if (it == handlersById.end()) {
+            return;
+        }
+
+        for (const auto* handler : it->second) {
+            // Failures are ignored here, they will be reported when the value is applied
+            if (handler->preprocess(styleDeclaration.attribute.value)) {
+                preprocessedValuesCount++;
+            }
+        }
+    });
+
+    return preprocessedValuesCount;
+}
+
 SharedBoundAttributes AttributesManager::getAttributesForClass(const StringBox& className) noexcept {
     std::lock_guard<std::mutex> guard(_mutex);
     return lockFreeGetAttributesForClass(className);
@@ -153,7 +203,8 @@ void AttributesManager::populateAttributeHandlerById(AttributeHandlerById& attri
                 auto index = preprocessors->second.size();
                 while (index > 0) {
                     index--;
-                    attributeHandler.preprendPreprocessor(preprocessors->second[index], false);
+                    const auto& [preprocessor, identity] = preprocessors->second[index];
+                    attributeHandler.preprendPreprocessor(preprocessor, false, identity);
                 }
                 // Enable preprocessor cache for all default preprocessors.
                 attributeHandler.setEnablePreprocessorCache(true);
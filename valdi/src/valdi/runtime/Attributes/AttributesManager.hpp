@@ -25,6 +25,7 @@ namespace Valdi {
 
 class IViewManager;
 class ILogger;
+class CSSDocument;
 
 class AttributesManager {
 public:
@@ -35,11 +36,23 @@ public:
                       std::shared_ptr<YGConfig> yogaConfig);
 
     void registerPreprocessor(AttributeId attributeId, const AttributePreprocessor& preprocessor);
+    void registerPreprocessor(AttributeId attributeId,
+                              const AttributePreprocessor& preprocessor,
+                              const AttributePreprocessorIdentity& identity);
     void registerPreprocessor(AttributeId attributeId,
                               Result<Value> (*preprocessor)(const Ref<ColorPalette>&, const Value&));
     void registerPostprocessor(AttributeId attributeId,
                                Result<Value> (*postprocessor)(ViewNode& viewNode, const Value& value));
 
+    /**
+     Preprocesses the values declared in the given CSS document with the handlers of the
+     classes bound so far, so that they are already in the global PreprocessorCache when
+     the document is first applied. Each value is preprocessed once per preprocessor chain,
+     regardless of how many classes use that chain. Returns the number of values which were
+     preprocessed. Can be called from any thread.
+     */
+    size_t warmUpPreprocessorCache(const CSSDocument& cssDocument);
+
     SharedBoundAttributes getAttributesForClass(const StringBox& className) noexcept;
     FlatMap<StringBox, SharedBoundAttributes> getAllBoundAttributes() const;
 
@@ -59,7 +72,7 @@ private:
     ILogger& _logger;
     std::shared_ptr<YGConfig> _yogaConfig;
     FlatMap<StringBox, SharedBoundAttributes> _boundAttributesByClass;
-    FlatMap<AttributeId, std::vector<AttributePreprocessor>> _preprocessors;
+    FlatMap<AttributeId, std::vector<std::pair<AttributePreprocessor, AttributePreprocessorIdentity>>> _preprocessors;
     FlatMap<AttributeId, std::vector<AttributePostprocessor>> _postprocessors;
     Ref<ColorPalette> _colorPalette;
     mutable std::mutex _mutex;
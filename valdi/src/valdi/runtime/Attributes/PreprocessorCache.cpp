@@ -6,20 +6,20 @@
 //
 
 #include "valdi/runtime/Attributes/PreprocessorCache.hpp"
+#include "valdi_core/cpp/Utils/ValueArena.hpp"
+
+#include <algorithm>
+#include <map>
 
 namespace Valdi {
 
-PreprocessorCacheValue::PreprocessorCacheValue(const PreprocessorCacheKey& key,
-                                               const Value& value,
-                                               Weak<PreprocessorCache> cache)
-    : _key(key), _value(value), _cache(std::move(cache)) {}
+// Expired entries are purged when a shard grows past this many entries, then past
+// twice the number of live entries it had after the last purge.
+static constexpr size_t kMinPurgeThreshold = 64;
 
-PreprocessorCacheValue::~PreprocessorCacheValue() {
-    auto cache = _cache.lock();
-    if (cache != nullptr) {
-        cache->removeCacheKey(_key);
-    }
-}
+PreprocessorCacheValue::PreprocessorCacheValue(const Value& value) : _value(value) {}
+
+PreprocessorCacheValue::~PreprocessorCacheValue() = default;
 
 const Value& PreprocessorCacheValue::value() const {
     return _value;
@@ -30,11 +30,31 @@ PreprocessedValue::PreprocessedValue(Value value) : value(std::move(value)) {}
 PreprocessedValue::PreprocessedValue(Value value, Ref<SharedPtrRefCountable> handle)
     : value(std::move(value)), handle(std::move(handle)) {}
 
+PreprocessorCache::Shard::Shard() : recentlyUsed(0), purgeThreshold(kMinPurgeThreshold) {}
+
+PreprocessorCache::PreprocessorCache() : PreprocessorCache(0) {}
+
+PreprocessorCache::PreprocessorCache(size_t recentlyUsedCapacity) {
+    auto capacityPerShard = (recentlyUsedCapacity + kShardsCount - 1) / kShardsCount;
+    for (auto& shard : _shards) {
+        shard.recentlyUsed.setCapacity(capacityPerShard);
+    }
+}
+
+PreprocessorCache::~PreprocessorCache() = default;
+
+PreprocessorCache::Shard& PreprocessorCache::getShard(const PreprocessorCacheKey& key) const {
+    auto hash = key.hash();
+    auto index = ((hash >> 8) ^ (hash >> 16) ^ (hash >> 24)) % kShardsCount;
+    return _shards[index];
+}
+
 std::optional<PreprocessedValue> PreprocessorCache::get(const PreprocessorCacheKey& key) const {
-    std::lock_guard<Mutex> guard(_mutex);
+    auto& shard = getShard(key);
+    std::lock_guard<Mutex> guard(shard.mutex);
 
-    const auto& it = _cache.find(key);
-    if (it == _cache.end()) {
+    const auto& it = shard.entries.find(key);
+    if (it == shard.entries.end()) {
         return std::nullopt;
     }
 
@@ -43,29 +63,138 @@ std::optional<PreprocessedValue> PreprocessorCache::get(const PreprocessorCacheK
         return std::nullopt;
     }
 
+    // Move the value to the front of the recently used values
+    shard.recentlyUsed.insert(key, strongCachedValue);
+
     auto value = strongCachedValue->value();
 
     return PreprocessedValue(std::move(value), strongCachedValue);
 }
 
 PreprocessedValue PreprocessorCache::store(const PreprocessorCacheKey& key, const Value& value) {
-    std::lock_guard<Mutex> guard(_mutex);
-    auto cachedValue = Valdi::makeShared<PreprocessorCacheValue>(key, value, weak_from_this());
-    _cache[key] = cachedValue;
-    return PreprocessedValue(value, cachedValue);
+    // Cached values outlive the pass which created them, they should not pin the arena
+    auto heapKey = key.withValue(ValueArena::copyToHeap(key.value()));
+    auto heapValue = ValueArena::copyToHeap(value);
+    auto cachedValue = Valdi::makeShared<PreprocessorCacheValue>(heapValue);
+
+    auto& shard = getShard(heapKey);
+    std::lock_guard<Mutex> guard(shard.mutex);
+    shard.entries[heapKey] = cachedValue;
+    shard.recentlyUsed.insert(heapKey, cachedValue);
+
+    if (shard.entries.size() >= shard.purgeThreshold) {
+        purgeExpiredEntries(shard);
+    }
+
+    return PreprocessedValue(std::move(heapValue), cachedValue);
 }
 
-void PreprocessorCache::removeCacheKey(const PreprocessorCacheKey& key) {
-    std::lock_guard<Mutex> guard(_mutex);
-    const auto& it = _cache.find(key);
-    if (it != _cache.end()) {
-        _cache.erase(key);
+void PreprocessorCache::purgeExpiredEntries(Shard& shard) {
+    auto it = shard.entries.begin();
+    while (it != shard.entries.end()) {
+        if (it->second.expired()) {
+            shard.entries.erase(it++);
+        } else {
+            ++it;
+        }
     }
+
+    shard.purgeThreshold = std::max(kMinPurgeThreshold, shard.entries.size() * 2);
 }
 
 void PreprocessorCache::clear() {
-    std::lock_guard<Mutex> guard(_mutex);
-    _cache.clear();
+    for (auto& shard : _shards) {
+        std::lock_guard<Mutex> guard(shard.mutex);
+        shard.entries.clear();
+        shard.recentlyUsed.clear();
+        shard.purgeThreshold = kMinPurgeThreshold;
+    }
+}
+
+void PreprocessorCache::clearScope(size_t scope) {
+    FlatSet<size_t> scopes;
+    scopes.insert(scope);
+    clearScopes(scopes);
+}
+
+void PreprocessorCache::clearScopes(const FlatSet<size_t>& scopes) {
+    for (auto& shard : _shards) {
+        std::lock_guard<Mutex> guard(shard.mutex);
+
+        auto it = shard.entries.begin();
+        while (it != shard.entries.end()) {
+            if (scopes.find(it->first.scope()) != scopes.end()) {
+                shard.recentlyUsed.remove(it->first);
+                shard.entries.erase(it++);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+size_t PreprocessorCache::size() const {
+    size_t size = 0;
+    for (auto& shard : _shards) {
+        std::lock_guard<Mutex> guard(shard.mutex);
+        size += shard.entries.size();
+    }
+    return size;
+}
+
+const Shared<PreprocessorCache>& PreprocessorCache::getGlobal() {
+    static auto* kCache = new Shared<PreprocessorCache>(makeShared<PreprocessorCache>(kGlobalRecentlyUsedCapacity));
+    return *kCache;
+}
+
+struct PreprocessorCacheScopes {
+    Mutex mutex;
+    std::map<std::vector<AttributePreprocessorIdentity>, size_t> scopeByIdentities;
+    // Scope 0 is used by the keys created without scope
+    size_t nextScope = 1;
+};
+
+static PreprocessorCacheScopes& getScopes() {
+    static auto* kScopes = new PreprocessorCacheScopes();
+    return *kScopes;
+}
+
+size_t PreprocessorCache::resolveScope(const std::vector<AttributePreprocessorIdentity>& identities) {
+    auto& scopes = getScopes();
+    std::lock_guard<Mutex> guard(scopes.mutex);
+
+    auto it = scopes.scopeByIdentities.try_emplace(identities, scopes.nextScope);
+    if (it.second) {
+        scopes.nextScope++;
+    }
+    return it.first->second;
+}
+
+void PreprocessorCache::releaseScopes(uint64_t contextId) {
+    FlatSet<size_t> releasedScopes;
+
+    {
+        auto& scopes = getScopes();
+        std::lock_guard<Mutex> guard(scopes.mutex);
+
+        auto it = scopes.scopeByIdentities.begin();
+        while (it != scopes.scopeByIdentities.end()) {
+            auto usesContext = std::any_of(
+                it->first.begin(), it->first.end(), [&](const AttributePreprocessorIdentity& identity) {
+                    return identity.contextId == contextId;
+                });
+            if (usesContext) {
+                releasedScopes.insert(it->second);
+                it = scopes.scopeByIdentities.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    if (!releasedScopes.empty()) {
+        getGlobal()->clearScopes(releasedScopes);
+    }
 }
 
 } // namespace Valdi
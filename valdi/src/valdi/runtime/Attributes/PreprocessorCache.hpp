@@ -7,12 +7,17 @@
 
 #pragma once
 
+#include "valdi/runtime/Attributes/AttributePreprocessor.hpp"
 #include "valdi/runtime/Attributes/PreprocessorCacheKey.hpp"
 #include "valdi_core/cpp/Utils/FlatMap.hpp"
+#include "valdi_core/cpp/Utils/FlatSet.hpp"
+#include "valdi_core/cpp/Utils/LRUCache.hpp"
 #include "valdi_core/cpp/Utils/Mutex.hpp"
 #include "valdi_core/cpp/Utils/Shared.hpp"
 #include "valdi_core/cpp/Utils/Value.hpp"
+#include <array>
 #include <optional>
+#include <vector>
 
 namespace Valdi {
 
@@ -30,32 +35,80 @@ struct PreprocessedValue {
     PreprocessedValue(Value value, Ref<SharedPtrRefCountable> handle);
 };
 
-class PreprocessorCache;
 class PreprocessorCacheValue : public SharedPtrRefCountable {
 public:
-    PreprocessorCacheValue(const PreprocessorCacheKey& key, const Value& value, Weak<PreprocessorCache> cache);
+    explicit PreprocessorCacheValue(const Value& value);
     ~PreprocessorCacheValue() override;
 
     const Value& value() const;
 
 private:
-    PreprocessorCacheKey _key;
     Value _value;
-    Weak<PreprocessorCache> _cache;
 };
 
-class PreprocessorCache : public std::enable_shared_from_this<PreprocessorCache> {
+/**
+ A cache of preprocessed values. Values are held weakly for as long as a handle
+ returned by get() or store() is alive, and the most recently used ones are also
+ held strongly up to the recently used capacity, so that values which are released
+ and set again shortly after, like when a screen is re-rendered, are not preprocessed again.
+
+ The entries are spread across lock-striped shards, which lets the global cache
+ be used from multiple runtimes and threads without contending on a single lock.
+ */
+class PreprocessorCache {
 public:
+    static constexpr size_t kShardsCount = 16;
+    static constexpr size_t kGlobalRecentlyUsedCapacity = 512;
+
+    PreprocessorCache();
+    explicit PreprocessorCache(size_t recentlyUsedCapacity);
+    ~PreprocessorCache();
+
     std::optional<PreprocessedValue> get(const PreprocessorCacheKey& key) const;
     PreprocessedValue store(const PreprocessorCacheKey& key, const Value& value);
     void clear();
 
+    /**
+     Removes all the values which were stored with the given scope.
+     */
+    void clearScope(size_t scope);
+
+    size_t size() const;
+
+    /**
+     Returns the cache shared by all the handlers whose preprocessors can be identified,
+     across all the runtimes of the process.
+     */
+    static const Shared<PreprocessorCache>& getGlobal();
+
+    /**
+     Returns the scope in which the values produced by the given chain of preprocessors
+     should be stored in the global cache. Identical chains resolve to the same scope.
+     */
+    static size_t resolveScope(const std::vector<AttributePreprocessorIdentity>& identities);
+
+    /**
+     Forgets the scopes of all the chains of preprocessors which use the given context id,
+     and removes their values from the global cache. Should be called when the context,
+     like a ColorPalette, is destroyed.
+     */
+    static void releaseScopes(uint64_t contextId);
+
 private:
-    FlatMap<PreprocessorCacheKey, Weak<PreprocessorCacheValue>> _cache;
-    mutable Mutex _mutex;
+    struct alignas(64) Shard {
+        Mutex mutex;
+        FlatMap<PreprocessorCacheKey, Weak<PreprocessorCacheValue>> entries;
+        LRUCache<PreprocessorCacheKey, Ref<PreprocessorCacheValue>> recentlyUsed;
+        size_t purgeThreshold;
+
+        Shard();
+    };
+
+    mutable std::array<Shard, kShardsCount> _shards;
 
-    friend PreprocessorCacheValue;
-    void removeCacheKey(const PreprocessorCacheKey& key);
+    Shard& getShard(const PreprocessorCacheKey& key) const;
+    void clearScopes(const FlatSet<size_t>& scopes);
+    static void purgeExpiredEntries(Shard& shard);
 };
 
 } // namespace Valdi
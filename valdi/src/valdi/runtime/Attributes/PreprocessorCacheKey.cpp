@@ -7,16 +7,37 @@
 
 #include "valdi/runtime/Attributes/PreprocessorCacheKey.hpp"
 
+#include <boost/functional/hash.hpp>
+
 namespace Valdi {
 
 PreprocessorCacheKey::PreprocessorCacheKey(const Value& value) : _value(value), _hash(value.hash()) {}
 
+PreprocessorCacheKey::PreprocessorCacheKey(size_t scope, const Value& value)
+    : _value(value), _scope(scope), _hash(value.hash()) {
+    boost::hash_combine(_hash, scope);
+}
+
+PreprocessorCacheKey PreprocessorCacheKey::withValue(const Value& value) const {
+    auto key = *this;
+    key._value = value;
+    return key;
+}
+
 size_t PreprocessorCacheKey::hash() const {
     return _hash;
 }
 
+size_t PreprocessorCacheKey::scope() const {
+    return _scope;
+}
+
+const Value& PreprocessorCacheKey::value() const {
+    return _value;
+}
+
 bool PreprocessorCacheKey::operator==(const PreprocessorCacheKey& other) const {
-    return _value == other._value;
+    return _scope == other._scope && _value == other._value;
 }
 
 bool PreprocessorCacheKey::operator!=(const PreprocessorCacheKey& other) const {
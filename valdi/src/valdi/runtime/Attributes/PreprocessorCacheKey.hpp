@@ -14,15 +14,23 @@ namespace Valdi {
 class PreprocessorCacheKey {
 public:
     explicit PreprocessorCacheKey(const Value& value);
+    PreprocessorCacheKey(size_t scope, const Value& value);
 
     size_t hash() const;
+    size_t scope() const;
     const Value& value() const;
 
+    /**
+     Returns a copy of this key holding the given value, which must be equal to value().
+     */
+    PreprocessorCacheKey withValue(const Value& value) const;
+
     bool operator==(const PreprocessorCacheKey& other) const;
     bool operator!=(const PreprocessorCacheKey& other) const;
 
 private:
     Value _value;
+    size_t _scope = 0;
     size_t _hash = 0;
 };
 
@@ -23,11 +23,62 @@ ViewNodeAttribute::ViewNodeAttribute(const AttributeHandler* handler)
       _handlerCanAffectLayout(handler->shouldInvalidateLayoutOnChange()),
       _handlerIsCompositePart(handler->isCompositePart()) {}
 
+ViewNodeAttribute::ViewNodeAttribute(ViewNodeAttribute&& other) noexcept
+    : _handler(other._handler),
+      _pendingAnimatedValue(std::move(other._pendingAnimatedValue)),
+      _handlerNeedsView(other._handlerNeedsView),
+      _handlerCanAffectLayout(other._handlerCanAffectLayout),
+      _handlerIsCompositePart(other._handlerIsCompositePart),
+      _appliedValueDirty(other._appliedValueDirty),
+      _hasAppliedValue(other._hasAppliedValue) {
+    moveValuesFrom(other);
+}
+
 ViewNodeAttribute::~ViewNodeAttribute() {
+    destroyValues();
+}
+
+ViewNodeAttribute& ViewNodeAttribute::operator=(ViewNodeAttribute&& other) noexcept {
+    if (this != &other) {
+        destroyValues();
+
+        _handler = other._handler;
+        _pendingAnimatedValue = std::move(other._pendingAnimatedValue);
+        _handlerNeedsView = other._handlerNeedsView;
+        _handlerCanAffectLayout = other._handlerCanAffectLayout;
+        _handlerIsCompositePart = other._handlerIsCompositePart;
+        _appliedValueDirty = other._appliedValueDirty;
+        _hasAppliedValue = other._hasAppliedValue;
+
+        moveValuesFrom(other);
+    }
+
+    return *this;
+}
+
+void ViewNodeAttribute::moveValuesFrom(ViewNodeAttribute& other) {
+    if (other._hasSingleAttribute) {
+        auto& attributeValue = other.getSingleAttributeValue();
+        new (&_valuesUnion) AttributeValue(std::move(attributeValue));
+        attributeValue.~AttributeValue();
+
+        _hasSingleAttribute = true;
+        other._hasSingleAttribute = false;
+    } else if (other._hasAttributeCollection) {
+        *reinterpret_cast<AttributeValueCollection**>(&_valuesUnion) = &other.getAttributeValueCollection();
+
+        _hasAttributeCollection = true;
+        other._hasAttributeCollection = false;
+    }
+}
+
+void ViewNodeAttribute::destroyValues() {
     if (_hasSingleAttribute) {
         getSingleAttributeValue().~AttributeValue();
+        _hasSingleAttribute = false;
     } else if (_hasAttributeCollection) {
         delete &getAttributeValueCollection();
+        _hasAttributeCollection = false;
     }
 }
 
@@ -345,6 +396,8 @@ Result<Void> ViewNodeAttribute::update(ViewTransactionScope& viewTransactionScop
                                        bool justAddedView,
                                        const Ref<Animator>& animator) {
     auto needValue = !empty() && (!_handlerNeedsView || hasView);
+    // The handler can move this attribute by mutating the attributes of the ViewNode
+    const auto* handler = _handler;
 
     if (needValue) {
         if (!_hasAppliedValue || _appliedValueDirty) {
@@ -362,12 +415,12 @@ Result<Void> ViewNodeAttribute::update(ViewTransactionScope& viewTransactionScop
             // pre-animation state of the view, but got captured in the view's "appearing in the viewport" animation
             bool shouldForceApplyWithoutAnimation = pendingAnimatedValue == nullptr && justAddedView;
             if (shouldForceApplyWithoutAnimation) {
-                return _handler->applyAttribute(viewTransactionScope, *viewNode, result.value(), nullptr);
+                return handler->applyAttribute(viewTransactionScope, *viewNode, result.value(), nullptr);
             }
-            auto flushResult =
-                flushPendingAnimatedValue(viewTransactionScope, viewNode, pendingAnimatedValue, animator != nullptr);
+            auto flushResult = flushPendingAnimatedValue(
+                viewTransactionScope, viewNode, handler, pendingAnimatedValue, animator != nullptr);
 
-            auto applyResult = _handler->applyAttribute(viewTransactionScope, *viewNode, result.value(), animator);
+            auto applyResult = handler->applyAttribute(viewTransactionScope, *viewNode, result.value(), animator);
 
             if (!applyResult) {
                 return applyResult;
@@ -385,10 +438,10 @@ Result<Void> ViewNodeAttribute::update(ViewTransactionScope& viewTransactionScop
             _appliedValueDirty = false;
 
             auto pendingAnimatedValue = std::move(_pendingAnimatedValue);
-            auto flushResult =
-                flushPendingAnimatedValue(viewTransactionScope, viewNode, pendingAnimatedValue, animator != nullptr);
+            auto flushResult = flushPendingAnimatedValue(
+                viewTransactionScope, viewNode, handler, pendingAnimatedValue, animator != nullptr);
 
-            _handler->resetAttribute(viewTransactionScope, *viewNode, animator);
+            handler->resetAttribute(viewTransactionScope, *viewNode, animator);
 
             return flushResult;
         }
@@ -407,6 +460,7 @@ void ViewNodeAttribute::willAnimate() {
 
 Result<Void> ViewNodeAttribute::flushPendingAnimatedValue(ViewTransactionScope& viewTransactionScope,
                                                           ViewNode* viewNode,
+                                                          const AttributeHandler* handler,
                                                           const std::unique_ptr<Result<Value>>& pendingAnimatedValue,
                                                           bool willAnimate) {
     if (!willAnimate || pendingAnimatedValue == nullptr) {
@@ -417,7 +471,7 @@ Result<Void> ViewNodeAttribute::flushPendingAnimatedValue(ViewTransactionScope&
         return pendingAnimatedValue->moveError();
     }
 
-    return _handler->applyAttribute(viewTransactionScope, *viewNode, pendingAnimatedValue->value(), nullptr);
+    return handler->applyAttribute(viewTransactionScope, *viewNode, pendingAnimatedValue->value(), nullptr);
 }
 
 void ViewNodeAttribute::markDirty() {
@@ -432,16 +486,16 @@ void ViewNodeAttribute::markDirty() {
     }
 }
 
-Ref<ViewNodeAttribute> ViewNodeAttribute::copy() {
-    auto copy = makeShared<ViewNodeAttribute>(_handler);
+ViewNodeAttribute ViewNodeAttribute::copy() {
+    ViewNodeAttribute copy(_handler);
 
     if (!empty()) {
         auto result = getResolvedPreprocessedValue();
         if (result) {
-            copy->unsafeSetAsTrivial(nullptr, Value(result.value()));
-            copy->getSingleAttributeValue().preprocessedValue = PreprocessedValue(result.moveValue());
+            copy.unsafeSetAsTrivial(nullptr, Value(result.value()));
+            copy.getSingleAttributeValue().preprocessedValue = PreprocessedValue(result.moveValue());
         }
-        copy->_appliedValueDirty = true;
+        copy._appliedValueDirty = true;
     }
 
     return copy;
@@ -25,14 +25,26 @@ class AttributeOwner;
 class CompositeAttribute;
 class ViewTransactionScope;
 
-class ViewNodeAttribute : public SimpleRefCountable {
+/**
+ The values set on an attribute of a ViewNode. Instances are held inline by
+ ViewNodeAttributeStorage, and can therefore be moved whenever an attribute
+ is inserted or removed from the storage.
+ */
+class ViewNodeAttribute {
 public:
     explicit ViewNodeAttribute(const AttributeHandler* handler);
-    ~ViewNodeAttribute() override;
+    ViewNodeAttribute(ViewNodeAttribute&& other) noexcept;
+    ViewNodeAttribute(const ViewNodeAttribute& other) = delete;
+    ~ViewNodeAttribute();
+
+    ViewNodeAttribute& operator=(ViewNodeAttribute&& other) noexcept;
+    ViewNodeAttribute& operator=(const ViewNodeAttribute& other) = delete;
 
     /**
      Update the attribute to the given ViewNode.
      This function will be a no-op if no updates need to be done.
+     The attribute handler might re-entrantly mutate the attributes of the ViewNode,
+     so this function does not access the attribute after calling into the handler.
      */
     [[nodiscard]] Result<Void> update(ViewTransactionScope& viewTransactionScope,
                                       ViewNode* viewNode,
@@ -50,7 +62,7 @@ public:
     /**
      Copy this attribute with its resolved value
      */
-    Ref<ViewNodeAttribute> copy();
+    ViewNodeAttribute copy();
 
     /**
      Returns the value for the given owner.
@@ -143,10 +155,14 @@ private:
     bool _hasSingleAttribute = false;
     bool _hasAttributeCollection = false;
 
-    Result<Void> flushPendingAnimatedValue(ViewTransactionScope& viewTransactionScope,
-                                           ViewNode* viewNode,
-                                           const std::unique_ptr<Result<Value>>& pendingAnimatedValue,
-                                           bool willAnimate);
+    static Result<Void> flushPendingAnimatedValue(ViewTransactionScope& viewTransactionScope,
+                                                  ViewNode* viewNode,
+                                                  const AttributeHandler* handler,
+                                                  const std::unique_ptr<Result<Value>>& pendingAnimatedValue,
+                                                  bool willAnimate);
+
+    void moveValuesFrom(ViewNodeAttribute& other);
+    void destroyValues();
 
     inline void unsafeSetAsTrivial(const AttributeOwner* owner, Value&& value) {
         new (&_valuesUnion) AttributeValue(owner, std::move(value));
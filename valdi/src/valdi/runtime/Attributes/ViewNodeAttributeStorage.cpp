@@ -0,0 +1,92 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi/runtime/Attributes/ViewNodeAttributeStorage.hpp"
+#include "utils/debugging/Assert.hpp"
+
+namespace Valdi {
+
+ViewNodeAttributeStorage::ViewNodeAttributeStorage() = default;
+ViewNodeAttributeStorage::~ViewNodeAttributeStorage() = default;
+
+size_t ViewNodeAttributeStorage::lowerBound(AttributeId id) const {
+    size_t low = 0;
+    size_t high = _entries.size();
+
+    while (low < high) {
+        auto middle = low + (high - low) / 2;
+        if (_entries[middle].id < id) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+ViewNodeAttribute* ViewNodeAttributeStorage::find(AttributeId id) {
+    auto index = lowerBound(id);
+    if (index == _entries.size() || _entries[index].id != id) {
+        return nullptr;
+    }
+
+    return &_entries[index].attribute;
+}
+
+const ViewNodeAttribute* ViewNodeAttributeStorage::find(AttributeId id) const {
+    auto index = lowerBound(id);
+    if (index == _entries.size() || _entries[index].id != id) {
+        return nullptr;
+    }
+
+    return &_entries[index].attribute;
+}
+
+ViewNodeAttribute& ViewNodeAttributeStorage::emplace(AttributeId id, const AttributeHandler* handler) {
+    auto index = lowerBound(id);
+    if (index != _entries.size() && _entries[index].id == id) {
+        return _entries[index].attribute;
+    }
+
+    _mutationId++;
+    auto it = _entries.emplace(_entries.begin() + index, id, ViewNodeAttribute(handler));
+
+    return it->attribute;
+}
+
+void ViewNodeAttributeStorage::insertOrAssign(AttributeId id, ViewNodeAttribute&& attribute) {
+    _mutationId++;
+
+    auto index = lowerBound(id);
+    if (index != _entries.size() && _entries[index].id == id) {
+        _entries[index].attribute = std::move(attribute);
+    } else {
+        _entries.emplace(_entries.begin() + index, id, std::move(attribute));
+    }
+}
+
+ViewNodeAttribute ViewNodeAttributeStorage::removeAt(size_t index) {
+    SC_ASSERT(index < _entries.size());
+    _mutationId++;
+
+    auto attribute = std::move(_entries[index].attribute);
+    _entries.erase(_entries.begin() + index);
+
+    return attribute;
+}
+
+std::optional<ViewNodeAttribute> ViewNodeAttributeStorage::remove(AttributeId id) {
+    auto index = lowerBound(id);
+    if (index == _entries.size() || _entries[index].id != id) {
+        return std::nullopt;
+    }
+
+    return {removeAt(index)};
+}
+
+void ViewNodeAttributeStorage::clear() {
+    _mutationId++;
+    _entries.clear();
+}
+
+} // namespace Valdi
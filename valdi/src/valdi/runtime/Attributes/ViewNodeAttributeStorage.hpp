@@ -0,0 +1,132 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "valdi/runtime/Attributes/AttributeId.hpp"
+#include "valdi/runtime/Attributes/ViewNodeAttribute.hpp"
+#include "valdi_core/cpp/Utils/SmallVector.hpp"
+
+#include <optional>
+
+namespace Valdi {
+
+/**
+ The attributes set on a ViewNode, held inline and sorted by attribute id.
+ Most ViewNodes have a handful of attributes, which fit in the inline storage
+ without any per-attribute allocation, and a lookup is a binary search over a
+ contiguous array.
+
+ Inserting or removing an attribute moves the attributes stored after it, which
+ invalidates any pointer or reference to them. The mutation id is incremented on
+ every such change, so that callers iterating while attribute handlers re-enter
+ the storage can detect it and restart, like with SafeReentrantContainer.
+ */
+class ViewNodeAttributeStorage {
+public:
+    struct Entry {
+        AttributeId id;
+        ViewNodeAttribute attribute;
+
+        Entry(AttributeId id, ViewNodeAttribute&& attribute) : id(id), attribute(std::move(attribute)) {}
+    };
+
+    static constexpr size_t kInlineCapacity = 4;
+
+    ViewNodeAttributeStorage();
+    ~ViewNodeAttributeStorage();
+
+    ViewNodeAttribute* find(AttributeId id);
+    const ViewNodeAttribute* find(AttributeId id) const;
+
+    /**
+     Returns the attribute for the given id, creating it with the given handler
+     if it does not exist yet.
+     */
+    ViewNodeAttribute& emplace(AttributeId id, const AttributeHandler* handler);
+
+    /**
+     Inserts the given attribute, replacing any existing attribute with the same id.
+     */
+    void insertOrAssign(AttributeId id, ViewNodeAttribute&& attribute);
+
+    /**
+     Removes the attribute at the given index and returns it.
+     */
+    ViewNodeAttribute removeAt(size_t index);
+
+    /**
+     Removes the attribute for the given id and returns it, if it exists.
+     */
+    std::optional<ViewNodeAttribute> remove(AttributeId id);
+
+    void clear();
+
+    /**
+     Calls the visitor with the id and attribute of every entry. The visitor can re-entrantly
+     insert or remove attributes, in which case the iteration restarts from the beginning,
+     like with SafeReentrantContainer. Entries can therefore be visited more than once, and
+     the visitor must not access the attribute after it mutated the storage.
+     */
+    template<typename F>
+    void forEachReentrant(F&& visitor) {
+        size_t index = 0;
+        while (index < _entries.size()) {
+            auto mutationId = _mutationId;
+            auto& entry = _entries[index];
+            visitor(entry.id, entry.attribute);
+
+            if (mutationId == _mutationId) {
+                index++;
+            } else {
+                index = 0;
+            }
+        }
+    }
+
+    /**
+     Returns the index of the first entry whose id is not less than the given id.
+     */
+    size_t lowerBound(AttributeId id) const;
+
+    size_t size() const {
+        return _entries.size();
+    }
+
+    bool empty() const {
+        return _entries.empty();
+    }
+
+    Entry& operator[](size_t index) {
+        return _entries[index];
+    }
+
+    const Entry& operator[](size_t index) const {
+        return _entries[index];
+    }
+
+    auto begin() {
+        return _entries.begin();
+    }
+
+    auto end() {
+        return _entries.end();
+    }
+
+    auto begin() const {
+        return _entries.begin();
+    }
+
+    auto end() const {
+        return _entries.end();
+    }
+
+    int getMutationId() const {
+        return _mutationId;
+    }
+
+private:
+    SmallVector<Entry, kInlineCapacity> _entries;
+    int _mutationId = 0;
+};
+
+} // namespace Valdi
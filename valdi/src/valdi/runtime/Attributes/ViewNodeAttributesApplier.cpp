@@ -17,6 +17,8 @@
 #include "valdi_core/cpp/Utils/ValueArray.hpp"
 #include "valdi_core/cpp/Utils/ValueMap.hpp"
 
+#include <boost/functional/hash.hpp>
+
 namespace Valdi {
 
 ViewNodeAttributesApplier::ViewNodeAttributesApplier(ViewNode* viewNode) : _viewNode(viewNode) {}
@@ -33,25 +35,25 @@ bool ViewNodeAttributesApplier::setAttribute(ViewTransactionScope& viewTransacti
     }
 
     if (value.isNullOrUndefined()) {
-        auto it = _attributes.find(id);
-        if (it == _attributes.end()) {
+        auto* attribute = _attributes.find(id);
+        if (attribute == nullptr) {
             return false;
         }
 
         if (animator != nullptr) {
-            it->second->willAnimate();
+            attribute->willAnimate();
         }
 
-        auto changed = it->second->removeValue(owner);
+        auto changed = attribute->removeValue(owner);
 
         if (changed) {
-            auto attribute = it->second;
-
             if (attribute->empty()) {
-                _attributes.erase(it);
+                // The attribute needs to outlive its removal so that it can be reset on the view
+                auto removedAttribute = _attributes.remove(id);
+                processAttributeChange(viewTransactionScope, id, removedAttribute.value(), animator);
+            } else {
+                processAttributeChange(viewTransactionScope, id, *attribute, animator);
             }
-
-            processAttributeChange(viewTransactionScope, id, *attribute, animator);
         }
 
         return changed;
@@ -76,24 +78,22 @@ bool ViewNodeAttributesApplier::setAttribute(ViewTransactionScope& viewTransacti
 }
 
 bool ViewNodeAttributesApplier::hasResolvedAttributeValue(AttributeId id) const {
-    const auto& it = _attributes.find(id);
-    return it != _attributes.end();
+    return _attributes.find(id) != nullptr;
 }
 
 Value ViewNodeAttributesApplier::getResolvedAttributeValue(AttributeId id) const {
-    const auto& it = _attributes.find(id);
-    if (it == _attributes.end()) {
+    const auto* attribute = _attributes.find(id);
+    if (attribute == nullptr) {
         return Value::undefined();
     }
-    return it->second->getResolvedValue();
+    return attribute->getResolvedValue();
 }
 
 void ViewNodeAttributesApplier::reapplyAttribute(ViewTransactionScope& viewTransactionScope, AttributeId id) {
-    const auto& it = _attributes.find(id);
-    if (it == _attributes.end()) {
+    auto* attribute = _attributes.find(id);
+    if (attribute == nullptr) {
         return;
     }
-    auto attribute = it->second;
 
     attribute->markDirty();
 
@@ -107,35 +107,47 @@ void ViewNodeAttributesApplier::reapplyAttribute(ViewTransactionScope& viewTrans
 bool ViewNodeAttributesApplier::removeAllAttributesForOwner(ViewTransactionScope& viewTransactionScope,
                                                             const AttributeOwner* owner,
                                                             const Ref<Animator>& animator) {
-    // This shims tries to efficiently remove the owner from our attributes map.
+    // This shims tries to efficiently remove the owner from our attributes.
     // In the optimal case, we do a single iteration where we take care of removing
-    // attributes and updating our iterator. In some cases, updating an attribute
-    // could trigger a call back inside our attributes map, making our iterator invalid.
-    // In those cases we restart our iteration in the map until we finished processing
+    // attributes and updating our index. In some cases, updating an attribute
+    // could trigger a call back inside our attributes, making our index invalid.
+    // In those cases we restart our iteration until we finished processing
     // all values.
 
     auto hadAChange = false;
 
-    auto it = _attributes.begin();
-    while (it != _attributes.end()) {
-        auto changed = it->second->removeValue(owner);
+    size_t index = 0;
+    while (index < _attributes.size()) {
+        auto& entry = _attributes[index];
+        auto changed = entry.attribute.removeValue(owner);
 
-        if (changed) {
-            hadAChange = true;
-            auto name = it->first;
-            auto attribute = it->second;
+        if (!changed) {
+            index++;
+            continue;
+        }
 
-            if (attribute->empty()) {
-                it = _attributes.erase(it);
+        hadAChange = true;
+        auto id = entry.id;
 
-                processAttributeChange(viewTransactionScope, name, *attribute, animator);
-            } else {
-                ++it;
+        if (entry.attribute.empty()) {
+            auto attribute = _attributes.removeAt(index);
+            auto mutationId = _attributes.getMutationId();
 
-                processAttributeChange(viewTransactionScope, name, *attribute, animator);
+            processAttributeChange(viewTransactionScope, id, attribute, animator);
+
+            if (mutationId != _attributes.getMutationId()) {
+                index = 0;
             }
         } else {
-            ++it;
+            auto mutationId = _attributes.getMutationId();
+
+            processAttributeChange(viewTransactionScope, id, entry.attribute, animator);
+
+            if (mutationId == _attributes.getMutationId()) {
+                index++;
+            } else {
+                index = 0;
+            }
         }
     }
 
@@ -214,15 +226,13 @@ void ViewNodeAttributesApplier::didAddView(ViewTransactionScope& viewTransaction
 void ViewNodeAttributesApplier::updateAttributes(ViewTransactionScope& viewTransactionScope,
                                                  const Ref<Animator>& animator,
                                                  bool justAddedView) {
-    for (const auto& it : _attributes) {
-        if (it.second->isCompositePart()) {
-            continue;
+    // Updating an attribute can re-entrantly insert or remove attributes, in which case
+    // we restart from the beginning. Attributes which were already updated are no-ops.
+    _attributes.forEachReentrant([&](AttributeId id, ViewNodeAttribute& attribute) {
+        if (!attribute.isCompositePart()) {
+            updateAttribute(viewTransactionScope, id, attribute, animator, justAddedView);
         }
-
-        auto key = it.first;
-        auto attribute = it.second;
-        updateAttribute(viewTransactionScope, key, *attribute, animator, justAddedView);
-    }
+    });
 }
 
 void ViewNodeAttributesApplier::updateAttribute(ViewTransactionScope& viewTransactionScope,
@@ -308,10 +318,10 @@ CompositeAttributeResult ViewNodeAttributesApplier::populateCompositeAttribute(
     for (size_t index = 0; index < size; index++) {
         const auto& part = compositeAttribute.getParts()[index];
 
-        auto attributeValue = _attributes.find(part.attributeId);
+        auto* attribute = _attributes.find(part.attributeId);
         Value valueToInsert;
 
-        if (attributeValue == _attributes.end() || attributeValue->second->empty()) {
+        if (attribute == nullptr || attribute->empty()) {
             if (!part.optional) {
                 result.isIncomplete = true;
             }
@@ -320,7 +330,7 @@ CompositeAttributeResult ViewNodeAttributesApplier::populateCompositeAttribute(
         } else {
             result.hasAValue = true;
 
-            auto attributeResult = attributeValue->second->getResolvedProcessedValue(*_viewNode);
+            auto attributeResult = attribute->getResolvedProcessedValue(*_viewNode);
 
             if (attributeResult) {
                 valueToInsert = attributeResult.moveValue();
@@ -332,7 +342,7 @@ CompositeAttributeResult ViewNodeAttributesApplier::populateCompositeAttribute(
                     _viewNode->getLoggerFormatPrefix(),
                     getAttributeName(compositeAttribute.getAttributeId()),
                     getAttributeName(part.attributeId),
-                    attributeValue->second->getResolvedValue().toString(),
+                    attribute->getResolvedValue().toString(),
                     _boundAttributes->getClassName(),
                     attributeResult.error());
             }
@@ -357,10 +367,10 @@ const AttributeHandler* ViewNodeAttributesApplier::getAttributeHandler(Attribute
     return attributeHandler;
 }
 
-Ref<ViewNodeAttribute> ViewNodeAttributesApplier::emplaceAttribute(AttributeId id) {
-    auto it = _attributes.find(id);
-    if (it != _attributes.end()) {
-        return it->second;
+ViewNodeAttribute* ViewNodeAttributesApplier::emplaceAttribute(AttributeId id) {
+    auto* attribute = _attributes.find(id);
+    if (attribute != nullptr) {
+        return attribute;
     }
 
     SC_ASSERT_NOTNULL(_boundAttributes);
@@ -371,53 +381,110 @@ Ref<ViewNodeAttribute> ViewNodeAttributesApplier::emplaceAttribute(AttributeId i
         return nullptr;
     }
 
-    auto attribute = makeShared<ViewNodeAttribute>(attributeHandler);
-
-    _attributes.mutate([&](auto& container) { container[id] = attribute; });
-
-    return attribute;
+    return &_attributes.emplace(id, attributeHandler);
 }
 
 void ViewNodeAttributesApplier::copyViewLayoutAttributes(ViewNodeAttributesApplier& attributesApplier) {
-    for (const auto& it : _attributes) {
-        if (it.second->canAffectLayout() && it.second->requiresView()) {
-            auto name = it.first;
-            auto attribute = it.second;
+    for (auto& entry : _attributes) {
+        if (entry.attribute.canAffectLayout() && entry.attribute.requiresView()) {
+            attributesApplier._attributes.insertOrAssign(entry.id, entry.attribute.copy());
+        }
+    }
+}
+
+template<typename F>
+Result<Void> ViewNodeAttributesApplier::forEachProcessedViewLayoutAttribute(F&& visitor) {
+    size_t index = 0;
+    while (index < _attributes.size()) {
+        auto& entry = _attributes[index];
+        auto id = entry.id;
+        auto& attribute = entry.attribute;
+        if (!attribute.canAffectLayout() || !attribute.requiresView() || attribute.isCompositePart()) {
+            index++;
+            continue;
+        }
+
+        // Postprocessors can re-entrantly insert or remove attributes, which moves the attribute
+        auto name = attribute.getAttributeName();
+        auto mutationId = _attributes.getMutationId();
+        auto result = attribute.getResolvedProcessedValue(*_viewNode);
+        if (!result) {
+            VALDI_ERROR(_viewNode->getLogger(),
+                        "{}, Could not preprocess attribute '{}' in class {}: {}",
+                        _viewNode->getLoggerFormatPrefix(),
+                        name,
+                        _boundAttributes->getClassName(),
+                        result.error());
+
+            return result.moveError();
+        }
+
+        if (!visitor(name, result.value())) {
+            break;
+        }
 
-            attributesApplier._attributes.mutate([&](auto& container) { container[name] = attribute->copy(); });
+        if (mutationId == _attributes.getMutationId()) {
+            index++;
+        } else {
+            // Resume after the visited attribute, the visitor must see each attribute only once
+            index = _attributes.lowerBound(id + 1);
         }
     }
+
+    return Void();
 }
 
 Result<Ref<ValueMap>> ViewNodeAttributesApplier::copyProcessedViewLayoutAttributes() {
     auto out = makeShared<ValueMap>();
 
-    for (const auto& it : _attributes) {
-        if (it.second->canAffectLayout() && it.second->requiresView() && !it.second->isCompositePart()) {
-            auto result = it.second->getResolvedProcessedValue(*_viewNode);
-            if (!result) {
-                VALDI_ERROR(_viewNode->getLogger(),
-                            "{}, Could not preprocess attribute '{}' in class {}: {}",
-                            _viewNode->getLoggerFormatPrefix(),
-                            it.second->getAttributeName(),
-                            _boundAttributes->getClassName(),
-                            result.error());
-
-                return result.moveError();
-            }
-
-            (*out)[it.second->getAttributeName()] = result.value();
-        }
+    auto result = forEachProcessedViewLayoutAttribute([&](const StringBox& name, const Value& value) {
+        (*out)[name] = value;
+        return true;
+    });
+    if (!result) {
+        return result.moveError();
     }
 
     return out;
 }
 
+Result<size_t> ViewNodeAttributesApplier::hashProcessedViewLayoutAttributes() {
+    size_t hash = 0;
+
+    auto result = forEachProcessedViewLayoutAttribute([&](const StringBox& name, const Value& value) {
+        boost::hash_combine(hash, name.hash());
+        boost::hash_combine(hash, value.hash());
+        return true;
+    });
+    if (!result) {
+        return result.moveError();
+    }
+
+    return hash;
+}
+
+bool ViewNodeAttributesApplier::processedViewLayoutAttributesEqual(const ValueMap& attributes) {
+    size_t matchedCount = 0;
+    bool equal = true;
+
+    auto result = forEachProcessedViewLayoutAttribute([&](const StringBox& name, const Value& value) {
+        const auto& it = attributes.find(name);
+        if (it == attributes.end() || it->second != value) {
+            equal = false;
+            return false;
+        }
+        matchedCount++;
+        return true;
+    });
+
+    return result && equal && matchedCount == attributes.size();
+}
+
 Ref<ValueMap> ViewNodeAttributesApplier::dumpResolvedAttributes() const {
     auto out = makeShared<ValueMap>();
-    for (const auto& it : _attributes) {
-        if (it.second->getCompositeAttribute() == nullptr || it.second->isCompositePart()) {
-            (*out)[getAttributeName(it.first)] = it.second->getResolvedValue();
+    for (const auto& entry : _attributes) {
+        if (entry.attribute.getCompositeAttribute() == nullptr || entry.attribute.isCompositePart()) {
+            (*out)[getAttributeName(entry.id)] = entry.attribute.getResolvedValue();
         }
     }
 
@@ -426,8 +493,8 @@ Ref<ValueMap> ViewNodeAttributesApplier::dumpResolvedAttributes() const {
 
 Ref<ValueMap> ViewNodeAttributesApplier::dumpAttributes() const {
     auto out = makeShared<ValueMap>();
-    for (const auto& it : _attributes) {
-        (*out)[getAttributeName(it.first)] = it.second->dump();
+    for (const auto& entry : _attributes) {
+        (*out)[getAttributeName(entry.id)] = entry.attribute.dump();
     }
 
     return out;
@@ -453,27 +520,22 @@ const Ref<BoundAttributes>& ViewNodeAttributesApplier::getBoundAttributes() cons
 void ViewNodeAttributesApplier::updateAttributeHandlers() {
     std::vector<AttributeId> attributeIdsToRemove;
 
-    for (const auto& it : _attributes) {
-        const auto* handler = getAttributeHandler(it.first);
+    for (auto& entry : _attributes) {
+        const auto* handler = getAttributeHandler(entry.id);
         if (VALDI_LIKELY(handler != nullptr)) {
-            it.second->setHandler(handler);
+            entry.attribute.setHandler(handler);
 
             if (handler->requiresView()) {
                 // View attributes need to be re-applied
-                it.second->markDirty();
+                entry.attribute.markDirty();
             }
         } else {
-            attributeIdsToRemove.emplace_back(it.first);
+            attributeIdsToRemove.emplace_back(entry.id);
         }
     }
 
     for (const auto& attributeId : attributeIdsToRemove) {
-        _attributes.mutate([&](auto& container) {
-            auto it = container.find(attributeId);
-            if (it != container.end()) {
-                container.erase(it);
-            }
-        });
+        _attributes.remove(attributeId);
     }
 }
 
@@ -491,11 +553,11 @@ int ViewNodeAttributesApplier::getAttributePriority(AttributeId id) const {
 
     const auto* handler = _boundAttributes->getAttributeHandlerForId(id);
     for (const auto& part : handler->getCompositeAttribute()->getParts()) {
-        const auto& it = _attributes.find(part.attributeId);
-        if (it == _attributes.end()) {
+        const auto* attribute = _attributes.find(part.attributeId);
+        if (attribute == nullptr) {
             continue;
         }
-        bestPriority = std::min(bestPriority, it->second->getResolvedValuePriority());
+        bestPriority = std::min(bestPriority, attribute->getResolvedValuePriority());
     }
 
     return bestPriority;
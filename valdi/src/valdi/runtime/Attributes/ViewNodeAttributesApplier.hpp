@@ -9,7 +9,7 @@
 
 #include "valdi/runtime/Attributes/AttributeOwner.hpp"
 #include "valdi/runtime/Attributes/AttributesApplier.hpp"
-#include "valdi/runtime/Utils/SafeReentrantContainer.hpp"
+#include "valdi/runtime/Attributes/ViewNodeAttributeStorage.hpp"
 #include "valdi_core/cpp/Utils/FlatMap.hpp"
 #include "valdi_core/cpp/Utils/FlatSet.hpp"
 #include "valdi_core/cpp/Utils/Shared.hpp"
@@ -21,7 +21,6 @@ class ViewNode;
 class BoundAttributes;
 class ILogger;
 class CompositeAttribute;
-class ViewNodeAttribute;
 class AttributeHandler;
 class ViewTransactionScope;
 
@@ -79,6 +78,17 @@ public:
 
     Result<Ref<ValueMap>> copyProcessedViewLayoutAttributes();
 
+    /**
+     Hashes the attributes that copyProcessedViewLayoutAttributes() would return, without copying them.
+     */
+    Result<size_t> hashProcessedViewLayoutAttributes();
+
+    /**
+     Returns whether the given map, returned by copyProcessedViewLayoutAttributes(),
+     is equal to the current processed view layout attributes.
+     */
+    bool processedViewLayoutAttributesEqual(const ValueMap& attributes);
+
     const Ref<BoundAttributes>& getBoundAttributes() const;
     void setBoundAttributes(Ref<BoundAttributes> boundAttributes);
 
@@ -97,7 +107,7 @@ private:
     Ref<BoundAttributes> _boundAttributes;
 
     // Attributes set on this applier.
-    SafeReentrantContainer<FlatMap<AttributeId, Ref<ViewNodeAttribute>>> _attributes;
+    ViewNodeAttributeStorage _attributes;
     FlatMap<AttributeId, Ref<Animator>> _dirtyCompositeAttributes;
 
     bool _hasView = false;
@@ -106,7 +116,7 @@ private:
                                   AttributeId compositeId,
                                   const Ref<Animator>& animator);
 
-    Ref<ViewNodeAttribute> emplaceAttribute(AttributeId id);
+    ViewNodeAttribute* emplaceAttribute(AttributeId id);
     void processAttributeChange(ViewTransactionScope& viewTransactionScope,
                                 AttributeId id,
                                 ViewNodeAttribute& attribute,
@@ -130,6 +140,9 @@ private:
 
     void updateAttributeHandlers();
 
+    template<typename F>
+    Result<Void> forEachProcessedViewLayoutAttribute(F&& visitor);
+
     const AttributeHandler* getAttributeHandler(AttributeId id) const;
 };
 } // namespace Valdi
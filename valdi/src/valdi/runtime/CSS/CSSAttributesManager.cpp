@@ -20,6 +20,14 @@ struct CSSNodeContainer {
     Ref<CSSDocument> cssDocument;
 };
 
+// Changes are only recorded to be matched against the document on the next CSS update
+static bool discardChangesWithoutDocument(CSSNodeContainer& nodeContainer, bool changed) {
+    if (changed && nodeContainer.cssDocument == nullptr) {
+        nodeContainer.node.clearPendingChanges();
+    }
+    return changed;
+}
+
 CSSAttributesManager::CSSAttributesManager() = default;
 
 CSSAttributesManager::~CSSAttributesManager() = default;
@@ -142,21 +150,41 @@ void CSSAttributesManager::applyAttributesOfStyle(const Ref<CSSAttributes>& cssA
     }
 }
 
-void CSSAttributesManager::updateCSS(const CSSAttributesManagerUpdateContext& context) {
-    if (_cssNodeContainerFromParentOveridde != nullptr && _cssNodeContainerFromParentOveridde->cssDocument != nullptr) {
-        _cssNodeContainerFromParentOveridde->node.applyCss(context.viewTransactionScope,
-                                                           *_cssNodeContainerFromParentOveridde->cssDocument,
-                                                           context.attributesApplier,
-                                                           context.animator);
+bool CSSAttributesManager::updateCSS(const CSSAttributesManagerUpdateContext& context, bool ancestorsChanged) {
+    auto affectsDescendants = false;
+
+    if (_cssNodeContainerFromParentOveridde != nullptr) {
+        affectsDescendants |= updateCSS(*_cssNodeContainerFromParentOveridde, context, ancestorsChanged);
+    }
+    if (_cssNodeContainer != nullptr) {
+        affectsDescendants |= updateCSS(*_cssNodeContainer, context, ancestorsChanged);
+    }
+
+    return affectsDescendants;
+}
+
+bool CSSAttributesManager::updateCSS(CSSNodeContainer& nodeContainer,
+                                     const CSSAttributesManagerUpdateContext& context,
+                                     bool ancestorsChanged) {
+    if (ancestorsChanged) {
+        nodeContainer.node.invalidateAncestorFilter();
     }
-    if (_cssNodeContainer != nullptr && _cssNodeContainer->cssDocument != nullptr) {
-        _cssNodeContainer->node.applyCss(
-            context.viewTransactionScope, *_cssNodeContainer->cssDocument, context.attributesApplier, context.animator);
+
+    if (nodeContainer.cssDocument == nullptr) {
+        return false;
     }
+
+    auto affectsDescendants = nodeContainer.node.changesAffectDescendants(*nodeContainer.cssDocument);
+
+    nodeContainer.node.applyCss(
+        context.viewTransactionScope, *nodeContainer.cssDocument, context.attributesApplier, context.animator);
+
+    return affectsDescendants;
 }
 
 bool CSSAttributesManager::setCSSClass(const Value& cssClass, bool isOverridenFromParent) {
-    return getCSSNodeContainer(isOverridenFromParent).node.setClass(cssClass.toStringBox());
+    auto& nodeContainer = getCSSNodeContainer(isOverridenFromParent);
+    return discardChangesWithoutDocument(nodeContainer, nodeContainer.node.setClass(cssClass.toStringBox()));
 }
 
 bool CSSAttributesManager::setCSSDocument(const Value& cssDocument, bool isOverridenFromParent) {
@@ -169,21 +197,27 @@ bool CSSAttributesManager::setCSSDocument(const Value& cssDocument, bool isOverr
     }
 
     nodeContainer.cssDocument = std::move(cssDocumentNative);
+    nodeContainer.node.invalidateDescendants();
+    nodeContainer.node.invalidateAncestorFilter();
+
     if (nodeContainer.cssDocument != nullptr) {
         nodeContainer.node.setMonitoredCssAttributes(nodeContainer.cssDocument->getMonitoredAttributes());
     } else {
         nodeContainer.node.setMonitoredCssAttributes(nullptr);
+        nodeContainer.node.clearPendingChanges();
     }
 
     return true;
 }
 
 bool CSSAttributesManager::setElementTag(const StringBox& elementTag, bool isOverridenFromParent) {
-    return getCSSNodeContainer(isOverridenFromParent).node.setTagName(elementTag);
+    auto& nodeContainer = getCSSNodeContainer(isOverridenFromParent);
+    return discardChangesWithoutDocument(nodeContainer, nodeContainer.node.setTagName(elementTag));
 }
 
 bool CSSAttributesManager::setElementId(const StringBox& elementId, bool isOverridenFromParent) {
-    return getCSSNodeContainer(isOverridenFromParent).node.setNodeId(elementId);
+    auto& nodeContainer = getCSSNodeContainer(isOverridenFromParent);
+    return discardChangesWithoutDocument(nodeContainer, nodeContainer.node.setNodeId(elementId));
 }
 
 CSSNodeContainer* CSSAttributesManager::getCSSNodeContainerForDocument(const CSSDocument* cssDocument) const {
@@ -216,24 +250,43 @@ void CSSAttributesManager::copyCSSDocument(const CSSAttributesManager& other) {
 }
 
 void CSSAttributesManager::setParent(CSSAttributesManager* attributesManagerOfParent) {
-    _attributesManagerOfParent = attributesManagerOfParent;
+    if (_attributesManagerOfParent != attributesManagerOfParent) {
+        _attributesManagerOfParent = attributesManagerOfParent;
+
+        if (_cssNodeContainer != nullptr) {
+            _cssNodeContainer->node.invalidateAncestorFilter();
+        }
+        if (_cssNodeContainerFromParentOveridde != nullptr) {
+            _cssNodeContainerFromParentOveridde->node.invalidateAncestorFilter();
+        }
+    }
 }
 
 bool CSSAttributesManager::setSiblingsIndexes(int siblingsCount, int indexAmongSiblings) {
     auto changed = false;
 
     if (_cssNodeContainer != nullptr) {
-        changed |= _cssNodeContainer->node.setSiblingsCount(siblingsCount);
-        changed |= _cssNodeContainer->node.setIndexAmongSiblings(indexAmongSiblings);
+        changed |= setSiblingsIndexes(*_cssNodeContainer, siblingsCount, indexAmongSiblings);
     }
     if (_cssNodeContainerFromParentOveridde != nullptr) {
-        changed |= _cssNodeContainerFromParentOveridde->node.setSiblingsCount(siblingsCount);
-        changed |= _cssNodeContainerFromParentOveridde->node.setIndexAmongSiblings(indexAmongSiblings);
+        changed |= setSiblingsIndexes(*_cssNodeContainerFromParentOveridde, siblingsCount, indexAmongSiblings);
     }
 
     return changed;
 }
 
+bool CSSAttributesManager::setSiblingsIndexes(CSSNodeContainer& nodeContainer,
+                                              int siblingsCount,
+                                              int indexAmongSiblings) {
+    auto changed = nodeContainer.node.setSiblingsCount(siblingsCount);
+    changed |= nodeContainer.node.setIndexAmongSiblings(indexAmongSiblings);
+    discardChangesWithoutDocument(nodeContainer, changed);
+
+    // The sibling indexes only matter to documents with first-child, last-child or nth-child rules
+    return changed && nodeContainer.cssDocument != nullptr &&
+           nodeContainer.cssDocument->getInvalidationFeatures().hasStructuralRules;
+}
+
 StringBox CSSAttributesManager::getNodeId() const {
     if (_cssNodeContainer != nullptr) {
         return _cssNodeContainer->node.getNodeId();
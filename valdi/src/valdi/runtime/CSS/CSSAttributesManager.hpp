@@ -61,9 +61,12 @@ public:
     bool apply(const Value& style, const CSSAttributesManagerUpdateContext& context);
 
     /**
-     Do a CSS update pass using the given animator.
+     Do a CSS update pass using the given animator. ancestorsChanged should be set when
+     the update is caused by a change on the ancestors of the node.
+     Returns whether the changes that were applied can change the CSS rules
+     matched by the descendants, in which case they need to be updated as well.
      */
-    void updateCSS(const CSSAttributesManagerUpdateContext& context);
+    bool updateCSS(const CSSAttributesManagerUpdateContext& context, bool ancestorsChanged);
 
     Shared<CSSDocument> getCSSDocument() const;
 
@@ -108,6 +111,11 @@ private:
 
     CSSNodeContainer& getCSSNodeContainer(bool isOverridenFromParent);
     CSSNodeContainer* getCSSNodeContainerForDocument(const CSSDocument* document) const;
+
+    static bool updateCSS(CSSNodeContainer& nodeContainer,
+                          const CSSAttributesManagerUpdateContext& context,
+                          bool ancestorsChanged);
+    static bool setSiblingsIndexes(CSSNodeContainer& nodeContainer, int siblingsCount, int indexAmongSiblings);
 };
 
 } // namespace Valdi
@@ -0,0 +1,87 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "valdi_core/cpp/Utils/StringBox.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Valdi {
+
+/**
+ A fixed size bloom filter of the ids, classes and tags of CSS nodes.
+ It lets the CSS matching reject descendant selectors whose ancestor keys
+ cannot be found in the ancestry of a node, without walking the ancestors.
+ Keys are added as hashes, each of them setting two bits of the filter.
+ */
+class CSSBloomFilter {
+public:
+    static uint32_t hashId(const StringBox& nodeId) {
+        return hashKey(nodeId, 0x9e3779b9);
+    }
+
+    static uint32_t hashClass(const StringBox& cssClass) {
+        return hashKey(cssClass, 0x85ebca6b);
+    }
+
+    static uint32_t hashTag(const StringBox& tagName) {
+        return hashKey(tagName, 0xc2b2ae35);
+    }
+
+    void add(uint32_t hash) {
+        setBit(hash);
+        setBit(hash >> kBitsPerKeyShift);
+    }
+
+    bool mayContain(uint32_t hash) const {
+        return hasBit(hash) && hasBit(hash >> kBitsPerKeyShift);
+    }
+
+    bool mayContainAny(const std::vector<uint32_t>& hashes) const {
+        for (auto hash : hashes) {
+            if (mayContain(hash)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void merge(const CSSBloomFilter& other) {
+        for (size_t i = 0; i < kWordsCount; i++) {
+            _words[i] |= other._words[i];
+        }
+    }
+
+    void clear() {
+        _words.fill(0);
+    }
+
+private:
+    static constexpr size_t kBitsCount = 512;
+    static constexpr size_t kWordsCount = kBitsCount / 64;
+    static constexpr uint32_t kBitsPerKeyShift = 9;
+
+    std::array<uint64_t, kWordsCount> _words = {};
+
+    static uint32_t hashKey(const StringBox& key, uint32_t seed) {
+        auto hash = static_cast<uint32_t>(key.hash()) ^ seed;
+        hash ^= hash >> 16;
+        hash *= 0x7feb352d;
+        hash ^= hash >> 15;
+        return hash;
+    }
+
+    void setBit(uint32_t hash) {
+        auto bit = hash % kBitsCount;
+        _words[bit / 64] |= (static_cast<uint64_t>(1) << (bit % 64));
+    }
+
+    bool hasBit(uint32_t hash) const {
+        auto bit = hash % kBitsCount;
+        return (_words[bit / 64] & (static_cast<uint64_t>(1) << (bit % 64))) != 0;
+    }
+};
+
+} // namespace Valdi
@@ -14,7 +14,7 @@ namespace Valdi {
 
 CSSDocument::CSSDocument(const ResourceId& resourceId, const Valdi::StyleNode& styleNode, AttributeIds& attributeIds)
     : _resourceId(resourceId) {
-    populateStyleNode(attributeIds, styleNode, _rootNode);
+    populateStyleNode(attributeIds, styleNode, _rootNode, false);
 }
 
 CSSDocument::~CSSDocument() = default;
@@ -23,6 +23,54 @@ const MonitoredCssAttributesPtr& CSSDocument::getMonitoredAttributes() const {
     return _monitoredCssAttributes;
 }
 
+const CSSInvalidationFeatures& CSSDocument::getInvalidationFeatures() const {
+    return _invalidationFeatures;
+}
+
+static void visitStyleDeclarations(const CSSProcessedRuleIndex& ruleIndex,
+                                   const Function<void(const CSSStyleDeclaration&)>& callback);
+
+static void visitStyleDeclarations(const CSSStyleNode& styleNode,
+                                   const Function<void(const CSSStyleDeclaration&)>& callback) {
+    for (const auto& style : styleNode.styles) {
+        callback(style);
+    }
+    if (styleNode.ruleIndex != nullptr) {
+        visitStyleDeclarations(*styleNode.ruleIndex, callback);
+    }
+}
+
+static void visitStyleDeclarations(const CSSProcessedRuleIndex& ruleIndex,
+                                   const Function<void(const CSSStyleDeclaration&)>& callback) {
+    for (const auto* rules : {&ruleIndex.idRules, &ruleIndex.classRules, &ruleIndex.tagRules}) {
+        for (const auto& it : *rules) {
+            visitStyleDeclarations(it.second, callback);
+        }
+    }
+    for (const auto& attributeRule : ruleIndex.attributeRules) {
+        visitStyleDeclarations(attributeRule.styleNode, callback);
+    }
+    if (ruleIndex.firstChildRule != nullptr) {
+        visitStyleDeclarations(*ruleIndex.firstChildRule, callback);
+    }
+    if (ruleIndex.lastChildRule != nullptr) {
+        visitStyleDeclarations(*ruleIndex.lastChildRule, callback);
+    }
+    for (const auto& nthChildRule : ruleIndex.nthChildRules) {
+        visitStyleDeclarations(nthChildRule.node, callback);
+    }
+    if (ruleIndex.ancestorRules != nullptr) {
+        visitStyleDeclarations(*ruleIndex.ancestorRules, callback);
+    }
+    if (ruleIndex.directParentRules != nullptr) {
+        visitStyleDeclarations(*ruleIndex.directParentRules, callback);
+    }
+}
+
+void CSSDocument::forEachStyleDeclaration(const Function<void(const CSSStyleDeclaration&)>& callback) const {
+    visitStyleDeclarations(_rootNode, callback);
+}
+
 Value valueFromNodeAttribute(const Valdi::NodeAttribute& attribute) {
     switch (attribute.type()) {
         case Valdi::NodeAttribute_Type_NODE_ATTRIBUTE_TYPE_DOUBLE:
@@ -52,7 +100,8 @@ void CSSDocument::populateStyleDeclaration(AttributeIds& attributeIds,
 
 void CSSDocument::populateStyleNode(AttributeIds& attributeIds,
                                     const Valdi::StyleNode& styleNode,
-                                    CSSStyleNode& currentNode) {
+                                    CSSStyleNode& currentNode,
+                                    bool isAncestorRule) {
     for (const auto& decl : styleNode.styles()) {
         auto& newStyle = currentNode.styles.emplace_back();
         populateStyleDeclaration(attributeIds, decl, newStyle);
@@ -60,26 +109,57 @@ void CSSDocument::populateStyleNode(AttributeIds& attributeIds,
 
     if (styleNode.has_ruleindex()) {
         currentNode.ruleIndex = std::make_unique<CSSProcessedRuleIndex>();
-        populateRuleIndex(attributeIds, styleNode.ruleindex(), *currentNode.ruleIndex);
+        populateRuleIndex(attributeIds, styleNode.ruleindex(), *currentNode.ruleIndex, isAncestorRule);
     }
 }
 
 void CSSDocument::populateMapRule(AttributeIds& attributeIds,
                                   const google::protobuf::RepeatedPtrField<::Valdi::NamedStyleNode>& mapRule,
-                                  FlatMap<StringBox, CSSStyleNode>& currentMap) {
+                                  FlatMap<StringBox, CSSStyleNode>& currentMap,
+                                  bool isAncestorRule) {
     for (const auto& it : mapRule) {
         auto key = StringCache::getGlobal().makeString(it.name());
         auto outIt = currentMap.try_emplace(key);
-        populateStyleNode(attributeIds, it.node(), outIt.first->second);
+        populateStyleNode(attributeIds, it.node(), outIt.first->second, isAncestorRule);
+    }
+}
+
+void CSSDocument::populateKeyHashes(CSSProcessedRuleIndex& currentRuleIndex, bool isAncestorRule) {
+    static auto kWildcardRule = STRING_LITERAL("*");
+
+    auto& keyHashes = currentRuleIndex.keyHashes;
+    keyHashes.reserve(currentRuleIndex.idRules.size() + currentRuleIndex.classRules.size() +
+                      currentRuleIndex.tagRules.size());
+
+    for (const auto& it : currentRuleIndex.idRules) {
+        keyHashes.emplace_back(CSSBloomFilter::hashId(it.first));
+    }
+    for (const auto& it : currentRuleIndex.classRules) {
+        keyHashes.emplace_back(CSSBloomFilter::hashClass(it.first));
+    }
+    for (const auto& it : currentRuleIndex.tagRules) {
+        if (it.first == kWildcardRule) {
+            currentRuleIndex.canMatchWithoutKey = true;
+        } else {
+            keyHashes.emplace_back(CSSBloomFilter::hashTag(it.first));
+        }
+    }
+
+    if (isAncestorRule) {
+        for (auto keyHash : keyHashes) {
+            _invalidationFeatures.ancestorKeys.add(keyHash);
+        }
     }
 }
 
 void CSSDocument::populateRuleIndex(AttributeIds& attributeIds,
                                     const Valdi::CSSRuleIndex& ruleIndex,
-                                    CSSProcessedRuleIndex& currentRuleIndex) {
-    populateMapRule(attributeIds, ruleIndex.id_rules(), currentRuleIndex.idRules);
-    populateMapRule(attributeIds, ruleIndex.class_rules(), currentRuleIndex.classRules);
-    populateMapRule(attributeIds, ruleIndex.tag_rules(), currentRuleIndex.tagRules);
+                                    CSSProcessedRuleIndex& currentRuleIndex,
+                                    bool isAncestorRule) {
+    populateMapRule(attributeIds, ruleIndex.id_rules(), currentRuleIndex.idRules, isAncestorRule);
+    populateMapRule(attributeIds, ruleIndex.class_rules(), currentRuleIndex.classRules, isAncestorRule);
+    populateMapRule(attributeIds, ruleIndex.tag_rules(), currentRuleIndex.tagRules, isAncestorRule);
+    populateKeyHashes(currentRuleIndex, isAncestorRule);
 
     for (const auto& attributeRule : ruleIndex.attribute_rules()) {
         auto& newAttributeRule = currentRuleIndex.attributeRules.emplace_back();
@@ -94,35 +174,53 @@ void CSSDocument::populateRuleIndex(AttributeIds& attributeIds,
         }
         _monitoredCssAttributes->emplace(newAttributeRule.attribute.id);
 
-        populateStyleNode(attributeIds, attributeRule.node(), newAttributeRule.styleNode);
+        populateStyleNode(attributeIds, attributeRule.node(), newAttributeRule.styleNode, isAncestorRule);
     }
 
     if (ruleIndex.has_first_child_rule()) {
         currentRuleIndex.firstChildRule = std::make_unique<CSSStyleNode>();
-        populateStyleNode(attributeIds, ruleIndex.first_child_rule(), *currentRuleIndex.firstChildRule);
+        populateStyleNode(
+            attributeIds, ruleIndex.first_child_rule(), *currentRuleIndex.firstChildRule, isAncestorRule);
     }
 
     if (ruleIndex.has_last_child_rule()) {
         currentRuleIndex.lastChildRule = std::make_unique<CSSStyleNode>();
-        populateStyleNode(attributeIds, ruleIndex.last_child_rule(), *currentRuleIndex.lastChildRule);
+        populateStyleNode(attributeIds, ruleIndex.last_child_rule(), *currentRuleIndex.lastChildRule, isAncestorRule);
     }
 
     for (const auto& nthChildRule : ruleIndex.nth_child_rules()) {
         auto& newRule = currentRuleIndex.nthChildRules.emplace_back();
         newRule.n = static_cast<int>(nthChildRule.n());
         newRule.offset = static_cast<int>(nthChildRule.offset());
-        populateStyleNode(attributeIds, nthChildRule.node(), newRule.node);
+        populateStyleNode(attributeIds, nthChildRule.node(), newRule.node, isAncestorRule);
+    }
+
+    auto hasAttributeRules = !currentRuleIndex.attributeRules.empty();
+    auto hasStructuralRules = currentRuleIndex.firstChildRule != nullptr ||
+                              currentRuleIndex.lastChildRule != nullptr || !currentRuleIndex.nthChildRules.empty();
+
+    if (hasStructuralRules) {
+        _invalidationFeatures.hasStructuralRules = true;
+    }
+    if (isAncestorRule) {
+        _invalidationFeatures.ancestorsUseStructuralRules |= hasStructuralRules;
+        _invalidationFeatures.ancestorsUseAttributeRules |= hasAttributeRules;
     }
 
     if (ruleIndex.has_direct_parent_rules()) {
         currentRuleIndex.directParentRules = std::make_unique<CSSProcessedRuleIndex>();
-        populateRuleIndex(attributeIds, ruleIndex.direct_parent_rules(), *currentRuleIndex.directParentRules);
+        populateRuleIndex(attributeIds, ruleIndex.direct_parent_rules(), *currentRuleIndex.directParentRules, true);
     }
 
     if (ruleIndex.has_ancestor_rules()) {
         currentRuleIndex.ancestorRules = std::make_unique<CSSProcessedRuleIndex>();
-        populateRuleIndex(attributeIds, ruleIndex.ancestor_rules(), *currentRuleIndex.ancestorRules);
+        populateRuleIndex(attributeIds, ruleIndex.ancestor_rules(), *currentRuleIndex.ancestorRules, true);
     }
+
+    // Those rules are matched from the node itself or from its ancestors, regardless of its keys
+    currentRuleIndex.canMatchWithoutKey |= hasAttributeRules || hasStructuralRules ||
+                                           currentRuleIndex.directParentRules != nullptr ||
+                                           currentRuleIndex.ancestorRules != nullptr;
 }
 
 const CSSStyleNode& CSSDocument::getRootNode() const {
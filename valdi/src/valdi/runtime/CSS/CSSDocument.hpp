@@ -8,11 +8,13 @@
 #pragma once
 
 #include "valdi/runtime/CSS/CSSAttributes.hpp"
+#include "valdi/runtime/CSS/CSSBloomFilter.hpp"
 #include "valdi/valdi.pb.h"
 #include "valdi_core/cpp/Resources/ResourceId.hpp"
 #include "valdi_core/cpp/Utils/Bytes.hpp"
 #include "valdi_core/cpp/Utils/FlatMap.hpp"
 #include "valdi_core/cpp/Utils/FlatSet.hpp"
+#include "valdi_core/cpp/Utils/Function.hpp"
 #include "valdi_core/cpp/Utils/Result.hpp"
 #include "valdi_core/cpp/Utils/StringBox.hpp"
 #include "valdi_core/cpp/Utils/ValdiObject.hpp"
@@ -53,6 +55,27 @@ struct CSSProcessedRuleIndex {
     std::vector<CSSNthChildRule> nthChildRules;
     std::unique_ptr<CSSProcessedRuleIndex> ancestorRules;
     std::unique_ptr<CSSProcessedRuleIndex> directParentRules;
+
+    // Hashes of the ids, classes and tags of idRules, classRules and tagRules,
+    // used to reject this index against the ancestor bloom filter of a node.
+    std::vector<uint32_t> keyHashes;
+    // Whether a node can match this index without having any of the keys in keyHashes
+    bool canMatchWithoutKey = false;
+};
+
+/**
+ Describes which changes on a node can change the rules matched by its descendants,
+ so that a CSS pass only restyles the subtree of a node when it needs to.
+ */
+struct CSSInvalidationFeatures {
+    // Keys matched against the ancestors of a node, from descendant and child selectors
+    CSSBloomFilter ancestorKeys;
+    // Whether the document has first-child, last-child or nth-child rules
+    bool hasStructuralRules = false;
+    // Whether structural rules are matched against the ancestors of a node
+    bool ancestorsUseStructuralRules = false;
+    // Whether attribute rules are matched against the ancestors of a node
+    bool ancestorsUseAttributeRules = false;
 };
 
 using MonitoredCssAttributesPtr = std::shared_ptr<FlatSet<AttributeId>>;
@@ -64,6 +87,13 @@ public:
 
     const CSSStyleNode& getRootNode() const;
     const MonitoredCssAttributesPtr& getMonitoredAttributes() const;
+    const CSSInvalidationFeatures& getInvalidationFeatures() const;
+
+    /**
+     Calls the given callback with every style declaration of the document,
+     regardless of the rules they belong to.
+     */
+    void forEachStyleDeclaration(const Function<void(const CSSStyleDeclaration&)>& callback) const;
 
     Result<Ref<CSSAttributes>> getAttributesForClass(const StringBox& className) const;
 
@@ -79,18 +109,25 @@ private:
     ResourceId _resourceId;
     CSSStyleNode _rootNode;
     MonitoredCssAttributesPtr _monitoredCssAttributes;
+    CSSInvalidationFeatures _invalidationFeatures;
 
-    void populateStyleNode(AttributeIds& attributeIds, const Valdi::StyleNode& styleNode, CSSStyleNode& currentNode);
+    void populateStyleNode(AttributeIds& attributeIds,
+                           const Valdi::StyleNode& styleNode,
+                           CSSStyleNode& currentNode,
+                           bool isAncestorRule);
     void populateRuleIndex(AttributeIds& attributeIds,
                            const Valdi::CSSRuleIndex& ruleIndex,
-                           CSSProcessedRuleIndex& currentRuleIndex);
+                           CSSProcessedRuleIndex& currentRuleIndex,
+                           bool isAncestorRule);
+    void populateKeyHashes(CSSProcessedRuleIndex& currentRuleIndex, bool isAncestorRule);
     static void populateStyleDeclaration(AttributeIds& attributeIds,
                                          const Valdi::StyleDeclaration& styleDeclaration,
                                          CSSStyleDeclaration& currentStyleDeclaration);
 
     void populateMapRule(AttributeIds& attributeIds,
                          const google::protobuf::RepeatedPtrField<::Valdi::NamedStyleNode>& mapRule,
-                         FlatMap<StringBox, CSSStyleNode>& currentMap);
+                         FlatMap<StringBox, CSSStyleNode>& currentMap,
+                         bool isAncestorRule);
 };
 
 } // namespace Valdi
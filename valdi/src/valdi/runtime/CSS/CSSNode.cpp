@@ -67,10 +67,25 @@ bool CSSNode::setClass(const StringBox& cssClass) {
     }
 
     _cssClass = cssClass;
+
+    FlatSet<StringBox> previousCssClasses = std::move(_resolvedCssClasses);
     _resolvedCssClasses.clear();
 
     forEachCSSClass(cssClass, [&](StringBox cssClass) { _resolvedCssClasses.emplace(std::move(cssClass)); });
 
+    for (const auto& previousCssClass : previousCssClasses) {
+        if (_resolvedCssClasses.find(previousCssClass) == _resolvedCssClasses.end()) {
+            onKeyChanged(CSSBloomFilter::hashClass(previousCssClass));
+        }
+    }
+    for (const auto& resolvedCssClass : _resolvedCssClasses) {
+        if (previousCssClasses.find(resolvedCssClass) == previousCssClasses.end()) {
+            onKeyChanged(CSSBloomFilter::hashClass(resolvedCssClass));
+        }
+    }
+
+    updateKeysFilter();
+
     return true;
 }
 
@@ -78,7 +93,15 @@ bool CSSNode::setNodeId(const StringBox& nodeId) {
     if (_nodeId == nodeId) {
         return false;
     }
+    if (!_nodeId.isEmpty()) {
+        onKeyChanged(CSSBloomFilter::hashId(_nodeId));
+    }
+    if (!nodeId.isEmpty()) {
+        onKeyChanged(CSSBloomFilter::hashId(nodeId));
+    }
+
     _nodeId = nodeId;
+    updateKeysFilter();
     return true;
 }
 
@@ -90,10 +113,81 @@ bool CSSNode::setTagName(const StringBox& tagName) {
     if (_tagName == tagName) {
         return false;
     }
+    if (!_tagName.isEmpty()) {
+        onKeyChanged(CSSBloomFilter::hashTag(_tagName));
+    }
+    if (!tagName.isEmpty()) {
+        onKeyChanged(CSSBloomFilter::hashTag(tagName));
+    }
+
     _tagName = tagName;
+    updateKeysFilter();
     return true;
 }
 
+void CSSNode::onKeyChanged(uint32_t keyHash) {
+    _changedKeyHashes.emplace_back(keyHash);
+}
+
+void CSSNode::updateKeysFilter() {
+    _keysFilter.clear();
+
+    if (!_nodeId.isEmpty()) {
+        _keysFilter.add(CSSBloomFilter::hashId(_nodeId));
+    }
+    if (!_tagName.isEmpty()) {
+        _keysFilter.add(CSSBloomFilter::hashTag(_tagName));
+    }
+    for (const auto& cssClass : _resolvedCssClasses) {
+        _keysFilter.add(CSSBloomFilter::hashClass(cssClass));
+    }
+}
+
+void CSSNode::invalidateAncestorFilter() {
+    _ancestorFilterValid = false;
+}
+
+const CSSBloomFilter& CSSNode::getAncestorFilter(const CSSDocument& cssDocument) {
+    // The filters of the descendants are invalidated as they get restyled after a change
+    // of keys which can be matched by ancestor rules, or after a change of ancestors.
+    // Keys which are not matched by any ancestor rule can be stale, since they are never looked up.
+    if (!_ancestorFilterValid) {
+        _ancestorFilter.clear();
+
+        auto* parent = resolveParent(cssDocument);
+        if (parent != nullptr) {
+            _ancestorFilter.merge(parent->getAncestorFilter(cssDocument));
+            _ancestorFilter.merge(parent->_keysFilter);
+        }
+
+        _ancestorFilterValid = true;
+    }
+
+    return _ancestorFilter;
+}
+
+bool CSSNode::changesAffectDescendants(const CSSDocument& cssDocument) const {
+    if (_descendantsInvalidated) {
+        return true;
+    }
+
+    const auto& features = cssDocument.getInvalidationFeatures();
+    if (_siblingsChanged && features.ancestorsUseStructuralRules) {
+        return true;
+    }
+    if (_monitoredAttributeChanged && features.ancestorsUseAttributeRules) {
+        return true;
+    }
+
+    return std::any_of(_changedKeyHashes.begin(), _changedKeyHashes.end(), [&](uint32_t keyHash) {
+        return features.ancestorKeys.mayContain(keyHash);
+    });
+}
+
+void CSSNode::invalidateDescendants() {
+    _descendantsInvalidated = true;
+}
+
 void CSSNode::setIsManagingRootOfChildTree(bool managingRootOfChildTree) {
     _managingRootOfChildTree = managingRootOfChildTree;
 }
@@ -115,7 +209,12 @@ bool CSSNode::isMonitoredAttribute(AttributeId attribute) const {
 }
 
 bool CSSNode::attributeChanged(AttributeId attribute) {
-    return isMonitoredAttribute(attribute);
+    if (!isMonitoredAttribute(attribute)) {
+        return false;
+    }
+
+    _monitoredAttributeChanged = true;
+    return true;
 }
 
 int CSSNode::getIndexAmongSiblings() const {
@@ -128,6 +227,7 @@ bool CSSNode::setIndexAmongSiblings(int index) {
     }
 
     _indexAmongSiblings = index;
+    _siblingsChanged = true;
     return true;
 }
 
@@ -137,6 +237,7 @@ bool CSSNode::setSiblingsCount(int count) {
     }
 
     _siblingsCount = count;
+    _siblingsChanged = true;
     return true;
 }
 
@@ -279,11 +380,15 @@ void CSSNode::insertDeclarations(const CSSDocument& cssDocument,
     }
 
     if (ruleIndex.ancestorRules != nullptr) {
-        auto* ancestor = resolveParent(cssDocument);
-        while (ancestor != nullptr) {
-            ancestor->insertDeclarations(
-                cssDocument, *ruleIndex.ancestorRules, attributesApplier, bestStyleDeclarationByKey);
-            ancestor = ancestor->resolveParent(cssDocument);
+        const auto& ancestorRules = *ruleIndex.ancestorRules;
+
+        // Skip walking the ancestors when none of them can have a key matched by the rules
+        if (ancestorRules.canMatchWithoutKey || getAncestorFilter(cssDocument).mayContainAny(ancestorRules.keyHashes)) {
+            auto* ancestor = resolveParent(cssDocument);
+            while (ancestor != nullptr) {
+                ancestor->insertDeclarations(cssDocument, ancestorRules, attributesApplier, bestStyleDeclarationByKey);
+                ancestor = ancestor->resolveParent(cssDocument);
+            }
         }
     }
 }
@@ -322,6 +427,15 @@ void CSSNode::applyCss(ViewTransactionScope& viewTransactionScope,
         setAttributeFromDeclaration(viewTransactionScope, property, attributesApplier, tuple.second, animator);
     }
     _lastStyleDeclarations = std::move(bestStyleDeclarationByKey);
+
+    clearPendingChanges();
+}
+
+void CSSNode::clearPendingChanges() {
+    _changedKeyHashes.clear();
+    _siblingsChanged = false;
+    _monitoredAttributeChanged = false;
+    _descendantsInvalidated = false;
 }
 
 CSSNode* CSSNode::resolveParent(const CSSDocument& cssDocument) const {
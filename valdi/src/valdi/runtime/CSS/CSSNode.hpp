@@ -14,11 +14,13 @@
 #include "valdi/runtime/Attributes/Animator.hpp"
 #include "valdi/runtime/Attributes/AttributeIds.hpp"
 #include "valdi/runtime/Attributes/AttributeOwner.hpp"
+#include "valdi/runtime/CSS/CSSBloomFilter.hpp"
 #include "valdi/runtime/CSS/CSSDocument.hpp"
 #include "valdi/runtime/CSS/CSSNodeParentResolver.hpp"
 #include "valdi/valdi.pb.h"
 #include "valdi_core/cpp/Utils/FlatMap.hpp"
 #include "valdi_core/cpp/Utils/FlatSet.hpp"
+#include "valdi_core/cpp/Utils/SmallVector.hpp"
 #include "valdi_core/cpp/Utils/StringBox.hpp"
 #include "valdi_core/cpp/Utils/Value.hpp"
 
@@ -64,6 +66,30 @@ public:
 
     StringBox getAttributeSource(AttributeId attributeId) const override;
 
+    /**
+     Returns whether the changes made on this node since the last applyCss() can change
+     the rules matched by its descendants in the given document.
+     */
+    bool changesAffectDescendants(const CSSDocument& cssDocument) const;
+
+    /**
+     Marks the rules matched by the descendants of this node as needing to be resolved again,
+     for instance because the document or the parent of the node changed.
+     */
+    void invalidateDescendants();
+
+    /**
+     Forgets the changes made on this node since the last applyCss(), for instance
+     because the node has no document which they could be matched against.
+     */
+    void clearPendingChanges();
+
+    /**
+     Invalidates the cached bloom filter of the keys of the ancestors of this node.
+     Should be called whenever the CSS ancestors of this node or their keys change.
+     */
+    void invalidateAncestorFilter();
+
 private:
     StringBox _tagName;
     StringBox _nodeId;
@@ -75,9 +101,21 @@ private:
 
     std::unique_ptr<FlatMap<AttributeId, const CSSStyleDeclaration*>> _lastStyleDeclarations;
 
+    // Ids, classes and tag of this node
+    CSSBloomFilter _keysFilter;
+    // Ids, classes and tags of all the ancestors of this node, rebuilt lazily when invalidated
+    CSSBloomFilter _ancestorFilter;
+
+    // Keys which were added or removed since the last applyCss()
+    SmallVector<uint32_t, 4> _changedKeyHashes;
+
     int _indexAmongSiblings = 0;
     int _siblingsCount = 0;
     bool _managingRootOfChildTree = false;
+    bool _siblingsChanged = false;
+    bool _monitoredAttributeChanged = false;
+    bool _descendantsInvalidated = false;
+    bool _ancestorFilterValid = false;
 
     void insertDeclarations(const CSSDocument& cssDocument,
                             const CSSStyleNode& styleNode,
@@ -98,6 +136,10 @@ private:
 
     CSSNode* resolveParent(const CSSDocument& cssDocument) const;
 
+    const CSSBloomFilter& getAncestorFilter(const CSSDocument& cssDocument);
+    void updateKeysFilter();
+    void onKeyChanged(uint32_t keyHash);
+
     // Style declaration pooling
 
     static std::unique_ptr<FlatMap<AttributeId, const CSSStyleDeclaration*>> newStyleDeclarationMap();
@@ -13,6 +13,8 @@
 #include "valdi/runtime/Context/ViewManagerContext.hpp"
 #include "valdi/runtime/Metrics/Metrics.hpp"
 #include "valdi/runtime/Rendering/RenderRequest.hpp"
+#include "valdi/runtime/Rendering/RenderRequestMerger.hpp"
+#include "valdi/runtime/Rendering/RenderRequestPreprocessor.hpp"
 #include "valdi/runtime/Runtime.hpp"
 #include "valdi/runtime/Utils/AsyncGroup.hpp"
 #include "valdi_core/cpp/Utils/ContainerUtils.hpp"
@@ -277,6 +279,11 @@ bool Context::runRenderRequest(ContextUpdateId updateId) {
 }
 
 void Context::runNextPendingRenderRequest(std::unique_lock<Mutex>& guard) {
+    if (_pendingRenderRequests.size() > 1) {
+        runAllPendingRenderRequestsMerged(guard);
+        return;
+    }
+
     auto pendingRenderRequest = _pendingRenderRequests.front();
     _pendingRenderRequests.pop_front();
     Ref<Runtime> runtime(_runtime);
@@ -285,6 +292,26 @@ void Context::runNextPendingRenderRequest(std::unique_lock<Mutex>& guard) {
     markUpdateCompleted(pendingRenderRequest.updateId, guard);
 }
 
+void Context::runAllPendingRenderRequestsMerged(std::unique_lock<Mutex>& guard) {
+    // The render requests piled up because the main thread fell behind, render them
+    // all at once instead of replaying every intermediate frame.
+    RenderRequestMerger merger;
+    std::vector<ContextUpdateId> updateIds;
+    updateIds.reserve(_pendingRenderRequests.size());
+    for (const auto& pendingRenderRequest : _pendingRenderRequests) {
+        merger.append(pendingRenderRequest.renderRequest);
+        updateIds.emplace_back(pendingRenderRequest.updateId);
+    }
+    _pendingRenderRequests.clear();
+
+    Ref<Runtime> runtime(_runtime);
+    guard.unlock();
+    runtime->processRenderRequest(merger.merge());
+    for (auto updateId : updateIds) {
+        markUpdateCompleted(updateId, guard);
+    }
+}
+
 bool Context::flushRenderRequests() {
     bool didFlush = false;
     std::unique_lock<Mutex> guard(_mutex);
@@ -302,6 +329,14 @@ bool Context::hasPendingRenderRequests() const {
     return !_pendingRenderRequests.empty();
 }
 
+const Ref<RenderRequestPreprocessor>& Context::getRenderRequestPreprocessor() {
+    if (_renderRequestPreprocessor == nullptr && _viewManagerContext != nullptr) {
+        _renderRequestPreprocessor =
+            makeShared<RenderRequestPreprocessor>(_viewManagerContext->getGlobalViewFactories());
+    }
+    return _renderRequestPreprocessor;
+}
+
 void Context::markUpdateCompleted(ContextUpdateId updateId) {
     std::unique_lock<Mutex> guard(_mutex);
     markUpdateCompleted(updateId, guard);
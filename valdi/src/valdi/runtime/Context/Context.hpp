@@ -37,6 +37,7 @@ class ViewManagerContext;
 
 class Runtime;
 class RenderRequest;
+class RenderRequestPreprocessor;
 
 struct RetainedContext {
     Ref<Context> context;
@@ -117,6 +118,13 @@ public:
     bool flushRenderRequests();
     bool hasPendingRenderRequests() const;
 
+    /**
+     Returns the preprocessor which tracks the render requests of this Context to preprocess
+     their attributes ahead of rendering. Lazily created, this should only be called
+     from the worker queue. Returns null if the Context has no ViewManagerContext.
+     */
+    const Ref<RenderRequestPreprocessor>& getRenderRequestPreprocessor();
+
     void waitUntilAllUpdatesCompleted(const Ref<ValueFunction>& callback);
     void waitUntilAllUpdatesCompletedSync(bool shouldFlushRenderRequests);
 
@@ -171,6 +179,7 @@ private:
     std::vector<Ref<ValueFunction>> _updateCompletedCallbacks;
     Ref<Context> _parentContext;
     std::deque<PendingRenderRequest> _pendingRenderRequests;
+    Ref<RenderRequestPreprocessor> _renderRequestPreprocessor;
 
     bool _created = false;
     bool _destroyed = false;
@@ -183,6 +192,7 @@ private:
     void markUpdateCompleted(ContextUpdateId updateId, std::unique_lock<Mutex>& guard);
 
     void runNextPendingRenderRequest(std::unique_lock<Mutex>& guard);
+    void runAllPendingRenderRequestsMerged(std::unique_lock<Mutex>& guard);
 };
 
 } // namespace Valdi
@@ -0,0 +1,268 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi/runtime/Context/LayoutCache.hpp"
+#include "valdi/runtime/Attributes/Yoga/Yoga.hpp"
+#include "valdi/runtime/Views/MeasureDelegate.hpp"
+
+#include <boost/functional/hash.hpp>
+#include <cmath>
+#include <cstring>
+
+namespace Valdi {
+
+class LayoutCacheEntry : public SimpleRefCountable {
+public:
+    LayoutCacheEntry(LayoutCacheKey&& key, std::vector<YGLayout>&& layouts)
+        : _key(std::move(key)), _layouts(std::move(layouts)) {}
+    ~LayoutCacheEntry() override = default;
+
+    const LayoutCacheKey& getKey() const {
+        return _key;
+    }
+
+    const std::vector<YGLayout>& getLayouts() const {
+        return _layouts;
+    }
+
+private:
+    LayoutCacheKey _key;
+    std::vector<YGLayout> _layouts;
+};
+
+static bool floatEquals(float left, float right) {
+    return left == right || (std::isnan(left) && std::isnan(right));
+}
+
+static void hashFloat(size_t& hash, float value) {
+    // Undefined Yoga values are NaN, which need to hash consistently
+    uint32_t bits = 0x7fc00000;
+    if (!std::isnan(value)) {
+        std::memcpy(&bits, &value, sizeof(bits));
+    }
+    boost::hash_combine(hash, bits);
+}
+
+static void hashYogaValue(size_t& hash, YGValue value) {
+    hashFloat(hash, value.value);
+    boost::hash_combine(hash, static_cast<int>(value.unit));
+}
+
+static void hashYogaStyle(size_t& hash, const YGStyle& style) {
+    boost::hash_combine(hash, static_cast<int>(style.direction()));
+    boost::hash_combine(hash, static_cast<int>(style.flexDirection()));
+    boost::hash_combine(hash, static_cast<int>(style.justifyContent()));
+    boost::hash_combine(hash, static_cast<int>(style.alignItems()));
+    boost::hash_combine(hash, static_cast<int>(style.alignSelf()));
+    boost::hash_combine(hash, static_cast<int>(style.positionType()));
+    boost::hash_combine(hash, static_cast<int>(style.flexWrap()));
+    boost::hash_combine(hash, static_cast<int>(style.display()));
+    hashFloat(hash, style.flexGrow().unwrap());
+    hashFloat(hash, style.flexShrink().unwrap());
+    hashYogaValue(hash, style.flexBasis());
+
+    for (size_t i = 0; i < 2; i++) {
+        auto dimension = static_cast<YGDimension>(i);
+        hashYogaValue(hash, style.dimensions()[dimension]);
+        hashYogaValue(hash, style.minDimensions()[dimension]);
+        hashYogaValue(hash, style.maxDimensions()[dimension]);
+    }
+
+    for (size_t i = 0; i <= static_cast<size_t>(YGEdgeAll); i++) {
+        auto edge = static_cast<YGEdge>(i);
+        hashYogaValue(hash, style.margin()[edge]);
+        hashYogaValue(hash, style.padding()[edge]);
+        hashYogaValue(hash, style.position()[edge]);
+    }
+}
+
+bool LayoutCacheMeasureInput::operator==(const LayoutCacheMeasureInput& other) const {
+    if (measureDelegate != other.measureDelegate || isRightToLeft != other.isRightToLeft ||
+        pointScale != other.pointScale || estimatedWidth != other.estimatedWidth ||
+        estimatedHeight != other.estimatedHeight || attributesHash != other.attributesHash ||
+        environment != other.environment) {
+        return false;
+    }
+
+    if (attributes != nullptr && other.attributes != nullptr) {
+        return *attributes == *other.attributes;
+    }
+    if (viewNode != nullptr && other.attributes != nullptr) {
+        return viewNode->processedViewLayoutAttributesEqual(*other.attributes);
+    }
+    if (other.viewNode != nullptr && attributes != nullptr) {
+        return other.viewNode->processedViewLayoutAttributesEqual(*attributes);
+    }
+
+    return viewNode == other.viewNode && attributes == other.attributes;
+}
+
+size_t LayoutCacheMeasureInput::hash() const {
+    size_t hash = 0;
+    boost::hash_combine(hash, measureDelegate.get());
+    boost::hash_combine(hash, isRightToLeft);
+    hashFloat(hash, pointScale);
+    hashFloat(hash, estimatedWidth);
+    hashFloat(hash, estimatedHeight);
+    boost::hash_combine(hash, attributesHash);
+    boost::hash_combine(hash, environment.hash());
+    return hash;
+}
+
+bool LayoutCacheNodeInput::operator==(const LayoutCacheNodeInput& other) const {
+    return childrenCount == other.childrenCount && measureInput == other.measureInput && style == other.style;
+}
+
+bool LayoutCacheKey::operator==(const LayoutCacheKey& other) const {
+    return hash == other.hash && widthMode == other.widthMode && heightMode == other.heightMode &&
+           direction == other.direction && floatEquals(width, other.width) && floatEquals(height, other.height) &&
+           pointScale == other.pointScale && nodes == other.nodes;
+}
+
+LayoutCache::LayoutCache(size_t capacity) : _entries(capacity) {}
+LayoutCache::~LayoutCache() = default;
+
+static bool appendNodeInputs(YGNode* yogaNode, std::vector<LayoutCacheNodeInput>& nodes, size_t& hash) {
+    if (nodes.size() >= LayoutCache::kMaxSubtreeNodes) {
+        return false;
+    }
+
+    const auto& children = yogaNode->getChildren();
+
+    auto& input = nodes.emplace_back();
+    input.style = yogaNode->getStyle();
+    input.childrenCount = children.size();
+
+    hashYogaStyle(hash, input.style);
+    boost::hash_combine(hash, input.childrenCount);
+
+    if (yogaNode->hasMeasureFunc()) {
+        auto* viewNode = Yoga::getAttachedViewNode(yogaNode);
+        LayoutCacheMeasureInput measureInput;
+        if (viewNode == nullptr || !viewNode->getLayoutCacheMeasureInput(measureInput)) {
+            return false;
+        }
+
+        boost::hash_combine(hash, measureInput.hash());
+        input.measureInput = std::move(measureInput);
+    }
+
+    for (auto* child : children) {
+        if (!appendNodeInputs(child, nodes, hash)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::optional<LayoutCacheKey> LayoutCache::makeKey(YGNode* yogaNode,
+                                                   float width,
+                                                   MeasureMode widthMode,
+                                                   float height,
+                                                   MeasureMode heightMode,
+                                                   LayoutDirection direction) {
+    LayoutCacheKey key;
+    key.width = width;
+    key.widthMode = widthMode;
+    key.height = height;
+    key.heightMode = heightMode;
+    key.direction = direction;
+    key.pointScale = yogaNode->getConfig()->pointScaleFactor;
+
+    size_t hash = 0;
+    if (!appendNodeInputs(yogaNode, key.nodes, hash)) {
+        return std::nullopt;
+    }
+
+    boost::hash_combine(hash, static_cast<int>(widthMode));
+    boost::hash_combine(hash, static_cast<int>(heightMode));
+    boost::hash_combine(hash, static_cast<int>(direction));
+    hashFloat(hash, width);
+    hashFloat(hash, height);
+    hashFloat(hash, key.pointScale);
+    key.hash = hash;
+
+    return {std::move(key)};
+}
+
+static void restoreLayouts(YGNode* yogaNode, const std::vector<YGLayout>& layouts, size_t& index) {
+    yogaNode->setLayout(layouts[index++]);
+    yogaNode->setHasNewLayout(true);
+    yogaNode->setDirty(false);
+
+    for (auto* child : yogaNode->getChildren()) {
+        restoreLayouts(child, layouts, index);
+    }
+}
+
+static void collectLayouts(YGNode* yogaNode, std::vector<YGLayout>& layouts) {
+    layouts.emplace_back(yogaNode->getLayout());
+
+    for (auto* child : yogaNode->getChildren()) {
+        collectLayouts(child, layouts);
+    }
+}
+
+bool LayoutCache::restore(const LayoutCacheKey& key, YGNode* yogaNode) {
+    Ref<LayoutCacheEntry> entry;
+    {
+        std::lock_guard<Mutex> guard(_mutex);
+        auto it = _entries.find(key.hash);
+        if (it == _entries.end() || !(it->value()->getKey() == key)) {
+            _missCount++;
+            return false;
+        }
+
+        _hitCount++;
+        entry = it->value();
+    }
+
+    size_t index = 0;
+    restoreLayouts(yogaNode, entry->getLayouts(), index);
+
+    return true;
+}
+
+void LayoutCache::store(LayoutCacheKey&& key, YGNode* yogaNode) {
+    for (auto& node : key.nodes) {
+        if (!node.measureInput || node.measureInput->viewNode == nullptr) {
+            continue;
+        }
+
+        auto attributes = node.measureInput->viewNode->copyProcessedViewLayoutAttributes();
+        if (!attributes) {
+            return;
+        }
+
+        // Stored keys should not reference nodes, which might be destroyed before the entry
+        node.measureInput->attributes = attributes.moveValue();
+        node.measureInput->viewNode = nullptr;
+    }
+
+    std::vector<YGLayout> layouts;
+    layouts.reserve(key.nodes.size());
+    collectLayouts(yogaNode, layouts);
+
+    auto hash = key.hash;
+    auto entry = makeShared<LayoutCacheEntry>(std::move(key), std::move(layouts));
+
+    std::lock_guard<Mutex> guard(_mutex);
+    _entries.insert(std::move(hash), std::move(entry));
+}
+
+size_t LayoutCache::size() const {
+    std::lock_guard<Mutex> guard(_mutex);
+    return _entries.size();
+}
+
+size_t LayoutCache::getHitCount() const {
+    std::lock_guard<Mutex> guard(_mutex);
+    return _hitCount;
+}
+
+size_t LayoutCache::getMissCount() const {
+    std::lock_guard<Mutex> guard(_mutex);
+    return _missCount;
+}
+
+} // namespace Valdi
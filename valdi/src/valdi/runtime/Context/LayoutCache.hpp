@@ -0,0 +1,125 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "valdi/runtime/Context/ViewNode.hpp"
+#include "valdi/runtime/Views/Measure.hpp"
+#include "valdi_core/cpp/Utils/LRUCache.hpp"
+#include "valdi_core/cpp/Utils/Mutex.hpp"
+#include "valdi_core/cpp/Utils/Shared.hpp"
+#include "valdi_core/cpp/Utils/Value.hpp"
+#include "valdi_core/cpp/Utils/ValueMap.hpp"
+
+#include <optional>
+#include <vector>
+#include <yoga/YGNode.h>
+
+namespace Valdi {
+
+class MeasureDelegate;
+
+/**
+ The inputs which determine how a Yoga node with a measure function measures itself.
+ */
+struct LayoutCacheMeasureInput {
+    Ref<MeasureDelegate> measureDelegate;
+    /**
+     The measured node, only set on keys created for a lookup. Its processed attributes
+     are hashed and compared in place, and are only copied when the key is stored.
+     */
+    ViewNode* viewNode = nullptr;
+    Ref<ValueMap> attributes;
+    size_t attributesHash = 0;
+    /**
+     The state outside of the attributes that the measure delegate depends on.
+     */
+    Value environment;
+    bool isRightToLeft = false;
+    float pointScale = 0;
+    float estimatedWidth = 0;
+    float estimatedHeight = 0;
+
+    bool operator==(const LayoutCacheMeasureInput& other) const;
+    size_t hash() const;
+};
+
+/**
+ The content of a Yoga node which can affect the layout of its subtree.
+ */
+struct LayoutCacheNodeInput {
+    YGStyle style;
+    size_t childrenCount = 0;
+    std::optional<LayoutCacheMeasureInput> measureInput;
+
+    bool operator==(const LayoutCacheNodeInput& other) const;
+};
+
+/**
+ Identifies the layout of a Yoga subtree calculated with a given set of constraints.
+ Holds the content of every node of the subtree in depth first order, so that a lookup
+ can verify that a cached layout was calculated from the same content.
+ */
+struct LayoutCacheKey {
+    std::vector<LayoutCacheNodeInput> nodes;
+    float width = 0;
+    MeasureMode widthMode = MeasureModeUnspecified;
+    float height = 0;
+    MeasureMode heightMode = MeasureModeUnspecified;
+    LayoutDirection direction = LayoutDirectionLTR;
+    float pointScale = 0;
+    size_t hash = 0;
+
+    bool operator==(const LayoutCacheKey& other) const;
+};
+
+class LayoutCacheEntry;
+
+/**
+ A cache of calculated Yoga layouts shared across ViewNodes, which lets a freshly
+ created subtree, like a recycled list cell, reuse the layout of an identical subtree
+ calculated with the same constraints instead of measuring all its nodes again.
+ */
+class LayoutCache : public SimpleRefCountable {
+public:
+    static constexpr size_t kDefaultCapacity = 64;
+    static constexpr size_t kMaxSubtreeNodes = 256;
+
+    explicit LayoutCache(size_t capacity);
+    ~LayoutCache() override;
+
+    /**
+     Creates the key for the layout of the given Yoga subtree.
+     Returns an empty optional if the subtree cannot be cached, for instance
+     because it is too large or has a node measured by a JS callback.
+     */
+    static std::optional<LayoutCacheKey> makeKey(YGNode* yogaNode,
+                                                 float width,
+                                                 MeasureMode widthMode,
+                                                 float height,
+                                                 MeasureMode heightMode,
+                                                 LayoutDirection direction);
+
+    /**
+     Applies the cached layout for the given key on the Yoga subtree.
+     Returns whether a layout was found.
+     */
+    bool restore(const LayoutCacheKey& key, YGNode* yogaNode);
+
+    /**
+     Stores the layout that was calculated on the Yoga subtree for the given key.
+     The processed attributes of the measured nodes are copied into the key.
+     */
+    void store(LayoutCacheKey&& key, YGNode* yogaNode);
+
+    size_t size() const;
+    size_t getHitCount() const;
+    size_t getMissCount() const;
+
+private:
+    mutable Mutex _mutex;
+    LRUCache<size_t, Ref<LayoutCacheEntry>> _entries;
+    size_t _hitCount = 0;
+    size_t _missCount = 0;
+};
+
+} // namespace Valdi
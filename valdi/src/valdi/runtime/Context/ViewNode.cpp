@@ -10,6 +10,7 @@
 #include "valdi/runtime/Attributes/Yoga/Yoga.hpp"
 #include "valdi/runtime/CSS/CSSAttributesManager.hpp"
 #include "valdi/runtime/Context/IViewNodeAssetHandler.hpp"
+#include "valdi/runtime/Context/LayoutCache.hpp"
 #include "valdi/runtime/Context/ViewManagerContext.hpp"
 #include "valdi/runtime/Context/ViewNodeAccessibilityState.hpp"
 #include "valdi/runtime/Context/ViewNodeChildrenIndexer.hpp"
@@ -36,9 +37,13 @@
 #include "utils/debugging/Assert.hpp"
 #include "utils/time/StopWatch.hpp"
 #include "valdi_core/cpp/Utils/ContainerUtils.hpp"
+#include "valdi_core/cpp/Threading/DispatchQueue.hpp"
+#include "valdi_core/cpp/Utils/Mutex.hpp"
+#include <atomic>
 #include <cmath>
 #include <fmt/format.h>
 #include <sstream>
+#include <thread>
 #include <yoga/YGNode.h>
 
 namespace Valdi {
@@ -124,6 +129,7 @@ constexpr size_t kLimitToViewportDisabledFlag = 14;
 constexpr size_t kHasChildWithZIndex = 15;
 constexpr size_t kAnimationsEnabled = 16;
 constexpr size_t kHasParent = 17;
+constexpr size_t kCSSSubtreeNeedsUpdate = 18;
 constexpr size_t kShouldReceiveVisibilityUpdates = 19;
 constexpr size_t kCSSNeedsUpdate = 20;
 constexpr size_t kCSSHasChildNeedsUpdate = 21;
@@ -1316,6 +1322,10 @@ void ViewNode::removeFromParent(ViewTransactionScope& viewTransactionScope) {
     removeViewFromParent(viewTransactionScope);
 
     parent->onChildrenChanged();
+    if (getCSSAttributesManager().needUpdateCSS()) {
+        // The remaining siblings need their indexes updated for first-child, last-child and nth-child rules
+        parent->setCSSHasChildNeedsUpdate();
+    }
     getCSSAttributesManager().setParent(nullptr);
     _parent.reset();
     setHasParent(false);
@@ -1353,6 +1363,8 @@ void ViewNode::insertChildAt(ViewTransactionScope& viewTransactionScope, const R
     child->getCSSAttributesManager().setParent(&getCSSAttributesManager());
 
     if (child->getCSSAttributesManager().needUpdateCSS()) {
+        // The ancestors of the child changed, which can change the rules matched in its whole subtree
+        child->_flags[kCSSSubtreeNeedsUpdate] = true;
         child->setCSSNeedsUpdate();
     }
     if (child->cssNeedsUpdate()) {
@@ -1434,6 +1446,38 @@ Size ViewNode::onMeasure(float width, MeasureMode widthMode, float height, Measu
     }
 }
 
+bool ViewNode::getLayoutCacheMeasureInput(LayoutCacheMeasureInput& output) {
+    if (_lazyLayoutData != nullptr && _lazyLayoutData->onMeasureCallback != nullptr) {
+        return false;
+    }
+
+    output.isRightToLeft = isRightToLeft();
+    output.pointScale = getPointScale();
+
+    const auto& boundAttributes = _attributesApplier.getBoundAttributes();
+    if (boundAttributes != nullptr && boundAttributes->getMeasureDelegate() != nullptr) {
+        const auto& measureDelegate = boundAttributes->getMeasureDelegate();
+        if (!measureDelegate->canCacheMeasurement()) {
+            return false;
+        }
+
+        auto attributesHash = _attributesApplier.hashProcessedViewLayoutAttributes();
+        if (!attributesHash) {
+            return false;
+        }
+
+        output.measureDelegate = measureDelegate;
+        output.viewNode = this;
+        output.attributesHash = attributesHash.value();
+        output.environment = measureDelegate->getMeasurementCacheEnvironment();
+    } else if (_lazyLayoutData != nullptr) {
+        output.estimatedWidth = _lazyLayoutData->estimatedWidth;
+        output.estimatedHeight = _lazyLayoutData->estimatedHeight;
+    }
+
+    return true;
+}
+
 Ref<ViewNode> ViewNode::makePlaceholderViewNode(ViewTransactionScope& viewTransactionScope,
                                                 const Ref<View>& placeholderView) {
     auto viewNode = Valdi::makeShared<ViewNode>(nullptr, _attributeIds, _logger);
@@ -1455,6 +1499,10 @@ Result<Ref<ValueMap>> ViewNode::copyProcessedViewLayoutAttributes() {
     return _attributesApplier.copyProcessedViewLayoutAttributes();
 }
 
+bool ViewNode::processedViewLayoutAttributesEqual(const ValueMap& attributes) {
+    return _attributesApplier.processedViewLayoutAttributesEqual(attributes);
+}
+
 Size ViewNode::measureExternal(float width, MeasureMode widthMode, float height, MeasureMode heightMode) {
     std::initializer_list<Value> parameters = {Value(static_cast<double>(width)),
                                                Value(static_cast<int32_t>(widthMode)),
@@ -2052,6 +2100,86 @@ static void doCalculateLayoutOnNode(YGNode* yogaNode,
     yogaNode->getStyle().maxDimensions()[YGDimensionHeight] = savedMaxHeight;
 }
 
+namespace {
+
+struct ConcurrentLazyLayoutEntry {
+    YGNode* yogaNode;
+    float width;
+    float height;
+    MeasureMetrics measureMetrics;
+};
+
+/**
+ A set of detached lazy layout Yoga trees which are calculated concurrently.
+ Entries are claimed one by one by whichever thread calls drain(), which lets the
+ calling thread participate and guarantees completion even if the layout queue
+ is busy or torn down.
+ */
+class ConcurrentLazyLayoutBatch : public SimpleRefCountable {
+public:
+    explicit ConcurrentLazyLayoutBatch(std::vector<ConcurrentLazyLayoutEntry> entries)
+        : _entries(std::move(entries)) {}
+
+    void drain() {
+        size_t completed = 0;
+        for (;;) {
+            auto index = _nextIndex.fetch_add(1);
+            if (index >= _entries.size()) {
+                break;
+            }
+
+            auto& entry = _entries[index];
+            VALDI_TRACE("Valdi.calculateLazyLayoutConcurrently");
+            doCalculateLayoutOnNode(entry.yogaNode,
+                                    entry.width,
+                                    MeasureModeExactly,
+                                    entry.height,
+                                    MeasureModeExactly,
+                                    LayoutDirectionLTR /* The direction is set on the style directly */,
+                                    entry.measureMetrics);
+            completed++;
+        }
+
+        if (completed == 0) {
+            return;
+        }
+
+        std::lock_guard<Mutex> guard(_mutex);
+        _completedCount += completed;
+        if (_completedCount == _entries.size()) {
+            _condition.notifyAll();
+        }
+    }
+
+    void wait() {
+        std::unique_lock<Mutex> guard(_mutex);
+        while (_completedCount < _entries.size()) {
+            _condition.wait(guard);
+        }
+    }
+
+    const ConcurrentLazyLayoutEntry& getEntry(size_t index) const {
+        return _entries[index];
+    }
+
+    uint32_t getTotalMeasure() const {
+        uint32_t totalMeasure = 0;
+        for (const auto& entry : _entries) {
+            totalMeasure += entry.measureMetrics.totalMeasure;
+        }
+        return totalMeasure;
+    }
+
+private:
+    std::vector<ConcurrentLazyLayoutEntry> _entries;
+    std::atomic_size_t _nextIndex = 0;
+    Mutex _mutex;
+    ConditionVariable _condition;
+    size_t _completedCount = 0;
+};
+
+} // namespace
+
 bool ViewNode::calculateLayoutOnNodeIfNeeded(YGNode* yogaNode,
                                              float width,
                                              MeasureMode widthMode,
@@ -2064,6 +2192,18 @@ bool ViewNode::calculateLayoutOnNodeIfNeeded(YGNode* yogaNode,
         return false;
     }
 
+    std::optional<LayoutCacheKey> layoutCacheKey;
+    auto* layoutCache = _viewNodeTree != nullptr ? _viewNodeTree->getLayoutCache().get() : nullptr;
+    if (layoutCache != nullptr && YGFloatIsUndefined(yogaNode->getLayout().dimensions[YGDimensionWidth])) {
+        // Only subtrees which were never laid out are looked up, as Yoga already
+        // caches the measurements of subtrees which were laid out before.
+        layoutCacheKey = LayoutCache::makeKey(yogaNode, width, widthMode, height, heightMode, direction);
+        if (layoutCacheKey && layoutCache->restore(layoutCacheKey.value(), yogaNode)) {
+            VALDI_TRACE("Valdi.restoreCachedLayout");
+            return true;
+        }
+    }
+
     auto backendString = getBackendString(getBackend(_viewNodeTree));
     auto module = getModuleName();
 
@@ -2076,6 +2216,10 @@ bool ViewNode::calculateLayoutOnNodeIfNeeded(YGNode* yogaNode,
     MeasureMetrics measureCount;
     doCalculateLayoutOnNode(yogaNode, width, widthMode, height, heightMode, direction, measureCount);
 
+    if (layoutCacheKey) {
+        layoutCache->store(std::move(layoutCacheKey.value()), yogaNode);
+    }
+
     if (measureCount.totalMeasure > 0) {
         if (isFromLazyLayout) {
             if (metricsObj != nullptr) {
@@ -2160,6 +2304,10 @@ void ViewNode::layoutFinished(ViewTransactionScope& viewTransactionScope, bool d
     }
 
     VALDI_TRACE("Valdi.updateCalculatedFrames");
+    if (!_flags[kIsLazyLayoutFlag]) {
+        calculateLazyLayoutsConcurrently(didPerformLayout);
+    }
+
     layoutFinished(viewTransactionScope,
                    didPerformLayout,
                    getViewOffsetX(),
@@ -2244,6 +2392,15 @@ bool ViewNode::updateLazyLayout() {
                           _lazyLayoutData->availableHeight != _calculatedFrame.height;
 
     bool forceLayout = sizeHasChanged || directionHasChanged;
+
+    if (_lazyLayoutData->hasConcurrentLayoutResult) {
+        _lazyLayoutData->hasConcurrentLayoutResult = false;
+        if (!forceLayout && !_lazyLayoutData->yogaNode->isDirty()) {
+            // The layout was already calculated by calculateLazyLayoutsConcurrently()
+            return true;
+        }
+    }
+
     auto updated = calculateLayoutOnNodeIfNeeded(_lazyLayoutData->yogaNode,
                                                  _calculatedFrame.width,
                                                  MeasureModeExactly,
@@ -2260,6 +2417,159 @@ bool ViewNode::updateLazyLayout() {
     return updated;
 }
 
+bool ViewNode::canMeasureConcurrently() const {
+    if (_lazyLayoutData != nullptr && _lazyLayoutData->onMeasureCallback != nullptr) {
+        // onMeasure callbacks are implemented in JS
+        return false;
+    }
+
+    const auto& boundAttributes = _attributesApplier.getBoundAttributes();
+    if (boundAttributes != nullptr && boundAttributes->getMeasureDelegate() != nullptr) {
+        return boundAttributes->getMeasureDelegate()->canMeasureConcurrently();
+    }
+
+    return true;
+}
+
+bool ViewNode::canCalculateLayoutConcurrently() const {
+    for (auto* child : *this) {
+        if (child->_yogaNode->hasMeasureFunc() && !child->canMeasureConcurrently()) {
+            return false;
+        }
+
+        // Nested lazy layouts are only measured as part of this subtree, their children
+        // belong to a separate Yoga tree.
+        if (!child->_flags[kIsLazyLayoutFlag] && !child->canCalculateLayoutConcurrently()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ViewNode::collectConcurrentLazyLayouts(bool didPerformLayout, std::vector<ViewNode*>& lazyLayouts) const {
+    for (auto* child : *this) {
+        if (!didPerformLayout && !child->_flags[kHasLazyLayoutNeedingCalculationFlag]) {
+            // Nothing changed in this subtree, layoutFinished() won't visit it
+            continue;
+        }
+
+        if (!child->_flags[kIsLazyLayoutFlag]) {
+            child->collectConcurrentLazyLayouts(didPerformLayout, lazyLayouts);
+            continue;
+        }
+
+        auto* lazyYogaNode = child->getLazyLayoutYogaNode();
+        if (lazyYogaNode == nullptr || !child->_flags[kVisibleInViewportFlag]) {
+            continue;
+        }
+
+        // Mirrors updateLazyLayout(), using the frame that layoutFinished() is about to apply
+        auto width = didPerformLayout ? sanitizeYogaValue(YGNodeLayoutGetWidth(child->_yogaNode)) :
+                                        child->_calculatedFrame.width;
+        auto height = didPerformLayout ? sanitizeYogaValue(YGNodeLayoutGetHeight(child->_yogaNode)) :
+                                         child->_calculatedFrame.height;
+
+        auto needsLayout = lazyYogaNode->isDirty() || child->_lazyLayoutData->availableWidth != width ||
+                           child->_lazyLayoutData->availableHeight != height ||
+                           child->_yogaNode->getLayout().direction() != lazyYogaNode->getLayout().direction();
+
+        if (needsLayout && child->canCalculateLayoutConcurrently()) {
+            lazyLayouts.emplace_back(child);
+        }
+    }
+}
+
+void ViewNode::calculateLazyLayoutsConcurrently(bool didPerformLayout) {
+    if (_viewNodeTree == nullptr || _viewNodeTree->getLayoutQueue() == nullptr) {
+        return;
+    }
+
+    std::vector<ViewNode*> lazyLayouts;
+    collectConcurrentLazyLayouts(didPerformLayout, lazyLayouts);
+
+    if (lazyLayouts.size() < 2) {
+        // Not worth dispatching, updateLazyLayout() will calculate it inline
+        return;
+    }
+
+    VALDI_TRACE("Valdi.calculateLazyLayoutsConcurrently");
+
+    // The layout cache is only accessed from the calling thread, as building a key
+    // reads the attributes of the measured nodes.
+    auto* layoutCache = _viewNodeTree->getLayoutCache().get();
+    std::vector<ViewNode*> calculatedLazyLayouts;
+    std::vector<std::optional<LayoutCacheKey>> layoutCacheKeys;
+    std::vector<ConcurrentLazyLayoutEntry> entries;
+    entries.reserve(lazyLayouts.size());
+    for (auto* lazyLayout : lazyLayouts) {
+        auto& lazyLayoutData = *lazyLayout->_lazyLayoutData;
+        auto* lazyYogaNode = lazyLayoutData.yogaNode;
+        YGNodeStyleSetDirection(lazyYogaNode, lazyLayout->_yogaNode->getLayout().direction());
+
+        auto width = didPerformLayout ? sanitizeYogaValue(YGNodeLayoutGetWidth(lazyLayout->_yogaNode)) :
+                                        lazyLayout->_calculatedFrame.width;
+        auto height = didPerformLayout ? sanitizeYogaValue(YGNodeLayoutGetHeight(lazyLayout->_yogaNode)) :
+                                         lazyLayout->_calculatedFrame.height;
+
+        std::optional<LayoutCacheKey> layoutCacheKey;
+        if (layoutCache != nullptr && YGFloatIsUndefined(lazyYogaNode->getLayout().dimensions[YGDimensionWidth])) {
+            // Same key as the one updateLazyLayout() would have used, the direction is set on the style
+            layoutCacheKey = LayoutCache::makeKey(
+                lazyYogaNode, width, MeasureModeExactly, height, MeasureModeExactly, LayoutDirectionLTR);
+            if (layoutCacheKey && layoutCache->restore(layoutCacheKey.value(), lazyYogaNode)) {
+                lazyLayoutData.availableWidth = width;
+                lazyLayoutData.availableHeight = height;
+                lazyLayoutData.hasConcurrentLayoutResult = true;
+                continue;
+            }
+        }
+
+        auto& entry = entries.emplace_back();
+        entry.yogaNode = lazyYogaNode;
+        entry.width = width;
+        entry.height = height;
+        calculatedLazyLayouts.emplace_back(lazyLayout);
+        layoutCacheKeys.emplace_back(std::move(layoutCacheKey));
+    }
+
+    if (entries.empty()) {
+        return;
+    }
+
+    auto backendString = getBackendString(getBackend(_viewNodeTree));
+    auto module = getModuleName();
+    auto metricsObj = getMetrics();
+    ScopedMetrics metrics = Metrics::scopedCalculateLazyLayoutLatency(metricsObj, module, backendString);
+
+    auto batch = makeShared<ConcurrentLazyLayoutBatch>(std::move(entries));
+    const auto& layoutQueue = _viewNodeTree->getLayoutQueue();
+    auto workersCount =
+        std::min(calculatedLazyLayouts.size() - 1, static_cast<size_t>(std::thread::hardware_concurrency()));
+    for (size_t i = 0; i < workersCount; i++) {
+        layoutQueue->async([batch]() { batch->drain(); });
+    }
+
+    batch->drain();
+    batch->wait();
+
+    for (size_t i = 0; i < calculatedLazyLayouts.size(); i++) {
+        const auto& entry = batch->getEntry(i);
+        auto& lazyLayoutData = *calculatedLazyLayouts[i]->_lazyLayoutData;
+        lazyLayoutData.availableWidth = entry.width;
+        lazyLayoutData.availableHeight = entry.height;
+        lazyLayoutData.hasConcurrentLayoutResult = true;
+
+        if (layoutCacheKeys[i]) {
+            layoutCache->store(std::move(layoutCacheKeys[i].value()), entry.yogaNode);
+        }
+    }
+
+    if (batch->getTotalMeasure() > 0 && metricsObj != nullptr) {
+        metricsObj->emitCalculateLazyLayoutLatencyMeasure(module, backendString, metrics.elapsed());
+    }
+}
+
 void ViewNode::updateScrollState() {
     auto& scrollState = getOrCreateScrollState();
     scrollState.setInScrollMode(true);
@@ -2384,6 +2694,11 @@ void ViewNode::layoutFinished(ViewTransactionScope& viewTransactionScope,
         return;
     }
 
+    if (_flags[kIsLazyLayoutFlag]) {
+        // Nested lazy layouts can only be resolved once our own lazy layout is calculated
+        calculateLazyLayoutsConcurrently(didPerformLayoutForChildren);
+    }
+
     float childrenViewOffsetX = 0.0f;
     float childrenViewOffsetY = 0.0f;
 
@@ -2882,25 +3197,31 @@ void ViewNode::updateCSS(ViewTransactionScope& viewTransactionScope,
     handleCSSChange(getCSSAttributesManager().setSiblingsIndexes(siblingsCount, indexAmongSiblings));
 
     auto needUpdateSelf = force || _flags[kCSSNeedsUpdate];
-    auto needUpdateChildren = needUpdateSelf || _flags[kCSSHasChildNeedsUpdate];
+    auto needUpdateSubtree = force || _flags[kCSSSubtreeNeedsUpdate];
 
     if (needUpdateSelf) {
         updateResult.updatedNodes++;
-        getCSSAttributesManager().updateCSS(
-            CSSAttributesManagerUpdateContext(viewTransactionScope, getAttributesApplier(), getLogger(), animator));
+        // The descendants only need to be restyled if the changes on this node can change the rules they match
+        if (getCSSAttributesManager().updateCSS(
+                CSSAttributesManagerUpdateContext(viewTransactionScope, getAttributesApplier(), getLogger(), animator),
+                force)) {
+            needUpdateSubtree = true;
+        }
     }
     _attributesApplier.flush(viewTransactionScope);
 
-    if (needUpdateChildren) {
+    if (needUpdateSelf || needUpdateSubtree || _flags[kCSSHasChildNeedsUpdate]) {
         auto childCount = static_cast<int>(getChildCount());
         int index = 0;
         for (auto* childViewNode : *this) {
-            childViewNode->updateCSS(viewTransactionScope, animator, needUpdateSelf, childCount, index, updateResult);
+            childViewNode->updateCSS(
+                viewTransactionScope, animator, needUpdateSubtree, childCount, index, updateResult);
             index++;
         }
     }
 
     _flags[kCSSNeedsUpdate] = false;
+    _flags[kCSSSubtreeNeedsUpdate] = false;
     _flags[kCSSHasChildNeedsUpdate] = false;
 }
 
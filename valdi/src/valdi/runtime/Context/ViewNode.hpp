@@ -57,6 +57,7 @@ class BoundAttributes;
 class AttributeOwner;
 class ViewNodesFrameObserver;
 class Metrics;
+struct LayoutCacheMeasureInput;
 
 class ViewNode;
 class ViewNodeIterator {
@@ -81,6 +82,8 @@ struct LazyLayoutData {
     float estimatedWidth = 0;
     float estimatedHeight = 0;
     Ref<ValueFunction> onMeasureCallback;
+    // Set when the layout of this subtree was calculated ahead of time on the layout queue
+    bool hasConcurrentLayoutResult = false;
 
     ~LazyLayoutData();
 
@@ -351,6 +354,12 @@ public:
      */
     Size onMeasure(float width, MeasureMode widthMode, float height, MeasureMode heightMode);
 
+    /**
+     Populates the inputs that onMeasure() depends on, so that the measurement can be
+     reused through the LayoutCache. Returns false if the measurement cannot be cached.
+     */
+    bool getLayoutCacheMeasureInput(LayoutCacheMeasureInput& output);
+
     std::string getLayoutDebugDescription() const;
 
     Ref<ValueMap> getDebugDescriptionMap() const;
@@ -563,6 +572,7 @@ public:
     Ref<ViewNode> makePlaceholderViewNode(ViewTransactionScope& viewTransactionScope, const Ref<View>& placeholderView);
 
     Result<Ref<ValueMap>> copyProcessedViewLayoutAttributes();
+    bool processedViewLayoutAttributesEqual(const ValueMap& attributes);
 
     Frame computeVisualFrameInRoot() const;
 
@@ -652,6 +662,10 @@ private:
     void setViewFrameNeedsUpdate();
 
     bool updateLazyLayout();
+    bool canMeasureConcurrently() const;
+    bool canCalculateLayoutConcurrently() const;
+    void collectConcurrentLazyLayouts(bool didPerformLayout, std::vector<ViewNode*>& lazyLayouts) const;
+    void calculateLazyLayoutsConcurrently(bool didPerformLayout);
     void doUpdateViewTree(ViewTransactionScope& viewTransactionScope,
                           const Ref<View>& currentParentView,
                           bool parentVisibleInViewport,
@@ -12,6 +12,7 @@
 #include "valdi/runtime/Context/Context.hpp"
 #include "valdi/runtime/Context/ContextEntry.hpp"
 #include "valdi/runtime/Context/IViewNodesAssetTracker.hpp"
+#include "valdi/runtime/Context/LayoutCache.hpp"
 #include "valdi/runtime/Context/ViewManagerContext.hpp"
 #include "valdi/runtime/Context/ViewNodePath.hpp"
 #include "valdi/runtime/Context/ViewNodesFrameObserver.hpp"
@@ -29,6 +30,7 @@
 #include "valdi_core/cpp/Utils/LoggerUtils.hpp"
 #include "valdi_core/cpp/Utils/StringCache.hpp"
 #include "valdi_core/cpp/Utils/Trace.hpp"
+#include "valdi_core/cpp/Utils/ValueArena.hpp"
 #include "valdi_core/cpp/Utils/ValueFunction.hpp"
 #include "valdi_core/cpp/Utils/ValueMap.hpp"
 
@@ -594,6 +596,30 @@ ViewNodesFrameObserver* ViewNodeTree::getViewNodesFrameObserver() const {
     return _framesObserver.get();
 }
 
+void ViewNodeTree::setLayoutQueue(const Ref<DispatchQueue>& layoutQueue) {
+    _layoutQueue = layoutQueue;
+}
+
+const Ref<DispatchQueue>& ViewNodeTree::getLayoutQueue() const {
+    // The runtime only creates its queue once the runtime tweaks are set,
+    // which can happen after this tree was created.
+    if (_layoutQueue == nullptr && _runtime != nullptr) {
+        return _runtime->getLayoutQueue();
+    }
+    return _layoutQueue;
+}
+
+void ViewNodeTree::setLayoutCache(const Ref<LayoutCache>& layoutCache) {
+    _layoutCache = layoutCache;
+}
+
+const Ref<LayoutCache>& ViewNodeTree::getLayoutCache() const {
+    if (_layoutCache == nullptr && _runtime != nullptr) {
+        return _runtime->getLayoutCache();
+    }
+    return _layoutCache;
+}
+
 void ViewNodeTree::flushFrameObserver() {
     if (_framesObserver != nullptr) {
         _framesObserver->flush();
@@ -659,6 +685,8 @@ void ViewNodeTree::runUpdatesInner() {
     VALDI_TRACE("Valdi.runTreeUpdates")
 
     ContextEntry contextEntry(_context);
+    // The Values created while applying the updates mostly die with the pass
+    ValueArenaScope arenaScope;
     auto viewTransactionScope = beginViewTransaction();
 
     auto layoutDirtyCounter = _layoutDirtyCounter;
@@ -26,6 +26,8 @@
 
 namespace Valdi {
 
+class DispatchQueue;
+class LayoutCache;
 class Runtime;
 class ViewNodePath;
 
@@ -201,6 +203,22 @@ public:
     ViewNodesFrameObserver* getViewNodesFrameObserver() const;
     void flushFrameObserver();
 
+    /**
+     Set the concurrent queue on which independent lazy layout subtrees can be
+     calculated in parallel, instead of the layout queue of the Runtime.
+     Layout is calculated on a single thread when neither is set.
+     */
+    void setLayoutQueue(const Ref<DispatchQueue>& layoutQueue);
+    const Ref<DispatchQueue>& getLayoutQueue() const;
+
+    /**
+     Set the cache from which freshly created subtrees can reuse the layout
+     of identical subtrees, instead of the layout cache of the Runtime.
+     Layouts are not cached when neither is set.
+     */
+    void setLayoutCache(const Ref<LayoutCache>& layoutCache);
+    const Ref<LayoutCache>& getLayoutCache() const;
+
     const AttributeOwner* getParentAttributeOwner();
 
     const Ref<MainThreadManager>& getMainThreadManager() const;
@@ -245,6 +263,8 @@ private:
     Ref<ViewNode> _rootViewNode;
     Ref<ViewNodesVisibilityObserver> _visibilityObserver;
     Ref<ViewNodesFrameObserver> _framesObserver;
+    Ref<DispatchQueue> _layoutQueue;
+    Ref<LayoutCache> _layoutCache;
     Ref<IViewNodesAssetTracker> _assetTracker;
     SharedAnimator _animator;
     Ref<View> _rootView;
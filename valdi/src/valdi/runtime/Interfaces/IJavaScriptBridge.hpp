@@ -9,6 +9,7 @@
 #pragma once
 
 #include "valdi/runtime/Interfaces/IJavaScriptContext.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptHeapDumpBuilder.hpp"
 #include "valdi_core/cpp/Utils/Bytes.hpp"
 #include <span>
 
@@ -50,6 +51,27 @@ public:
      */
     virtual BytesView dumpHeap(std::span<IJavaScriptContext*> jsContexts, JSExceptionTracker& exceptionTracker) = 0;
 
+    /**
+     Dumps the heap for the given JSContexts into the given output.
+     Engines which can build the dump incrementally should override this method to avoid
+     holding the full dump in memory, the default implementation writes the result of dumpHeap().
+     The spillDirectory is a writable directory in which the engine can store intermediate data.
+     */
+    virtual void dumpHeapToOutput(std::span<IJavaScriptContext*> jsContexts,
+                                  const Path& /*spillDirectory*/,
+                                  JavaScriptHeapDumpOutput& output,
+                                  JSExceptionTracker& exceptionTracker) {
+        auto heapDump = dumpHeap(jsContexts, exceptionTracker);
+        if (!exceptionTracker) {
+            return;
+        }
+
+        auto result = output.write(heapDump.data(), heapDump.size());
+        if (!result) {
+            exceptionTracker.onError(result.moveError());
+        }
+    }
+
     /**
      * Starts the JS debugger server for the created JSContexts.
      */
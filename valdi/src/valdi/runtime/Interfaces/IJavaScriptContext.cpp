@@ -256,6 +256,17 @@ JSValueRef IJavaScriptContext::newArrayBufferCopy(const Byte* data, size_t size,
     return newArrayBuffer(makeShared<ByteBuffer>(data, data + size)->toBytesView(), exceptionTracker);
 }
 
+JSValueRef IJavaScriptContext::getObjectPropertyWithCache(const JSValue& object,
+                                                          const JSPropertyName& propertyName,
+                                                          JSPropertyCache& /*propertyCache*/,
+                                                          JSExceptionTracker& exceptionTracker) {
+    return getObjectProperty(object, propertyName, exceptionTracker);
+}
+
+bool IJavaScriptContext::detachArrayBuffer(const JSValue& /*arrayBuffer*/, JSExceptionTracker& /*exceptionTracker*/) {
+    return false;
+}
+
 JavaScriptLong IJavaScriptContext::valueToLong(const JSValue& value, JSExceptionTracker& exceptionTracker) {
     static auto kLow = STRING_LITERAL("low");
     static auto kHigh = STRING_LITERAL("high");
@@ -132,6 +132,14 @@ public:
         return false;
     }
 
+    /**
+     * Return the version of the bytecode produced by preCompile(). Precompiled modules
+     * can only be evaluated by a context which uses the same version.
+     */
+    virtual uint32_t getPreCompilationVersion() const {
+        return 0;
+    }
+
     virtual BytesView preCompile(const std::string_view& /*script*/,
                                  const std::string_view& /*sourceFilename*/,
                                  JSExceptionTracker& exceptionTracker) = 0;
@@ -164,6 +172,12 @@ public:
 
     virtual JSValueRef newArrayBufferCopy(const Byte* data, size_t size, JSExceptionTracker& exceptionTracker);
 
+    /**
+     * Detach the given ArrayBuffer, after which its contents can no longer be accessed from JS.
+     * Return false if the engine does not support detaching ArrayBuffers.
+     */
+    virtual bool detachArrayBuffer(const JSValue& arrayBuffer, JSExceptionTracker& exceptionTracker);
+
     virtual JSValueRef newTypedArrayFromArrayBuffer(const TypedArrayType& type,
                                                     const JSValue& arrayBuffer,
                                                     JSExceptionTracker& exceptionTracker) = 0;
@@ -185,6 +199,16 @@ public:
                                          const JSPropertyName& propertyName,
                                          JSExceptionTracker& exceptionTracker) = 0;
 
+    /**
+     * Get the property of the given object, using the given cache to skip the property lookup
+     * when the object has the same shape as the last object the property was read from.
+     * Engines which don't support inline caches ignore the cache.
+     */
+    virtual JSValueRef getObjectPropertyWithCache(const JSValue& object,
+                                                  const JSPropertyName& propertyName,
+                                                  JSPropertyCache& propertyCache,
+                                                  JSExceptionTracker& exceptionTracker);
+
     virtual JSValueRef getObjectPropertyForIndex(const JSValue& object,
                                                  size_t index,
                                                  JSExceptionTracker& exceptionTracker) = 0;
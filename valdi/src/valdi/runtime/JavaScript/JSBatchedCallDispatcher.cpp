@@ -0,0 +1,171 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi/runtime/JavaScript/JSBatchedCallDispatcher.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptFunctionCallContext.hpp"
+#include "valdi_core/cpp/Utils/ByteBuffer.hpp"
+#include "valdi_core/cpp/Utils/Trace.hpp"
+
+#include <cmath>
+#include <limits>
+#include <optional>
+
+namespace Valdi {
+
+static void onInvalidCallBuffer(JSExceptionTracker& exceptionTracker) {
+    exceptionTracker.onError("Invalid batched call buffer");
+}
+
+// Slots are written by JS and can hold any double, they are validated before being cast
+static bool toSlotIndex(double slot, size_t limit, size_t& index) {
+    if (!(slot >= 0.0 && slot < static_cast<double>(limit)) || std::floor(slot) != slot) {
+        return false;
+    }
+    index = static_cast<size_t>(slot);
+    return true;
+}
+
+static Ref<ByteBuffer> makeFloat64Buffer(size_t slots) {
+    auto buffer = makeShared<ByteBuffer>();
+    buffer->resize(slots * sizeof(double));
+    return buffer;
+}
+
+JSBatchedCallDispatcher::JSBatchedCallDispatcher(IJavaScriptContext& jsContext) : _jsContext(jsContext) {}
+
+JSBatchedCallDispatcher::~JSBatchedCallDispatcher() = default;
+
+JSValueRef JSBatchedCallDispatcher::registerFunction(const JSValue& function, JSExceptionTracker& exceptionTracker) {
+    if (!_jsContext.isValueFunction(function)) {
+        exceptionTracker.onError("Was not provided with a function value");
+        return _jsContext.newUndefined();
+    }
+
+    auto callable = _jsContext.valueToFunction(function, exceptionTracker);
+    if (!exceptionTracker || callable == nullptr) {
+        // Functions implemented in JS are called directly by the caller
+        exceptionTracker.clearError();
+        return _jsContext.newUndefined();
+    }
+
+    for (size_t i = 0; i < _functions.size(); i++) {
+        if (_functions[i] == callable) {
+            return _jsContext.newNumber(static_cast<int32_t>(i));
+        }
+    }
+
+    auto functionId = static_cast<int32_t>(_functions.size());
+    _functions.emplace_back(std::move(callable));
+    return _jsContext.newNumber(functionId);
+}
+
+JSValueRef JSBatchedCallDispatcher::getCallBuffer(JSExceptionTracker& exceptionTracker) {
+    if (_callBuffer == nullptr) {
+        _callBuffer = makeFloat64Buffer(kCallBufferSlots);
+    }
+
+    return _jsContext.newArrayBuffer(_callBuffer->toBytesView(), exceptionTracker);
+}
+
+JSValueRef JSBatchedCallDispatcher::getResultBuffer(JSExceptionTracker& exceptionTracker) {
+    if (_resultBuffer == nullptr) {
+        _resultBuffer = makeFloat64Buffer(kMaxCalls);
+    }
+
+    return _jsContext.newArrayBuffer(_resultBuffer->toBytesView(), exceptionTracker);
+}
+
+void JSBatchedCallDispatcher::dispatch(size_t callCount, const JSValue& values, JSExceptionTracker& exceptionTracker) {
+    VALDI_TRACE("Valdi.dispatchBatchedCalls");
+
+    if (_callBuffer == nullptr || _resultBuffer == nullptr || callCount > kMaxCalls) {
+        onInvalidCallBuffer(exceptionTracker);
+        return;
+    }
+
+    const auto* slots = reinterpret_cast<const double*>(_callBuffer->data());
+    auto* results = reinterpret_cast<double*>(_resultBuffer->data());
+    size_t current = 0;
+    // Exception of the first call which failed, reported once the batch is complete
+    std::optional<JSValueRef> firstException;
+
+    for (size_t i = 0; i < callCount; i++) {
+        size_t functionId = 0;
+        size_t parametersCount = 0;
+        size_t valuesMask = 0;
+        if (current + 3 > kCallBufferSlots || !toSlotIndex(slots[current], _functions.size(), functionId) ||
+            !toSlotIndex(slots[current + 1], kMaxParameters + 1, parametersCount) ||
+            !toSlotIndex(slots[current + 2], static_cast<size_t>(1) << kMaxParameters, valuesMask) ||
+            current + 3 + parametersCount > kCallBufferSlots) {
+            // The remaining calls cannot be located in the buffer
+            if (firstException) {
+                exceptionTracker.storeException(std::move(firstException.value()));
+            } else {
+                onInvalidCallBuffer(exceptionTracker);
+            }
+            return;
+        }
+
+        const auto* parameterSlots = &slots[current + 3];
+        current += 3 + parametersCount;
+
+        // Calls are independent and can be enqueued by unrelated callers, a failed call
+        // does not prevent the following ones from being made
+        JSExceptionTracker callExceptionTracker(_jsContext);
+        results[i] =
+            dispatchCall(functionId, parameterSlots, parametersCount, valuesMask, values, callExceptionTracker);
+        if (!callExceptionTracker) {
+            auto exception = callExceptionTracker.getExceptionAndClear();
+            if (!firstException) {
+                firstException = std::move(exception);
+            }
+            results[i] = std::numeric_limits<double>::quiet_NaN();
+        }
+    }
+
+    if (firstException) {
+        exceptionTracker.storeException(std::move(firstException.value()));
+    }
+}
+
+double JSBatchedCallDispatcher::dispatchCall(size_t functionId,
+                                             const double* parameterSlots,
+                                             size_t parametersCount,
+                                             size_t valuesMask,
+                                             const JSValue& values,
+                                             JSExceptionTracker& exceptionTracker) {
+    JSValueRef parameters[kMaxParameters];
+    for (size_t j = 0; j < parametersCount; j++) {
+        auto slot = parameterSlots[j];
+        if ((valuesMask & (static_cast<size_t>(1) << j)) != 0) {
+            size_t valueIndex = 0;
+            if (!toSlotIndex(slot, std::numeric_limits<uint32_t>::max(), valueIndex)) {
+                onInvalidCallBuffer(exceptionTracker);
+                return 0.0;
+            }
+            parameters[j] = _jsContext.getObjectPropertyForIndex(values, valueIndex, exceptionTracker);
+            if (!exceptionTracker) {
+                return 0.0;
+            }
+        } else {
+            parameters[j] = _jsContext.newNumber(slot);
+        }
+    }
+
+    const auto& function = _functions[functionId];
+    JSFunctionNativeCallContext callContext(
+        _jsContext, parameters, parametersCount, exceptionTracker, function->getReferenceInfo());
+    auto result = (*function)(callContext);
+    if (!exceptionTracker) {
+        return 0.0;
+    }
+
+    if (_jsContext.isValueNumber(result.get())) {
+        return _jsContext.valueToDouble(result.get(), exceptionTracker);
+    } else if (_jsContext.getValueType(result.get()) == ValueType::Bool) {
+        return _jsContext.valueToBool(result.get(), exceptionTracker) ? 1.0 : 0.0;
+    } else {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+}
+
+} // namespace Valdi
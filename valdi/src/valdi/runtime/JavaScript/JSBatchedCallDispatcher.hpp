@@ -0,0 +1,71 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "valdi/runtime/Interfaces/IJavaScriptContext.hpp"
+#include "valdi_core/cpp/Utils/Shared.hpp"
+
+#include <vector>
+
+namespace Valdi {
+
+class ByteBuffer;
+
+/**
+ Dispatches calls to native functions which were enqueued by JS, so that
+ a sequence of short native calls can be made in a single JS to C++ crossing.
+
+ Functions are first registered through registerFunction(), which returns the
+ id used to enqueue them. Calls are written by JS in the call buffer as float64
+ slots, using the following layout:
+   [functionId, parametersCount, valuesMask, parameter0, parameter1, ...]
+ Each parameter slot holds a number, unless the bit at the parameter position
+ is set in valuesMask, in which case it holds the index of the parameter inside
+ the values array given to dispatch().
+
+ The result of each call is written at the index of the call in the result buffer.
+ Numbers and booleans are written as is, any other result is written as NaN.
+ */
+class JSBatchedCallDispatcher {
+public:
+    static constexpr size_t kMaxParameters = 8;
+    static constexpr size_t kCallBufferSlots = 8192;
+    static constexpr size_t kMaxCalls = kCallBufferSlots / 3;
+
+    explicit JSBatchedCallDispatcher(IJavaScriptContext& jsContext);
+    ~JSBatchedCallDispatcher();
+
+    /**
+     Registers the given native function and returns its id as a JS number.
+     Returns undefined if the function is not backed by a native implementation,
+     in which case it cannot be dispatched from the call buffer.
+     */
+    JSValueRef registerFunction(const JSValue& function, JSExceptionTracker& exceptionTracker);
+
+    JSValueRef getCallBuffer(JSExceptionTracker& exceptionTracker);
+    JSValueRef getResultBuffer(JSExceptionTracker& exceptionTracker);
+
+    /**
+     Dispatches the given number of calls from the call buffer, in order.
+     A call which fails does not prevent the following ones from being made,
+     its result is written as NaN and the error of the first call which failed
+     is reported through the exception tracker once all the calls are made.
+     The dispatch stops if the call buffer is malformed.
+     */
+    void dispatch(size_t callCount, const JSValue& values, JSExceptionTracker& exceptionTracker);
+
+private:
+    IJavaScriptContext& _jsContext;
+    std::vector<Ref<JSFunction>> _functions;
+    Ref<ByteBuffer> _callBuffer;
+    Ref<ByteBuffer> _resultBuffer;
+
+    double dispatchCall(size_t functionId,
+                        const double* parameterSlots,
+                        size_t parametersCount,
+                        size_t valuesMask,
+                        const JSValue& values,
+                        JSExceptionTracker& exceptionTracker);
+};
+
+} // namespace Valdi
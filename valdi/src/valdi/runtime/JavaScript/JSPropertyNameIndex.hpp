@@ -53,13 +53,25 @@ public:
         return _jsPropertyNames[index];
     }
 
+    /**
+     Reads the property at the given index from the given object, through an inline
+     cache kept for each property, so that reading the properties of objects which
+     always have the same shape skips the property lookups.
+     */
+    JSValueRef getObjectProperty(const JSValue& object, size_t index, JSExceptionTracker& exceptionTracker) {
+        return _context->getObjectPropertyWithCache(
+            object, _jsPropertyNames[index], _propertyCaches[index], exceptionTracker);
+    }
+
 private:
     IJavaScriptContext* _context = nullptr;
     std::array<JSPropertyName, size> _jsPropertyNames;
     std::array<std::string_view, size> _cppPropertyNames;
+    std::array<JSPropertyCache, size> _propertyCaches;
 
     void unload() {
         unloadPropertyNames(_context, size, _jsPropertyNames.data());
+        _propertyCaches.fill(JSPropertyCache());
     }
 
     void load() {
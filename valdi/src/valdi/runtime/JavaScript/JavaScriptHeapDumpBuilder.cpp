@@ -8,6 +8,8 @@
 #include "valdi/runtime/JavaScript/JavaScriptHeapDumpBuilder.hpp"
 #include "utils/debugging/Assert.hpp"
 #include "valdi_core/cpp/Schema/ValueSchema.hpp"
+#include "valdi_core/cpp/Utils/ByteBuffer.hpp"
+#include "valdi_core/cpp/Utils/DiskUtils.hpp"
 #include "valdi_core/cpp/Utils/JSONReader.hpp"
 #include "valdi_core/cpp/Utils/JSONWriter.hpp"
 #include "valdi_core/cpp/Utils/StringCache.hpp"
@@ -17,6 +19,11 @@
 #include "valdi_core/cpp/Utils/Format.hpp"
 #include "valdi_core/cpp/Utils/SmallVector.hpp"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
 #include <utility>
 
 namespace Valdi {
@@ -215,6 +222,53 @@ bool JavaScriptHeapDumpFieldsIndexes::resolveEdgeTypeByIndex(const ValueArray* e
 JavaScriptHeapDumpParser::JavaScriptHeapDumpParser(const Byte* data,
                                                    size_t length,
                                                    ExceptionTracker& exceptionTracker) {
+    parse(data, length, exceptionTracker);
+}
+
+JavaScriptHeapDumpParser::JavaScriptHeapDumpParser(const Path& path, ExceptionTracker& exceptionTracker) {
+    auto mappedFile = DiskUtils::mapFile(path);
+    if (!mappedFile) {
+        exceptionTracker.onError(mappedFile.moveError());
+        return;
+    }
+
+    parse(mappedFile.value().data(), mappedFile.value().size(), exceptionTracker);
+}
+
+JavaScriptHeapDumpParser::JavaScriptHeapDumpParser() = default;
+JavaScriptHeapDumpParser::~JavaScriptHeapDumpParser() = default;
+
+void JavaScriptHeapDumpParser::visit(const Path& path,
+                                     JavaScriptHeapDumpVisitor& visitor,
+                                     ExceptionTracker& exceptionTracker) {
+    auto mappedFile = DiskUtils::mapFile(path);
+    if (!mappedFile) {
+        exceptionTracker.onError(mappedFile.moveError());
+        return;
+    }
+
+    std::string_view json(reinterpret_cast<const char*>(mappedFile.value().data()), mappedFile.value().size());
+    JSONReader reader(json);
+
+    JavaScriptHeapDumpParser parser;
+    int32_t nodeCount = 0;
+    int32_t edgeCount = 0;
+    size_t nodesPosition = 0;
+    size_t edgesPosition = 0;
+    parser.indexHeapDump(reader, nodeCount, edgeCount, nodesPosition, edgesPosition);
+
+    if (reader.hasError()) {
+        exceptionTracker.onError(reader.getError());
+        return;
+    }
+
+    auto result = parser.visitEntries(json, nodeCount, edgeCount, nodesPosition, edgesPosition, visitor);
+    if (!result) {
+        exceptionTracker.onError(result.moveError());
+    }
+}
+
+void JavaScriptHeapDumpParser::parse(const Byte* data, size_t length, ExceptionTracker& exceptionTracker) {
     JSONReader reader(std::string_view(reinterpret_cast<const char*>(data), length));
 
     parseHeapDump(reader);
@@ -227,8 +281,6 @@ JavaScriptHeapDumpParser::JavaScriptHeapDumpParser(const Byte* data,
     }
 }
 
-JavaScriptHeapDumpParser::~JavaScriptHeapDumpParser() = default;
-
 bool JavaScriptHeapDumpParser::parseSnapshot(const Value& snapshot, int32_t& nodeCount, int32_t& edgeCount) {
     nodeCount = snapshot.getMapValue("node_count").toInt();
     edgeCount = snapshot.getMapValue("edge_count").toInt();
@@ -311,14 +363,17 @@ void JavaScriptHeapDumpParser::parseHeapDump(JSONReader& reader) {
     validateDump(reader);
 }
 
-static bool parseComponents(JSONReader& reader, std::vector<uint32_t>& output, size_t length) {
-    output.resize(length);
+/**
+ Parse the components of a single node or edge. Rows are parsed one at a time, so that
+ we don't need to hold an intermediate representation of the whole nodes or edges array.
+ */
+static bool parseComponents(JSONReader& reader, SmallVectorBase<uint32_t>& output, bool isFirstRow) {
     auto* outputBegin = output.data();
-    auto* outputEnd = outputBegin + length;
+    auto* outputEnd = outputBegin + output.size();
     auto* outputIt = outputBegin;
 
     while (outputIt != outputEnd) {
-        if (outputIt != outputBegin && !reader.parseComma()) {
+        if ((outputIt != outputBegin || !isFirstRow) && !reader.parseComma()) {
             return false;
         }
 
@@ -332,23 +387,31 @@ static bool parseComponents(JSONReader& reader, std::vector<uint32_t>& output, s
     return true;
 }
 
+// The node and edge counts come from the dump being parsed and cannot be trusted,
+// past this many entries the arrays grow as entries are actually parsed.
+static constexpr size_t kMaxReservedParsedEntries = 1024 * 1024;
+
 void JavaScriptHeapDumpParser::parseNodes(JSONReader& reader, int32_t nodeCount) {
     if (!reader.parseBeginArray()) {
         return;
     }
 
-    auto fieldsCountPerNode = _fieldsIndexes.fieldsCountPerNode;
-    std::vector<uint32_t> components;
-    if (!parseComponents(reader, components, fieldsCountPerNode * nodeCount)) {
-        return;
-    }
-
-    auto* componentsPtr = components.data();
+    SmallVector<uint32_t, 8> components;
+    components.resize(_fieldsIndexes.fieldsCountPerNode);
+    const auto* componentsPtr = components.data();
 
     size_t edgesStart = 0;
     auto nodeTypeMaxSize = static_cast<uint32_t>(_fieldsIndexes.nodeTypeByIndex.size());
 
+    if (nodeCount > 0) {
+        _nodes.reserve(std::min(static_cast<size_t>(nodeCount), kMaxReservedParsedEntries));
+    }
+
     for (int32_t i = 0; i < nodeCount; i++) {
+        if (!parseComponents(reader, components, i == 0)) {
+            return;
+        }
+
         auto typeIndex = componentsPtr[_fieldsIndexes.nodes.type];
         auto nameIndex = componentsPtr[_fieldsIndexes.nodes.name];
         auto id = componentsPtr[_fieldsIndexes.nodes.id];
@@ -364,7 +427,6 @@ void JavaScriptHeapDumpParser::parseNodes(JSONReader& reader, int32_t nodeCount)
             this, _fieldsIndexes.nodeTypeByIndex[typeIndex], nameIndex, id, selfSizeBytes, edgesStart, edgesCount);
 
         edgesStart += edgesCount;
-        componentsPtr += fieldsCountPerNode;
     }
 
     reader.parseEndArray();
@@ -375,15 +437,20 @@ void JavaScriptHeapDumpParser::parseEdges(JSONReader& reader, int32_t edgeCount)
         return;
     }
 
-    auto fieldsCountPerEdge = _fieldsIndexes.fieldsCountPerEdge;
-    std::vector<uint32_t> components;
-    if (!parseComponents(reader, components, fieldsCountPerEdge * edgeCount)) {
-        return;
-    }
-    auto* componentsPtr = components.data();
+    SmallVector<uint32_t, 4> components;
+    components.resize(_fieldsIndexes.fieldsCountPerEdge);
+    const auto* componentsPtr = components.data();
     auto edgeTypeMaxSize = static_cast<uint32_t>(_fieldsIndexes.edgeTypeByIndex.size());
 
+    if (edgeCount > 0) {
+        _edges.reserve(std::min(static_cast<size_t>(edgeCount), kMaxReservedParsedEntries));
+    }
+
     for (int32_t i = 0; i < edgeCount; i++) {
+        if (!parseComponents(reader, components, i == 0)) {
+            return;
+        }
+
         auto edgeTypeIndex = componentsPtr[_fieldsIndexes.edges.type];
         auto edgeNameOrIndex = componentsPtr[_fieldsIndexes.edges.nameOrIndex];
         auto edgeToNode = componentsPtr[_fieldsIndexes.edges.toNode];
@@ -397,8 +464,6 @@ void JavaScriptHeapDumpParser::parseEdges(JSONReader& reader, int32_t edgeCount)
                             _fieldsIndexes.edgeTypeByIndex[edgeTypeIndex],
                             edgeNameOrIndex,
                             edgeToNode / _fieldsIndexes.fieldsCountPerNode);
-
-        componentsPtr += fieldsCountPerEdge;
     }
 
     reader.parseEndArray();
@@ -458,6 +523,212 @@ void JavaScriptHeapDumpParser::validateDump(JSONReader& reader) {
     }
 }
 
+/**
+ Consume an array of unsigned integers without storing it, and return how many integers it held.
+ */
+static bool skipUIntArray(JSONReader& reader, size_t& count) {
+    if (!reader.parseBeginArray()) {
+        return false;
+    }
+
+    uint32_t component = 0;
+    count = 0;
+    while (!reader.tryParseEndArray()) {
+        if (reader.hasError()) {
+            return false;
+        }
+
+        if (count != 0 && !reader.parseComma()) {
+            return false;
+        }
+
+        if (!reader.parseUInt(component)) {
+            return false;
+        }
+
+        count++;
+    }
+
+    return !reader.hasError();
+}
+
+void JavaScriptHeapDumpParser::indexHeapDump(JSONReader& reader,
+                                             int32_t& nodeCount,
+                                             int32_t& edgeCount,
+                                             size_t& nodesPosition,
+                                             size_t& edgesPosition) {
+    if (!reader.parseBeginObject()) {
+        return;
+    }
+
+    bool isFirst = true;
+    bool hasNodes = false;
+    bool hasEdges = false;
+    std::string key;
+    size_t nodesComponentsCount = 0;
+    size_t edgesComponentsCount = 0;
+
+    while (!reader.tryParseEndObject()) {
+        if (reader.hasError()) {
+            return;
+        }
+
+        if (isFirst) {
+            isFirst = false;
+        } else if (!reader.parseComma()) {
+            return;
+        }
+
+        key.clear();
+        if (!reader.parseString(key) || !reader.parseColon()) {
+            return;
+        }
+
+        if (key == "snapshot") {
+            auto snapshotJSON = readValueFromJSONReader(reader);
+            if (reader.hasError()) {
+                return;
+            }
+            if (!parseSnapshot(snapshotJSON, nodeCount, edgeCount)) {
+                reader.setErrorAtCurrentPosition("Failed to parse snapshot");
+                return;
+            }
+        } else if (key == "nodes") {
+            // Nodes and edges are visited later through readers positioned at the start of their arrays
+            nodesPosition = reader.position();
+            hasNodes = skipUIntArray(reader, nodesComponentsCount);
+            if (!hasNodes) {
+                return;
+            }
+        } else if (key == "edges") {
+            edgesPosition = reader.position();
+            hasEdges = skipUIntArray(reader, edgesComponentsCount);
+            if (!hasEdges) {
+                return;
+            }
+        } else if (key == "strings") {
+            parseStrings(reader);
+            if (reader.hasError()) {
+                return;
+            }
+        } else {
+            // Unknown key, just consume the JSONReader
+            readValueFromJSONReader(reader);
+            if (reader.hasError()) {
+                return;
+            }
+        }
+    }
+
+    if (!reader.ensureIsAtEnd()) {
+        return;
+    }
+
+    if (!_fieldsIndexes.isPopulated() || !hasNodes || !hasEdges) {
+        reader.setErrorAtCurrentPosition("Missing snapshot, nodes or edges");
+        return;
+    }
+
+    if (nodeCount < 0 || edgeCount < 0 ||
+        nodesComponentsCount != static_cast<size_t>(nodeCount) * _fieldsIndexes.fieldsCountPerNode ||
+        edgesComponentsCount != static_cast<size_t>(edgeCount) * _fieldsIndexes.fieldsCountPerEdge) {
+        reader.setErrorAtCurrentPosition("Nodes or edges do not match the snapshot counts");
+        return;
+    }
+}
+
+Result<Void> JavaScriptHeapDumpParser::visitEntries(std::string_view json,
+                                                    int32_t nodeCount,
+                                                    int32_t edgeCount,
+                                                    size_t nodesPosition,
+                                                    size_t edgesPosition,
+                                                    JavaScriptHeapDumpVisitor& visitor) {
+    JSONReader nodesReader(json.substr(nodesPosition));
+    JSONReader edgesReader(json.substr(edgesPosition));
+    if (!nodesReader.parseBeginArray()) {
+        return nodesReader.getError();
+    }
+    if (!edgesReader.parseBeginArray()) {
+        return edgesReader.getError();
+    }
+
+    SmallVector<uint32_t, 8> nodeComponents;
+    nodeComponents.resize(_fieldsIndexes.fieldsCountPerNode);
+    const auto* nodeComponentsPtr = nodeComponents.data();
+
+    SmallVector<uint32_t, 4> edgeComponents;
+    edgeComponents.resize(_fieldsIndexes.fieldsCountPerEdge);
+    const auto* edgeComponentsPtr = edgeComponents.data();
+
+    auto nodeTypeMaxSize = static_cast<uint32_t>(_fieldsIndexes.nodeTypeByIndex.size());
+    auto edgeTypeMaxSize = static_cast<uint32_t>(_fieldsIndexes.edgeTypeByIndex.size());
+    auto stringsSize = static_cast<uint32_t>(_strings.size());
+    int32_t visitedEdgesCount = 0;
+
+    for (int32_t i = 0; i < nodeCount; i++) {
+        if (!parseComponents(nodesReader, nodeComponents, i == 0)) {
+            return nodesReader.getError();
+        }
+
+        auto typeIndex = nodeComponentsPtr[_fieldsIndexes.nodes.type];
+        auto nameIndex = nodeComponentsPtr[_fieldsIndexes.nodes.name];
+        auto edgesCount = nodeComponentsPtr[_fieldsIndexes.nodes.edgeCount];
+
+        if (typeIndex >= nodeTypeMaxSize) {
+            nodesReader.setErrorAtCurrentPosition("Out of bounds nodeType");
+            return nodesReader.getError();
+        }
+        if (nameIndex >= stringsSize) {
+            nodesReader.setErrorAtCurrentPosition("Out of bounds name");
+            return nodesReader.getError();
+        }
+        if (edgesCount > static_cast<uint32_t>(edgeCount - visitedEdgesCount)) {
+            nodesReader.setErrorAtCurrentPosition("Out of bounds edges");
+            return nodesReader.getError();
+        }
+
+        visitor.visitNode(static_cast<size_t>(i),
+                          _fieldsIndexes.nodeTypeByIndex[typeIndex],
+                          _strings[nameIndex],
+                          static_cast<uint64_t>(nodeComponentsPtr[_fieldsIndexes.nodes.id]),
+                          nodeComponentsPtr[_fieldsIndexes.nodes.selfSize]);
+
+        for (uint32_t j = 0; j < edgesCount; j++) {
+            if (!parseComponents(edgesReader, edgeComponents, visitedEdgesCount == 0)) {
+                return edgesReader.getError();
+            }
+            visitedEdgesCount++;
+
+            auto edgeTypeIndex = edgeComponentsPtr[_fieldsIndexes.edges.type];
+            auto edgeNameOrIndex = edgeComponentsPtr[_fieldsIndexes.edges.nameOrIndex];
+            auto edgeNodeIndex = edgeComponentsPtr[_fieldsIndexes.edges.toNode] / _fieldsIndexes.fieldsCountPerNode;
+
+            if (edgeTypeIndex >= edgeTypeMaxSize) {
+                edgesReader.setErrorAtCurrentPosition("Out of bounds edgeType");
+                return edgesReader.getError();
+            }
+
+            auto edgeType = _fieldsIndexes.edgeTypeByIndex[edgeTypeIndex];
+            if (edgeType != JavaScriptHeapDumpEdgeType::ELEMENT && edgeNameOrIndex >= stringsSize) {
+                edgesReader.setErrorAtCurrentPosition("Out of bounds name");
+                return edgesReader.getError();
+            }
+            if (edgeNodeIndex >= static_cast<uint32_t>(nodeCount)) {
+                edgesReader.setErrorAtCurrentPosition("Out of bounds node");
+                return edgesReader.getError();
+            }
+
+            visitor.visitEdge(edgeType,
+                              edgeType == JavaScriptHeapDumpEdgeType::ELEMENT ?
+                                  JavaScriptHeapEdgeIdentifier::indexed(edgeNameOrIndex) :
+                                  JavaScriptHeapEdgeIdentifier::named(_strings[edgeNameOrIndex]),
+                              edgeNodeIndex);
+        }
+    }
+
+    return Void();
+}
+
 std::span<const JavaScriptHeapDumpParser::Node> JavaScriptHeapDumpParser::getNodes() const {
     return _nodes;
 }
@@ -519,7 +790,88 @@ std::span<const JavaScriptHeapDumpParser::Edge> JavaScriptHeapDumpParser::Node::
 
 static constexpr size_t kElementsPerNode = 7;
 
+JavaScriptHeapDumpFileOutput::JavaScriptHeapDumpFileOutput(int fd) : _fd(fd) {}
+JavaScriptHeapDumpFileOutput::~JavaScriptHeapDumpFileOutput() = default;
+
+Result<Void> JavaScriptHeapDumpFileOutput::write(const Byte* data, size_t length) {
+    while (length > 0) {
+        auto written = ::write(_fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return Error(STRING_FORMAT("Failed to write heap dump to fd '{}': {}", _fd, strerror(errno)));
+        }
+
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+
+    return Void();
+}
+
+JavaScriptHeapDumpBufferOutput::JavaScriptHeapDumpBufferOutput(ByteBuffer& buffer) : _buffer(buffer) {}
+JavaScriptHeapDumpBufferOutput::~JavaScriptHeapDumpBufferOutput() = default;
+
+Result<Void> JavaScriptHeapDumpBufferOutput::write(const Byte* data, size_t length) {
+    _buffer.append(data, data + length);
+    return Void();
+}
+
+namespace {
+
+/**
+ JSONWriter which hands its content to a JavaScriptHeapDumpOutput whenever
+ it has accumulated kOutputChunkSize bytes.
+ */
+class ChunkedHeapDumpWriter {
+public:
+    explicit ChunkedHeapDumpWriter(JavaScriptHeapDumpOutput& output) : _output(output), _writer(_buffer) {
+        _buffer.reserve(JavaScriptHeapDumpBuilder::kOutputChunkSize + 256);
+    }
+
+    JSONWriter& getWriter() {
+        return _writer;
+    }
+
+    bool flushIfNeeded() {
+        if (_buffer.size() < JavaScriptHeapDumpBuilder::kOutputChunkSize) {
+            return true;
+        }
+        return flush();
+    }
+
+    bool flush() {
+        if (_buffer.size() == 0) {
+            return true;
+        }
+
+        _result = _output.write(_buffer.data(), _buffer.size());
+        _buffer.clear();
+        return _result.success();
+    }
+
+    Result<Void> finish() {
+        flush();
+        return _result;
+    }
+
+private:
+    JavaScriptHeapDumpOutput& _output;
+    ByteBuffer _buffer;
+    JSONWriter _writer;
+    Result<Void> _result = Void();
+};
+
+} // namespace
+
+void JavaScriptHeapDumpBuilder::FileCloser::operator()(FILE* file) const {
+    fclose(file);
+}
+
 JavaScriptHeapDumpBuilder::JavaScriptHeapDumpBuilder() = default;
+JavaScriptHeapDumpBuilder::JavaScriptHeapDumpBuilder(size_t maxBufferedEntries, Path spillDirectory)
+    : _maxBufferedEntries(maxBufferedEntries), _spillDirectory(std::move(spillDirectory)) {}
 JavaScriptHeapDumpBuilder::~JavaScriptHeapDumpBuilder() = default;
 
 static void writeSnapshot(size_t nodeCount, size_t edgeCount, JSONWriter& writer) {
@@ -589,20 +941,45 @@ static void writeSnapshot(size_t nodeCount, size_t edgeCount, JSONWriter& writer
 }
 
 BytesView JavaScriptHeapDumpBuilder::build() {
-    SC_ASSERT(_nodes.size() == _nodeById.size());
+    auto buffer = makeShared<ByteBuffer>();
+    JavaScriptHeapDumpBufferOutput output(*buffer);
+    auto result = build(output);
+    SC_ASSERT(result.success(), result.description());
+
+    return buffer->toBytesView();
+}
+
+static Result<Void> onBuildFailed(ChunkedHeapDumpWriter& chunkedWriter) {
+    auto result = chunkedWriter.finish();
+    if (result) {
+        // The output did not fail, so the failure comes from reading back the spilled entries
+        return Error("Failed to read spilled heap dump entries");
+    }
+    return result;
+}
+
+Result<Void> JavaScriptHeapDumpBuilder::build(JavaScriptHeapDumpOutput& output) {
+    SC_ASSERT(getNodesCount() == _nodeById.size());
 
-    auto output = makeShared<ByteBuffer>();
-    JSONWriter writer(*output);
+    ChunkedHeapDumpWriter chunkedWriter(output);
+    auto& writer = chunkedWriter.getWriter();
 
     writer.writeBeginObject();
 
     writer.writeProperty("snapshot");
-    writeSnapshot(_nodes.size(), _edges.size(), writer);
+    writeSnapshot(getNodesCount(), getEdgesCount(), writer);
     writer.writeComma();
     writer.writeNewLine();
 
     writer.writeProperty("nodes");
-    writer.writeArray(_nodes, [&](const JavaScriptHeapDumpBuilder::Node& node) {
+    writer.writeBeginArray();
+    auto isFirst = true;
+    auto success = forEachEntry(_nodes, _spilledNodes, _spilledNodesCount, [&](const Node& node) {
+        if (!isFirst) {
+            writer.writeComma();
+        }
+        isFirst = false;
+
         /**
          0    type    The type of node. See Node types, below.
          1    name    The name of the node. This is a number that's the index in the top-level strings array. To find
@@ -628,12 +1005,25 @@ BytesView JavaScriptHeapDumpBuilder::build() {
         writer.writeInt(static_cast<int32_t>(0));
         writer.writeComma();
         writer.writeInt(static_cast<int32_t>(0));
+
+        return chunkedWriter.flushIfNeeded();
     });
+    if (!success) {
+        return onBuildFailed(chunkedWriter);
+    }
+    writer.writeEndArray();
     writer.writeComma();
     writer.writeNewLine();
 
     writer.writeProperty("edges");
-    writer.writeArray(_edges, [&](const JavaScriptHeapDumpBuilder::Edge& edge) {
+    writer.writeBeginArray();
+    isFirst = true;
+    success = forEachEntry(_edges, _spilledEdges, _spilledEdgesCount, [&](const Edge& edge) {
+        if (!isFirst) {
+            writer.writeComma();
+        }
+        isFirst = false;
+
         /**
          0    type    The type of edge. See Edge types to find out what are the possible types.
          1    name_or_index    This can be a number or a string. If it's a number, it corresponds to the index in the
@@ -649,16 +1039,35 @@ BytesView JavaScriptHeapDumpBuilder::build() {
         writer.writeInt(edge.nameOrIndex);
         writer.writeComma();
         writer.writeInt(static_cast<int32_t>(indexedNode.nodeIndex.value() * kElementsPerNode));
+
+        return chunkedWriter.flushIfNeeded();
     });
+    if (!success) {
+        return onBuildFailed(chunkedWriter);
+    }
+    writer.writeEndArray();
     writer.writeComma();
     writer.writeNewLine();
 
     writer.writeProperty("strings");
-    writer.writeArray(_stringTable, [&](const StringBox& str) { writer.writeString(str.toStringView()); });
+    writer.writeBeginArray();
+    isFirst = true;
+    for (const auto& str : _stringTable) {
+        if (!isFirst) {
+            writer.writeComma();
+        }
+        isFirst = false;
+
+        writer.writeString(str.toStringView());
+        if (!chunkedWriter.flushIfNeeded()) {
+            return chunkedWriter.finish();
+        }
+    }
+    writer.writeEndArray();
 
     writer.writeEndObject();
 
-    return output->toBytesView();
+    return chunkedWriter.finish();
 }
 
 void JavaScriptHeapDumpBuilder::appendDump(const Byte* data, size_t length, ExceptionTracker& exceptionTracker) {
@@ -694,9 +1103,15 @@ void JavaScriptHeapDumpBuilder::beginNode(JavaScriptHeapDumpNodeType type,
                                           size_t selfSizeBytes) {
     auto& referencedNode = getReferencedNode(nodeId);
     SC_ASSERT(!referencedNode.nodeIndex.has_value());
-    auto newNodeIndex = _nodes.size();
+    auto newNodeIndex = getNodesCount();
     referencedNode.nodeIndex = {newNodeIndex};
 
+    // The previous node is complete at this point, so this is the only place
+    // where nodes can be spilled without invalidating the current node.
+    if (_maxBufferedEntries != 0 && _nodes.size() >= _maxBufferedEntries) {
+        spill(_nodes, _spilledNodes, _spilledNodesCount);
+    }
+
     auto& node = _nodes.emplace_back();
 
     node.type = static_cast<int32_t>(type);
@@ -717,7 +1132,7 @@ void JavaScriptHeapDumpBuilder::appendEdge(JavaScriptHeapDumpEdgeType type,
 void JavaScriptHeapDumpBuilder::appendEdge(JavaScriptHeapDumpEdgeType type,
                                            const JavaScriptHeapEdgeIdentifier& identifier,
                                            uint64_t nodeId) {
-    auto& edge = _edges.emplace_back();
+    auto& edge = appendEdgeEntry();
     edge.type = static_cast<int32_t>(type);
     edge.nodeId = getReferencedNode(nodeId).id;
     _currentNode->edgeCount++;
@@ -753,7 +1168,7 @@ void JavaScriptHeapDumpBuilder::appendEdgeToValue(JavaScriptHeapDumpEdgeType typ
     }
 
     if (!referencedNode->nodeIndex) {
-        referencedNode->nodeIndex = {_nodes.size()};
+        referencedNode->nodeIndex = {getNodesCount()};
 
         auto internedName = StringCache::getGlobal().makeString(std::string_view(stringValue));
 
@@ -765,10 +1180,10 @@ void JavaScriptHeapDumpBuilder::appendEdgeToValue(JavaScriptHeapDumpEdgeType typ
         node.selfSize = static_cast<int32_t>(valueSelfSizeBytes);
 
         // Restore current node
-        _currentNode = &_nodes[_currentNodeIndex];
+        _currentNode = &_nodes[_currentNodeIndex - _spilledNodesCount];
     }
 
-    auto& edge = _edges.emplace_back();
+    auto& edge = appendEdgeEntry();
     edge.type = static_cast<int32_t>(type);
     edge.nodeId = referencedNode->id;
 
@@ -801,6 +1216,108 @@ JavaScriptHeapDumpBuilder::ReferencedNode& JavaScriptHeapDumpBuilder::appendRefe
     return referencedNode;
 }
 
+JavaScriptHeapDumpBuilder::Edge& JavaScriptHeapDumpBuilder::appendEdgeEntry() {
+    if (_maxBufferedEntries != 0 && _edges.size() >= _maxBufferedEntries) {
+        spill(_edges, _spilledEdges, _spilledEdgesCount);
+    }
+
+    return _edges.emplace_back();
+}
+
+size_t JavaScriptHeapDumpBuilder::getNodesCount() const {
+    return _spilledNodesCount + _nodes.size();
+}
+
+size_t JavaScriptHeapDumpBuilder::getEdgesCount() const {
+    return _spilledEdgesCount + _edges.size();
+}
+
+JavaScriptHeapDumpBuilder::SpillFile JavaScriptHeapDumpBuilder::openSpillFile() const {
+    if (_spillDirectory.empty()) {
+        return SpillFile(tmpfile());
+    }
+
+    // tmpfile() relies on a system temporary directory, which is not writable on every
+    // platform (e.g. Android), so we create the file ourselves inside the spill directory.
+    auto pathTemplate = _spillDirectory.appending("heap_dump_spill_XXXXXX").toString();
+    auto fd = mkstemp(pathTemplate.data());
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    // The file is only reachable through its descriptor, and is removed once closed
+    unlink(pathTemplate.c_str());
+
+    auto* file = fdopen(fd, "w+b");
+    if (file == nullptr) {
+        close(fd);
+    }
+
+    return SpillFile(file);
+}
+
+template<typename T>
+void JavaScriptHeapDumpBuilder::spill(std::vector<T>& entries, SpillFile& file, size_t& spilledCount) {
+    if (file == nullptr) {
+        file = openSpillFile();
+        if (file == nullptr) {
+            // Keep everything in memory if we can't create a temporary file
+            _maxBufferedEntries = 0;
+            return;
+        }
+    }
+
+    // Entries are only accounted for once the write fully succeeded. Partially written
+    // entries at the end of the file are never read back, as we only read spilledCount entries.
+    if (fseeko(file.get(), static_cast<off_t>(spilledCount * sizeof(T)), SEEK_SET) != 0 ||
+        fwrite(entries.data(), sizeof(T), entries.size(), file.get()) != entries.size()) {
+        _maxBufferedEntries = 0;
+        return;
+    }
+
+    spilledCount += entries.size();
+    entries.clear();
+}
+
+template<typename T, typename F>
+bool JavaScriptHeapDumpBuilder::forEachEntry(const std::vector<T>& entries,
+                                             const SpillFile& file,
+                                             size_t spilledCount,
+                                             F&& fn) const {
+    if (spilledCount > 0) {
+        if (fseeko(file.get(), 0, SEEK_SET) != 0) {
+            return false;
+        }
+
+        std::vector<T> chunk;
+        chunk.resize(std::min(spilledCount, std::max(_maxBufferedEntries, static_cast<size_t>(1024))));
+
+        auto remaining = spilledCount;
+        while (remaining > 0) {
+            auto chunkSize = std::min(remaining, chunk.size());
+            if (fread(chunk.data(), sizeof(T), chunkSize, file.get()) != chunkSize) {
+                return false;
+            }
+
+            for (size_t i = 0; i < chunkSize; i++) {
+                if (!fn(chunk[i])) {
+                    return false;
+                }
+            }
+
+            remaining -= chunkSize;
+        }
+    }
+
+    for (const auto& entry : entries) {
+        if (!fn(entry)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
 int32_t JavaScriptHeapDumpBuilder::getStringTableIndex(const StringBox& str) {
     const auto& it = _stringToStringTableIndex.find(str);
     if (it != _stringToStringTableIndex.end()) {
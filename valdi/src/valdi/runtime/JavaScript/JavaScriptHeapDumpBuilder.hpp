@@ -10,6 +10,8 @@
 #include "valdi_core/cpp/Utils/Bytes.hpp"
 #include "valdi_core/cpp/Utils/ExceptionTracker.hpp"
 #include "valdi_core/cpp/Utils/FlatMap.hpp"
+#include "valdi_core/cpp/Utils/PathUtils.hpp"
+#include "valdi_core/cpp/Utils/Result.hpp"
 #include "valdi_core/cpp/Utils/SmallVector.hpp"
 #include "valdi_core/cpp/Utils/StaticString.hpp"
 #include "valdi_core/cpp/Utils/StringBox.hpp"
@@ -17,11 +19,15 @@
 #include "valdi_core/cpp/Utils/ValueArrayBuilder.hpp"
 
 #include <cstdint>
+#include <cstdio>
+#include <memory>
 #include <span>
+#include <string_view>
 #include <vector>
 
 namespace Valdi {
 
+class ByteBuffer;
 class JSONReader;
 
 /**
@@ -131,9 +137,61 @@ private:
     JavaScriptHeapEdgeIdentifier(Value&& value);
 };
 
+/**
+ Destination into which a heap dump is written incrementally.
+ */
+class JavaScriptHeapDumpOutput {
+public:
+    virtual ~JavaScriptHeapDumpOutput() = default;
+
+    virtual Result<Void> write(const Byte* data, size_t length) = 0;
+};
+
+/**
+ Writes a heap dump into a file descriptor, which is not owned by the output.
+ */
+class JavaScriptHeapDumpFileOutput : public JavaScriptHeapDumpOutput {
+public:
+    explicit JavaScriptHeapDumpFileOutput(int fd);
+    ~JavaScriptHeapDumpFileOutput() override;
+
+    Result<Void> write(const Byte* data, size_t length) override;
+
+private:
+    int _fd;
+};
+
+/**
+ Writes a heap dump into a ByteBuffer, which is not owned by the output.
+ */
+class JavaScriptHeapDumpBufferOutput : public JavaScriptHeapDumpOutput {
+public:
+    explicit JavaScriptHeapDumpBufferOutput(ByteBuffer& buffer);
+    ~JavaScriptHeapDumpBufferOutput() override;
+
+    Result<Void> write(const Byte* data, size_t length) override;
+
+private:
+    ByteBuffer& _buffer;
+};
+
 class JavaScriptHeapDumpBuilder {
 public:
+    /**
+     Size of the chunks in which the JSON representation is handed to a JavaScriptHeapDumpOutput.
+     */
+    static constexpr size_t kOutputChunkSize = 64 * 1024;
+
     JavaScriptHeapDumpBuilder();
+
+    /**
+     Create a builder which keeps at most maxBufferedEntries nodes and edges in memory.
+     Nodes and edges beyond that are spilled into anonymous files created inside spillDirectory,
+     or through tmpfile() when spillDirectory is empty, and read back in chunks when the dump is written.
+     Everything is kept in memory if the spill files cannot be created. The node id table and the
+     strings table remain in memory, as they are needed to resolve edges and to deduplicate names.
+     */
+    JavaScriptHeapDumpBuilder(size_t maxBufferedEntries, Path spillDirectory);
     ~JavaScriptHeapDumpBuilder();
 
     /**
@@ -187,6 +245,12 @@ public:
 
     BytesView build();
 
+    /**
+     Write the heap dump into the given output, in chunks of kOutputChunkSize bytes,
+     without materializing its full JSON representation.
+     */
+    Result<Void> build(JavaScriptHeapDumpOutput& output);
+
 private:
     /**
      Represents a Node that has been visited through the beginNode() method.
@@ -242,8 +306,20 @@ private:
         std::optional<size_t> nodeIndex;
     };
 
+    struct FileCloser {
+        void operator()(FILE* file) const;
+    };
+    using SpillFile = std::unique_ptr<FILE, FileCloser>;
+
+    // The nodes and edges which have not been spilled yet.
     std::vector<Node> _nodes;
     std::vector<Edge> _edges;
+    size_t _spilledNodesCount = 0;
+    size_t _spilledEdgesCount = 0;
+    size_t _maxBufferedEntries = 0;
+    Path _spillDirectory;
+    SpillFile _spilledNodes;
+    SpillFile _spilledEdges;
     std::vector<ReferencedNode> _nodeById;
     FlatMap<uint64_t, size_t> _nodePtrToIndex;
     std::vector<StringBox> _stringTable;
@@ -257,6 +333,19 @@ private:
     ReferencedNode& appendReferencedNode();
 
     int32_t getStringTableIndex(const StringBox& str);
+
+    size_t getNodesCount() const;
+    size_t getEdgesCount() const;
+
+    Edge& appendEdgeEntry();
+
+    SpillFile openSpillFile() const;
+
+    template<typename T>
+    void spill(std::vector<T>& entries, SpillFile& file, size_t& spilledCount);
+
+    template<typename T, typename F>
+    bool forEachEntry(const std::vector<T>& entries, const SpillFile& file, size_t spilledCount, F&& fn) const;
 };
 
 /**
@@ -304,6 +393,26 @@ private:
     bool resolveEdgeTypeByIndex(const ValueArray* edgeTypes);
 };
 
+/**
+ Receives the content of a heap dump visited through JavaScriptHeapDumpParser::visit().
+ The edges of a node are visited right after it, and refer to their destination node
+ by its index in the visiting order.
+ */
+class JavaScriptHeapDumpVisitor {
+public:
+    virtual ~JavaScriptHeapDumpVisitor() = default;
+
+    virtual void visitNode(size_t nodeIndex,
+                           JavaScriptHeapDumpNodeType type,
+                           const StringBox& name,
+                           uint64_t id,
+                           size_t selfSizeBytes) = 0;
+
+    virtual void visitEdge(JavaScriptHeapDumpEdgeType type,
+                           const JavaScriptHeapEdgeIdentifier& identifier,
+                           size_t nodeIndex) = 0;
+};
+
 /**
  Helper that can parse a Chrome heap dump and provide all the nodes and edges in a structured format.
  Takes care of validation during parsing.
@@ -311,8 +420,23 @@ private:
 class JavaScriptHeapDumpParser {
 public:
     JavaScriptHeapDumpParser(const Byte* data, size_t length, ExceptionTracker& exceptionTracker);
+
+    /**
+     Parse the heap dump stored at the given path. The file is mapped in memory
+     for the duration of the parsing instead of being loaded.
+     */
+    JavaScriptHeapDumpParser(const Path& path, ExceptionTracker& exceptionTracker);
     ~JavaScriptHeapDumpParser();
 
+    /**
+     Visit the nodes and edges of the heap dump stored at the given path without building
+     the nodes and edges tables, which lets large dumps be processed with a memory usage
+     bounded by the size of their strings table. The file is mapped in memory for the
+     duration of the visit. Entries are validated as they are visited, and an error
+     might be reported after some of them were already given to the visitor.
+     */
+    static void visit(const Path& path, JavaScriptHeapDumpVisitor& visitor, ExceptionTracker& exceptionTracker);
+
     struct Node;
     struct Edge {
     public:
@@ -374,7 +498,21 @@ private:
     friend JavaScriptHeapDumpParser::Node;
     friend JavaScriptHeapDumpParser::Edge;
 
+    JavaScriptHeapDumpParser();
+
+    void parse(const Byte* data, size_t length, ExceptionTracker& exceptionTracker);
     void parseHeapDump(JSONReader& reader);
+    void indexHeapDump(JSONReader& reader,
+                       int32_t& nodeCount,
+                       int32_t& edgeCount,
+                       size_t& nodesPosition,
+                       size_t& edgesPosition);
+    Result<Void> visitEntries(std::string_view json,
+                              int32_t nodeCount,
+                              int32_t edgeCount,
+                              size_t nodesPosition,
+                              size_t edgesPosition,
+                              JavaScriptHeapDumpVisitor& visitor);
     bool parseSnapshot(const Value& snapshot, int32_t& nodeCount, int32_t& edgeCount);
     void parseNodes(JSONReader& reader, int32_t nodeCount);
     void parseEdges(JSONReader& reader, int32_t edgeCount);
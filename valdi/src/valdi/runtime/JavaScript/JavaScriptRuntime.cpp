@@ -15,6 +15,7 @@
 #include "utils/time/StopWatch.hpp"
 #include "valdi/JSRuntimeNativeObjectsManager.hpp"
 #include "valdi/runtime/Attributes/AttributeIds.hpp"
+#include "valdi/runtime/JavaScript/JSBatchedCallDispatcher.hpp"
 #include "valdi/runtime/JavaScript/JSFunctionWithCallable.hpp"
 #include "valdi/runtime/JavaScript/JSFunctionWithMethod.hpp"
 #include "valdi/runtime/JavaScript/JSFunctionWithValueFunction.hpp"
@@ -26,13 +27,17 @@
 #include "valdi/runtime/JavaScript/JavaScriptUtils.hpp"
 #include "valdi/runtime/JavaScript/JavaScriptValueMarshaller.hpp"
 #include "valdi/runtime/JavaScript/JavaScriptWorker.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptWorkerPool.hpp"
 #include "valdi/runtime/JavaScript/ValueFunctionWithJSValue.hpp"
 #include "valdi/runtime/Resources/DirectionalAsset.hpp"
 #include "valdi/runtime/Resources/PlatformSpecificAsset.hpp"
 #include "valdi/runtime/ValdiRuntimeTweaks.hpp"
 #include "valdi_core/cpp/Constants.hpp"
+#include "valdi_core/cpp/Threading/DispatchQueueInstrumentation.hpp"
+#include "valdi_core/cpp/Threading/DispatchQueue.hpp"
 #include "valdi_core/cpp/Resources/LoadedAsset.hpp"
 #include "valdi_core/cpp/Resources/ResourceId.hpp"
+#include "valdi_core/cpp/Utils/ByteBuffer.hpp"
 #include "valdi_core/cpp/Utils/ConsoleLogger.hpp"
 #include "valdi_core/cpp/Utils/LoggerUtils.hpp"
 #include "valdi_core/cpp/Utils/Marshaller.hpp"
@@ -42,12 +47,15 @@
 #include "valdi_core/cpp/Utils/StringCache.hpp"
 #include "valdi_core/cpp/Utils/TimePoint.hpp"
 #include "valdi_core/cpp/Utils/Trace.hpp"
+#include "valdi_core/cpp/Utils/ValueArena.hpp"
 #include "valdi_core/cpp/Utils/ValueArrayBuilder.hpp"
 #include "valdi_core/cpp/Utils/ValueFunction.hpp"
 #include "valdi_core/cpp/Utils/ValueMap.hpp"
 
 #include "valdi/runtime/JavaScript/JavaScriptANRDetector.hpp"
 #include "valdi/runtime/JavaScript/JavaScriptRuntimeDeserializers.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptSharedModuleCache.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptStartupSnapshot.hpp"
 #include "valdi/runtime/JavaScript/Modules/JavaScriptModuleFactory.hpp"
 
 #include "valdi/runtime/Interfaces/IDiskCache.hpp"
@@ -80,8 +88,12 @@
 #include "utils/encoding/Base64Utils.hpp"
 #include "valdi/runtime/JavaScript/JavaScriptAssetLoadObserver.hpp"
 #include "valdi_core/cpp/Utils/ContainerUtils.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
 #include <fmt/format.h>
 #include <sstream>
+#include <unistd.h>
 
 #if defined(__ANDROID__)
 #include <malloc.h>
@@ -107,6 +119,8 @@ constexpr size_t kUnloadPropertyName = 3;
 constexpr size_t kRegisterModulePropertyName = 4;
 constexpr size_t kPreloadModulePropertyName = 5;
 
+constexpr std::string_view kStartupSnapshotFileName = "snapshot.bin";
+
 const ResourceId& valdiModuleResourceId() {
     static auto kValdiModuleResourceId =
         JavaScriptPathResolver::resolveResourceId(STRING_LITERAL("valdi_core/src/Valdi")).value();
@@ -119,6 +133,14 @@ const ResourceId& symbolicatorResourceId() {
     return kSymbolicatorResourceId;
 }
 
+// Warming up the preprocessor cache is only an optimization, it runs at low priority
+// so that it does not delay the JS thread nor the renders
+static const Ref<DispatchQueue>& getPreprocessorCacheWarmUpQueue() {
+    static auto* kQueue =
+        new Ref<DispatchQueue>(DispatchQueue::create(STRING_LITERAL("Valdi Preprocessor Warm Up"), ThreadQoSClassLow));
+    return *kQueue;
+}
+
 static ContextId getParameterAsContextId(JSFunctionNativeCallContext& callContext, size_t index) {
     return static_cast<ContextId>(callContext.getParameterAsInt(index));
 }
@@ -308,6 +330,7 @@ void JavaScriptRuntime::postInit() {
         auto runtimeTweaks = _listener->getRuntimeTweaks();
         if (runtimeTweaks != nullptr) {
             _dispatchQueue->setDisableSyncCallsInCallingThread(runtimeTweaks->disableSyncCallsInCallingThread());
+            _dispatchQueue->setInstrumentationEnabled(runtimeTweaks->enableQueueInstrumentation());
         }
     }
 }
@@ -391,6 +414,7 @@ void JavaScriptRuntime::teardown(bool destroyContext) {
                 _contextHandler = nullptr;
             }
             _runtimeDeserializers = nullptr;
+            _batchedCallDispatcher = nullptr;
             _propertyNameIndex.setContext(nullptr);
             auto weakJavaScriptContext = weakRef(_javaScriptContext.get());
             _javaScriptContext = nullptr;
@@ -454,6 +478,7 @@ Result<Void> JavaScriptRuntime::initializeContext() {
     auto jsContext = _javaScriptBridge.createJsContext(this, *_logger);
 
     std::unique_ptr<JavaScriptRuntimeDeserializers> runtimeDeserializers;
+    std::unique_ptr<JSBatchedCallDispatcher> batchedCallDispatcher;
 
     IJavaScriptContextConfig config;
 
@@ -463,14 +488,27 @@ Result<Void> JavaScriptRuntime::initializeContext() {
     if (exceptionTracker) {
         jsContext->startDebugger(_isWorker);
 
+        if (runtimeTweaks != nullptr && _listener->getDiskCache() != nullptr) {
+            const auto& diskCache = _listener->getDiskCache();
+            if (runtimeTweaks->enableJsBytecodeDiskCache()) {
+                jsContext->setBytecodeDiskCache(diskCache->scopedCache(Path("js_bytecode"), false));
+            }
+            // Workers load different modules, only the main JS runtime is snapshotted
+            if (!_isWorker && runtimeTweaks->enableJsStartupSnapshot() && jsContext->supportsPreCompilation()) {
+                prepareStartupSnapshot(*jsContext, diskCache);
+            }
+        }
+
         runtimeDeserializers =
             std::make_unique<JavaScriptRuntimeDeserializers>(*jsContext, _stringCache, getStyleAttributesCache());
+        batchedCallDispatcher = std::make_unique<JSBatchedCallDispatcher>(*jsContext);
         buildContext(*jsContext, runtimeTweaks, exceptionTracker);
     }
 
     if (exceptionTracker) {
         _javaScriptContext = std::move(jsContext);
         _runtimeDeserializers = std::move(runtimeDeserializers);
+        _batchedCallDispatcher = std::move(batchedCallDispatcher);
         _propertyNameIndex.setContext(_javaScriptContext.get());
         return Void();
     } else {
@@ -853,6 +891,7 @@ JSValueRef JavaScriptRuntime::runtimeSubmitRenderRequest(JSFunctionNativeCallCon
     auto renderRequest = _runtimeDeserializers->deserializeRenderRequest(rawRequest, referenceInfo, exceptionTracker);
     if (exceptionTracker && _listener != nullptr) {
         _listener->receivedRenderRequest(renderRequest);
+        finishStartupSnapshot();
     }
     if (callback != nullptr) {
         (*callback)();
@@ -860,6 +899,59 @@ JSValueRef JavaScriptRuntime::runtimeSubmitRenderRequest(JSFunctionNativeCallCon
     return callContext.getContext().newUndefined();
 }
 
+JSValueRef JavaScriptRuntime::runtimeGetRenderRequestTransportBuffer(JSFunctionNativeCallContext& callContext) {
+    return _runtimeDeserializers->getTransportBuffer(callContext.getExceptionTracker());
+}
+
+JSValueRef JavaScriptRuntime::runtimeSubmitRenderRequestFromTransportBuffer(JSFunctionNativeCallContext& callContext) {
+    auto treeId = static_cast<ContextId>(callContext.getParameterAsInt(0));
+    CHECK_CALL_CONTEXT(callContext);
+    auto descriptorSize = static_cast<int64_t>(callContext.getParameterAsInt(1));
+    CHECK_CALL_CONTEXT(callContext);
+
+    auto renderRequest =
+        _runtimeDeserializers->deserializeRenderRequestFromTransportBuffer(treeId,
+                                                                           descriptorSize,
+                                                                           callContext.getParameter(2),
+                                                                           callContext.getParameter(3),
+                                                                           callContext.getParameter(4),
+                                                                           callContext.getExceptionTracker());
+    CHECK_CALL_CONTEXT(callContext);
+
+    // The descriptor has been fully consumed at this point, the transport buffer
+    // can be reused by a render request submitted while processing this one.
+    if (_listener != nullptr) {
+        _listener->receivedRenderRequest(renderRequest);
+        finishStartupSnapshot();
+    }
+    return callContext.getContext().newUndefined();
+}
+
+JSValueRef JavaScriptRuntime::runtimeRegisterBatchedFunction(JSFunctionNativeCallContext& callContext) {
+    return _batchedCallDispatcher->registerFunction(callContext.getParameter(0), callContext.getExceptionTracker());
+}
+
+JSValueRef JavaScriptRuntime::runtimeGetBatchedCallBuffer(JSFunctionNativeCallContext& callContext) {
+    return _batchedCallDispatcher->getCallBuffer(callContext.getExceptionTracker());
+}
+
+JSValueRef JavaScriptRuntime::runtimeGetBatchedCallResultBuffer(JSFunctionNativeCallContext& callContext) {
+    return _batchedCallDispatcher->getResultBuffer(callContext.getExceptionTracker());
+}
+
+JSValueRef JavaScriptRuntime::runtimeSubmitBatchedCalls(JSFunctionNativeCallContext& callContext) {
+    auto callCount = callContext.getParameterAsInt(0);
+    CHECK_CALL_CONTEXT(callContext);
+
+    if (callCount < 0) {
+        return callContext.throwError(Error("Invalid batched call count"));
+    }
+
+    _batchedCallDispatcher->dispatch(
+        static_cast<size_t>(callCount), callContext.getParameter(1), callContext.getExceptionTracker());
+    return callContext.getContext().newUndefined();
+}
+
 // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
 JSValueRef JavaScriptRuntime::runtimeTrace(JSFunctionNativeCallContext& callContext) {
     auto traceName = callContext.getParameterAsString(0);
@@ -902,15 +994,20 @@ static double traceTimePointToEpochMicroseconds(const TraceTimePoint& timePoint)
     return static_cast<double>(asMicroseconds.count());
 }
 
+static std::vector<RecordedTrace> stopSortedTraceRecording(size_t id) {
+    auto traces = Tracer::shared().stopRecording(id);
+    std::sort(traces.begin(), traces.end(), [](const RecordedTrace& left, const RecordedTrace& right) -> bool {
+        return left.start < right.start;
+    });
+    return traces;
+}
+
 // NOLINTNEXTLINE(readability-convert-member-functions-to-static)
 JSValueRef JavaScriptRuntime::runtimeStopTraceRecording(JSFunctionNativeCallContext& callContext) {
     auto id = static_cast<size_t>(callContext.getParameterAsInt(0));
     CHECK_CALL_CONTEXT(callContext);
 
-    auto traces = Tracer::shared().stopRecording(static_cast<size_t>(id));
-    std::sort(traces.begin(), traces.end(), [](const RecordedTrace& left, const RecordedTrace& right) -> bool {
-        return left.start < right.start;
-    });
+    auto traces = stopSortedTraceRecording(id);
 
     ValueArrayBuilder output;
 
@@ -929,6 +1026,18 @@ JSValueRef JavaScriptRuntime::runtimeStopTraceRecording(JSFunctionNativeCallCont
                           callContext.getExceptionTracker());
 }
 
+// NOLINTNEXTLINE(readability-convert-member-functions-to-static)
+JSValueRef JavaScriptRuntime::runtimeStopTraceRecordingAsChromeTrace(JSFunctionNativeCallContext& callContext) {
+    auto id = static_cast<size_t>(callContext.getParameterAsInt(0));
+    CHECK_CALL_CONTEXT(callContext);
+
+    auto traces = stopSortedTraceRecording(id);
+    auto output = makeShared<ByteBuffer>();
+    writeChromeTraceJSON(traces, *output);
+
+    return callContext.getContext().newArrayBuffer(output->toBytesView(), callContext.getExceptionTracker());
+}
+
 JSValueRef JavaScriptRuntime::runtimeSubmitDebugMessage(JSFunctionNativeCallContext& callContext) {
     auto debugLevel = static_cast<int32_t>(callContext.getParameterAsInt(0));
     CHECK_CALL_CONTEXT(callContext);
@@ -1397,6 +1506,12 @@ ModuleLoadResult JavaScriptRuntime::loadJsModuleFromBytes(IJavaScriptContext& js
             "Valdi.evalJsModule",
             STRING_FORMAT("importPath: {}, jsModule size: {} bytes", importPath.toStringView(), jsModule.size()));
         auto preCompiledContent = getPreCompiledJsModuleData(jsModule);
+        if (!preCompiledContent && _startupSnapshotRecorder != nullptr) {
+            preCompiledContent = resolveStartupSnapshotModule(jsContext, jsModule, importPath);
+        }
+        if (!preCompiledContent && _sharedModuleCache != nullptr) {
+            preCompiledContent = _sharedModuleCache->getOrCompile(jsContext, importPath, jsModule);
+        }
 
         if (preCompiledContent) {
             moduleLoadMode = ModuleLoadMode::JS_BYTECODE;
@@ -1418,6 +1533,100 @@ ModuleLoadResult JavaScriptRuntime::loadJsModuleFromBytes(IJavaScriptContext& js
     return std::make_pair(jsContext.callObjectAsFunction(evalResult.get(), callContext), moduleLoadMode);
 }
 
+void JavaScriptRuntime::prepareStartupSnapshot(const IJavaScriptContext& jsContext,
+                                               const Ref<IDiskCache>& diskCache) {
+    VALDI_TRACE("Valdi.prepareStartupSnapshot");
+    _startupSnapshotDiskCache = diskCache->scopedCache(Path("js_startup_snapshot"), false);
+    // Bytecode can only be read back by the engine version which produced it
+    auto engineKey = STRING_FORMAT(
+        "{}-{}-{}", _javaScriptBridge.getName(), valdiVersion, jsContext.getPreCompilationVersion());
+    _startupSnapshotRecorder = makeShared<JavaScriptStartupSnapshot>(engineKey);
+
+    Path snapshotPath(kStartupSnapshotFileName);
+    if (!_startupSnapshotDiskCache->exists(snapshotPath)) {
+        _startupSnapshotChanged = true;
+        return;
+    }
+
+    auto snapshotBytes = _startupSnapshotDiskCache->load(snapshotPath);
+    if (!snapshotBytes) {
+        VALDI_WARN(*_logger, "Failed to load JS startup snapshot: {}", snapshotBytes.error());
+        _startupSnapshotChanged = true;
+        return;
+    }
+
+    auto snapshot = JavaScriptStartupSnapshot::deserialize(snapshotBytes.value(), engineKey);
+    if (!snapshot) {
+        VALDI_WARN(*_logger, "Discarding JS startup snapshot: {}", snapshot.error());
+        _startupSnapshotChanged = true;
+        return;
+    }
+
+    _startupSnapshot = snapshot.moveValue();
+    VALDI_DEBUG(*_logger, "Restored JS startup snapshot with {} modules", _startupSnapshot->size());
+}
+
+std::optional<BytesView> JavaScriptRuntime::resolveStartupSnapshotModule(IJavaScriptContext& jsContext,
+                                                                         const BytesView& jsModule,
+                                                                         const StringBox& importPath) {
+    std::optional<BytesView> preCompiledModule;
+    if (_startupSnapshot != nullptr) {
+        preCompiledModule = _startupSnapshot->getPreCompiledModule(importPath, jsModule);
+    }
+
+    if (!preCompiledModule) {
+        JSExceptionTracker exceptionTracker(jsContext);
+        auto compiledModule =
+            jsContext.preCompile(jsModule.asStringView(), importPath.toStringView(), exceptionTracker);
+        if (!exceptionTracker || compiledModule.empty()) {
+            // The module will be evaluated from source, which will report the error
+            exceptionTracker.clearError();
+            return std::nullopt;
+        }
+
+        preCompiledModule = compiledModule;
+        _startupSnapshotChanged = true;
+    }
+
+    // Modules are recorded again on every start so that the snapshot only holds
+    // the modules which are still loaded before the first render.
+    _startupSnapshotRecorder->addPreCompiledModule(importPath, jsModule, preCompiledModule.value());
+
+    return getPreCompiledJsModuleData(preCompiledModule.value());
+}
+
+void JavaScriptRuntime::finishStartupSnapshot() {
+    if (_startupSnapshotRecorder == nullptr) {
+        return;
+    }
+
+    auto recorder = _startupSnapshotRecorder;
+    _startupSnapshotRecorder = nullptr;
+    _startupSnapshot = nullptr;
+
+    if (!_startupSnapshotChanged) {
+        return;
+    }
+
+    auto saveSnapshot = [recorder, diskCache = _startupSnapshotDiskCache, logger = _logger]() {
+        VALDI_TRACE("Valdi.saveStartupSnapshot");
+        auto result = diskCache->store(Path(kStartupSnapshotFileName), recorder->serialize());
+        if (!result) {
+            VALDI_WARN(*logger, "Failed to save JS startup snapshot: {}", result.error());
+            return;
+        }
+
+        VALDI_DEBUG(*logger, "Saved JS startup snapshot with {} modules", recorder->size());
+    };
+
+    // This is called right as the first render is submitted, keep the write away from the JS thread
+    if (_listener != nullptr && _listener->getWorkerQueue() != nullptr) {
+        _listener->getWorkerQueue()->async(std::move(saveSnapshot));
+    } else {
+        saveSnapshot();
+    }
+}
+
 ModuleLoadResult JavaScriptRuntime::loadJsModuleFromNative(IJavaScriptContext& jsContext,
                                                            const StringBox& importPath,
                                                            const JSValueRef* parameters,
@@ -1520,6 +1729,12 @@ JSValueRef JavaScriptRuntime::runtimeGetCSSModule(JSFunctionNativeCallContext& c
 
     auto cssDocument = cssDocumentResult.moveValue();
 
+    if (_defaultViewManagerContext != nullptr) {
+        getPreprocessorCacheWarmUpQueue()->async([viewManagerContext = _defaultViewManagerContext, cssDocument]() {
+            viewManagerContext->getAttributesManager().warmUpPreprocessorCache(*cssDocument);
+        });
+    }
+
     static auto kFunctionName = STRING_LITERAL("getRule");
 
     auto lambdaFunction = makeShared<JSFunctionWithCallable>(
@@ -1910,7 +2125,10 @@ JSValueRef JavaScriptRuntime::runtimeDumpMemoryStatistics(JSFunctionNativeCallCo
     auto serializedMemoryStatistics =
         Value()
             .setMapValue("memoryUsageBytes", Value(static_cast<double>(memoryStatistics.memoryUsageBytes)))
-            .setMapValue("objectsCount", Value(static_cast<double>(memoryStatistics.objectsCount)));
+            .setMapValue("objectsCount", Value(static_cast<double>(memoryStatistics.objectsCount)))
+            .setMapValue("valueArenaPinnedChunksCount",
+                         Value(static_cast<double>(ValueArena::getPinnedChunksCount())))
+            .setMapValue("valueArenaPinnedBytes", Value(static_cast<double>(ValueArena::getPinnedBytes())));
 
     return valueToJSValue(callContext.getContext(),
                           serializedMemoryStatistics,
@@ -1918,6 +2136,37 @@ JSValueRef JavaScriptRuntime::runtimeDumpMemoryStatistics(JSFunctionNativeCallCo
                           callContext.getExceptionTracker());
 }
 
+static Value histogramSnapshotToValue(const HistogramSnapshot& snapshot) {
+    return Value()
+        .setMapValue("count", Value(static_cast<double>(snapshot.count)))
+        .setMapValue("meanUs", Value(snapshot.getMean()))
+        .setMapValue("p50Us", Value(static_cast<double>(snapshot.getValueAtPercentile(50))))
+        .setMapValue("p90Us", Value(static_cast<double>(snapshot.getValueAtPercentile(90))))
+        .setMapValue("p99Us", Value(static_cast<double>(snapshot.getValueAtPercentile(99))))
+        .setMapValue("maxUs", Value(static_cast<double>(snapshot.max)));
+}
+
+JSValueRef JavaScriptRuntime::runtimeDumpQueueStatistics(JSFunctionNativeCallContext& callContext) {
+    auto allStatistics = DispatchQueueInstrumentation::getAllStatistics();
+    auto serializedStatistics = ValueArray::make(allStatistics.size());
+
+    for (size_t i = 0; i < allStatistics.size(); i++) {
+        const auto& statistics = allStatistics[i];
+        serializedStatistics->emplace(
+            i,
+            Value()
+                .setMapValue("name", Value(statistics.name))
+                .setMapValue("maxDepth", Value(static_cast<double>(statistics.maxDepth)))
+                .setMapValue("waitTime", histogramSnapshotToValue(statistics.waitTimeMicros))
+                .setMapValue("runTime", histogramSnapshotToValue(statistics.runTimeMicros)));
+    }
+
+    return valueToJSValue(callContext.getContext(),
+                          Value(serializedStatistics),
+                          ReferenceInfoBuilder(),
+                          callContext.getExceptionTracker());
+}
+
 JSValueRef JavaScriptRuntime::runtimePerformGC(JSFunctionNativeCallContext& callContext) {
     dispatchPerformGcToWorkers();
     performGcNow(callContext.getContext());
@@ -1925,12 +2174,38 @@ JSValueRef JavaScriptRuntime::runtimePerformGC(JSFunctionNativeCallContext& call
 }
 
 JSValueRef JavaScriptRuntime::runtimeHeapDump(JSFunctionNativeCallContext& callContext) {
-    auto dumpHeapResult = dumpHeap();
+    // Streaming the dump lets the engine spill nodes and edges to disk instead of
+    // holding them in memory alongside the serialized dump.
+    auto buffer = makeShared<ByteBuffer>();
+    JavaScriptHeapDumpBufferOutput output(*buffer);
+    auto dumpHeapResult = dumpHeap(output);
     CHECK_CALL_CONTEXT(callContext);
-    return callContext.getContext().newArrayBuffer(dumpHeapResult.success() ? dumpHeapResult.value() : BytesView(),
+    return callContext.getContext().newArrayBuffer(dumpHeapResult.success() ? buffer->toBytesView() : BytesView(),
                                                    callContext.getExceptionTracker());
 }
 
+JSValueRef JavaScriptRuntime::runtimeHeapDumpToDiskCache(JSFunctionNativeCallContext& callContext) {
+    auto fileName = callContext.getParameterAsString(0);
+    CHECK_CALL_CONTEXT(callContext);
+
+    if (fileName.isEmpty() || fileName.contains('/') || fileName == "." || fileName == "..") {
+        return callContext.throwError(Error(STRING_FORMAT("Invalid heap dump file name '{}'", fileName)));
+    }
+
+    const auto& diskCache = _listener->getDiskCache();
+    if (diskCache == nullptr) {
+        return callContext.throwError(Error("No disk cache available to dump the heap into"));
+    }
+
+    auto path = diskCache->getRootPath().appending(fileName.toStringView());
+    auto dumpHeapResult = dumpHeap(path);
+    if (!dumpHeapResult) {
+        return callContext.throwError(dumpHeapResult.moveError());
+    }
+
+    return callContext.getContext().newStringUTF8(path.toString(), callContext.getExceptionTracker());
+}
+
 static JSValueRef updateErrorHandler(JSFunctionNativeCallContext& callContext, Shared<JSValueRefHolder>& holder) {
     auto callback = callContext.getParameter(0);
     if (callContext.getContext().isValueFunction(callback)) {
@@ -2013,7 +2288,8 @@ JSValueRef JavaScriptRuntime::runtimeSetUnhandledRejectionHandler(JSFunctionNati
     return updateErrorHandler(callContext, _unhandledRejectionHandler);
 }
 
-JSValueRef JavaScriptRuntime::runtimeCreateWorker(JSFunctionNativeCallContext& callContext) {
+Ref<JavaScriptRuntime> JavaScriptRuntime::makeWorkerRuntime(
+    const Ref<JavaScriptSharedModuleCache>& sharedModuleCache) {
     auto workerRuntime = makeShared<JavaScriptRuntime>(_javaScriptBridge,
                                                        _resourceManager,
                                                        _contextManager,
@@ -2025,6 +2301,7 @@ JSValueRef JavaScriptRuntime::runtimeCreateWorker(JSFunctionNativeCallContext& c
                                                        _anrDetector,
                                                        _logger,
                                                        true);
+    workerRuntime->_sharedModuleCache = sharedModuleCache;
     workerRuntime->postInit();
     for (const auto& moduleFactory : _moduleFactories) {
         workerRuntime->registerJavaScriptModuleFactory(moduleFactory);
@@ -2032,6 +2309,12 @@ JSValueRef JavaScriptRuntime::runtimeCreateWorker(JSFunctionNativeCallContext& c
     for (const auto& typeConverter : _typeConverters) {
         workerRuntime->registerTypeConverter(typeConverter.typeName, typeConverter.functionPath);
     }
+    _jsWorkers.emplace_back(weakRef(workerRuntime.get()));
+    return workerRuntime;
+}
+
+JSValueRef JavaScriptRuntime::runtimeCreateWorker(JSFunctionNativeCallContext& callContext) {
+    auto workerRuntime = makeWorkerRuntime(nullptr);
     auto worker = makeShared<JavaScriptWorker>(workerRuntime, callContext.getParameterAsString(0));
     worker->postInit();
     CHECK_CALL_CONTEXT(callContext);
@@ -2056,10 +2339,57 @@ JSValueRef JavaScriptRuntime::runtimeCreateWorker(JSFunctionNativeCallContext& c
                         "terminate",
                         &JavaScriptRuntime::workerTerminate);
     CHECK_CALL_CONTEXT(callContext);
-    _jsWorkers.emplace_back(weakRef(workerRuntime.get()));
     return workerJSValue;
 }
 
+JSValueRef JavaScriptRuntime::runtimeCreateWorkerPool(JSFunctionNativeCallContext& callContext) {
+    auto url = callContext.getParameterAsString(0);
+    CHECK_CALL_CONTEXT(callContext);
+
+    auto size = JavaScriptWorkerPool::getDefaultSize();
+    auto sizeParameter = callContext.getParameter(1);
+    if (!callContext.getContext().isValueUndefined(sizeParameter)) {
+        auto requestedSize = callContext.getContext().valueToInt(sizeParameter, callContext.getExceptionTracker());
+        CHECK_CALL_CONTEXT(callContext);
+        if (requestedSize > 0) {
+            size = std::min(static_cast<size_t>(requestedSize), JavaScriptWorkerPool::getMaxSize());
+        }
+    }
+
+    // The runtimes of the pool evaluate the same modules, they are compiled only once for the whole pool
+    auto sharedModuleCache = makeShared<JavaScriptSharedModuleCache>();
+    std::vector<Ref<JavaScriptWorker>> workers;
+    workers.reserve(size);
+    for (size_t i = 0; i < size; i++) {
+        auto worker = makeShared<JavaScriptWorker>(makeWorkerRuntime(sharedModuleCache), url);
+        worker->postInit();
+        workers.emplace_back(std::move(worker));
+    }
+
+    auto workerPool = makeShared<JavaScriptWorkerPool>(std::move(workers));
+    auto workerPoolJSValue = callContext.getContext().newWrappedObject(workerPool, callContext.getExceptionTracker());
+    CHECK_CALL_CONTEXT(callContext);
+    bindRuntimeFunction(callContext.getContext(),
+                        callContext.getExceptionTracker(),
+                        workerPoolJSValue,
+                        "submit",
+                        &JavaScriptRuntime::workerPoolSubmit);
+    CHECK_CALL_CONTEXT(callContext);
+    bindRuntimeFunction(callContext.getContext(),
+                        callContext.getExceptionTracker(),
+                        workerPoolJSValue,
+                        "getSize",
+                        &JavaScriptRuntime::workerPoolGetSize);
+    CHECK_CALL_CONTEXT(callContext);
+    bindRuntimeFunction(callContext.getContext(),
+                        callContext.getExceptionTracker(),
+                        workerPoolJSValue,
+                        "terminate",
+                        &JavaScriptRuntime::workerPoolTerminate);
+    CHECK_CALL_CONTEXT(callContext);
+    return workerPoolJSValue;
+}
+
 JSValueRef JavaScriptRuntime::queueMicrotask(JSFunctionNativeCallContext& callContext) {
     callContext.getContext().enqueueMicrotask(callContext.getParameter(0), callContext.getExceptionTracker());
     return callContext.getContext().newUndefined();
@@ -2080,18 +2410,32 @@ Ref<T> thisFromCallContext(JSFunctionNativeCallContext& callContext) {
 JSValueRef JavaScriptRuntime::workerSetOnMessage(JSFunctionNativeCallContext& callContext) {
     auto worker = thisFromCallContext<JavaScriptWorker>(callContext);
     if (worker != nullptr) {
-        worker->setHostOnMessage(callContext.getParameterAsFunction(0));
+        auto onMessage = callContext.getParameter(0);
+        if (!callContext.getContext().isValueFunction(onMessage)) {
+            return callContext.throwError(Error("onmessage should be a function"));
+        }
+
+        // Retained as a JS function, so that messages from the worker are deserialized straight into this context
+        worker->setHostOnMessage(
+            JSValueRefHolder::makeRetainedCallback(callContext.getContext(),
+                                                   onMessage,
+                                                   ReferenceInfoBuilder().withObject(STRING_LITERAL("onmessage")),
+                                                   callContext.getExceptionTracker()));
         CHECK_CALL_CONTEXT(callContext);
     }
     return callContext.getContext().newUndefined();
 }
 
-// worker.postMessage(any)
+// worker.postMessage(any, transfer?)
 JSValueRef JavaScriptRuntime::workerPostMessage(JSFunctionNativeCallContext& callContext) {
     auto worker = thisFromCallContext<JavaScriptWorker>(callContext);
     if (worker != nullptr) {
-        worker->postMessage(callContext.getParameterAsValue(0));
+        auto message = JavaScriptStructuredClone::serialize(callContext.getContext(),
+                                                            callContext.getParameter(0),
+                                                            callContext.getParameter(1),
+                                                            callContext.getExceptionTracker());
         CHECK_CALL_CONTEXT(callContext);
+        worker->postMessage(message);
     }
     return callContext.getContext().newUndefined();
 }
@@ -2105,6 +2449,50 @@ JSValueRef JavaScriptRuntime::workerTerminate(JSFunctionNativeCallContext& callC
     return callContext.getContext().newUndefined();
 }
 
+// pool.submit(any, transfer, (error, result) => void)
+JSValueRef JavaScriptRuntime::workerPoolSubmit(JSFunctionNativeCallContext& callContext) {
+    auto workerPool = thisFromCallContext<JavaScriptWorkerPool>(callContext);
+    if (workerPool != nullptr) {
+        auto completion = callContext.getParameter(2);
+        if (!callContext.getContext().isValueFunction(completion)) {
+            return callContext.throwError(Error("submit completion should be a function"));
+        }
+
+        auto task = JavaScriptStructuredClone::serialize(callContext.getContext(),
+                                                         callContext.getParameter(0),
+                                                         callContext.getParameter(1),
+                                                         callContext.getExceptionTracker());
+        CHECK_CALL_CONTEXT(callContext);
+
+        auto completionHolder =
+            JSValueRefHolder::makeRetainedCallback(callContext.getContext(),
+                                                   completion,
+                                                   ReferenceInfoBuilder().withObject(STRING_LITERAL("submit")),
+                                                   callContext.getExceptionTracker());
+        CHECK_CALL_CONTEXT(callContext);
+        workerPool->submit(task, completionHolder);
+    }
+    return callContext.getContext().newUndefined();
+}
+
+// pool.getSize()
+JSValueRef JavaScriptRuntime::workerPoolGetSize(JSFunctionNativeCallContext& callContext) {
+    auto workerPool = thisFromCallContext<JavaScriptWorkerPool>(callContext);
+    if (workerPool == nullptr) {
+        return callContext.getContext().newNumber(0);
+    }
+    return callContext.getContext().newNumber(static_cast<int32_t>(workerPool->getSize()));
+}
+
+// pool.terminate()
+JSValueRef JavaScriptRuntime::workerPoolTerminate(JSFunctionNativeCallContext& callContext) {
+    auto workerPool = thisFromCallContext<JavaScriptWorkerPool>(callContext);
+    if (workerPool != nullptr) {
+        workerPool->close();
+    }
+    return callContext.getContext().newUndefined();
+}
+
 constexpr static std::string_view getBuildType() {
     if (snap::kIsDevBuild) {
         return "dev";
@@ -2221,9 +2609,20 @@ void JavaScriptRuntime::buildContext(Valdi::IJavaScriptContext& context,
     JS_BIND(context, exceptionTracker, runtimeObject, "setColorPalette", runtimeSetColorPalette);
     JS_BIND(context, exceptionTracker, runtimeObject, "onMainThreadIdle", runtimeOnMainThreadIdle);
     JS_BIND(context, exceptionTracker, runtimeObject, "createWorker", runtimeCreateWorker);
+    JS_BIND(context, exceptionTracker, runtimeObject, "createWorkerPool", runtimeCreateWorkerPool);
 
     // Rendering
     JS_BIND(context, exceptionTracker, runtimeObject, "submitRawRenderRequest", runtimeSubmitRenderRequest);
+    JS_BIND(context,
+            exceptionTracker,
+            runtimeObject,
+            "getRenderRequestTransportBuffer",
+            runtimeGetRenderRequestTransportBuffer);
+    JS_BIND(context,
+            exceptionTracker,
+            runtimeObject,
+            "submitRenderRequestFromTransportBuffer",
+            runtimeSubmitRenderRequestFromTransportBuffer);
 
     JS_BIND(context, exceptionTracker, runtimeObject, "getCurrentPlatform", runtimeGetCurrentPlatform);
     JS_BIND(context,
@@ -2240,6 +2639,12 @@ void JavaScriptRuntime::buildContext(Valdi::IJavaScriptContext& context,
     JS_BIND(context, exceptionTracker, runtimeObject, "internString", runtimeInternString);
     JS_BIND(context, exceptionTracker, runtimeObject, "getAttributeId", runtimeGetAttributeId);
 
+    // Batched native calls
+    JS_BIND(context, exceptionTracker, runtimeObject, "registerBatchedFunction", runtimeRegisterBatchedFunction);
+    JS_BIND(context, exceptionTracker, runtimeObject, "getBatchedCallBuffer", runtimeGetBatchedCallBuffer);
+    JS_BIND(context, exceptionTracker, runtimeObject, "getBatchedCallResultBuffer", runtimeGetBatchedCallResultBuffer);
+    JS_BIND(context, exceptionTracker, runtimeObject, "submitBatchedCalls", runtimeSubmitBatchedCalls);
+
     JS_BIND(context, exceptionTracker, runtimeObject, "createContext", runtimeCreateContext);
     JS_BIND(context, exceptionTracker, runtimeObject, "destroyContext", runtimeDestroyContext);
 
@@ -2257,11 +2662,17 @@ void JavaScriptRuntime::buildContext(Valdi::IJavaScriptContext& context,
 
     JS_BIND(context, exceptionTracker, runtimeObject, "startTraceRecording", runtimeStartTraceRecording);
     JS_BIND(context, exceptionTracker, runtimeObject, "stopTraceRecording", runtimeStopTraceRecording);
+    JS_BIND(context,
+            exceptionTracker,
+            runtimeObject,
+            "stopTraceRecordingAsChromeTrace",
+            runtimeStopTraceRecordingAsChromeTrace);
 
     JS_BIND(context, exceptionTracker, runtimeObject, "scheduleWorkItem", runtimeScheduleWorkItem);
     JS_BIND(context, exceptionTracker, runtimeObject, "unscheduleWorkItem", runtimeUnscheduleWorkItem);
 
     JS_BIND(context, exceptionTracker, runtimeObject, "dumpMemoryStatistics", runtimeDumpMemoryStatistics);
+    JS_BIND(context, exceptionTracker, runtimeObject, "dumpQueueStatistics", runtimeDumpQueueStatistics);
     JS_BIND(context, exceptionTracker, runtimeObject, "performGC", runtimePerformGC);
 
     JS_BIND(
@@ -2271,6 +2682,7 @@ void JavaScriptRuntime::buildContext(Valdi::IJavaScriptContext& context,
 
     if constexpr (Valdi::shouldEnableJsHeapDump()) {
         JS_BIND(context, exceptionTracker, runtimeObject, "dumpHeap", runtimeHeapDump);
+        JS_BIND(context, exceptionTracker, runtimeObject, "dumpHeapToDiskCache", runtimeHeapDumpToDiskCache);
     }
 
     context.setObjectProperty(globalObject.get(), "runtime", runtimeObject.get(), exceptionTracker);
@@ -3154,25 +3566,7 @@ void JavaScriptRuntime::destroyNativeObjectsManager(
 }
 
 std::shared_ptr<snap::valdi::JSRuntime> JavaScriptRuntime::createWorker() {
-    auto workerRuntime = makeShared<JavaScriptRuntime>(_javaScriptBridge,
-                                                       _resourceManager,
-                                                       _contextManager,
-                                                       _mainThreadManager,
-                                                       _attributeIds,
-                                                       _platformType,
-                                                       _enableDebugger,
-                                                       ThreadQoSClassHigh,
-                                                       _anrDetector,
-                                                       _logger,
-                                                       true);
-    workerRuntime->postInit();
-    for (const auto& moduleFactory : _moduleFactories) {
-        workerRuntime->registerJavaScriptModuleFactory(moduleFactory);
-    }
-    for (const auto& typeConverter : _typeConverters) {
-        workerRuntime->registerTypeConverter(typeConverter.typeName, typeConverter.functionPath);
-    }
-    _jsWorkers.emplace_back(weakRef(workerRuntime.get()));
+    auto workerRuntime = makeWorkerRuntime(nullptr);
     return std::dynamic_pointer_cast<snap::valdi::JSRuntime>(*workerRuntime->getInnerSharedPtr());
 }
 
@@ -3741,6 +4135,55 @@ Result<BytesView> JavaScriptRuntime::dumpHeap() {
     }
 }
 
+Result<Void> JavaScriptRuntime::dumpHeap(JavaScriptHeapDumpOutput& output) {
+    if constexpr (Valdi::shouldEnableJsHeapDump()) {
+        Result<Void> result = Void();
+        dispatchSynchronouslyOnJsThread([this, &result, &output](JavaScriptEntryParameters& entry) {
+            std::vector<IJavaScriptContext*> jsContexts;
+
+            // Spill intermediate data into the disk cache, as the system temporary directory
+            // is not writable on every platform.
+            Path spillDirectory;
+            const auto& diskCache = _listener->getDiskCache();
+            if (diskCache != nullptr) {
+                spillDirectory = diskCache->getRootPath();
+            }
+
+            lockAllJSContexts(jsContexts, [&]() {
+                _javaScriptBridge.dumpHeapToOutput(std::span<IJavaScriptContext*>(jsContexts.data(), jsContexts.size()),
+                                                   spillDirectory,
+                                                   output,
+                                                   entry.exceptionTracker);
+            });
+
+            if (!entry.exceptionTracker) {
+                result = entry.exceptionTracker.extractError();
+            }
+        });
+
+        return result;
+    } else {
+        return Void();
+    }
+}
+
+Result<Void> JavaScriptRuntime::dumpHeap(const Path& path) {
+    auto pathString = path.toString();
+    auto fd = ::open(pathString.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return Error(STRING_FORMAT("Failed to open heap dump file '{}': {}", pathString, strerror(errno)));
+    }
+
+    JavaScriptHeapDumpFileOutput output(fd);
+    auto result = dumpHeap(output);
+
+    if (::close(fd) != 0 && result) {
+        return Error(STRING_FORMAT("Failed to close heap dump file '{}': {}", pathString, strerror(errno)));
+    }
+
+    return result;
+}
+
 Result<Ref<Context>> JavaScriptRuntime::getContextForId(ContextId contextId) const {
     // We lookup in the ContextManager first, to handle both contexts that are created externally
     // and contexts that are created directly in JS (which happens when running tests)
@@ -44,6 +44,7 @@
 
 #include "valdi_core/cpp/Utils/Function.hpp"
 #include <future>
+#include <optional>
 #include <tuple>
 #include <utility>
 #include <vector>
@@ -61,7 +62,10 @@ class Context;
 class ResourceManager;
 class ContextComponentRenderer;
 class ViewNode;
+class JSBatchedCallDispatcher;
 class JavaScriptRuntimeDeserializers;
+class JavaScriptStartupSnapshot;
+class JavaScriptSharedModuleCache;
 class IDiskCache;
 class AttributeIds;
 class StyleAttributesCache;
@@ -106,6 +110,10 @@ public:
     virtual void onDebugMessage(int32_t level, const StringBox& message) = 0;
 
     virtual Ref<ValdiRuntimeTweaks> getRuntimeTweaks() = 0;
+
+    virtual const Ref<IDiskCache>& getDiskCache() const = 0;
+
+    virtual const Ref<DispatchQueue>& getWorkerQueue() const = 0;
 };
 
 class JavaScriptStacktraceCaptureSession : public SimpleRefCountable {
@@ -303,6 +311,17 @@ public:
 
     Result<BytesView> dumpHeap();
 
+    /**
+     Dumps the heap into the given output, in chunks when supported by the JS engine.
+     */
+    Result<Void> dumpHeap(JavaScriptHeapDumpOutput& output);
+
+    /**
+     Dumps the heap into the file at the given path, which is created or truncated.
+     The dump is streamed into the file and is never held in memory as a whole.
+     */
+    Result<Void> dumpHeap(const Path& path);
+
 private:
     struct RegisteredTypeConverter {
         StringBox typeName;
@@ -329,6 +348,7 @@ private:
 
     std::unique_ptr<StyleAttributesCache> _styleAttributesCache;
     std::unique_ptr<JavaScriptRuntimeDeserializers> _runtimeDeserializers;
+    std::unique_ptr<JSBatchedCallDispatcher> _batchedCallDispatcher;
     Ref<JavaScriptANRDetector> _anrDetector;
 
     Result<JSValueRef> _symbolicateFunction;
@@ -377,6 +397,15 @@ private:
 
     std::vector<ModuleMemoryConsumptionInfo> _moduleMemoryTracker;
 
+    // Restored when the runtime starts, used until the first render
+    Ref<JavaScriptStartupSnapshot> _startupSnapshot;
+    // Records the modules loaded until the first render
+    Ref<JavaScriptStartupSnapshot> _startupSnapshotRecorder;
+    Ref<IDiskCache> _startupSnapshotDiskCache;
+    bool _startupSnapshotChanged = false;
+    // Set on the runtimes of a worker pool, which compile each module once for the whole pool
+    Ref<JavaScriptSharedModuleCache> _sharedModuleCache;
+
     void doInitialize();
 
     Result<Void> initializeContext();
@@ -384,6 +413,12 @@ private:
                       const Ref<ValdiRuntimeTweaks>& tweaks,
                       JSExceptionTracker& exceptionTracker);
 
+    void prepareStartupSnapshot(const IJavaScriptContext& jsContext, const Ref<IDiskCache>& diskCache);
+    std::optional<BytesView> resolveStartupSnapshotModule(IJavaScriptContext& jsContext,
+                                                          const BytesView& jsModule,
+                                                          const StringBox& importPath);
+    void finishStartupSnapshot();
+
     void doUnloadModulesAndDependentModules(const std::vector<ResourceId>& resourceIds,
                                             bool isHotReloading,
                                             JavaScriptEntryParameters& entry);
@@ -436,12 +471,18 @@ private:
     JSValueRef runtimeGetCurrentPlatform(JSFunctionNativeCallContext& callContext);
     JSValueRef runtimeGetBackendRenderingTypeForContextId(JSFunctionNativeCallContext& callContext);
     JSValueRef runtimeSubmitRenderRequest(JSFunctionNativeCallContext& callContext);
+    JSValueRef runtimeGetRenderRequestTransportBuffer(JSFunctionNativeCallContext& callContext);
+    JSValueRef runtimeSubmitRenderRequestFromTransportBuffer(JSFunctionNativeCallContext& callContext);
 
     JSValueRef runtimeGetCSSModule(JSFunctionNativeCallContext& callContext);
     JSValueRef runtimeCreateCSSRule(JSFunctionNativeCallContext& callContext);
 
     JSValueRef runtimeInternString(JSFunctionNativeCallContext& callContext);
     JSValueRef runtimeGetAttributeId(JSFunctionNativeCallContext& callContext);
+    JSValueRef runtimeRegisterBatchedFunction(JSFunctionNativeCallContext& callContext);
+    JSValueRef runtimeGetBatchedCallBuffer(JSFunctionNativeCallContext& callContext);
+    JSValueRef runtimeGetBatchedCallResultBuffer(JSFunctionNativeCallContext& callContext);
+    JSValueRef runtimeSubmitBatchedCalls(JSFunctionNativeCallContext& callContext);
 
     JSValueRef runtimeCreateContext(JSFunctionNativeCallContext& callContext);
     JSValueRef runtimeDestroyContext(JSFunctionNativeCallContext& callContext);
@@ -464,6 +505,7 @@ private:
     JSValueRef runtimeMakeTraceProxy(JSFunctionNativeCallContext& callContext);
     JSValueRef runtimeStartTraceRecording(JSFunctionNativeCallContext& callContext);
     JSValueRef runtimeStopTraceRecording(JSFunctionNativeCallContext& callContext);
+    JSValueRef runtimeStopTraceRecordingAsChromeTrace(JSFunctionNativeCallContext& callContext);
 
     JSValueRef runtimeScheduleWorkItem(JSFunctionNativeCallContext& callContext);
     JSValueRef runtimeUnscheduleWorkItem(JSFunctionNativeCallContext& callContext);
@@ -479,8 +521,10 @@ private:
     JSValueRef runtimeRestoreCurrentContext(JSFunctionNativeCallContext& callContext);
 
     JSValueRef runtimeDumpMemoryStatistics(JSFunctionNativeCallContext& callContext);
+    JSValueRef runtimeDumpQueueStatistics(JSFunctionNativeCallContext& callContext);
     JSValueRef runtimePerformGC(JSFunctionNativeCallContext& callContext);
     JSValueRef runtimeHeapDump(JSFunctionNativeCallContext& callContext);
+    JSValueRef runtimeHeapDumpToDiskCache(JSFunctionNativeCallContext& callContext);
 
     JSValueRef runtimeSetUncaughtExceptionHandler(JSFunctionNativeCallContext& callContext);
     JSValueRef runtimeSetUnhandledRejectionHandler(JSFunctionNativeCallContext& callContext);
@@ -499,6 +543,17 @@ private:
     JSValueRef workerPostMessage(JSFunctionNativeCallContext& callContext);
     JSValueRef workerTerminate(JSFunctionNativeCallContext& callContext);
 
+    // Worker pool methods
+    // - runtime.createWorkerPool(url, size)
+    // - pool.submit(data, transfer, completion)
+    // - pool.getSize()
+    // - pool.terminate()
+    JSValueRef runtimeCreateWorkerPool(JSFunctionNativeCallContext& callContext);
+    JSValueRef workerPoolSubmit(JSFunctionNativeCallContext& callContext);
+    JSValueRef workerPoolGetSize(JSFunctionNativeCallContext& callContext);
+    JSValueRef workerPoolTerminate(JSFunctionNativeCallContext& callContext);
+    Ref<JavaScriptRuntime> makeWorkerRuntime(const Ref<JavaScriptSharedModuleCache>& sharedModuleCache);
+
     Shared<JavaScriptModuleContainer> importModule(const ResourceId& resourceId, JavaScriptEntryParameters& jsEntry);
     Shared<JavaScriptModuleContainer> importModule(const StringBox& path, JavaScriptEntryParameters& jsEntry);
 
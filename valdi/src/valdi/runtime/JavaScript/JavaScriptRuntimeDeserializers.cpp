@@ -14,6 +14,7 @@
 #include "valdi/runtime/JavaScript/ValueFunctionWithJSValue.hpp"
 #include "valdi/runtime/Rendering/AnimationOptions.hpp"
 #include "valdi/runtime/Rendering/RenderRequest.hpp"
+#include "valdi_core/cpp/Utils/ByteBuffer.hpp"
 #include "valdi_core/cpp/Utils/Result.hpp"
 #include "valdi_core/cpp/Utils/StringCache.hpp"
 #include "valdi_core/cpp/Utils/Trace.hpp"
@@ -28,6 +29,9 @@ namespace Valdi {
 struct RenderRequestDescriptor {
     ContextId treeId;
     JSTypedArray descriptor;
+    // Points either to the descriptor typed array, or to the transport buffer
+    const uint32_t* words = nullptr;
+    size_t wordsCapacity = 0;
     int64_t descriptorSize;
     JSValue values;
     size_t valuesLength = 0;
@@ -54,6 +58,10 @@ constexpr size_t kValuesPropertyName = 3;
 constexpr size_t kVisibilityObserverPropertyName = 4;
 constexpr size_t kFrameObserverPropertyName = 5;
 
+// Large enough to fit the render requests of most renders, bigger
+// requests fall back to a descriptor allocated by the JS renderer.
+constexpr size_t kTransportBufferSize = 64 * 1024;
+
 JavaScriptRuntimeDeserializers::JavaScriptRuntimeDeserializers(IJavaScriptContext& jsContext,
                                                                JavaScriptStringCache& stringCache,
                                                                StyleAttributesCache& styleAttributesCache)
@@ -144,12 +152,12 @@ Ref<RenderRequest> JavaScriptRuntimeDeserializers::parseRequestDescriptor(
     auto renderRequest = Valdi::makeShared<RenderRequest>();
     renderRequest->setContextId(requestDescriptor.treeId);
 
-    const auto* descriptor = reinterpret_cast<const uint32_t*>(requestDescriptor.descriptor.data);
+    const auto* descriptor = requestDescriptor.words;
 
     auto valuesSize = requestDescriptor.valuesLength;
     Ref<ValueArray> values = valuesSize > 0 ? ValueArray::make(valuesSize) : nullptr;
     auto length = static_cast<size_t>(requestDescriptor.descriptorSize);
-    if (requestDescriptor.descriptor.length / 4 < length) {
+    if (requestDescriptor.descriptorSize < 0 || requestDescriptor.wordsCapacity < length) {
         return onParseError(exceptionTracker);
     }
 
@@ -160,7 +168,7 @@ Ref<RenderRequest> JavaScriptRuntimeDeserializers::parseRequestDescriptor(
 
         RawViewNodeId nodeId = 0;
 
-        if (type < 14) {
+        if (type < 14 || type == 18) {
             // Those are always tied to a node id.
             nodeId = static_cast<RawViewNodeId>(typeHeader >> 8);
         }
@@ -200,7 +208,7 @@ Ref<RenderRequest> JavaScriptRuntimeDeserializers::parseRequestDescriptor(
             entry->setElementId(nodeId);
             entry->setParentElementId(static_cast<RawViewNodeId>(parentId));
             entry->setParentIndex(static_cast<int>(parentIndex));
-        } else if (type >= 5 && type <= 13) {
+        } else if ((type >= 5 && type <= 13) || type == 18) {
             if (current + 1 > length) {
                 return onParseError(exceptionTracker);
             }
@@ -308,6 +316,18 @@ Ref<RenderRequest> JavaScriptRuntimeDeserializers::parseRequestDescriptor(
                     return nullptr;
                 }
                 disableCallIfContextIsDestroyed(entry->getAttributeValue());
+            } else if (type == 18) {
+                // interned string
+                if (current + 1 > length) {
+                    return onParseError(exceptionTracker);
+                }
+
+                auto str = _stringCache.get(static_cast<size_t>(descriptor[current++]));
+                if (!str) {
+                    return onParseError(exceptionTracker);
+                }
+
+                entry->setAttributeValue(Value(std::move(*str)));
             }
         } else if (type == 14) {
             if (current + 12 > length) {
@@ -399,47 +419,58 @@ Ref<RenderRequest> JavaScriptRuntimeDeserializers::parseRequestDescriptor(
     return renderRequest;
 }
 
-Ref<RenderRequest> JavaScriptRuntimeDeserializers::deserializeRenderRequest(const JSValue& jsValue,
-                                                                            const ReferenceInfo& referenceInfo,
-                                                                            JSExceptionTracker& exceptionTracker) {
+bool JavaScriptRuntimeDeserializers::parseObservers(RenderRequestDescriptor& requestDescriptor,
+                                                    const JSValue& visibilityObserver,
+                                                    const JSValue& frameObserver,
+                                                    JSExceptionTracker& exceptionTracker) {
     static auto kVisibilityObserver = STRING_LITERAL("visibilityObserver");
     static auto kFrameObserver = STRING_LITERAL("frameObserver");
 
+    requestDescriptor.visibilityObserver = jsValueToValue(
+        _jsContext, visibilityObserver, ReferenceInfoBuilder().withProperty(kVisibilityObserver), exceptionTracker);
+    if (!exceptionTracker) {
+        return false;
+    }
+    requestDescriptor.frameObserver =
+        jsValueToValue(_jsContext, frameObserver, ReferenceInfoBuilder().withProperty(kFrameObserver), exceptionTracker);
+    return static_cast<bool>(exceptionTracker);
+}
+
+Ref<RenderRequest> JavaScriptRuntimeDeserializers::deserializeRenderRequest(const JSValue& jsValue,
+                                                                            const ReferenceInfo& referenceInfo,
+                                                                            JSExceptionTracker& exceptionTracker) {
     VALDI_TRACE("Valdi.jsRenderRequestToCpp");
 
     RenderRequestDescriptor descriptor;
 
-    auto treeId =
-        _jsContext.getObjectProperty(jsValue, _propertyNames.getJsName(kTreeIdPropertyName), exceptionTracker);
+    // Render requests are always created with the same shape, which the property caches take advantage of
+    auto treeId = _propertyNames.getObjectProperty(jsValue, kTreeIdPropertyName, exceptionTracker);
     if (!exceptionTracker) {
         return nullptr;
     }
-    auto descriptorResult =
-        _jsContext.getObjectProperty(jsValue, _propertyNames.getJsName(kDescriptorPropertyName), exceptionTracker);
+    auto descriptorResult = _propertyNames.getObjectProperty(jsValue, kDescriptorPropertyName, exceptionTracker);
     if (!exceptionTracker) {
         return nullptr;
     }
 
     auto descriptorSizeResult =
-        _jsContext.getObjectProperty(jsValue, _propertyNames.getJsName(kDescriptorSizePropertyName), exceptionTracker);
+        _propertyNames.getObjectProperty(jsValue, kDescriptorSizePropertyName, exceptionTracker);
     if (!exceptionTracker) {
         return nullptr;
     }
 
-    auto valuesResult =
-        _jsContext.getObjectProperty(jsValue, _propertyNames.getJsName(kValuesPropertyName), exceptionTracker);
+    auto valuesResult = _propertyNames.getObjectProperty(jsValue, kValuesPropertyName, exceptionTracker);
     if (!exceptionTracker) {
         return nullptr;
     }
 
-    auto visibilityObserverResult = _jsContext.getObjectProperty(
-        jsValue, _propertyNames.getJsName(kVisibilityObserverPropertyName), exceptionTracker);
+    auto visibilityObserverResult =
+        _propertyNames.getObjectProperty(jsValue, kVisibilityObserverPropertyName, exceptionTracker);
     if (!exceptionTracker) {
         return nullptr;
     }
 
-    auto frameObserverResult =
-        _jsContext.getObjectProperty(jsValue, _propertyNames.getJsName(kFrameObserverPropertyName), exceptionTracker);
+    auto frameObserverResult = _propertyNames.getObjectProperty(jsValue, kFrameObserverPropertyName, exceptionTracker);
     if (!exceptionTracker) {
         return nullptr;
     }
@@ -452,6 +483,8 @@ Ref<RenderRequest> JavaScriptRuntimeDeserializers::deserializeRenderRequest(cons
     if (!exceptionTracker) {
         return nullptr;
     }
+    descriptor.words = reinterpret_cast<const uint32_t*>(descriptor.descriptor.data);
+    descriptor.wordsCapacity = descriptor.descriptor.length / 4;
     descriptor.descriptorSize =
         static_cast<int64_t>(_jsContext.valueToInt(descriptorSizeResult.get(), exceptionTracker));
     if (!exceptionTracker) {
@@ -463,16 +496,53 @@ Ref<RenderRequest> JavaScriptRuntimeDeserializers::deserializeRenderRequest(cons
     if (!exceptionTracker) {
         return nullptr;
     }
-    descriptor.visibilityObserver = jsValueToValue(_jsContext,
-                                                   visibilityObserverResult.get(),
-                                                   ReferenceInfoBuilder().withProperty(kVisibilityObserver),
-                                                   exceptionTracker);
-    if (!exceptionTracker) {
+    if (!parseObservers(descriptor, visibilityObserverResult.get(), frameObserverResult.get(), exceptionTracker)) {
         return nullptr;
     }
-    descriptor.frameObserver = jsValueToValue(
-        _jsContext, frameObserverResult.get(), ReferenceInfoBuilder().withProperty(kFrameObserver), exceptionTracker);
-    if (!exceptionTracker) {
+
+    return parseRequestDescriptor(descriptor, exceptionTracker);
+}
+
+JSValueRef JavaScriptRuntimeDeserializers::getTransportBuffer(JSExceptionTracker& exceptionTracker) {
+    if (_transportBuffer == nullptr) {
+        _transportBuffer = makeShared<ByteBuffer>();
+        _transportBuffer->resize(kTransportBufferSize);
+    }
+
+    // The ArrayBuffer references the memory of the transport buffer directly,
+    // writes made from JS are seen by parseRequestDescriptor() without any copy.
+    return _jsContext.newArrayBuffer(_transportBuffer->toBytesView(), exceptionTracker);
+}
+
+Ref<RenderRequest> JavaScriptRuntimeDeserializers::deserializeRenderRequestFromTransportBuffer(
+    ContextId treeId,
+    int64_t descriptorSize,
+    const JSValue& values,
+    const JSValue& visibilityObserver,
+    const JSValue& frameObserver,
+    JSExceptionTracker& exceptionTracker) {
+    VALDI_TRACE("Valdi.jsRenderRequestToCpp");
+
+    if (_transportBuffer == nullptr) {
+        return onParseError(exceptionTracker);
+    }
+
+    RenderRequestDescriptor descriptor;
+    descriptor.treeId = treeId;
+    descriptor.words = reinterpret_cast<const uint32_t*>(_transportBuffer->data());
+    descriptor.wordsCapacity = _transportBuffer->size() / 4;
+    descriptor.descriptorSize = descriptorSize;
+
+    // The values array is omitted when the request only holds primitive values
+    if (!_jsContext.isValueUndefined(values)) {
+        descriptor.values = values;
+        descriptor.valuesLength = jsArrayGetLength(_jsContext, values, exceptionTracker);
+        if (!exceptionTracker) {
+            return nullptr;
+        }
+    }
+
+    if (!parseObservers(descriptor, visibilityObserver, frameObserver, exceptionTracker)) {
         return nullptr;
     }
 
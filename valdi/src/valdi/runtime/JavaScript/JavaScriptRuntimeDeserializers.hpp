@@ -9,12 +9,14 @@
 
 #include "valdi/runtime/Interfaces/IJavaScriptContext.hpp"
 #include "valdi/runtime/JavaScript/JSPropertyNameIndex.hpp"
+#include "valdi_core/cpp/Context/ContextId.hpp"
 #include "valdi_core/cpp/Utils/Shared.hpp"
 
 namespace Valdi {
 
 template<typename T>
 class JavaScriptObjectDeserializer;
+class ByteBuffer;
 class RenderRequest;
 class ContextManager;
 class JavaScriptStringCache;
@@ -35,12 +37,34 @@ public:
                                                 const ReferenceInfo& referenceInfo,
                                                 JSExceptionTracker& exceptionTracker);
 
+    /**
+     Returns an ArrayBuffer backed by memory owned by the runtime, in which the JS renderer
+     can write the descriptor of a render request to submit it through
+     deserializeRenderRequestFromTransportBuffer(). The memory is allocated once and
+     reused across render requests.
+     */
+    JSValueRef getTransportBuffer(JSExceptionTracker& exceptionTracker);
+
+    /**
+     Parses a render request whose descriptor was written at the start of the transport buffer.
+     Unlike deserializeRenderRequest(), the request fields are passed directly and the
+     descriptor is read in place. values can be undefined if the descriptor does not
+     reference any attached value.
+     */
+    Ref<RenderRequest> deserializeRenderRequestFromTransportBuffer(ContextId treeId,
+                                                                   int64_t descriptorSize,
+                                                                   const JSValue& values,
+                                                                   const JSValue& visibilityObserver,
+                                                                   const JSValue& frameObserver,
+                                                                   JSExceptionTracker& exceptionTracker);
+
 private:
     IJavaScriptContext& _jsContext;
     JavaScriptStringCache& _stringCache;
     StyleAttributesCache& _styleAttributesCache;
 
     JSPropertyNameIndex<6> _propertyNames;
+    Ref<ByteBuffer> _transportBuffer;
 
     Ref<RenderRequest> parseRequestDescriptor(const RenderRequestDescriptor& requestDescriptor,
                                               JSExceptionTracker& exceptionTracker);
@@ -50,6 +74,11 @@ private:
                                   size_t index,
                                   const ReferenceInfoBuilder& referenceInfoBuilder,
                                   JSExceptionTracker& exceptionTracker) const;
+
+    bool parseObservers(RenderRequestDescriptor& requestDescriptor,
+                        const JSValue& visibilityObserver,
+                        const JSValue& frameObserver,
+                        JSExceptionTracker& exceptionTracker);
 };
 
 } // namespace Valdi
@@ -0,0 +1,48 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi/runtime/JavaScript/JavaScriptSharedModuleCache.hpp"
+
+#include "valdi/runtime/JavaScript/JavaScriptUtils.hpp"
+#include "valdi_core/cpp/Utils/StringCache.hpp"
+
+namespace Valdi {
+
+// Modules are only shared between runtimes of the same process, the engine is always the same
+JavaScriptSharedModuleCache::JavaScriptSharedModuleCache() : _modules(STRING_LITERAL("shared")) {}
+
+JavaScriptSharedModuleCache::~JavaScriptSharedModuleCache() = default;
+
+std::optional<BytesView> JavaScriptSharedModuleCache::getOrCompile(IJavaScriptContext& jsContext,
+                                                                   const StringBox& importPath,
+                                                                   const BytesView& jsModule) {
+    if (!jsContext.supportsPreCompilation()) {
+        return std::nullopt;
+    }
+
+    {
+        std::lock_guard<Mutex> lock(_mutex);
+        auto preCompiledModule = _modules.getPreCompiledModule(importPath, jsModule);
+        if (preCompiledModule) {
+            return getPreCompiledJsModuleData(preCompiledModule.value());
+        }
+    }
+
+    // Compiled outside of the lock, two runtimes might compile the same module concurrently
+    // the first time it is loaded, which is cheaper than serializing all the compilations.
+    JSExceptionTracker exceptionTracker(jsContext);
+    auto compiledModule = jsContext.preCompile(jsModule.asStringView(), importPath.toStringView(), exceptionTracker);
+    if (!exceptionTracker || compiledModule.empty()) {
+        // The module will be evaluated from source, which will report the error
+        exceptionTracker.clearError();
+        return std::nullopt;
+    }
+
+    {
+        std::lock_guard<Mutex> lock(_mutex);
+        _modules.addPreCompiledModule(importPath, jsModule, compiledModule);
+    }
+
+    return getPreCompiledJsModuleData(compiledModule);
+}
+
+} // namespace Valdi
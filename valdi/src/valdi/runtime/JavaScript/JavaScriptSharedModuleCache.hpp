@@ -0,0 +1,37 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "valdi/runtime/Interfaces/IJavaScriptContext.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptStartupSnapshot.hpp"
+#include "valdi_core/cpp/Utils/Mutex.hpp"
+
+#include <optional>
+
+namespace Valdi {
+
+/**
+ Holds the precompiled JS modules shared by a group of JS runtimes, like the runtimes
+ of a worker pool, so that each module is compiled once for the whole group instead
+ of being parsed again by every runtime. Can be used from any JS thread.
+ */
+class JavaScriptSharedModuleCache : public SimpleRefCountable {
+public:
+    JavaScriptSharedModuleCache();
+    ~JavaScriptSharedModuleCache() override;
+
+    /**
+     Returns the bytecode of the given module, ready to be passed to evaluatePreCompiled(),
+     compiling it with the given context if no runtime of the group compiled it yet.
+     Returns nullopt if the engine does not support precompilation.
+     */
+    std::optional<BytesView> getOrCompile(IJavaScriptContext& jsContext,
+                                          const StringBox& importPath,
+                                          const BytesView& jsModule);
+
+private:
+    Mutex _mutex;
+    JavaScriptStartupSnapshot _modules;
+};
+
+} // namespace Valdi
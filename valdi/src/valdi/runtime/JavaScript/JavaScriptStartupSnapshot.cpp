@@ -0,0 +1,122 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi/runtime/JavaScript/JavaScriptStartupSnapshot.hpp"
+
+#include "valdi/runtime/Utils/BytesUtils.hpp"
+#include "valdi_core/cpp/Resources/ValdiArchive.hpp"
+#include "valdi_core/cpp/Utils/ByteBuffer.hpp"
+#include "valdi_core/cpp/Utils/Format.hpp"
+#include "valdi_core/cpp/Utils/StringCache.hpp"
+
+#include <cstring>
+
+namespace Valdi {
+
+// First entry of the archive, holds the engine key
+static constexpr std::string_view kEngineKeyEntryPath = "__startup_snapshot__";
+
+struct JavaScriptStartupSnapshotModuleHeader {
+    Byte sourceHash[JavaScriptStartupSnapshot::kSourceHashSize];
+};
+
+JavaScriptStartupSnapshot::JavaScriptStartupSnapshot(const StringBox& engineKey) : _engineKey(engineKey) {}
+
+JavaScriptStartupSnapshot::~JavaScriptStartupSnapshot() = default;
+
+Result<Ref<JavaScriptStartupSnapshot>> JavaScriptStartupSnapshot::deserialize(const BytesView& bytes,
+                                                                              const StringBox& engineKey) {
+    ValdiArchive archive(bytes.begin(), bytes.end());
+    auto entries = archive.getEntries();
+    if (!entries) {
+        return entries.moveError();
+    }
+
+    if (entries.value().empty() || entries.value()[0].filePath != kEngineKeyEntryPath) {
+        return Error("Invalid startup snapshot");
+    }
+
+    auto recordedEngineKey = entries.value()[0].getStringData();
+    if (recordedEngineKey != engineKey) {
+        return Error(STRING_FORMAT(
+            "Startup snapshot was recorded with '{}', current engine is '{}'", recordedEngineKey, engineKey));
+    }
+
+    auto snapshot = makeShared<JavaScriptStartupSnapshot>(engineKey);
+    for (size_t i = 1; i < entries.value().size(); i++) {
+        const auto& entry = entries.value()[i];
+        if (entry.dataLength < sizeof(JavaScriptStartupSnapshotModuleHeader)) {
+            return Error(STRING_FORMAT("Invalid startup snapshot entry '{}'", entry.filePath));
+        }
+
+        JavaScriptStartupSnapshotModuleHeader header;
+        std::memcpy(&header, entry.data, sizeof(header));
+
+        Module module;
+        std::memcpy(module.sourceHash.data(), header.sourceHash, kSourceHashSize);
+        // Points into the snapshot bytes, which are retained by the module
+        module.preCompiledModule = BytesView(bytes.getSource(),
+                                             entry.data + sizeof(header),
+                                             entry.dataLength - sizeof(header));
+        snapshot->_modules[entry.filePath] = std::move(module);
+    }
+
+    return snapshot;
+}
+
+BytesView JavaScriptStartupSnapshot::serialize() const {
+    ValdiArchiveBuilder builder;
+    builder.addEntry(ValdiArchiveEntry(StringBox::fromString(kEngineKeyEntryPath), _engineKey));
+
+    ByteBuffer entryData;
+    for (const auto& it : _modules) {
+        JavaScriptStartupSnapshotModuleHeader header;
+        std::memcpy(header.sourceHash, it.second.sourceHash.data(), kSourceHashSize);
+
+        entryData.clear();
+        entryData.append(reinterpret_cast<const Byte*>(&header), reinterpret_cast<const Byte*>(&header + 1));
+        entryData.append(it.second.preCompiledModule.begin(), it.second.preCompiledModule.end());
+
+        builder.addEntry(ValdiArchiveEntry(it.first, entryData.data(), entryData.size()));
+    }
+
+    return builder.build()->toBytesView();
+}
+
+std::optional<BytesView> JavaScriptStartupSnapshot::getPreCompiledModule(const StringBox& importPath,
+                                                                         const BytesView& source) const {
+    const auto& it = _modules.find(importPath);
+    if (it == _modules.end()) {
+        return std::nullopt;
+    }
+
+    if (it->second.sourceHash != hashSource(source)) {
+        return std::nullopt;
+    }
+
+    return it->second.preCompiledModule;
+}
+
+void JavaScriptStartupSnapshot::addPreCompiledModule(const StringBox& importPath,
+                                                     const BytesView& source,
+                                                     const BytesView& preCompiledModule) {
+    Module module;
+    module.sourceHash = hashSource(source);
+    module.preCompiledModule = preCompiledModule;
+
+    _modules[importPath] = std::move(module);
+}
+
+std::array<Byte, JavaScriptStartupSnapshot::kSourceHashSize> JavaScriptStartupSnapshot::hashSource(
+    const BytesView& source) {
+    auto digest = BytesUtils::sha256(source);
+
+    std::array<Byte, kSourceHashSize> hash;
+    std::memcpy(hash.data(), digest->data(), kSourceHashSize);
+    return hash;
+}
+
+size_t JavaScriptStartupSnapshot::size() const {
+    return _modules.size();
+}
+
+} // namespace Valdi
@@ -0,0 +1,59 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "valdi_core/cpp/Utils/Bytes.hpp"
+#include "valdi_core/cpp/Utils/FlatMap.hpp"
+#include "valdi_core/cpp/Utils/Result.hpp"
+#include "valdi_core/cpp/Utils/Shared.hpp"
+#include "valdi_core/cpp/Utils/StringBox.hpp"
+
+#include <array>
+#include <optional>
+
+namespace Valdi {
+
+/**
+ Holds the precompiled JS modules which were evaluated while a JS runtime was
+ starting, up to its first render. A snapshot is recorded during the first start
+ and restored in a single read on the following ones, so that these modules are
+ evaluated from bytecode instead of being parsed again.
+ A snapshot can only be restored by the engine, bytecode and Valdi version it was
+ recorded with, and a module is only used if the SHA-256 digest of its source did
+ not change since then, like the entries of the QuickJS bytecode disk cache.
+ */
+class JavaScriptStartupSnapshot : public SimpleRefCountable {
+public:
+    // Size of a SHA-256 digest
+    static constexpr size_t kSourceHashSize = 32;
+
+    explicit JavaScriptStartupSnapshot(const StringBox& engineKey);
+    ~JavaScriptStartupSnapshot() override;
+
+    static Result<Ref<JavaScriptStartupSnapshot>> deserialize(const BytesView& bytes, const StringBox& engineKey);
+
+    BytesView serialize() const;
+
+    /**
+     Returns the precompiled module, as returned by IJavaScriptContext::preCompile(),
+     of the given import path if it was compiled from the given source.
+     */
+    std::optional<BytesView> getPreCompiledModule(const StringBox& importPath, const BytesView& source) const;
+
+    void addPreCompiledModule(const StringBox& importPath, const BytesView& source, const BytesView& preCompiledModule);
+
+    size_t size() const;
+
+private:
+    struct Module {
+        std::array<Byte, kSourceHashSize> sourceHash;
+        BytesView preCompiledModule;
+    };
+
+    static std::array<Byte, kSourceHashSize> hashSource(const BytesView& source);
+
+    StringBox _engineKey;
+    FlatMap<StringBox, Module> _modules;
+};
+
+} // namespace Valdi
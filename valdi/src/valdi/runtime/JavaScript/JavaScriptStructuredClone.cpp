@@ -0,0 +1,656 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi/runtime/JavaScript/JavaScriptStructuredClone.hpp"
+
+#include "valdi/runtime/JavaScript/JavaScriptCircularRefChecker.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptFunctionCallContext.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptUtils.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptValueMarshaller.hpp"
+#include "valdi_core/cpp/Utils/StringCache.hpp"
+
+#include <cstring>
+
+namespace Valdi {
+
+enum class StructuredCloneTag : uint8_t {
+    Undefined,
+    Null,
+    False,
+    True,
+    Int,
+    Double,
+    Long,
+    UnsignedLong,
+    String,
+    Array,
+    // Followed by key/value pairs, ended by an empty key
+    Object,
+    TypedArray,
+    TransferredTypedArray,
+    // Index of a Value which went through the regular marshalling
+    Value,
+};
+
+struct TransferredArrayBuffer {
+    JSValueRef arrayBuffer;
+    // Address of the ArrayBuffer contents in the sending runtime
+    const Byte* data = nullptr;
+    BytesView bytes;
+};
+
+class StructuredCloneWriter : public IJavaScriptPropertyNamesVisitor {
+public:
+    StructuredCloneWriter(ByteBuffer& output,
+                          std::vector<Value>& values,
+                          const std::vector<TransferredArrayBuffer>& transferredArrayBuffers)
+        : _output(output), _values(values), _transferredArrayBuffers(transferredArrayBuffers) {}
+
+    bool write(IJavaScriptContext& jsContext, const JSValue& value, JSExceptionTracker& exceptionTracker) {
+        switch (jsContext.getValueType(value)) {
+            case ValueType::Undefined:
+                writeTag(StructuredCloneTag::Undefined);
+                return true;
+            case ValueType::Null:
+                writeTag(StructuredCloneTag::Null);
+                return true;
+            case ValueType::Bool: {
+                auto boolean = jsContext.valueToBool(value, exceptionTracker);
+                writeTag(boolean ? StructuredCloneTag::True : StructuredCloneTag::False);
+                return static_cast<bool>(exceptionTracker);
+            }
+            case ValueType::Int:
+                writeTag(StructuredCloneTag::Int);
+                writeRaw(jsContext.valueToInt(value, exceptionTracker));
+                return static_cast<bool>(exceptionTracker);
+            case ValueType::Double:
+                writeTag(StructuredCloneTag::Double);
+                writeRaw(jsContext.valueToDouble(value, exceptionTracker));
+                return static_cast<bool>(exceptionTracker);
+            case ValueType::Long: {
+                auto jsLong = jsContext.valueToLong(value, exceptionTracker);
+                if (jsLong.isUnsigned()) {
+                    writeTag(StructuredCloneTag::UnsignedLong);
+                    writeRaw(jsLong.toUInt64());
+                } else {
+                    writeTag(StructuredCloneTag::Long);
+                    writeRaw(jsLong.toInt64());
+                }
+                return static_cast<bool>(exceptionTracker);
+            }
+            case ValueType::InternedString:
+            case ValueType::StaticString: {
+                auto str = jsContext.valueToString(value, exceptionTracker);
+                writeTag(StructuredCloneTag::String);
+                writeString(str.toStringView());
+                return static_cast<bool>(exceptionTracker);
+            }
+            case ValueType::Array:
+                return writeArray(jsContext, value, exceptionTracker);
+            case ValueType::Map:
+                return writeObject(jsContext, value, exceptionTracker);
+            case ValueType::TypedArray:
+                return writeTypedArray(jsContext, value, exceptionTracker);
+            case ValueType::Function:
+            case ValueType::ValdiObject:
+            case ValueType::Error:
+                return writeValue(jsValueToValue(jsContext, value, ReferenceInfoBuilder(), exceptionTracker),
+                                  exceptionTracker);
+            case ValueType::TypedObject:
+            case ValueType::ProxyTypedObject:
+                exceptionTracker.onError(Error("Cannot clone typed objects"));
+                return false;
+        }
+    }
+
+    bool visitPropertyName(IJavaScriptContext& jsContext,
+                           JSValue object,
+                           const JSPropertyName& propertyName,
+                           JSExceptionTracker& exceptionTracker) override {
+        auto propertyValue = jsContext.getObjectProperty(object, propertyName, exceptionTracker);
+        if (!exceptionTracker) {
+            return false;
+        }
+
+        // Undefined properties are omitted, like when converting to a Value
+        if (jsContext.isValueUndefined(propertyValue.get())) {
+            return true;
+        }
+
+        auto key = jsContext.propertyNameToString(propertyName);
+        // Keys are written with their length + 1, so that 0 can end the object
+        writeSize(key.length() + 1);
+        writeBytes(key.toStringView().data(), key.length());
+
+        return write(jsContext, propertyValue.get(), exceptionTracker);
+    }
+
+private:
+    ByteBuffer& _output;
+    std::vector<Value>& _values;
+    const std::vector<TransferredArrayBuffer>& _transferredArrayBuffers;
+
+    void writeTag(StructuredCloneTag tag) {
+        _output.append(static_cast<Byte>(tag));
+    }
+
+    void writeSize(size_t size) {
+        while (size >= 0x80) {
+            _output.append(static_cast<Byte>((size & 0x7F) | 0x80));
+            size >>= 7;
+        }
+        _output.append(static_cast<Byte>(size));
+    }
+
+    void writeBytes(const void* data, size_t size) {
+        const auto* begin = reinterpret_cast<const Byte*>(data);
+        _output.append(begin, begin + size);
+    }
+
+    template<typename T>
+    void writeRaw(T value) {
+        writeBytes(&value, sizeof(T));
+    }
+
+    void writeString(std::string_view str) {
+        writeSize(str.size());
+        writeBytes(str.data(), str.size());
+    }
+
+    bool writeValue(Value&& value, JSExceptionTracker& exceptionTracker) {
+        if (!exceptionTracker) {
+            return false;
+        }
+
+        writeTag(StructuredCloneTag::Value);
+        writeSize(_values.size());
+        _values.emplace_back(std::move(value));
+        return true;
+    }
+
+    bool checkNotCircular(const JSValue& value,
+                          JavaScriptRef<JSValue>& ref,
+                          JSExceptionTracker& exceptionTracker) {
+        auto& circularRefChecker = exceptionTracker.getCircularRefChecker();
+        if (circularRefChecker.isRefAlreadyPresent(value)) {
+            exceptionTracker.onError(Error("Cannot clone a circular structure"));
+            return false;
+        }
+
+        ref = circularRefChecker.push(value);
+        return true;
+    }
+
+    bool writeArray(IJavaScriptContext& jsContext, const JSValue& value, JSExceptionTracker& exceptionTracker) {
+        JavaScriptRef<JSValue> ref;
+        if (!checkNotCircular(value, ref, exceptionTracker)) {
+            return false;
+        }
+
+        auto length = jsArrayGetLength(jsContext, value, exceptionTracker);
+        if (!exceptionTracker) {
+            return false;
+        }
+
+        writeTag(StructuredCloneTag::Array);
+        writeSize(length);
+
+        for (size_t i = 0; i < length; i++) {
+            auto item = jsContext.getObjectPropertyForIndex(value, i, exceptionTracker);
+            if (!exceptionTracker) {
+                return false;
+            }
+
+            if (!write(jsContext, item.get(), exceptionTracker)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool writeObject(IJavaScriptContext& jsContext, const JSValue& value, JSExceptionTracker& exceptionTracker) {
+        auto* valueMarshaller = jsContext.getValueMarshaller();
+        if (valueMarshaller != nullptr) {
+            // Proxy objects are backed by native objects, they are passed as is
+            auto proxyObject = valueMarshaller->tryUnwrap(value, exceptionTracker);
+            if (!exceptionTracker) {
+                return false;
+            }
+            if (!proxyObject.isUndefined()) {
+                return writeValue(std::move(proxyObject), exceptionTracker);
+            }
+        }
+
+        JavaScriptRef<JSValue> ref;
+        if (!checkNotCircular(value, ref, exceptionTracker)) {
+            return false;
+        }
+
+        writeTag(StructuredCloneTag::Object);
+        jsContext.visitObjectPropertyNames(value, exceptionTracker, *this);
+        if (!exceptionTracker) {
+            return false;
+        }
+        writeSize(0);
+
+        return true;
+    }
+
+    bool writeTypedArray(IJavaScriptContext& jsContext, const JSValue& value, JSExceptionTracker& exceptionTracker) {
+        auto typedArray = jsContext.valueToTypedArray(value, exceptionTracker);
+        if (!exceptionTracker) {
+            return false;
+        }
+
+        const auto* data = reinterpret_cast<const Byte*>(typedArray.data);
+
+        for (size_t i = 0; i < _transferredArrayBuffers.size(); i++) {
+            const auto& transferredArrayBuffer = _transferredArrayBuffers[i];
+            if (jsContext.isValueEqual(transferredArrayBuffer.arrayBuffer.get(), typedArray.arrayBuffer.get())) {
+                writeTag(StructuredCloneTag::TransferredTypedArray);
+                _output.append(static_cast<Byte>(typedArray.type));
+                writeSize(i);
+                writeSize(typedArray.length == 0 ? 0 : static_cast<size_t>(data - transferredArrayBuffer.data));
+                writeSize(typedArray.length);
+                return true;
+            }
+        }
+
+        writeTag(StructuredCloneTag::TypedArray);
+        _output.append(static_cast<Byte>(typedArray.type));
+        writeSize(typedArray.length);
+        writeBytes(data, typedArray.length);
+
+        return true;
+    }
+};
+
+class StructuredCloneReader {
+public:
+    StructuredCloneReader(const ByteBuffer& input,
+                          const std::vector<BytesView>& transferredBuffers,
+                          const std::vector<Value>& values)
+        : _current(input.begin()),
+          _end(input.end()),
+          _transferredBuffers(transferredBuffers),
+          _transferredArrayBuffers(transferredBuffers.size()),
+          _values(values) {}
+
+    JSValueRef read(IJavaScriptContext& jsContext, JSExceptionTracker& exceptionTracker) {
+        if (_current >= _end) {
+            return onInvalidData(jsContext, exceptionTracker);
+        }
+
+        auto tag = static_cast<StructuredCloneTag>(*_current++);
+        switch (tag) {
+            case StructuredCloneTag::Undefined:
+                return jsContext.newUndefined();
+            case StructuredCloneTag::Null:
+                return jsContext.newNull();
+            case StructuredCloneTag::False:
+                return jsContext.newBool(false);
+            case StructuredCloneTag::True:
+                return jsContext.newBool(true);
+            case StructuredCloneTag::Int: {
+                int32_t value = 0;
+                if (!readRaw(value)) {
+                    return onInvalidData(jsContext, exceptionTracker);
+                }
+                return jsContext.newNumber(value);
+            }
+            case StructuredCloneTag::Double: {
+                double value = 0;
+                if (!readRaw(value)) {
+                    return onInvalidData(jsContext, exceptionTracker);
+                }
+                return jsContext.newNumber(value);
+            }
+            case StructuredCloneTag::Long: {
+                int64_t value = 0;
+                if (!readRaw(value)) {
+                    return onInvalidData(jsContext, exceptionTracker);
+                }
+                return jsContext.newLong(value, exceptionTracker);
+            }
+            case StructuredCloneTag::UnsignedLong: {
+                uint64_t value = 0;
+                if (!readRaw(value)) {
+                    return onInvalidData(jsContext, exceptionTracker);
+                }
+                return jsContext.newUnsignedLong(value, exceptionTracker);
+            }
+            case StructuredCloneTag::String: {
+                std::string_view str;
+                if (!readString(str)) {
+                    return onInvalidData(jsContext, exceptionTracker);
+                }
+                return jsContext.newStringUTF8(str, exceptionTracker);
+            }
+            case StructuredCloneTag::Array:
+                return readArray(jsContext, exceptionTracker);
+            case StructuredCloneTag::Object:
+                return readObject(jsContext, exceptionTracker);
+            case StructuredCloneTag::TypedArray:
+                return readTypedArray(jsContext, exceptionTracker);
+            case StructuredCloneTag::TransferredTypedArray:
+                return readTransferredTypedArray(jsContext, exceptionTracker);
+            case StructuredCloneTag::Value: {
+                size_t index = 0;
+                if (!readSize(index) || index >= _values.size()) {
+                    return onInvalidData(jsContext, exceptionTracker);
+                }
+                return valueToJSValue(jsContext, _values[index], ReferenceInfoBuilder(), exceptionTracker);
+            }
+        }
+
+        return onInvalidData(jsContext, exceptionTracker);
+    }
+
+private:
+    const Byte* _current;
+    const Byte* _end;
+    const std::vector<BytesView>& _transferredBuffers;
+    // ArrayBuffers created from the transferred buffers, so that views sharing a buffer keep sharing it
+    std::vector<JSValueRef> _transferredArrayBuffers;
+    const std::vector<Value>& _values;
+
+    static JSValueRef onInvalidData(IJavaScriptContext& jsContext, JSExceptionTracker& exceptionTracker) {
+        exceptionTracker.onError(Error("Invalid structured clone data"));
+        return jsContext.newUndefined();
+    }
+
+    bool readSize(size_t& size) {
+        size = 0;
+        size_t shift = 0;
+        while (_current < _end && shift < sizeof(size_t) * 8) {
+            auto byte = *_current++;
+            size |= static_cast<size_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+            shift += 7;
+        }
+        return false;
+    }
+
+    bool readBytes(size_t size, const Byte*& data) {
+        if (static_cast<size_t>(_end - _current) < size) {
+            return false;
+        }
+        data = _current;
+        _current += size;
+        return true;
+    }
+
+    template<typename T>
+    bool readRaw(T& value) {
+        const Byte* data = nullptr;
+        if (!readBytes(sizeof(T), data)) {
+            return false;
+        }
+        std::memcpy(&value, data, sizeof(T));
+        return true;
+    }
+
+    bool readString(std::string_view& str) {
+        size_t size = 0;
+        const Byte* data = nullptr;
+        if (!readSize(size) || !readBytes(size, data)) {
+            return false;
+        }
+        str = std::string_view(reinterpret_cast<const char*>(data), size);
+        return true;
+    }
+
+    bool readTypedArrayType(TypedArrayType& type) {
+        if (_current >= _end || *_current > static_cast<Byte>(TypedArrayType::ArrayBuffer)) {
+            return false;
+        }
+        type = static_cast<TypedArrayType>(*_current++);
+        return true;
+    }
+
+    JSValueRef readArray(IJavaScriptContext& jsContext, JSExceptionTracker& exceptionTracker) {
+        size_t length = 0;
+        if (!readSize(length) || length > static_cast<size_t>(_end - _current)) {
+            return onInvalidData(jsContext, exceptionTracker);
+        }
+
+        auto array = jsContext.newArray(length, exceptionTracker);
+        if (!exceptionTracker) {
+            return jsContext.newUndefined();
+        }
+
+        for (size_t i = 0; i < length; i++) {
+            auto item = read(jsContext, exceptionTracker);
+            if (!exceptionTracker) {
+                return jsContext.newUndefined();
+            }
+
+            jsContext.setObjectPropertyIndex(array.get(), i, item.get(), exceptionTracker);
+            if (!exceptionTracker) {
+                return jsContext.newUndefined();
+            }
+        }
+
+        return array;
+    }
+
+    JSValueRef readObject(IJavaScriptContext& jsContext, JSExceptionTracker& exceptionTracker) {
+        auto object = jsContext.newObject(exceptionTracker);
+        if (!exceptionTracker) {
+            return jsContext.newUndefined();
+        }
+
+        for (;;) {
+            size_t keySize = 0;
+            const Byte* keyData = nullptr;
+            if (!readSize(keySize)) {
+                return onInvalidData(jsContext, exceptionTracker);
+            }
+            if (keySize == 0) {
+                break;
+            }
+            if (!readBytes(keySize - 1, keyData)) {
+                return onInvalidData(jsContext, exceptionTracker);
+            }
+
+            auto propertyValue = read(jsContext, exceptionTracker);
+            if (!exceptionTracker) {
+                return jsContext.newUndefined();
+            }
+
+            jsContext.setObjectProperty(object.get(),
+                                        std::string_view(reinterpret_cast<const char*>(keyData), keySize - 1),
+                                        propertyValue.get(),
+                                        exceptionTracker);
+            if (!exceptionTracker) {
+                return jsContext.newUndefined();
+            }
+        }
+
+        return object;
+    }
+
+    JSValueRef readTypedArray(IJavaScriptContext& jsContext, JSExceptionTracker& exceptionTracker) {
+        TypedArrayType type;
+        size_t length = 0;
+        const Byte* data = nullptr;
+        if (!readTypedArrayType(type) || !readSize(length) || !readBytes(length, data)) {
+            return onInvalidData(jsContext, exceptionTracker);
+        }
+
+        auto arrayBuffer = jsContext.newArrayBufferCopy(data, length, exceptionTracker);
+        if (!exceptionTracker || type == TypedArrayType::ArrayBuffer) {
+            return arrayBuffer;
+        }
+
+        return jsContext.newTypedArrayFromArrayBuffer(type, arrayBuffer.get(), exceptionTracker);
+    }
+
+    JSValueRef readTransferredTypedArray(IJavaScriptContext& jsContext, JSExceptionTracker& exceptionTracker) {
+        TypedArrayType type;
+        size_t index = 0;
+        size_t offset = 0;
+        size_t length = 0;
+        if (!readTypedArrayType(type) || !readSize(index) || !readSize(offset) || !readSize(length) ||
+            index >= _transferredBuffers.size()) {
+            return onInvalidData(jsContext, exceptionTracker);
+        }
+
+        const auto& bytes = _transferredBuffers[index];
+        if (offset > bytes.size() || length > bytes.size() - offset) {
+            return onInvalidData(jsContext, exceptionTracker);
+        }
+
+        if (offset != 0 || length != bytes.size()) {
+            // Views over a part of the buffer get their own ArrayBuffer, which still shares the same memory
+            return newTypedArrayFromBytesView(
+                jsContext, type, BytesView(bytes.getSource(), bytes.data() + offset, length), exceptionTracker);
+        }
+
+        auto& arrayBuffer = _transferredArrayBuffers[index];
+        if (arrayBuffer.empty()) {
+            arrayBuffer = newTypedArrayFromBytesView(jsContext, TypedArrayType::ArrayBuffer, bytes, exceptionTracker);
+            if (!exceptionTracker) {
+                return jsContext.newUndefined();
+            }
+        }
+
+        if (type == TypedArrayType::ArrayBuffer) {
+            return arrayBuffer;
+        }
+
+        return jsContext.newTypedArrayFromArrayBuffer(type, arrayBuffer.get(), exceptionTracker);
+    }
+};
+
+static bool resolveTransferredArrayBuffer(IJavaScriptContext& jsContext,
+                                          const JSValue& transferable,
+                                          std::vector<TransferredArrayBuffer>& transferredArrayBuffers,
+                                          JSExceptionTracker& exceptionTracker) {
+    auto typedArray = jsContext.valueToTypedArray(transferable, exceptionTracker);
+    if (!exceptionTracker) {
+        return false;
+    }
+
+    if (typedArray.type != TypedArrayType::ArrayBuffer) {
+        // Views transfer the whole ArrayBuffer they are backed by
+        typedArray = jsContext.valueToTypedArray(typedArray.arrayBuffer.get(), exceptionTracker);
+        if (!exceptionTracker) {
+            return false;
+        }
+    }
+
+    for (const auto& transferredArrayBuffer : transferredArrayBuffers) {
+        if (jsContext.isValueEqual(transferredArrayBuffer.arrayBuffer.get(), typedArray.arrayBuffer.get())) {
+            exceptionTracker.onError(Error("ArrayBuffer is listed more than once in the transfer list"));
+            return false;
+        }
+    }
+
+    TransferredArrayBuffer transferredArrayBuffer;
+    transferredArrayBuffer.arrayBuffer = JSValueRef::makeRetained(jsContext, typedArray.arrayBuffer.get());
+    transferredArrayBuffer.data = reinterpret_cast<const Byte*>(typedArray.data);
+
+    if (typedArray.length > 0) {
+        auto source = getAttachedRefCountableFromArrayBuffer(jsContext, typedArray.arrayBuffer.get(), exceptionTracker);
+        if (!exceptionTracker) {
+            return false;
+        }
+
+        if (source != nullptr) {
+            transferredArrayBuffer.bytes = BytesView(source, transferredArrayBuffer.data, typedArray.length);
+        } else {
+            // The memory is owned by the JS heap of this runtime, it needs to be copied into native memory
+            transferredArrayBuffer.bytes =
+                makeShared<ByteBuffer>(transferredArrayBuffer.data, transferredArrayBuffer.data + typedArray.length)
+                    ->toBytesView();
+        }
+    }
+
+    transferredArrayBuffers.emplace_back(std::move(transferredArrayBuffer));
+    return true;
+}
+
+JavaScriptStructuredClone::JavaScriptStructuredClone() = default;
+JavaScriptStructuredClone::~JavaScriptStructuredClone() = default;
+
+Ref<JavaScriptStructuredClone> JavaScriptStructuredClone::serialize(IJavaScriptContext& jsContext,
+                                                                    const JSValue& value,
+                                                                    const JSValue& transferList,
+                                                                    JSExceptionTracker& exceptionTracker) {
+    std::vector<TransferredArrayBuffer> transferredArrayBuffers;
+
+    auto transferables = JSValueRef::makeRetained(jsContext, transferList);
+    if (jsContext.getValueType(transferList) == ValueType::Map) {
+        // Options object, as in postMessage(data, {transfer})
+        transferables = jsContext.getObjectProperty(transferList, "transfer", exceptionTracker);
+        if (!exceptionTracker) {
+            return nullptr;
+        }
+    }
+
+    if (!jsContext.isValueUndefined(transferables.get()) && !jsContext.isValueNull(transferables.get())) {
+        auto length = jsArrayGetLength(jsContext, transferables.get(), exceptionTracker);
+        if (!exceptionTracker) {
+            return nullptr;
+        }
+
+        transferredArrayBuffers.reserve(length);
+        for (size_t i = 0; i < length; i++) {
+            auto transferable = jsContext.getObjectPropertyForIndex(transferables.get(), i, exceptionTracker);
+            if (!exceptionTracker) {
+                return nullptr;
+            }
+
+            if (!resolveTransferredArrayBuffer(
+                    jsContext, transferable.get(), transferredArrayBuffers, exceptionTracker)) {
+                return nullptr;
+            }
+        }
+    }
+
+    auto structuredClone = makeShared<JavaScriptStructuredClone>();
+    StructuredCloneWriter writer(structuredClone->_data, structuredClone->_values, transferredArrayBuffers);
+    if (!writer.write(jsContext, value, exceptionTracker)) {
+        return nullptr;
+    }
+
+    // Only detach once the whole value was written, as the views need to be resolved from the ArrayBuffers
+    structuredClone->_transferredBuffers.reserve(transferredArrayBuffers.size());
+    for (auto& transferredArrayBuffer : transferredArrayBuffers) {
+        auto detached = jsContext.detachArrayBuffer(transferredArrayBuffer.arrayBuffer.get(), exceptionTracker);
+        if (!exceptionTracker) {
+            return nullptr;
+        }
+
+        if (!detached && transferredArrayBuffer.bytes.data() == transferredArrayBuffer.data) {
+            // The engine cannot detach the ArrayBuffer, so the sender can still write into the shared native
+            // memory. Hand over a copy instead, which the sender cannot reach.
+            transferredArrayBuffer.bytes =
+                makeShared<ByteBuffer>(transferredArrayBuffer.bytes.begin(), transferredArrayBuffer.bytes.end())
+                    ->toBytesView();
+        }
+
+        structuredClone->_transferredBuffers.emplace_back(std::move(transferredArrayBuffer.bytes));
+    }
+
+    return structuredClone;
+}
+
+JSValueRef JavaScriptStructuredClone::deserialize(IJavaScriptContext& jsContext,
+                                                  JSExceptionTracker& exceptionTracker) const {
+    StructuredCloneReader reader(_data, _transferredBuffers, _values);
+    return reader.read(jsContext, exceptionTracker);
+}
+
+size_t JavaScriptStructuredClone::getDataSize() const {
+    return _data.size();
+}
+
+size_t JavaScriptStructuredClone::getTransferredBuffersCount() const {
+    return _transferredBuffers.size();
+}
+
+} // namespace Valdi
@@ -0,0 +1,55 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "valdi/runtime/Interfaces/IJavaScriptContext.hpp"
+#include "valdi_core/cpp/Utils/ByteBuffer.hpp"
+#include "valdi_core/cpp/Utils/Bytes.hpp"
+#include "valdi_core/cpp/Utils/Value.hpp"
+
+#include <vector>
+
+namespace Valdi {
+
+/**
+ A JS value serialized into a compact binary format, so that it can be passed from
+ one JS runtime to another without going through an intermediate Value tree.
+
+ Primitives, plain objects, arrays and typed arrays are encoded inline. Values which
+ cannot be cloned as data, like functions or wrapped native objects, are kept aside
+ as Value and go through the regular marshalling on both ends.
+
+ ArrayBuffers given in the transfer list are moved instead of being copied: the
+ receiving runtime gets an ArrayBuffer backed by the same memory, and the ArrayBuffer
+ of the sending runtime is detached if the engine supports it. ArrayBuffers which were
+ allocated by the JS engine itself are copied once when first transferred, after which
+ they are backed by native memory and can be transferred again without copies.
+ */
+class JavaScriptStructuredClone : public SimpleRefCountable {
+public:
+    JavaScriptStructuredClone();
+    ~JavaScriptStructuredClone() override;
+
+    /**
+     Serializes the given value. The transfer list is either undefined, an array of
+     ArrayBuffers or typed arrays whose underlying ArrayBuffer should be transferred,
+     or an object holding that array in its "transfer" property.
+     Returns nullptr and reports the error through the exception tracker on failure.
+     */
+    static Ref<JavaScriptStructuredClone> serialize(IJavaScriptContext& jsContext,
+                                                    const JSValue& value,
+                                                    const JSValue& transferList,
+                                                    JSExceptionTracker& exceptionTracker);
+
+    JSValueRef deserialize(IJavaScriptContext& jsContext, JSExceptionTracker& exceptionTracker) const;
+
+    size_t getDataSize() const;
+    size_t getTransferredBuffersCount() const;
+
+private:
+    ByteBuffer _data;
+    std::vector<BytesView> _transferredBuffers;
+    std::vector<Value> _values;
+};
+
+} // namespace Valdi
@@ -12,6 +12,7 @@
 #include "valdi/runtime/JavaScript/JavaScriptCapturedStacktrace.hpp"
 #include "valdi_core/cpp/Utils/Function.hpp"
 #include "valdi_core/cpp/Utils/Shared.hpp"
+#include "valdi_core/cpp/Utils/ValueArena.hpp"
 
 #include <vector>
 
@@ -21,6 +22,8 @@ struct JavaScriptEntryParameters {
     IJavaScriptContext& jsContext;
     JSExceptionTracker& exceptionTracker;
     const Ref<Context>& valdiContext;
+    // Containers converted during the entry are allocated from the JS thread arena
+    ValueArenaScope arenaScope;
 
     JavaScriptEntryParameters(IJavaScriptContext& jsContext,
                               JSExceptionTracker& exceptionTracker,
@@ -82,6 +82,20 @@ struct JSValue : public BridgedValue<kJSValueStorageSize> {
     using BridgedValue<kJSValueStorageSize>::BridgedValue;
 };
 
+/**
+ Inline cache for a property read from C++, see IJavaScriptContext::getObjectPropertyWithCache().
+ Holds the shape of the last object the property was read from and the slot of the property
+ in that shape, so that reading the property from another object of the same shape skips the
+ property lookup. The engine checks the shape on every read and updates the cache when it
+ changed. A cache must always be used with the same property name and JS context.
+ */
+struct JSPropertyCache {
+    uint64_t shapeId = 0;
+    uint64_t protoShapeId = 0;
+    uint64_t protoObject = 0;
+    uint32_t slotOffset = 0;
+};
+
 void releaseRef(IJavaScriptContext& context, const JSValue& value);
 void retainRef(IJavaScriptContext& context, const JSValue& value);
 void releaseRef(IJavaScriptContext& context, const JSPropertyName& propertyName);
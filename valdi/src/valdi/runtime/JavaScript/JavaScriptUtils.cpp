@@ -537,9 +537,9 @@ static void attachRefCountablePtrToArrayBuffer(IJavaScriptContext& jsContext,
         arrayBuffer, jsContext.getPropertyNameCached(refKey()), wrappedObject.get(), exceptionTracker);
 }
 
-static Ref<RefCountable> getAttachedRefCountableFromArrayBuffer(IJavaScriptContext& jsContext,
-                                                                const JSValue& arrayBuffer,
-                                                                JSExceptionTracker& exceptionTracker) {
+Ref<RefCountable> getAttachedRefCountableFromArrayBuffer(IJavaScriptContext& jsContext,
+                                                         const JSValue& arrayBuffer,
+                                                         JSExceptionTracker& exceptionTracker) {
     auto jsSource =
         jsContext.getObjectProperty(arrayBuffer, jsContext.getPropertyNameCached(refKey()), exceptionTracker);
     if (!exceptionTracker) {
@@ -109,6 +109,14 @@ JSValueRef newTypedArrayFromBytesView(IJavaScriptContext& jsContext,
                                       const BytesView& bytesView,
                                       JSExceptionTracker& exceptionTracker);
 
+/**
+ Returns the native object owning the memory of the given ArrayBuffer, if it was
+ created from a BytesView through newTypedArrayFromBytesView().
+ */
+Ref<RefCountable> getAttachedRefCountableFromArrayBuffer(IJavaScriptContext& jsContext,
+                                                         const JSValue& arrayBuffer,
+                                                         JSExceptionTracker& exceptionTracker);
+
 StringBox nameFromJSFunction(IJavaScriptContext& jsContext, const JSValue& jsValue);
 
 } // namespace Valdi
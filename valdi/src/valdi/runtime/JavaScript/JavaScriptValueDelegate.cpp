@@ -198,6 +198,12 @@ private:
     JSValueRefHolder _value;
 };
 
+struct JavaScriptClassProperty {
+    JSPropertyName name;
+    // Objects of a class are usually created from the same constructor and share their shape
+    JSPropertyCache cache;
+};
+
 class JavaScriptClassDelegate : public PlatformObjectClassDelegate<JSValueRef> {
 public:
     ~JavaScriptClassDelegate() override {
@@ -207,13 +213,13 @@ public:
     }
 
     const JSPropertyName& getPropertyName(size_t index) const {
-        InlineContainerAllocator<JavaScriptClassDelegate, JSPropertyName> allocator;
-        return allocator.getContainerStartPtr(this)[index];
+        InlineContainerAllocator<JavaScriptClassDelegate, JavaScriptClassProperty> allocator;
+        return allocator.getContainerStartPtr(this)[index].name;
     }
 
     void setPropertyName(size_t index, JSPropertyNameRef&& propertyNameRef) {
-        InlineContainerAllocator<JavaScriptClassDelegate, JSPropertyName> allocator;
-        allocator.getContainerStartPtr(this)[index] = propertyNameRef.unsafeReleaseValue();
+        InlineContainerAllocator<JavaScriptClassDelegate, JavaScriptClassProperty> allocator;
+        allocator.getContainerStartPtr(this)[index].name = propertyNameRef.unsafeReleaseValue();
     }
 
     JSValueRef newObject(const JSValueRef* propertyValues, ExceptionTracker& exceptionTracker) final {
@@ -236,8 +242,10 @@ public:
     }
 
     JSValueRef getProperty(const JSValueRef& object, size_t propertyIndex, ExceptionTracker& exceptionTracker) final {
-        return getContext().getObjectProperty(
-            object.get(), getPropertyName(propertyIndex), toJSExceptionTracker(exceptionTracker));
+        InlineContainerAllocator<JavaScriptClassDelegate, JavaScriptClassProperty> allocator;
+        auto& property = allocator.getContainerStartPtr(this)[propertyIndex];
+        return getContext().getObjectPropertyWithCache(
+            object.get(), property.name, property.cache, toJSExceptionTracker(exceptionTracker));
     }
 
     Ref<ValueTypedProxyObject> newProxy(const JSValueRef& object,
@@ -253,7 +261,7 @@ public:
     }
 
     static Ref<JavaScriptClassDelegate> make(IJavaScriptContext& jsContext, size_t propertiesSize) {
-        InlineContainerAllocator<JavaScriptClassDelegate, JSPropertyName> allocator;
+        InlineContainerAllocator<JavaScriptClassDelegate, JavaScriptClassProperty> allocator;
 
         return allocator.allocate(propertiesSize, jsContext, propertiesSize);
     }
@@ -262,10 +270,13 @@ private:
     IJavaScriptContext& _jsContext;
     size_t _propertiesSize;
 
-    friend InlineContainerAllocator<JavaScriptClassDelegate, JSPropertyName>;
+    friend InlineContainerAllocator<JavaScriptClassDelegate, JavaScriptClassProperty>;
 
     JavaScriptClassDelegate(IJavaScriptContext& jsContext, size_t propertiesSize)
-        : _jsContext(jsContext), _propertiesSize(propertiesSize) {}
+        : _jsContext(jsContext), _propertiesSize(propertiesSize) {
+        InlineContainerAllocator<JavaScriptClassDelegate, JavaScriptClassProperty> allocator;
+        allocator.constructContainerEntries(this, propertiesSize);
+    }
 
     IJavaScriptContext& getContext() const {
         return _jsContext;
@@ -1,4 +1,6 @@
 #include "valdi/runtime/JavaScript/JavaScriptWorker.hpp"
+#include "valdi/runtime/JavaScript/JSFunctionWithCallable.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptFunctionCallContext.hpp"
 #include "valdi/runtime/JavaScript/JavaScriptUtils.hpp"
 #include "valdi_core/cpp/Utils/LoggerUtils.hpp"
 
@@ -17,38 +19,62 @@ JavaScriptWorker::~JavaScriptWorker() {
 }
 
 // Retrieve the onmessage function set by the script
-static Ref<ValueFunction> getGlobalOnMessage(JavaScriptEntryParameters& entry) {
+static JSValueRef getGlobalOnMessage(JavaScriptEntryParameters& entry) {
     auto globalObj = entry.jsContext.getGlobalObject(entry.exceptionTracker);
-    auto onMessageKey = STRING_LITERAL("onmessage");
-    auto onmessage =
-        entry.jsContext.getObjectProperty(globalObj.get(), onMessageKey.toStringView(), entry.exceptionTracker);
-    if (entry.jsContext.isValueFunction(onmessage.get())) {
-        return jsValueToFunction(
-            entry.jsContext, onmessage.get(), ReferenceInfoBuilder().withObject(onMessageKey), entry.exceptionTracker);
-    } else {
-        return nullptr;
+    if (!entry.exceptionTracker) {
+        return JSValueRef();
     }
+    return entry.jsContext.getObjectProperty(globalObj.get(), "onmessage", entry.exceptionTracker);
 }
 
-// Call the onmessage function with data
-static void dispatchMessage(const Ref<ValueFunction>& func, const Value& data) {
-    if (func == nullptr) {
-        return;
+// Call the onmessage function with the deserialized message as data, returns its result
+static JSValueRef dispatchMessage(JavaScriptEntryParameters& entry,
+                                  const JSValue& onMessage,
+                                  const JavaScriptStructuredClone& message) {
+    if (!entry.jsContext.isValueFunction(onMessage)) {
+        return entry.jsContext.newUndefined();
+    }
+
+    auto data = message.deserialize(entry.jsContext, entry.exceptionTracker);
+    if (!entry.exceptionTracker) {
+        return JSValueRef();
+    }
+
+    auto e = entry.jsContext.newObject(entry.exceptionTracker);
+    if (!entry.exceptionTracker) {
+        return JSValueRef();
     }
 
-    auto e = makeShared<ValueMap>();
-    (*e)[STRING_LITERAL("data")] = data;
-    (*func)({Value(e)});
+    entry.jsContext.setObjectProperty(e.get(), "data", data.get(), entry.exceptionTracker);
+    if (!entry.exceptionTracker) {
+        return JSValueRef();
+    }
+
+    JSFunctionCallContext callContext(entry.jsContext, &e, 1, entry.exceptionTracker);
+    return entry.jsContext.callObjectAsFunction(onMessage, callContext);
+}
+
+static void completeTask(IJavaScriptContext& jsContext,
+                         const JSValue& result,
+                         const JavaScriptWorkerTaskCompletion& completion) {
+    JSExceptionTracker exceptionTracker(jsContext);
+    auto serializedResult =
+        JavaScriptStructuredClone::serialize(jsContext, result, jsContext.newUndefined().get(), exceptionTracker);
+    if (!exceptionTracker) {
+        completion(exceptionTracker.extractError());
+        return;
+    }
+    completion(serializedResult);
 }
 
 void JavaScriptWorker::postInit() {
     _runtime->dispatchOnJsThread(
         nullptr, JavaScriptTaskScheduleTypeDefault, 0, [self = strongSmallRef(this)](JavaScriptEntryParameters& entry) {
-            self->doPostInit();
+            self->doPostInit(entry);
         });
 }
 
-void JavaScriptWorker::setHostOnMessage(const Ref<ValueFunction>& func) {
+void JavaScriptWorker::setHostOnMessage(const Shared<JSValueRefHolder>& func) {
     _runtime->dispatchOnJsThread(
         nullptr,
         JavaScriptTaskScheduleTypeDefault,
@@ -56,12 +82,22 @@ void JavaScriptWorker::setHostOnMessage(const Ref<ValueFunction>& func) {
         [self = strongSmallRef(this), func](JavaScriptEntryParameters& entry) { self->doSetHostOnMessage(func); });
 }
 
-void JavaScriptWorker::postMessage(const Value& value) {
-    _runtime->dispatchOnJsThread(
-        nullptr,
-        JavaScriptTaskScheduleTypeDefault,
-        0,
-        [self = strongSmallRef(this), value](JavaScriptEntryParameters& entry) { self->doPostMessage(entry, value); });
+void JavaScriptWorker::postMessage(const Ref<JavaScriptStructuredClone>& message) {
+    _runtime->dispatchOnJsThread(nullptr,
+                                 JavaScriptTaskScheduleTypeDefault,
+                                 0,
+                                 [self = strongSmallRef(this), message](JavaScriptEntryParameters& entry) {
+                                     self->doPostMessage(entry, *message);
+                                 });
+}
+
+void JavaScriptWorker::runTask(const Ref<JavaScriptStructuredClone>& task,
+                               JavaScriptWorkerTaskCompletion completion) {
+    _runtime->dispatchOnJsThread(nullptr,
+                                 JavaScriptTaskScheduleTypeDefault,
+                                 0,
+                                 [self = strongSmallRef(this), task, completion = std::move(completion)](
+                                     JavaScriptEntryParameters& entry) { self->doRunTask(entry, *task, completion); });
 }
 
 void JavaScriptWorker::close() {
@@ -71,23 +107,42 @@ void JavaScriptWorker::close() {
                                  [self = strongSmallRef(this)](JavaScriptEntryParameters& entry) { self->doClose(); });
 }
 
-void JavaScriptWorker::doPostInit() {
+void JavaScriptWorker::doPostInit(JavaScriptEntryParameters& entry) {
     auto weakSelf = weakRef(this);
     // Set up globals in the worker runtime
     // - onmessage
-    // - postMessage
+    // - postMessage(data, transfer)
     // - close
     // - location, https://developer.mozilla.org/en-US/docs/Web/API/WorkerLocation, only href and search are populated
     _runtime->setValueToGlobalObject(STRING_LITERAL("onmessage"), Value::undefined());
-    auto postMessageFunc = [weakSelf](const ValueFunctionCallContext& callContext) -> Value {
-        auto self = weakSelf.lock();
-        if (self && !self->_closed) {
-            dispatchMessage(self->_hostOnMessage, callContext.getParameter(0));
-        }
-        return Value::undefined();
-    };
-    _runtime->setValueToGlobalObject(STRING_LITERAL("postMessage"),
-                                     Value(makeShared<ValueFunctionWithCallable>(postMessageFunc)));
+    auto postMessageFunc = makeShared<JSFunctionWithCallable>(
+        ReferenceInfoBuilder().withObject(STRING_LITERAL("postMessage")),
+        [weakSelf](JSFunctionNativeCallContext& callContext) -> JSValueRef {
+            // Serialized from the worker's JS context, so that it can be deserialized straight into the host's
+            auto message = JavaScriptStructuredClone::serialize(callContext.getContext(),
+                                                                callContext.getParameter(0),
+                                                                callContext.getParameter(1),
+                                                                callContext.getExceptionTracker());
+            CHECK_CALL_CONTEXT(callContext);
+
+            auto self = weakSelf.lock();
+            if (self && !self->_closed) {
+                self->doPostMessageToHost(message);
+            }
+            return callContext.getContext().newUndefined();
+        });
+    auto globalObj = entry.jsContext.getGlobalObject(entry.exceptionTracker);
+    if (!entry.exceptionTracker) {
+        return;
+    }
+    auto postMessageJSValue = entry.jsContext.newFunction(postMessageFunc, entry.exceptionTracker);
+    if (!entry.exceptionTracker) {
+        return;
+    }
+    entry.jsContext.setObjectProperty(globalObj.get(), "postMessage", postMessageJSValue.get(), entry.exceptionTracker);
+    if (!entry.exceptionTracker) {
+        return;
+    }
     auto closeFunc = [weakSelf](const ValueFunctionCallContext& callContext) -> Value {
         auto self = weakSelf.lock();
         if (self) {
@@ -110,14 +165,116 @@ void JavaScriptWorker::doPostInit() {
     auto result = _runtime->evalModuleSync(scriptUrl, false);
 }
 
-void JavaScriptWorker::doSetHostOnMessage(const Ref<ValueFunction>& func) {
+void JavaScriptWorker::doSetHostOnMessage(const Shared<JSValueRefHolder>& func) {
     _hostOnMessage = func;
 }
 
-void JavaScriptWorker::doPostMessage(JavaScriptEntryParameters& entry, const Value& value) const {
+void JavaScriptWorker::doPostMessage(JavaScriptEntryParameters& entry, const JavaScriptStructuredClone& message) const {
     if (!_closed) {
         auto onMessageFunc = getGlobalOnMessage(entry);
-        dispatchMessage(onMessageFunc, value);
+        if (!entry.exceptionTracker) {
+            return;
+        }
+        dispatchMessage(entry, onMessageFunc.get(), message);
+    }
+}
+
+void JavaScriptWorker::doPostMessageToHost(const Ref<JavaScriptStructuredClone>& message) const {
+    auto hostOnMessage = _hostOnMessage;
+    if (hostOnMessage == nullptr) {
+        return;
+    }
+
+    auto taskScheduler = hostOnMessage->getTaskScheduler();
+    if (taskScheduler == nullptr) {
+        return;
+    }
+
+    taskScheduler->dispatchOnJsThreadAsync(
+        hostOnMessage->getContext(), [hostOnMessage, message](JavaScriptEntryParameters& entry) {
+            auto onMessageFunc = hostOnMessage->getJsValue(entry.jsContext, entry.exceptionTracker);
+            if (!entry.exceptionTracker) {
+                return;
+            }
+            dispatchMessage(entry, onMessageFunc, *message);
+        });
+}
+
+void JavaScriptWorker::doRunTask(JavaScriptEntryParameters& entry,
+                                 const JavaScriptStructuredClone& task,
+                                 const JavaScriptWorkerTaskCompletion& completion) const {
+    if (_closed) {
+        completion(Error("Worker was terminated"));
+        return;
+    }
+
+    auto onMessageFunc = getGlobalOnMessage(entry);
+    if (!entry.exceptionTracker) {
+        completion(entry.exceptionTracker.extractError());
+        return;
+    }
+    if (!entry.jsContext.isValueFunction(onMessageFunc.get())) {
+        completion(Error(STRING_FORMAT("Worker script '{}' did not set onmessage", _url)));
+        return;
+    }
+
+    auto result = dispatchMessage(entry, onMessageFunc.get(), task);
+    if (!entry.exceptionTracker) {
+        // Delivered to the submitter instead of being reported as uncaught
+        completion(entry.exceptionTracker.extractError());
+        return;
+    }
+
+    JSValueRef then;
+    if (entry.jsContext.isValueObject(result.get())) {
+        then = entry.jsContext.getObjectProperty(result.get(), "then", entry.exceptionTracker);
+        if (!entry.exceptionTracker) {
+            completion(entry.exceptionTracker.extractError());
+            return;
+        }
+    }
+
+    if (then.empty() || !entry.jsContext.isValueFunction(then.get())) {
+        completeTask(entry.jsContext, result.get(), completion);
+        return;
+    }
+
+    // The task returned a promise, the completion is called when it settles
+    auto onFulfilled = makeShared<JSFunctionWithCallable>(
+        ReferenceInfoBuilder().withObject(STRING_LITERAL("onTaskFulfilled")),
+        [completion](JSFunctionNativeCallContext& callContext) -> JSValueRef {
+            completeTask(callContext.getContext(), callContext.getParameter(0), completion);
+            return callContext.getContext().newUndefined();
+        });
+    auto onRejected = makeShared<JSFunctionWithCallable>(
+        ReferenceInfoBuilder().withObject(STRING_LITERAL("onTaskRejected")),
+        [completion](JSFunctionNativeCallContext& callContext) -> JSValueRef {
+            completion(convertJSErrorToValdiError(
+                callContext.getContext(),
+                JSValueRef::makeRetained(callContext.getContext(), callContext.getParameter(0)),
+                nullptr));
+            return callContext.getContext().newUndefined();
+        });
+
+    auto onFulfilledJSValue = entry.jsContext.newFunction(onFulfilled, entry.exceptionTracker);
+    if (!entry.exceptionTracker) {
+        completion(entry.exceptionTracker.extractError());
+        return;
+    }
+    auto onRejectedJSValue = entry.jsContext.newFunction(onRejected, entry.exceptionTracker);
+    if (!entry.exceptionTracker) {
+        completion(entry.exceptionTracker.extractError());
+        return;
+    }
+
+    std::initializer_list<JSValueRef> parameters = {std::move(onFulfilledJSValue), std::move(onRejectedJSValue)};
+
+    JSFunctionCallContext callContext(
+        entry.jsContext, parameters.begin(), /* parametersSize */ parameters.size(), entry.exceptionTracker);
+    callContext.setThisValue(result.get());
+    entry.jsContext.callObjectAsFunction(then.get(), callContext);
+    if (!entry.exceptionTracker) {
+        completion(entry.exceptionTracker.extractError());
     }
 }
 
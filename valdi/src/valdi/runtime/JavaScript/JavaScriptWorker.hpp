@@ -1,9 +1,14 @@
 #pragma once
 
+#include "valdi/runtime/JavaScript/JSValueRefHolder.hpp"
 #include "valdi/runtime/JavaScript/JavaScriptRuntime.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptStructuredClone.hpp"
+#include "valdi_core/cpp/Utils/Function.hpp"
 
 namespace Valdi {
 
+using JavaScriptWorkerTaskCompletion = Function<void(Result<Ref<JavaScriptStructuredClone>>)>;
+
 class JavaScriptWorker : public ValdiObject {
 public:
     VALDI_CLASS_HEADER(JavaScriptWorker);
@@ -12,21 +17,31 @@ public:
     ~JavaScriptWorker() override;
 
     void postInit();
-    void setHostOnMessage(const Ref<ValueFunction>& func);
-    void postMessage(const Value& value);
+    void setHostOnMessage(const Shared<JSValueRefHolder>& func);
+    void postMessage(const Ref<JavaScriptStructuredClone>& message);
+    /**
+     Calls onmessage of the worker script with the given task as data, and calls the completion
+     from the worker thread with the serialized value returned by onmessage. If onmessage returns
+     a promise, the completion is called once the promise settles.
+     */
+    void runTask(const Ref<JavaScriptStructuredClone>& task, JavaScriptWorkerTaskCompletion completion);
     void close();
 
 private:
     Ref<JavaScriptRuntime> _runtime;
     const StringBox _url;
     // onmessage callback in the owner's js context
-    Ref<ValueFunction> _hostOnMessage;
+    Shared<JSValueRefHolder> _hostOnMessage;
     bool _closed = false;
 
     // Called from JS runtime thread
-    void doPostInit();
-    void doSetHostOnMessage(const Ref<ValueFunction>& func);
-    void doPostMessage(JavaScriptEntryParameters& entry, const Value& value) const;
+    void doPostInit(JavaScriptEntryParameters& entry);
+    void doSetHostOnMessage(const Shared<JSValueRefHolder>& func);
+    void doPostMessage(JavaScriptEntryParameters& entry, const JavaScriptStructuredClone& message) const;
+    void doPostMessageToHost(const Ref<JavaScriptStructuredClone>& message) const;
+    void doRunTask(JavaScriptEntryParameters& entry,
+                   const JavaScriptStructuredClone& task,
+                   const JavaScriptWorkerTaskCompletion& completion) const;
     void doClose();
 };
 
@@ -0,0 +1,217 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi/runtime/JavaScript/JavaScriptWorkerPool.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptFunctionCallContext.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptTaskScheduler.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptUtils.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace Valdi {
+
+VALDI_CLASS_IMPL(JavaScriptWorkerPool);
+
+/**
+ Completion of a task handed over to a worker. It can be settled by the worker, or
+ by close() while the task is still running, whichever comes first. Worker scripts
+ can also return thenables which settle more than once, only the first one counts.
+ */
+class JavaScriptWorkerPool::RunningTask : public SimpleRefCountable {
+public:
+    explicit RunningTask(Shared<JSValueRefHolder> completion) : _completion(std::move(completion)) {}
+
+    /**
+     Notifies the completion with the given result, returns false if the task was already settled.
+     */
+    bool settle(const Result<Ref<JavaScriptStructuredClone>>& result) {
+        if (_settled.exchange(true)) {
+            return false;
+        }
+        notifyCompletion(_completion, result);
+        return true;
+    }
+
+private:
+    Shared<JSValueRefHolder> _completion;
+    std::atomic_bool _settled = false;
+};
+
+JavaScriptWorkerPool::JavaScriptWorkerPool(std::vector<Ref<JavaScriptWorker>> workers)
+    : _workers(std::move(workers)) {
+    _runningTasks.resize(_workers.size());
+    _idleWorkers.reserve(_workers.size());
+    // Reversed so that tasks are handed over to the first workers first
+    for (size_t i = _workers.size(); i > 0; i--) {
+        _idleWorkers.emplace_back(i - 1);
+    }
+}
+
+JavaScriptWorkerPool::~JavaScriptWorkerPool() {
+    close();
+}
+
+void JavaScriptWorkerPool::submit(const Ref<JavaScriptStructuredClone>& task,
+                                  const Shared<JSValueRefHolder>& completion) {
+    size_t workerIndex = 0;
+    Ref<JavaScriptWorker> worker;
+    Ref<RunningTask> runningTask;
+
+    {
+        std::lock_guard<Mutex> lock(_mutex);
+        if (!_closed) {
+            if (_idleWorkers.empty()) {
+                _pendingTasks.emplace_back(PendingTask{task, completion});
+                return;
+            }
+
+            workerIndex = _idleWorkers.back();
+            _idleWorkers.pop_back();
+            worker = _workers[workerIndex];
+            runningTask = makeShared<RunningTask>(completion);
+            _runningTasks[workerIndex] = runningTask;
+        }
+    }
+
+    if (worker == nullptr) {
+        notifyCompletion(completion, Error("Worker pool was terminated"));
+        return;
+    }
+
+    runTask(workerIndex, worker, task, runningTask);
+}
+
+void JavaScriptWorkerPool::close() {
+    std::vector<Ref<JavaScriptWorker>> workers;
+    std::vector<Ref<RunningTask>> runningTasks;
+    std::deque<PendingTask> pendingTasks;
+
+    {
+        std::lock_guard<Mutex> lock(_mutex);
+        if (_closed) {
+            return;
+        }
+        _closed = true;
+        workers = std::move(_workers);
+        runningTasks = std::move(_runningTasks);
+        pendingTasks = std::move(_pendingTasks);
+        _idleWorkers.clear();
+    }
+
+    for (const auto& pendingTask : pendingTasks) {
+        notifyCompletion(pendingTask.completion, Error("Worker pool was terminated"));
+    }
+
+    // The running tasks fail right away, a worker which is still in onmessage
+    // would otherwise only settle them once onmessage returns, if ever.
+    for (const auto& runningTask : runningTasks) {
+        if (runningTask != nullptr) {
+            runningTask->settle(Error("Worker pool was terminated"));
+        }
+    }
+
+    for (const auto& worker : workers) {
+        worker->close();
+    }
+}
+
+size_t JavaScriptWorkerPool::getSize() const {
+    std::lock_guard<Mutex> lock(_mutex);
+    return _workers.size();
+}
+
+size_t JavaScriptWorkerPool::getDefaultSize() {
+    auto hardwareConcurrency = static_cast<size_t>(std::thread::hardware_concurrency());
+    return hardwareConcurrency > 1 ? hardwareConcurrency - 1 : 1;
+}
+
+size_t JavaScriptWorkerPool::getMaxSize() {
+    return std::max(static_cast<size_t>(std::thread::hardware_concurrency()), static_cast<size_t>(1));
+}
+
+void JavaScriptWorkerPool::runTask(size_t workerIndex,
+                                   const Ref<JavaScriptWorker>& worker,
+                                   const Ref<JavaScriptStructuredClone>& task,
+                                   const Ref<RunningTask>& runningTask) {
+    auto weakSelf = weakRef(this);
+    worker->runTask(task,
+                    [weakSelf, workerIndex, runningTask](const Result<Ref<JavaScriptStructuredClone>>& result) {
+                        if (!runningTask->settle(result)) {
+                            // Already settled, the worker was handed over to another task at that point
+                            return;
+                        }
+
+                        auto self = weakSelf.lock();
+                        if (self != nullptr) {
+                            self->onTaskCompleted(workerIndex, runningTask);
+                        }
+                    });
+}
+
+void JavaScriptWorkerPool::onTaskCompleted(size_t workerIndex, const Ref<RunningTask>& runningTask) {
+    Ref<JavaScriptStructuredClone> task;
+    Ref<JavaScriptWorker> worker;
+    Ref<RunningTask> nextRunningTask;
+
+    {
+        std::lock_guard<Mutex> lock(_mutex);
+        if (_closed || _runningTasks[workerIndex] != runningTask) {
+            return;
+        }
+
+        if (_pendingTasks.empty()) {
+            _runningTasks[workerIndex] = nullptr;
+            _idleWorkers.emplace_back(workerIndex);
+            return;
+        }
+
+        auto pendingTask = std::move(_pendingTasks.front());
+        _pendingTasks.pop_front();
+        task = std::move(pendingTask.task);
+        worker = _workers[workerIndex];
+        nextRunningTask = makeShared<RunningTask>(std::move(pendingTask.completion));
+        _runningTasks[workerIndex] = nextRunningTask;
+    }
+
+    runTask(workerIndex, worker, task, nextRunningTask);
+}
+
+void JavaScriptWorkerPool::notifyCompletion(const Shared<JSValueRefHolder>& completion,
+                                            const Result<Ref<JavaScriptStructuredClone>>& result) {
+    auto taskScheduler = completion->getTaskScheduler();
+    if (taskScheduler == nullptr) {
+        return;
+    }
+
+    taskScheduler->dispatchOnJsThreadAsync(
+        completion->getContext(), [completion, result](JavaScriptEntryParameters& entry) {
+            auto callback = completion->getJsValue(entry.jsContext, entry.exceptionTracker);
+            if (!entry.exceptionTracker) {
+                return;
+            }
+
+            auto error = entry.jsContext.newUndefined();
+            auto value = entry.jsContext.newUndefined();
+            if (result) {
+                value = result.value()->deserialize(entry.jsContext, entry.exceptionTracker);
+                if (!entry.exceptionTracker) {
+                    auto deserializeError = entry.exceptionTracker.extractError();
+                    value = entry.jsContext.newUndefined();
+                    error = convertValdiErrorToJSError(entry.jsContext, deserializeError, entry.exceptionTracker);
+                }
+            } else {
+                error = convertValdiErrorToJSError(entry.jsContext, result.error(), entry.exceptionTracker);
+            }
+            if (!entry.exceptionTracker) {
+                return;
+            }
+
+            std::initializer_list<JSValueRef> parameters = {std::move(error), std::move(value)};
+            JSFunctionCallContext callContext(
+                entry.jsContext, parameters.begin(), /* parametersSize */ parameters.size(), entry.exceptionTracker);
+            entry.jsContext.callObjectAsFunction(callback, callContext);
+        });
+}
+
+} // namespace Valdi
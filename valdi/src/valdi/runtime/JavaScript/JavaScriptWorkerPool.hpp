@@ -0,0 +1,78 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "valdi/runtime/JavaScript/JSValueRefHolder.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptStructuredClone.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptWorker.hpp"
+#include "valdi_core/cpp/Utils/Mutex.hpp"
+
+#include <deque>
+#include <vector>
+
+namespace Valdi {
+
+/**
+ A fixed set of workers running the same script, to which tasks can be submitted.
+ Tasks are queued and handed over to the first worker which becomes idle, so that a
+ long task on one worker does not delay the tasks which could run on the others.
+
+ A task is run by calling onmessage of the worker script with the task as data, the
+ value returned by onmessage, or the value it resolves to if it is a promise, is the
+ result of the task. The completion given to submit() is called in the submitting
+ JS context as completion(error, result).
+ */
+class JavaScriptWorkerPool : public ValdiObject {
+public:
+    VALDI_CLASS_HEADER(JavaScriptWorkerPool);
+
+    explicit JavaScriptWorkerPool(std::vector<Ref<JavaScriptWorker>> workers);
+    ~JavaScriptWorkerPool() override;
+
+    void submit(const Ref<JavaScriptStructuredClone>& task, const Shared<JSValueRefHolder>& completion);
+
+    /**
+     Terminates the workers, the tasks which did not complete yet fail.
+     */
+    void close();
+
+    size_t getSize() const;
+
+    /**
+     Returns the pool size to use when none was provided, which leaves a core for the main JS thread.
+     */
+    static size_t getDefaultSize();
+
+    /**
+     Returns the largest pool size, each worker has its own thread and JS runtime,
+     having more of them than cores would only add memory and contention.
+     */
+    static size_t getMaxSize();
+
+private:
+    struct PendingTask {
+        Ref<JavaScriptStructuredClone> task;
+        Shared<JSValueRefHolder> completion;
+    };
+
+    class RunningTask;
+
+    mutable Mutex _mutex;
+    std::vector<Ref<JavaScriptWorker>> _workers;
+    // Task running on each worker, indexed by worker index
+    std::vector<Ref<RunningTask>> _runningTasks;
+    std::vector<size_t> _idleWorkers;
+    std::deque<PendingTask> _pendingTasks;
+    bool _closed = false;
+
+    void runTask(size_t workerIndex,
+                 const Ref<JavaScriptWorker>& worker,
+                 const Ref<JavaScriptStructuredClone>& task,
+                 const Ref<RunningTask>& runningTask);
+    void onTaskCompleted(size_t workerIndex, const Ref<RunningTask>& runningTask);
+
+    static void notifyCompletion(const Shared<JSValueRefHolder>& completion,
+                                 const Result<Ref<JavaScriptStructuredClone>>& result);
+};
+
+} // namespace Valdi
@@ -10,6 +10,7 @@
 #include "utils/base/NonCopyable.hpp"
 #include "utils/time/StopWatch.hpp"
 #include "valdi_core/cpp/Utils/Function.hpp"
+#include "valdi_core/cpp/Utils/ObjectPool.hpp"
 #include "valdi_core/cpp/Utils/StringBox.hpp"
 #include <chrono>
 
@@ -70,6 +71,11 @@ public:
 
     virtual void emitLoadModuleMemory(const StringBox& module, int64_t totalMemory, int64_t ownMemory) {};
 
+    /**
+     Emits the hit/miss counters of the process wide object pools, accumulated since the process started.
+     */
+    virtual void emitObjectPoolStatistics(const ObjectPoolStatistics& statistics) {};
+
     static ScopedMetrics scopedOnScrollLatency(const Ref<Metrics>& metrics,
                                                const StringBox& module,
                                                const StringBox& backend);
@@ -69,6 +69,10 @@ const Value& RenderRequest::getFrameObserverCallback() const {
     return _frameObserverCallback;
 }
 
+void RenderRequest::retainPreprocessedValueHandles(std::vector<Ref<RefCountable>> handles) {
+    _preprocessedValueHandles = std::move(handles);
+}
+
 size_t RenderRequest::getEntriesSize() const {
     return _entriesSize;
 }
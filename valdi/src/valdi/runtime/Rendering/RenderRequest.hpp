@@ -16,6 +16,7 @@
 #include "valdi_core/cpp/Utils/InlineContainerAllocator.hpp"
 #include "valdi_core/cpp/Utils/Shared.hpp"
 #include "valdi_core/cpp/Utils/ValueMap.hpp"
+#include <vector>
 
 namespace Valdi {
 
@@ -60,6 +61,13 @@ public:
     void setFrameObserverCallback(const Value& frameObserverCallback);
     const Value& getFrameObserverCallback() const;
 
+    /**
+     Keeps the given preprocessed value handles alive for as long as this request,
+     so that the values preprocessed ahead of rendering stay in their preprocessor
+     caches until the request is rendered.
+     */
+    void retainPreprocessedValueHandles(std::vector<Ref<RefCountable>> handles);
+
     Value serialize(const AttributeIds& attributeIds) const;
 
     size_t getEntriesSize() const;
@@ -99,6 +107,7 @@ private:
     ByteBuffer _entries;
     Value _visibilityObserverCallback;
     Value _frameObserverCallback;
+    std::vector<Ref<RefCountable>> _preprocessedValueHandles;
     size_t _entriesSize = 0;
 
     RenderRequestEntries::EntryBase* doAppendEntry(size_t size);
@@ -0,0 +1,247 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi/runtime/Rendering/RenderRequestMerger.hpp"
+
+#include <boost/functional/hash.hpp>
+
+namespace Valdi {
+
+bool RenderRequestMergerAttributeWriteKey::operator==(const RenderRequestMergerAttributeWriteKey& other) const {
+    return elementId == other.elementId && attributeId == other.attributeId &&
+           injectedFromParent == other.injectedFromParent;
+}
+
+static RenderRequestMergerAttributeWriteKey makeAttributeWriteKey(
+    const RenderRequestEntries::SetElementAttribute& entry) {
+    return RenderRequestMergerAttributeWriteKey{
+        entry.getElementId(), entry.getAttributeId(), entry.isInjectedFromParent()};
+}
+
+/**
+ First pass, finds the entries which can be dropped.
+ */
+class RenderRequestMergerAnalyzer {
+public:
+    explicit RenderRequestMergerAnalyzer(RenderRequestMerger& merger) : _merger(merger) {}
+
+    void visit(RenderRequestEntries::CreateElement& entry) {
+        auto& element = _merger._elements[entry.getElementId()];
+        element.generation++;
+        element.createCount++;
+        _merger._entryIndex++;
+    }
+
+    void visit(RenderRequestEntries::DestroyElement& entry) {
+        auto& element = _merger._elements[entry.getElementId()];
+        element.generation++;
+        if (element.createCount > 0) {
+            element.destroyedAfterCreate = true;
+        }
+        _merger._entryIndex++;
+    }
+
+    void visit(RenderRequestEntries::MoveElementToParent& entry) {
+        _merger._moves.emplace_back(RenderRequestMerger::Move{entry.getElementId(), entry.getParentElementId()});
+        _merger._entryIndex++;
+    }
+
+    void visit(RenderRequestEntries::SetRootElement& entry) {
+        _merger._elements[entry.getElementId()].referencedByRoot = true;
+        _merger._entryIndex++;
+    }
+
+    void visit(RenderRequestEntries::SetElementAttribute& entry) {
+        auto generation = _merger._elements[entry.getElementId()].generation;
+        auto entryIndex = _merger._entryIndex++;
+
+        auto key = makeAttributeWriteKey(entry);
+        const auto& it = _merger._lastAttributeWrites.find(key);
+        if (it == _merger._lastAttributeWrites.end()) {
+            _merger._lastAttributeWrites.try_emplace(key, RenderRequestMerger::AttributeWrite{generation, entryIndex});
+            return;
+        }
+
+        if (it->second.generation == generation) {
+            _merger._supersededEntries.insert(it->second.entryIndex);
+        }
+        it->second.generation = generation;
+        it->second.entryIndex = entryIndex;
+    }
+
+    void visit(RenderRequestEntries::StartAnimations& /*entry*/) {
+        onAnimationBarrier();
+    }
+
+    void visit(RenderRequestEntries::EndAnimations& /*entry*/) {
+        onAnimationBarrier();
+    }
+
+    void visit(RenderRequestEntries::CancelAnimation& /*entry*/) {
+        onAnimationBarrier();
+    }
+
+    void visit(RenderRequestEntries::OnLayoutComplete& /*entry*/) {
+        _merger._entryIndex++;
+    }
+
+private:
+    RenderRequestMerger& _merger;
+
+    void onAnimationBarrier() {
+        _merger._lastAttributeWrites.clear();
+        _merger._entryIndex++;
+    }
+};
+
+/**
+ Second pass, copies the entries which should be kept into the merged request.
+ */
+class RenderRequestMergerWriter {
+public:
+    RenderRequestMergerWriter(const RenderRequestMerger& merger, RenderRequest& output)
+        : _merger(merger), _output(output) {}
+
+    void visit(RenderRequestEntries::CreateElement& entry) {
+        if (shouldKeep(entry.getElementId())) {
+            auto* outputEntry = _output.appendCreateElement();
+            outputEntry->setElementId(entry.getElementId());
+            outputEntry->setViewClassName(entry.getViewClassName());
+        }
+    }
+
+    void visit(RenderRequestEntries::DestroyElement& entry) {
+        if (shouldKeep(entry.getElementId())) {
+            _output.appendDestroyElement()->setElementId(entry.getElementId());
+        }
+    }
+
+    void visit(RenderRequestEntries::MoveElementToParent& entry) {
+        if (shouldKeep(entry.getElementId())) {
+            auto* outputEntry = _output.appendMoveElementToParent();
+            outputEntry->setElementId(entry.getElementId());
+            outputEntry->setParentElementId(entry.getParentElementId());
+            outputEntry->setParentIndex(entry.getParentIndex());
+        }
+    }
+
+    void visit(RenderRequestEntries::SetRootElement& entry) {
+        if (shouldKeep(entry.getElementId())) {
+            _output.appendSetRootElement()->setElementId(entry.getElementId());
+        }
+    }
+
+    void visit(RenderRequestEntries::SetElementAttribute& entry) {
+        if (shouldKeep(entry.getElementId())) {
+            auto* outputEntry = _output.appendSetElementAttribute();
+            outputEntry->setElementId(entry.getElementId());
+            outputEntry->setAttributeId(entry.getAttributeId());
+            outputEntry->setInjectedFromParent(entry.isInjectedFromParent());
+            outputEntry->setAttributeValue(entry.getAttributeValue());
+        }
+    }
+
+    void visit(RenderRequestEntries::StartAnimations& entry) {
+        _entryIndex++;
+        _output.appendStartAnimations()->getAnimationOptions() = entry.getAnimationOptions();
+    }
+
+    void visit(RenderRequestEntries::EndAnimations& /*entry*/) {
+        _entryIndex++;
+        _output.appendEndAnimations();
+    }
+
+    void visit(RenderRequestEntries::CancelAnimation& entry) {
+        _entryIndex++;
+        _output.appendCancelAnimation()->setToken(entry.getToken());
+    }
+
+    void visit(RenderRequestEntries::OnLayoutComplete& entry) {
+        _entryIndex++;
+        _output.appendOnLayoutComplete()->setCallback(entry.getCallback());
+    }
+
+private:
+    const RenderRequestMerger& _merger;
+    RenderRequest& _output;
+    size_t _entryIndex = 0;
+
+    bool shouldKeep(RawViewNodeId elementId) {
+        auto entryIndex = _entryIndex++;
+        return !_merger._supersededEntries.contains(entryIndex) && !_merger._droppedElements.contains(elementId);
+    }
+};
+
+RenderRequestMerger::RenderRequestMerger() = default;
+RenderRequestMerger::~RenderRequestMerger() = default;
+
+void RenderRequestMerger::append(const Ref<RenderRequest>& renderRequest) {
+    _renderRequests.emplace_back(renderRequest);
+}
+
+void RenderRequestMerger::resolveDroppedElements() {
+    for (const auto& it : _elements) {
+        if (it.second.createCount == 1 && it.second.destroyedAfterCreate && !it.second.referencedByRoot) {
+            _droppedElements.insert(it.first);
+        }
+    }
+
+    // An element can only be dropped if every child that was moved into it is dropped as well,
+    // otherwise the kept children would be inserted into a parent that was never created.
+    auto changed = true;
+    while (changed) {
+        changed = false;
+        for (const auto& move : _moves) {
+            if (_droppedElements.contains(move.parentElementId) && !_droppedElements.contains(move.elementId)) {
+                _droppedElements.erase(move.parentElementId);
+                changed = true;
+            }
+        }
+    }
+}
+
+Ref<RenderRequest> RenderRequestMerger::merge() {
+    if (_renderRequests.empty()) {
+        return nullptr;
+    }
+    if (_renderRequests.size() == 1) {
+        return _renderRequests[0];
+    }
+
+    RenderRequestMergerAnalyzer analyzer(*this);
+    for (const auto& renderRequest : _renderRequests) {
+        renderRequest->visitEntries(analyzer);
+    }
+    resolveDroppedElements();
+
+    auto output = makeShared<RenderRequest>();
+    output->setContextId(_renderRequests[0]->getContextId());
+
+    RenderRequestMergerWriter writer(*this, *output);
+    for (const auto& renderRequest : _renderRequests) {
+        renderRequest->visitEntries(writer);
+
+        if (!renderRequest->getVisibilityObserverCallback().isNullOrUndefined()) {
+            output->setVisibilityObserverCallback(renderRequest->getVisibilityObserverCallback());
+        }
+        if (!renderRequest->getFrameObserverCallback().isNullOrUndefined()) {
+            output->setFrameObserverCallback(renderRequest->getFrameObserverCallback());
+        }
+    }
+
+    return output;
+}
+
+} // namespace Valdi
+
+namespace std {
+
+std::size_t hash<Valdi::RenderRequestMergerAttributeWriteKey>::operator()(
+    const Valdi::RenderRequestMergerAttributeWriteKey& k) const noexcept {
+    size_t hash = 0;
+    boost::hash_combine(hash, k.elementId);
+    boost::hash_combine(hash, k.attributeId);
+    boost::hash_combine(hash, k.injectedFromParent);
+    return hash;
+}
+
+} // namespace std
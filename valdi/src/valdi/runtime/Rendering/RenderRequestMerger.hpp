@@ -0,0 +1,97 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "valdi/runtime/Rendering/RenderRequest.hpp"
+#include "valdi_core/cpp/Utils/FlatMap.hpp"
+#include "valdi_core/cpp/Utils/FlatSet.hpp"
+
+#include <vector>
+
+namespace Valdi {
+
+/**
+ Identifies the attribute of an element written by a SetElementAttribute entry.
+ */
+struct RenderRequestMergerAttributeWriteKey {
+    RawViewNodeId elementId;
+    AttributeId attributeId;
+    bool injectedFromParent;
+
+    bool operator==(const RenderRequestMergerAttributeWriteKey& other) const;
+};
+
+} // namespace Valdi
+
+namespace std {
+
+template<>
+struct hash<Valdi::RenderRequestMergerAttributeWriteKey> {
+    std::size_t operator()(const Valdi::RenderRequestMergerAttributeWriteKey& k) const noexcept;
+};
+
+} // namespace std
+
+namespace Valdi {
+
+/**
+ Folds consecutive render requests of a context into a single one which results
+ in the same view tree once rendered, so that a context which fell behind
+ renders only once instead of replaying every intermediate frame:
+ - Only the last value of an attribute set multiple times on the same element is kept.
+ - Elements created and then destroyed within the requests are dropped entirely.
+ Animation entries act as barriers: attribute writes are never folded across
+ StartAnimations, EndAnimations or CancelAnimation, so that animated changes
+ keep their starting values.
+ Each render request replaces the visibility and frame observers of the tree it
+ renders into, so the merged request only keeps the last observers which were set.
+ Earlier ones would have been replaced before being notified of the merged render.
+ */
+class RenderRequestMerger {
+public:
+    RenderRequestMerger();
+    ~RenderRequestMerger();
+
+    void append(const Ref<RenderRequest>& renderRequest);
+
+    /**
+     Returns the merged render request. If only one request was appended,
+     it is returned as is.
+     */
+    Ref<RenderRequest> merge();
+
+private:
+    friend class RenderRequestMergerAnalyzer;
+    friend class RenderRequestMergerWriter;
+
+    struct ElementState {
+        // Incremented each time the element is created or destroyed,
+        // attribute writes are only folded within the same generation.
+        uint32_t generation = 0;
+        uint32_t createCount = 0;
+        bool destroyedAfterCreate = false;
+        bool referencedByRoot = false;
+    };
+
+    struct AttributeWrite {
+        uint32_t generation;
+        size_t entryIndex;
+    };
+
+    struct Move {
+        RawViewNodeId elementId;
+        RawViewNodeId parentElementId;
+    };
+
+    std::vector<Ref<RenderRequest>> _renderRequests;
+    FlatMap<RawViewNodeId, ElementState> _elements;
+    FlatMap<RenderRequestMergerAttributeWriteKey, AttributeWrite> _lastAttributeWrites;
+    FlatSet<size_t> _supersededEntries;
+    FlatSet<RawViewNodeId> _droppedElements;
+    std::vector<Move> _moves;
+    size_t _entryIndex = 0;
+
+    void resolveDroppedElements();
+};
+
+} // namespace Valdi
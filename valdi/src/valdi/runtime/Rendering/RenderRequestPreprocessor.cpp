@@ -0,0 +1,111 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi/runtime/Rendering/RenderRequestPreprocessor.hpp"
+#include "valdi/runtime/Attributes/AttributeHandler.hpp"
+#include "valdi/runtime/Attributes/BoundAttributes.hpp"
+#include "valdi/runtime/Views/GlobalViewFactories.hpp"
+#include "valdi/runtime/Views/ViewFactory.hpp"
+#include "valdi_core/cpp/Utils/Trace.hpp"
+
+namespace Valdi {
+
+class RenderRequestPreprocessorVisitor {
+public:
+    explicit RenderRequestPreprocessorVisitor(RenderRequestPreprocessor& preprocessor) : _preprocessor(preprocessor) {}
+
+    void visit(RenderRequestEntries::CreateElement& entry) {
+        auto boundAttributes = _preprocessor.getBoundAttributes(entry.getViewClassName());
+        if (boundAttributes != nullptr) {
+            _preprocessor._boundAttributesByElementId[entry.getElementId()] = std::move(boundAttributes);
+        } else {
+            _preprocessor._boundAttributesByElementId.erase(entry.getElementId());
+        }
+    }
+
+    void visit(RenderRequestEntries::DestroyElement& entry) {
+        _preprocessor._boundAttributesByElementId.erase(entry.getElementId());
+    }
+
+    void visit(RenderRequestEntries::SetElementAttribute& entry) {
+        const auto& attributeValue = entry.getAttributeValue();
+        if (attributeValue.isNullOrUndefined()) {
+            return;
+        }
+
+        const auto& elementIt = _preprocessor._boundAttributesByElementId.find(entry.getElementId());
+        if (elementIt == _preprocessor._boundAttributesByElementId.end()) {
+            return;
+        }
+
+        // getHandlers() is immutable once bound, unlike getAttributeHandlerForId()
+        // which lazily creates the handlers of the default delegate.
+        const auto& handlers = elementIt->second->getHandlers();
+        const auto& handlerIt = handlers.find(entry.getAttributeId());
+        if (handlerIt == handlers.end()) {
+            return;
+        }
+
+        const auto& handler = handlerIt->second;
+        // Only cached values can be picked up by the tree's thread. Values depending on the
+        // color palette could be cached while the palette is changing, those are left to the tree's thread.
+        if (handler.isPreprocessingTrivial() || !handler.hasPreprocessorCache() ||
+            handler.shouldReevaluateOnColorPaletteChange()) {
+            return;
+        }
+
+        auto result = handler.preprocess(attributeValue);
+        if (result && result.value().handle != nullptr) {
+            _handles.emplace_back(result.value().handle);
+        }
+        // Failures are ignored, they will be reported when the request is rendered
+    }
+
+    template<typename T>
+    void visit(T& /*entry*/) {}
+
+    std::vector<Ref<RefCountable>>& getHandles() {
+        return _handles;
+    }
+
+private:
+    RenderRequestPreprocessor& _preprocessor;
+    std::vector<Ref<RefCountable>> _handles;
+};
+
+RenderRequestPreprocessor::RenderRequestPreprocessor(Ref<GlobalViewFactories> viewFactories)
+    : _viewFactories(std::move(viewFactories)) {}
+
+RenderRequestPreprocessor::~RenderRequestPreprocessor() = default;
+
+Ref<BoundAttributes> RenderRequestPreprocessor::getBoundAttributes(const StringBox& viewClassName) {
+    const auto& it = _boundAttributesByClassName.find(viewClassName);
+    if (it != _boundAttributesByClassName.end()) {
+        return it->second;
+    }
+
+    auto viewFactory = _viewFactories->findViewFactory(viewClassName);
+    if (viewFactory == nullptr) {
+        return nullptr;
+    }
+
+    const auto& boundAttributes = viewFactory->getBoundAttributes();
+    _boundAttributesByClassName[viewClassName] = boundAttributes;
+    return boundAttributes;
+}
+
+size_t RenderRequestPreprocessor::preprocess(RenderRequest& renderRequest) {
+    VALDI_TRACE("Valdi.preprocessRenderRequest");
+
+    RenderRequestPreprocessorVisitor visitor(*this);
+    renderRequest.visitEntries(visitor);
+
+    auto& handles = visitor.getHandles();
+    auto preprocessedCount = handles.size();
+    if (!handles.empty()) {
+        renderRequest.retainPreprocessedValueHandles(std::move(handles));
+    }
+
+    return preprocessedCount;
+}
+
+} // namespace Valdi
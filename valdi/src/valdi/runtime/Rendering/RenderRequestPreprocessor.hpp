@@ -0,0 +1,50 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "valdi/runtime/Rendering/RenderRequest.hpp"
+#include "valdi_core/cpp/Utils/FlatMap.hpp"
+#include "valdi_core/cpp/Utils/Shared.hpp"
+#include "valdi_core/cpp/Utils/StringBox.hpp"
+
+namespace Valdi {
+
+class BoundAttributes;
+class GlobalViewFactories;
+
+/**
+ Runs the attribute preprocessors of the attributes set by the render requests of
+ a Context ahead of rendering, typically from the worker queue while the request waits
+ to be rendered on the tree's thread. The results land in the preprocessor caches of the
+ attribute handlers and are kept alive by the RenderRequest, so that rendering the
+ request only has to look them up.
+
+ Only attributes with cached preprocessors are handled, trivial preprocessors are cheaper
+ to run at render time. Elements whose view class has no view factory yet are skipped,
+ as creating one might call into the platform.
+
+ Render requests must be given in submission order, as the view class of each element
+ is tracked from the CreateElement and DestroyElement entries. This class is not thread safe.
+ */
+class RenderRequestPreprocessor : public SimpleRefCountable {
+public:
+    explicit RenderRequestPreprocessor(Ref<GlobalViewFactories> viewFactories);
+    ~RenderRequestPreprocessor() override;
+
+    /**
+     Preprocess the attribute values of the given request.
+     Returns the number of attribute values which were preprocessed.
+     */
+    size_t preprocess(RenderRequest& renderRequest);
+
+private:
+    friend class RenderRequestPreprocessorVisitor;
+
+    Ref<GlobalViewFactories> _viewFactories;
+    FlatMap<RawViewNodeId, Ref<BoundAttributes>> _boundAttributesByElementId;
+    FlatMap<StringBox, Ref<BoundAttributes>> _boundAttributesByClassName;
+
+    Ref<BoundAttributes> getBoundAttributes(const StringBox& viewClassName);
+};
+
+} // namespace Valdi
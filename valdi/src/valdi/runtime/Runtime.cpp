@@ -18,6 +18,7 @@
 #include "valdi/runtime/CSS/CSSDocument.hpp"
 
 #include "valdi/runtime/Rendering/RenderRequest.hpp"
+#include "valdi/runtime/Rendering/RenderRequestPreprocessor.hpp"
 #include "valdi/runtime/Rendering/ViewNodeRenderer.hpp"
 
 #include "valdi/runtime/Resources/AssetCatalog.hpp"
@@ -39,6 +40,7 @@
 #include "valdi/runtime/Metrics/Metrics.hpp"
 
 #include "valdi/RuntimeMessageHandler.hpp"
+#include "valdi/runtime/Context/LayoutCache.hpp"
 #include "valdi/runtime/Runtime.hpp"
 #include "valdi/runtime/ValdiRuntimeTweaks.hpp"
 #include "valdi_core/cpp/Resources/ResourceId.hpp"
@@ -50,6 +52,7 @@
 #include "utils/time/StopWatch.hpp"
 #include <algorithm>
 #include <fmt/format.h>
+#include <thread>
 #include <vector>
 #include <yoga/YGNode.h>
 
@@ -281,6 +284,11 @@ void Runtime::doDestroyContext(const SharedContext& context) {
     if (viewNodeTree != nullptr) {
         destroyViewNodeTree(*viewNodeTree);
     }
+
+    const auto& metricsObj = getMetrics();
+    if (metricsObj != nullptr) {
+        metricsObj->emitObjectPoolStatistics(ObjectPoolStatisticsProvider::getGlobalStatistics());
+    }
 }
 
 void Runtime::destroyViewNodeTreeWithId(ContextId contextId) {
@@ -350,6 +358,14 @@ DumpedLogs Runtime::dumpLogs(bool includeMetadata, bool includeVerbose, bool isC
 
     if (includeMetadata) {
         logs = dumpContextsLogs();
+
+        if (_layoutCache != nullptr) {
+            logs.appendMetadata(STRING_LITERAL("LayoutCache"),
+                                STRING_FORMAT("{} entries, {} hits, {} misses",
+                                              _layoutCache->size(),
+                                              _layoutCache->getHitCount(),
+                                              _layoutCache->getMissCount()));
+        }
     }
 
     if (jsDump.valid()) {
@@ -536,10 +552,33 @@ void Runtime::receivedRenderRequest(const Ref<RenderRequest>& renderRequest) {
     }
 
     auto taskIdOptional = context->enqueueRenderRequest(renderRequest);
+    if (!taskIdOptional) {
+        return;
+    }
 
-    if (taskIdOptional && !_autoRenderDisabled) {
-        getMainThreadManager().dispatch(
-            context, [context, taskId = taskIdOptional.value()]() { context->runRenderRequest(taskId); });
+    if (_renderPreprocessingQueue != nullptr) {
+        // The request will be rendered later on the main thread, preprocess its attributes
+        // in the meantime so that the main thread only has to apply them. The queue is serial,
+        // which keeps the requests of a context in order, and dedicated to renders so that they
+        // are not held behind the unrelated tasks of the worker queue.
+        _renderPreprocessingQueue->async([self = strongRef(this),
+                                          context,
+                                          renderRequest,
+                                          taskId = taskIdOptional.value()]() {
+            const auto& preprocessor = context->getRenderRequestPreprocessor();
+            if (preprocessor != nullptr) {
+                preprocessor->preprocess(*renderRequest);
+            }
+            self->scheduleRenderRequest(context, taskId);
+        });
+    } else {
+        scheduleRenderRequest(context, taskIdOptional.value());
+    }
+}
+
+void Runtime::scheduleRenderRequest(const SharedContext& context, ContextUpdateId updateId) {
+    if (!_autoRenderDisabled) {
+        getMainThreadManager().dispatch(context, [context, updateId]() { context->runRenderRequest(updateId); });
     }
 }
 
@@ -640,6 +679,21 @@ void Runtime::registerTypeConverter(const StringBox& className, const StringBox&
 
 void Runtime::setRuntimeTweaks(const Ref<ValdiRuntimeTweaks>& runtimeTweaks) {
     _resourceManager->setRuntimeTweaks(runtimeTweaks);
+    if (runtimeTweaks != nullptr && runtimeTweaks->enablePreprocessRenderRequestsOnWorkerQueue() &&
+        _renderPreprocessingQueue == nullptr) {
+        _renderPreprocessingQueue =
+            DispatchQueue::create(STRING_LITERAL("Valdi Render Preprocessing"), ThreadQoSClassHigh);
+    }
+
+    if (runtimeTweaks != nullptr && runtimeTweaks->enableParallelLayout() && _layoutQueue == nullptr) {
+        // The calling thread participates in the layout, so we leave one core to it
+        auto threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        _layoutQueue = DispatchQueue::createPool(STRING_LITERAL("Valdi Layout"), ThreadQoSClassHigh, threadCount);
+    }
+
+    if (runtimeTweaks != nullptr && runtimeTweaks->enableLayoutCache() && _layoutCache == nullptr) {
+        _layoutCache = makeShared<LayoutCache>(LayoutCache::kDefaultCapacity);
+    }
 }
 
 void Runtime::setMetrics(const Ref<Metrics>& metrics) {
@@ -768,6 +822,14 @@ const Ref<DispatchQueue>& Runtime::getWorkerQueue() const {
     return _workerQueue;
 }
 
+const Ref<DispatchQueue>& Runtime::getLayoutQueue() const {
+    return _layoutQueue;
+}
+
+const Ref<LayoutCache>& Runtime::getLayoutCache() const {
+    return _layoutCache;
+}
+
 ILogger& Runtime::getLogger() const {
     return *_logger;
 }
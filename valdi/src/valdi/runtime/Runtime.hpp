@@ -67,6 +67,7 @@ using SharedRuntime = Ref<Runtime>;
 
 class ViewManagerContext;
 class ColorPalette;
+class LayoutCache;
 class AssetLoaderManager;
 class ITweakValueProvider;
 class JavaScriptANRDetector;
@@ -227,7 +228,19 @@ public:
     void setLimitToViewportDisabled(bool limitToViewportDisabled);
     bool limitToViewportDisabled() const;
 
-    const Ref<DispatchQueue>& getWorkerQueue() const;
+    const Ref<DispatchQueue>& getWorkerQueue() const override;
+
+    /**
+     Returns the concurrent queue used to calculate independent layout subtrees in parallel,
+     or null if parallel layout is disabled.
+     */
+    const Ref<DispatchQueue>& getLayoutQueue() const;
+
+    /**
+     Returns the cache of calculated layouts shared by all the ViewNodeTrees,
+     or null if layout caching is disabled.
+     */
+    const Ref<LayoutCache>& getLayoutCache() const;
 
     ILogger& getLogger() const;
 
@@ -267,7 +280,7 @@ public:
     void updateColorPalette(const Value& colorPaletteMap) override;
     Value getColorPalette();
 
-    const Ref<IDiskCache>& getDiskCache() const;
+    const Ref<IDiskCache>& getDiskCache() const override;
 
     Shared<snap::valdi_core::HTTPRequestManager> getRequestManager() const;
 
@@ -316,6 +329,9 @@ private:
 
     Shared<YGConfig> _yogaConfig;
     Ref<DispatchQueue> _workerQueue;
+    Ref<DispatchQueue> _layoutQueue;
+    Ref<DispatchQueue> _renderPreprocessingQueue;
+    Ref<LayoutCache> _layoutCache;
     Shared<snap::valdi::RuntimeMessageHandler> _runtimeMessageHandler;
 
     Ref<ILogger> _logger;
@@ -343,6 +359,7 @@ private:
     void destroyViewNodeTreeWithId(ContextId contextId);
 
     void doDestroyContext(const SharedContext& context);
+    void scheduleRenderRequest(const SharedContext& context, ContextUpdateId updateId);
 
     void runWithExclusiveJsThreadLock(DispatchFunction&& cb);
     bool disablePersistentStoreEncryption();
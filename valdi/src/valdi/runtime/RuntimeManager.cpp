@@ -8,6 +8,7 @@
 #include "valdi/runtime/RuntimeManager.hpp"
 #include "valdi/RuntimeMessageHandler.hpp"
 #include "valdi/runtime/Attributes/DefaultAttributeProcessors.hpp"
+#include "valdi/runtime/Attributes/PreprocessorCache.hpp"
 #include "valdi/runtime/Context/AttributionResolver.hpp"
 #include "valdi/runtime/Context/ViewManagerContext.hpp"
 #include "valdi/runtime/Resources/BytesAssetLoader.hpp"
@@ -136,6 +137,8 @@ RuntimeManager::RuntimeManager(const Ref<IMainThreadDispatcher>& mainThreadDispa
 
 RuntimeManager::~RuntimeManager() {
     fullTeardown();
+    // The palette goes away with the manager, its preprocessed colors can no longer be used
+    PreprocessorCache::releaseScopes(_colorPalette->getId());
 }
 
 void RuntimeManager::postInit() {
@@ -520,6 +523,8 @@ void RuntimeManager::setTweakValueProvider(const Shared<ITweakValueProvider>& tw
         anrDetectorListener->setShouldCrashOnANR(runtimeTweaks != nullptr ? runtimeTweaks->shouldCrashOnANR() : false);
     }
     _anrDetector->setNudgeEnabled(runtimeTweaks != nullptr ? runtimeTweaks->shouldNudgeJSThread() : false);
+    _workerQueue->setInstrumentationEnabled(runtimeTweaks != nullptr ? runtimeTweaks->enableQueueInstrumentation() :
+                                                                       false);
 
     auto disableAnimationRemoveOnCompleteIos =
         runtimeTweaks != nullptr ? runtimeTweaks->disableAnimationRemoveOnCompleteIos() : false;
@@ -104,4 +104,28 @@ bool ValdiRuntimeTweaks::skipProtoIndex() const {
     return getConfigKey("VALDI_PROTO_SKIP_INDEX");
 }
 
+bool ValdiRuntimeTweaks::enableQueueInstrumentation() const {
+    return getConfigKey("VALDI_ENABLE_QUEUE_INSTRUMENTATION");
+}
+
+bool ValdiRuntimeTweaks::enablePreprocessRenderRequestsOnWorkerQueue() const {
+    return getConfigKey("VALDI_ENABLE_PREPROCESS_RENDER_REQUESTS_ON_WORKER_QUEUE");
+}
+
+bool ValdiRuntimeTweaks::enableJsBytecodeDiskCache() const {
+    return getConfigKey("VALDI_ENABLE_JS_BYTECODE_DISK_CACHE");
+}
+
+bool ValdiRuntimeTweaks::enableJsStartupSnapshot() const {
+    return getConfigKey("VALDI_ENABLE_JS_STARTUP_SNAPSHOT");
+}
+
+bool ValdiRuntimeTweaks::enableParallelLayout() const {
+    return getConfigKey("VALDI_ENABLE_PARALLEL_LAYOUT");
+}
+
+bool ValdiRuntimeTweaks::enableLayoutCache() const {
+    return getConfigKey("VALDI_ENABLE_LAYOUT_CACHE");
+}
+
 } // namespace Valdi
@@ -31,6 +31,12 @@ public:
     bool shouldNudgeJSThread() const;
     bool disablePersistentStoreEncryption() const;
     bool skipProtoIndex() const;
+    bool enableQueueInstrumentation() const;
+    bool enablePreprocessRenderRequestsOnWorkerQueue() const;
+    bool enableJsBytecodeDiskCache() const;
+    bool enableJsStartupSnapshot() const;
+    bool enableParallelLayout() const;
+    bool enableLayoutCache() const;
 
 private:
     Shared<ITweakValueProvider> _tweakValueProvider;
@@ -73,6 +73,17 @@ Ref<ViewFactory> GlobalViewFactories::getViewFactory(const StringBox& className)
     }
 }
 
+Ref<ViewFactory> GlobalViewFactories::findViewFactory(const StringBox& className) const {
+    std::lock_guard<Mutex> guard(_mutex);
+
+    const auto& it = _viewFactories.find(className);
+    if (it != _viewFactories.end()) {
+        return it->second;
+    }
+
+    return nullptr;
+}
+
 Ref<ViewFactory> GlobalViewFactories::createViewFactory(const StringBox& className) {
     auto boundAttributes = _attributesManager.getAttributesForClass(className);
     return _attributesManager.getViewManager().createViewFactory(className, boundAttributes);
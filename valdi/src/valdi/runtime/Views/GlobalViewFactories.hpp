@@ -27,6 +27,12 @@ public:
 
     Ref<ViewFactory> getViewFactory(const StringBox& className);
 
+    /**
+     Returns the view factory for the given class if it was already created,
+     without creating it otherwise.
+     */
+    Ref<ViewFactory> findViewFactory(const StringBox& className) const;
+
     std::vector<Ref<ViewFactory>> copyViewFactories() const;
 
 private:
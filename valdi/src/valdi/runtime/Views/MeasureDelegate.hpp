@@ -8,6 +8,7 @@
 #pragma once
 
 #include "valdi_core/cpp/Utils/Shared.hpp"
+#include "valdi_core/cpp/Utils/Value.hpp"
 
 #include "valdi/runtime/Views/Frame.hpp"
 #include "valdi/runtime/Views/Measure.hpp"
@@ -20,6 +21,32 @@ class MeasureDelegate : public SimpleRefCountable {
 public:
     virtual Size measure(
         ViewNode& viewNode, float width, MeasureMode widthMode, float height, MeasureMode heightMode) = 0;
+
+    /**
+     Whether measure() can be called from a layout thread while other nodes of the tree
+     are measured concurrently. Delegates that call into JS or mutate views must return false.
+     */
+    virtual bool canMeasureConcurrently() const {
+        return false;
+    }
+
+    /**
+     Whether the measured size is a pure function of the processed layout attributes of the node
+     and of the value returned by getMeasurementCacheEnvironment(), in which case it can be reused
+     across nodes with identical attributes. Delegates which depend on anything else, like the size
+     of a loaded asset, must return false.
+     */
+    virtual bool canCacheMeasurement() const {
+        return false;
+    }
+
+    /**
+     Returns the state outside of the processed attributes that the measured size depends on,
+     like the font scale. A cached measurement is only reused while this value stays equal.
+     */
+    virtual Value getMeasurementCacheEnvironment() const {
+        return Value();
+    }
 };
 
 } // namespace Valdi
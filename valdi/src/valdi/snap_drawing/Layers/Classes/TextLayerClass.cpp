@@ -11,6 +11,7 @@
 #include "valdi/snap_drawing/Utils/AttributesBinderUtils.hpp"
 #include "valdi_core/cpp/Attributes/TextAttributeValue.hpp"
 #include "valdi_core/cpp/Utils/LoggerUtils.hpp"
+#include "valdi_core/cpp/Utils/ValueArray.hpp"
 
 namespace snap::drawing {
 
@@ -86,6 +87,28 @@ Size TextLayerClass::onMeasure(const Valdi::Value& attributes, Size maxSize, boo
     return Size::make(textSize.width / displayScale, textSize.height / displayScale);
 }
 
+bool TextLayerClass::canCacheMeasurement() const {
+    // The font attribute is preprocessed into a resolved Font, the rest of what onMeasure()
+    // reads outside of the attributes is captured in getMeasurementCacheEnvironment()
+    return true;
+}
+
+Valdi::Value TextLayerClass::getMeasurementCacheEnvironment() const {
+    const auto& resources = getResources();
+    const auto& fontManager = resources->getFontManager();
+
+    auto typefacesRevision = fontManager != nullptr ? fontManager->getTypefacesRevision() : 0;
+
+    auto environment = Valdi::ValueArray::make({
+        Valdi::Value(resources->getRespectDynamicType()),
+        Valdi::Value(static_cast<double>(resources->getDisplayScale())),
+        Valdi::Value(static_cast<double>(resources->getDynamicTypeScale())),
+        Valdi::Value(static_cast<int64_t>(typefacesRevision)),
+    });
+
+    return Valdi::Value(environment);
+}
+
 void TextLayerClass::bindAttributes(Valdi::AttributesBindingContext& binder) {
     std::vector<snap::valdi_core::CompositeAttributePart> parts;
     parts.emplace_back(STRING_LITERAL("fontSize"), snap::valdi_core::AttributeType::Double, true, true);
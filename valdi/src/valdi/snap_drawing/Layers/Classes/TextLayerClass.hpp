@@ -22,6 +22,9 @@ public:
 
     Size onMeasure(const Valdi::Value& attributes, Size maxSize, bool isRightToLeft) override;
 
+    bool canCacheMeasurement() const override;
+    Valdi::Value getMeasurementCacheEnvironment() const override;
+
     void bindAttributes(Valdi::AttributesBindingContext& binder) override;
 
     DECLARE_TEXT_ATTRIBUTE(TextLayer, value)
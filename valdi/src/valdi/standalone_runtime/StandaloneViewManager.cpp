@@ -131,6 +131,13 @@ void doRegisterTextAttribute(const std::string_view& attributeName, Valdi::Attri
 void StandaloneViewManager::bindAttributes(const Valdi::StringBox& className, Valdi::AttributesBindingContext& binder) {
     binder.setDefaultDelegate(Valdi::makeShared<DummyAttributeHandlerDelegate>());
 
+    const auto& measureDelegate = _measureDelegates.find(className);
+    if (measureDelegate != _measureDelegates.end()) {
+        binder.bindUntypedAttribute(
+            STRING_LITERAL("value"), true, Valdi::makeShared<DummyAttributeHandlerDelegate>());
+        binder.setMeasureDelegate(measureDelegate->second);
+    }
+
     if (!_registerCustomAttributes) {
         return;
     }
@@ -215,6 +222,11 @@ void StandaloneViewManager::setRegisterCustomAttributes(bool registerCustomAttri
     _registerCustomAttributes = registerCustomAttributes;
 }
 
+void StandaloneViewManager::registerMeasuredViewClass(const StringBox& className,
+                                                      const Ref<MeasureDelegate>& measureDelegate) {
+    _measureDelegates[className] = measureDelegate;
+}
+
 void StandaloneViewManager::setAllowViewPooling(bool allowViewPooling) {
     _allowViewPooling = allowViewPooling;
 }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "valdi/runtime/Interfaces/IViewManager.hpp"
+#include "valdi/runtime/Views/MeasureDelegate.hpp"
 #include "valdi_core/cpp/Utils/FlatMap.hpp"
 #include "valdi_core/cpp/Utils/Shared.hpp"
 
@@ -42,6 +43,12 @@ public:
     void bindAttributes(const StringBox& className, Valdi::AttributesBindingContext& binder) override;
 
     void setRegisterCustomAttributes(bool registerCustomAttributes);
+
+    /**
+     Makes the given view class measured by the given delegate. The class gets a "value"
+     attribute which invalidates the layout when it changes.
+     */
+    void registerMeasuredViewClass(const StringBox& className, const Ref<MeasureDelegate>& measureDelegate);
     void setKeepAttributesHistory(bool keepAttributesHistory);
     void setAlwaysRenderInMainThread(bool alwaysRenderInMainThread);
 
@@ -59,6 +66,7 @@ private:
     bool _keepAttributesHistory = false;
     bool _allowViewPooling = false;
     bool _alwaysRenderInMainThread = false;
+    FlatMap<StringBox, Ref<MeasureDelegate>> _measureDelegates;
 };
 
 } // namespace Valdi
@@ -59,6 +59,18 @@ Ref<ValdiStandaloneRuntime> createValdiStandaloneRuntime(const StandaloneArgumen
     if (arguments.enableTSN) {
         tweakValueProvider->config.setMapValue(StringBox::fromCString("VALDI_ENABLE_TSN"), Value(true));
     }
+    if (arguments.enableJsBytecodeDiskCache) {
+        tweakValueProvider->config.setMapValue(StringBox::fromCString("VALDI_ENABLE_JS_BYTECODE_DISK_CACHE"),
+                                               Value(true));
+    }
+    if (arguments.enableJsStartupSnapshot) {
+        tweakValueProvider->config.setMapValue(StringBox::fromCString("VALDI_ENABLE_JS_STARTUP_SNAPSHOT"), Value(true));
+    }
+
+    Ref<IDiskCache> diskCache = arguments.diskCache;
+    if (diskCache == nullptr) {
+        diskCache = Valdi::makeShared<InMemoryDiskCache>();
+    }
 
     auto runtime = ValdiStandaloneRuntime::create(arguments.enableDebuggerService,
                                                   !arguments.enableHotReloader,
@@ -67,7 +79,7 @@ Ref<ValdiStandaloneRuntime> createValdiStandaloneRuntime(const StandaloneArgumen
                                                   false,
                                                   arguments.jsBridge,
                                                   mainQueue,
-                                                  Valdi::makeShared<InMemoryDiskCache>(),
+                                                  diskCache,
                                                   nullptr,
                                                   resourceLoader,
                                                   tweakValueProvider.toShared());
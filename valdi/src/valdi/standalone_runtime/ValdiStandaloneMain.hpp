@@ -8,6 +8,7 @@
 #pragma once
 
 #include "valdi_core/cpp/Interfaces/ILogger.hpp"
+#include "valdi_core/cpp/Utils/Shared.hpp"
 #include "valdi_core/cpp/Utils/StringBox.hpp"
 #include <memory>
 #include <vector>
@@ -17,6 +18,7 @@ class ModuleFactoriesProvider;
 }
 
 namespace Valdi {
+class IDiskCache;
 class IJavaScriptBridge;
 class RuntimeManager;
 class Arguments;
@@ -33,6 +35,10 @@ struct StandaloneArguments {
     bool enableDebuggerService = false;
     bool enableHotReloader = false;
     bool enableTSN = false;
+    bool enableJsBytecodeDiskCache = false;
+    bool enableJsStartupSnapshot = false;
+    // An empty in memory disk cache is used when not set
+    Ref<IDiskCache> diskCache;
 };
 
 Ref<ValdiStandaloneRuntime> createValdiStandaloneRuntime(const StandaloneArguments& arguments);
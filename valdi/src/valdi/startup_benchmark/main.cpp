@@ -4,6 +4,7 @@
 #include "valdi/runtime/Runtime.hpp"
 #include "valdi/standalone_runtime/Arguments.hpp"
 #include "valdi/standalone_runtime/ArgumentsParser.hpp"
+#include "valdi/standalone_runtime/InMemoryDiskCache.hpp"
 #include "valdi/standalone_runtime/SignalHandler.hpp"
 #include "valdi/standalone_runtime/StandaloneMainQueue.hpp"
 #include "valdi/standalone_runtime/ValdiStandaloneMain.hpp"
@@ -115,18 +116,44 @@ int main(int argc, const char** argv) {
     }
     standaloneArguments.jsBridge = Valdi::JavaScriptBridge::get(engineType);
 
-    snap::utils::time::StopWatch sw;
-    sw.start();
+    auto runBenchmark = [&](const Valdi::StandaloneArguments& arguments, const char* name) -> bool {
+        snap::utils::time::StopWatch sw;
+        sw.start();
 
-    auto exitCode = createRuntimeAndRenderComponent(standaloneArguments, [&]() { sw.stop(); });
+        auto exitCode = Valdi::createRuntimeAndRenderComponent(arguments, [&]() { sw.stop(); });
 
-    if (exitCode != 0) {
-        std::cerr << "Startup benchmark failed" << std::endl;
+        if (exitCode != 0) {
+            std::cerr << name << " failed" << std::endl;
+            return false;
+        }
+
+        std::cout << name << " took " << sw.elapsed().toString() << std::endl;
+        return true;
+    };
+
+    if (!runBenchmark(standaloneArguments, "Startup benchmark")) {
+        return EXIT_FAILURE;
+    }
+
+    // The first run populates the bytecode cache, the second run loads from it
+    auto bytecodeCacheArguments = standaloneArguments;
+    bytecodeCacheArguments.enableJsBytecodeDiskCache = true;
+    bytecodeCacheArguments.diskCache = Valdi::makeShared<Valdi::InMemoryDiskCache>();
+
+    if (!runBenchmark(bytecodeCacheArguments, "Startup benchmark with cold bytecode cache") ||
+        !runBenchmark(bytecodeCacheArguments, "Startup benchmark with warm bytecode cache")) {
         return EXIT_FAILURE;
     }
 
-    auto time = sw.elapsed();
-    std::cout << "Startup benchmark took " << time.toString() << std::endl;
+    // The first run records the startup snapshot, the second run restores it
+    auto startupSnapshotArguments = standaloneArguments;
+    startupSnapshotArguments.enableJsStartupSnapshot = true;
+    startupSnapshotArguments.diskCache = Valdi::makeShared<Valdi::InMemoryDiskCache>();
+
+    if (!runBenchmark(startupSnapshotArguments, "Startup benchmark recording startup snapshot") ||
+        !runBenchmark(startupSnapshotArguments, "Startup benchmark with startup snapshot")) {
+        return EXIT_FAILURE;
+    }
 
     return EXIT_SUCCESS;
 }
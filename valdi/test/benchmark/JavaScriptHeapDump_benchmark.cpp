@@ -1,7 +1,11 @@
+#include "benchmark/utils/benchmark_utils.hpp"
 #include "valdi/runtime/JavaScript/JavaScriptHeapDumpBuilder.hpp"
+#include "valdi_core/cpp/Utils/DiskUtils.hpp"
 #include "valdi_core/cpp/Utils/Format.hpp"
 #include "valdi_core/cpp/Utils/StringCache.hpp"
 #include <benchmark/benchmark.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace Valdi;
 
@@ -44,9 +48,28 @@ static void BuildHeapDump(benchmark::State& state) {
 
         benchmark::DoNotOptimize(builder.build());
     }
+
+    reportPeakRSS(state);
 }
 BENCHMARK(BuildHeapDump);
 
+static void StreamHeapDumpToFile(benchmark::State& state) {
+    BenchmarkHelper helper;
+    auto fd = ::open("/dev/null", O_WRONLY);
+
+    for (auto _ : state) {
+        JavaScriptHeapDumpBuilder builder(static_cast<size_t>(state.range(0)), Path());
+        helper.populateHeapDumpBuilder(builder);
+
+        JavaScriptHeapDumpFileOutput output(fd);
+        benchmark::DoNotOptimize(builder.build(output));
+    }
+
+    ::close(fd);
+    reportPeakRSS(state);
+}
+BENCHMARK(StreamHeapDumpToFile)->Arg(4096)->Arg(65536);
+
 static void ParseHeapDump(benchmark::State& state) {
     BenchmarkHelper helper;
     JavaScriptHeapDumpBuilder builder;
@@ -63,9 +86,36 @@ static void ParseHeapDump(benchmark::State& state) {
             }
         }
     }
+
+    reportPeakRSS(state);
 }
 BENCHMARK(ParseHeapDump);
 
+static void ParseMappedHeapDump(benchmark::State& state) {
+    auto path = DiskUtils::temporaryFilePath();
+    {
+        BenchmarkHelper helper;
+        JavaScriptHeapDumpBuilder builder;
+        helper.populateHeapDumpBuilder(builder);
+        DiskUtils::store(path, builder.build());
+    }
+
+    for (auto _ : state) {
+        SimpleExceptionTracker exceptionTracker;
+        JavaScriptHeapDumpParser parser(path, exceptionTracker);
+
+        for (const auto& node : parser.getNodes()) {
+            for (const auto& edge : node.getEdges()) {
+                benchmark::DoNotOptimize(edge.getIdentifier());
+            }
+        }
+    }
+
+    DiskUtils::remove(path);
+    reportPeakRSS(state);
+}
+BENCHMARK(ParseMappedHeapDump);
+
 static void MergeHeapDump(benchmark::State& state) {
     BenchmarkHelper helper;
     JavaScriptHeapDumpBuilder builder;
@@ -80,6 +130,8 @@ static void MergeHeapDump(benchmark::State& state) {
         builder.appendDump(heapDump.data(), heapDump.size(), exceptionTracker);
         benchmark::DoNotOptimize(builder.build());
     }
+
+    reportPeakRSS(state);
 }
 BENCHMARK(MergeHeapDump);
 
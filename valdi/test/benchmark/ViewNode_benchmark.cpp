@@ -1,4 +1,4 @@
-#include "benchmark_utils.hpp"
+#include "benchmark/utils/benchmark_utils.hpp"
 #include "valdi_test_utils.hpp"
 
 #include "valdi/runtime/Attributes/AttributeIds.hpp"
@@ -13,6 +13,7 @@
 #include "valdi/runtime/Rendering/RenderRequest.hpp"
 
 #include "valdi/runtime/Attributes/ViewNodeAttribute.hpp"
+#include "valdi/runtime/CSS/CSSDocument.hpp"
 
 #include <benchmark/benchmark.h>
 
@@ -224,4 +225,226 @@ static void DestroyTree(benchmark::State& state) {
 }
 BENCHMARK(DestroyTree);
 
+static Ref<RenderRequest> makeUpdateAttributesRequest(Dependencies& deps, RawViewNodeId elementsCount, bool toggle) {
+    auto request = makeShared<RenderRequest>();
+    auto opacityId = deps.attributeIds.getIdForName(STRING_LITERAL("opacity"));
+    auto marginTopId = deps.attributeIds.getIdForName(STRING_LITERAL("marginTop"));
+
+    for (RawViewNodeId elementId = 1; elementId <= elementsCount; elementId++) {
+        auto* setOpacity = request->appendSetElementAttribute();
+        setOpacity->setElementId(elementId);
+        setOpacity->setAttributeId(opacityId);
+        setOpacity->setAttributeValue(Value(toggle ? 0.5 : 1.0));
+
+        auto* setMarginTop = request->appendSetElementAttribute();
+        setMarginTop->setElementId(elementId);
+        setMarginTop->setAttributeId(marginTopId);
+        setMarginTop->setAttributeValue(Value(toggle ? 4.0 : 8.0));
+    }
+
+    return request;
+}
+
+static void UpdateAttributes(benchmark::State& state) {
+    Dependencies deps;
+
+    RenderState renderState(deps);
+    auto request = makeShared<RenderRequest>();
+    populateRenderRequest(*request, renderState, createElementTree());
+
+    auto tree = deps.createTree();
+    ViewNodeRenderer renderer(*tree, ConsoleLogger::getLogger(), false);
+    renderer.render(*request);
+
+    auto updateRequest = makeUpdateAttributesRequest(deps, renderState.elementId, true);
+    auto revertRequest = makeUpdateAttributesRequest(deps, renderState.elementId, false);
+
+    bool toggle = false;
+    for (auto _ : state) {
+        toggle = !toggle;
+        renderer.render(toggle ? *updateRequest : *revertRequest);
+    }
+
+    state.counters["ViewNodes"] = static_cast<double>(renderState.elementId);
+
+    deps.destroyTree(tree);
+}
+BENCHMARK(UpdateAttributes);
+
+static void RetainTrees(benchmark::State& state) {
+    Dependencies deps;
+
+    RenderState renderState(deps);
+    auto request = makeShared<RenderRequest>();
+    populateRenderRequest(*request, renderState, createElementTree());
+
+    for (auto _ : state) {
+        std::vector<Ref<ViewNodeTree>> trees;
+        for (int64_t i = 0; i < state.range(0); i++) {
+            auto tree = deps.createTree();
+            ViewNodeRenderer renderer(*tree, ConsoleLogger::getLogger(), false);
+            renderer.render(*request);
+            trees.emplace_back(std::move(tree));
+        }
+
+        state.PauseTiming();
+        for (auto& tree : trees) {
+            deps.destroyTree(tree);
+        }
+        state.ResumeTiming();
+    }
+
+    state.counters["ViewNodes"] = static_cast<double>(renderState.elementId * state.range(0));
+    reportPeakRSS(state);
+}
+BENCHMARK(RetainTrees)->Arg(10);
+
+static Valdi::StyleNode* addNamedRule(google::protobuf::RepeatedPtrField<Valdi::NamedStyleNode>* rules,
+                                      const std::string& name) {
+    auto* rule = rules->Add();
+    rule->set_name(name);
+    return rule->mutable_node();
+}
+
+static void addStyle(Valdi::StyleNode& styleNode, const char* attributeName, double value) {
+    static int32_t styleId = 0;
+
+    auto* style = styleNode.add_styles();
+    auto* attribute = style->mutable_attribute();
+    attribute->set_type(Valdi::NodeAttribute_Type_NODE_ATTRIBUTE_TYPE_DOUBLE);
+    attribute->set_name(attributeName);
+    attribute->set_double_value(value);
+    style->set_priority(10);
+    style->set_id(++styleId);
+    style->set_order(styleId);
+}
+
+/**
+ Creates a stylesheet resembling the ones of a large component, with class, child,
+ descendant and nth-child selectors. Most descendant selectors target ancestors
+ which are not in the tree, like the styles of screens which are not displayed.
+ */
+static Ref<CSSDocument> createCSSDocument(Dependencies& deps) {
+    Valdi::StyleNode styleNode;
+    auto* rootIndex = styleNode.mutable_ruleindex();
+
+    // .screen
+    addStyle(*addNamedRule(rootIndex->mutable_class_rules(), "screen"), "opacity", 1);
+
+    // .cell, .cell:nth-child(2n+1)
+    auto* cell = addNamedRule(rootIndex->mutable_class_rules(), "cell");
+    addStyle(*cell, "flexGrow", 1);
+    auto* oddCell = cell->mutable_ruleindex()->add_nth_child_rules();
+    oddCell->set_n(2);
+    oddCell->set_offset(1);
+    addStyle(*oddCell->mutable_node(), "marginTop", 4);
+
+    // .container, .container:first-child
+    auto* container = addNamedRule(rootIndex->mutable_class_rules(), "container");
+    addStyle(*container, "paddingTop", 2);
+    addStyle(*container->mutable_ruleindex()->mutable_first_child_rule(), "marginLeft", 2);
+
+    // .title, .cell > .title, .dark .title, .modal-N .title
+    auto* title = addNamedRule(rootIndex->mutable_class_rules(), "title");
+    addStyle(*title, "marginTop", 8);
+    auto* titleIndex = title->mutable_ruleindex();
+    addStyle(*addNamedRule(titleIndex->mutable_direct_parent_rules()->mutable_class_rules(), "cell"), "marginLeft", 4);
+
+    auto* titleAncestorRules = titleIndex->mutable_ancestor_rules()->mutable_class_rules();
+    addStyle(*addNamedRule(titleAncestorRules, "dark"), "opacity", 0.8);
+    for (size_t i = 0; i < 50; i++) {
+        addStyle(*addNamedRule(titleAncestorRules, "modal-" + std::to_string(i)), "borderRadius", 4);
+    }
+
+    return makeShared<CSSDocument>(
+        ResourceId(STRING_LITERAL("benchmark"), STRING_LITERAL("style.css")), styleNode, deps.attributeIds);
+}
+
+static Element createCSSElementTree(const Ref<CSSDocument>& cssDocument) {
+    auto makeElement = [&](const char* name, const char* cssClass) {
+        return Element(name).attribute("cssDocument", Value(cssDocument)).attribute("class", cssClass);
+    };
+
+    std::vector<Element> titles;
+    for (size_t i = 0; i < 10; i++) {
+        titles.emplace_back(makeElement("label", "title").attribute("value", "Hello world"));
+    }
+
+    std::vector<Element> cells;
+    for (size_t i = 0; i < 20; i++) {
+        // A deep chain of containers, with the titles at the bottom
+        auto leaf = makeElement("view", "container").setChildren(titles);
+        for (size_t depth = 0; depth < 12; depth++) {
+            leaf = makeElement("view", "container").child(std::move(leaf));
+        }
+        cells.emplace_back(makeElement("view", "cell").child(std::move(leaf)).child(titles[0]));
+    }
+
+    return makeElement("view", "screen").attribute("width", 100).attribute("height", 100).setChildren(cells);
+}
+
+static void CSSInitialRender(benchmark::State& state) {
+    Dependencies deps;
+    auto cssDocument = createCSSDocument(deps);
+
+    RenderState renderState(deps);
+    auto request = makeShared<RenderRequest>();
+    populateRenderRequest(*request, renderState, createCSSElementTree(cssDocument));
+
+    for (auto _ : state) {
+        auto tree = deps.createTree();
+        ViewNodeRenderer renderer(*tree, ConsoleLogger::getLogger(), false);
+
+        renderer.render(*request);
+
+        state.PauseTiming();
+        deps.destroyTree(tree);
+        state.ResumeTiming();
+    }
+
+    state.counters["ViewNodes"] = static_cast<double>(renderState.elementId);
+}
+BENCHMARK(CSSInitialRender);
+
+static Ref<RenderRequest> makeSetClassRequest(Dependencies& deps, RawViewNodeId elementId, const char* cssClass) {
+    auto request = makeShared<RenderRequest>();
+    auto* setClass = request->appendSetElementAttribute();
+    setClass->setElementId(elementId);
+    setClass->setAttributeId(deps.attributeIds.getIdForName(STRING_LITERAL("class")));
+    setClass->setAttributeValue(Value(STRING_LITERAL(cssClass)));
+    return request;
+}
+
+/**
+ Toggles a class on the root of the tree. With an argument of 0, the class is not used by
+ any descendant selector and only the root should be restyled. With an argument of 1, the
+ class is used by a descendant selector and the whole tree is restyled.
+ */
+static void CSSToggleRootClass(benchmark::State& state) {
+    Dependencies deps;
+    auto cssDocument = createCSSDocument(deps);
+
+    RenderState renderState(deps);
+    auto request = makeShared<RenderRequest>();
+    populateRenderRequest(*request, renderState, createCSSElementTree(cssDocument));
+
+    auto tree = deps.createTree();
+    ViewNodeRenderer renderer(*tree, ConsoleLogger::getLogger(), false);
+    renderer.render(*request);
+
+    auto toggledRequest = makeSetClassRequest(deps, 1, state.range(0) != 0 ? "screen dark" : "screen selected");
+    auto revertRequest = makeSetClassRequest(deps, 1, "screen");
+
+    bool toggle = false;
+    for (auto _ : state) {
+        toggle = !toggle;
+        renderer.render(toggle ? *toggledRequest : *revertRequest);
+    }
+
+    state.counters["ViewNodes"] = static_cast<double>(renderState.elementId);
+
+    deps.destroyTree(tree);
+}
+BENCHMARK(CSSToggleRootClass)->Arg(0)->Arg(1);
+
 BENCHMARK_MAIN();
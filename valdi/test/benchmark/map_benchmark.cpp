@@ -1,13 +1,17 @@
-#include "benchmark_utils.hpp"
+#include "benchmark/utils/benchmark_utils.hpp"
 #include <benchmark/benchmark.h>
 
 #include "valdi_core/cpp/Utils/FlatMap.hpp"
+#include "valdi_core/cpp/Utils/OrderedFlatMap.hpp"
+#include "valdi_core/cpp/Utils/Value.hpp"
+#include "valdi_core/cpp/Utils/ValueMap.hpp"
+#include <algorithm>
 #include <unordered_map>
 
 using namespace Valdi;
 
 static void CreateUnorderedMap(benchmark::State& state) {
-    StringCache stringCache;
+    auto& stringCache = StringCache::getGlobal();
     auto cachedStrings = makeRandomInternedStrings(stringCache, state.range(0), 10);
 
     for (auto _ : state) {
@@ -21,7 +25,7 @@ static void CreateUnorderedMap(benchmark::State& state) {
 BENCHMARK(CreateUnorderedMap)->DenseRange(8, 128, 8);
 
 static void CreateFlatMap(benchmark::State& state) {
-    StringCache stringCache;
+    auto& stringCache = StringCache::getGlobal();
     auto cachedStrings = makeRandomInternedStrings(stringCache, state.range(0), 10);
 
     for (auto _ : state) {
@@ -35,7 +39,7 @@ static void CreateFlatMap(benchmark::State& state) {
 BENCHMARK(CreateFlatMap)->DenseRange(8, 128, 8);
 
 static void CreateUnorderedMapWithReserve(benchmark::State& state) {
-    StringCache stringCache;
+    auto& stringCache = StringCache::getGlobal();
     auto cachedStrings = makeRandomInternedStrings(stringCache, state.range(0), 10);
 
     for (auto _ : state) {
@@ -50,7 +54,7 @@ static void CreateUnorderedMapWithReserve(benchmark::State& state) {
 BENCHMARK(CreateUnorderedMapWithReserve)->DenseRange(8, 128, 8);
 
 static void CreateFlatMapWithReserve(benchmark::State& state) {
-    StringCache stringCache;
+    auto& stringCache = StringCache::getGlobal();
     auto cachedStrings = makeRandomInternedStrings(stringCache, state.range(0), 10);
 
     for (auto _ : state) {
@@ -64,8 +68,37 @@ static void CreateFlatMapWithReserve(benchmark::State& state) {
 }
 BENCHMARK(CreateFlatMapWithReserve)->DenseRange(8, 128, 8);
 
+static void CreateOrderedFlatMap(benchmark::State& state) {
+    auto& stringCache = StringCache::getGlobal();
+    auto cachedStrings = makeRandomInternedStrings(stringCache, state.range(0), 10);
+
+    for (auto _ : state) {
+        Valdi::OrderedFlatMap<StringBox, bool> map;
+
+        for (const auto& str : cachedStrings) {
+            map[str] = true;
+        }
+    }
+}
+BENCHMARK(CreateOrderedFlatMap)->DenseRange(8, 128, 8);
+
+static void CreateOrderedFlatMapWithReserve(benchmark::State& state) {
+    auto& stringCache = StringCache::getGlobal();
+    auto cachedStrings = makeRandomInternedStrings(stringCache, state.range(0), 10);
+
+    for (auto _ : state) {
+        Valdi::OrderedFlatMap<StringBox, bool> map;
+        map.reserve(cachedStrings.size());
+
+        for (const auto& str : cachedStrings) {
+            map[str] = true;
+        }
+    }
+}
+BENCHMARK(CreateOrderedFlatMapWithReserve)->DenseRange(8, 128, 8);
+
 static void QueryUnorderedMap(benchmark::State& state) {
-    StringCache stringCache;
+    auto& stringCache = StringCache::getGlobal();
     auto cachedStrings = makeRandomInternedStrings(stringCache, state.range(0), 10);
 
     std::unordered_map<StringBox, bool> map;
@@ -85,7 +118,7 @@ static void QueryUnorderedMap(benchmark::State& state) {
 BENCHMARK(QueryUnorderedMap)->DenseRange(8, 128, 8);
 
 static void QueryFlatMap(benchmark::State& state) {
-    StringCache stringCache;
+    auto& stringCache = StringCache::getGlobal();
     auto cachedStrings = makeRandomInternedStrings(stringCache, state.range(0), 10);
 
     Valdi::FlatMap<StringBox, bool> map;
@@ -104,8 +137,28 @@ static void QueryFlatMap(benchmark::State& state) {
 }
 BENCHMARK(QueryFlatMap)->DenseRange(8, 128, 8);
 
+static void QueryOrderedFlatMap(benchmark::State& state) {
+    auto& stringCache = StringCache::getGlobal();
+    auto cachedStrings = makeRandomInternedStrings(stringCache, state.range(0), 10);
+
+    Valdi::OrderedFlatMap<StringBox, bool> map;
+
+    for (const auto& str : cachedStrings) {
+        map[str] = true;
+    }
+
+    for (auto _ : state) {
+        for (const auto& str : cachedStrings) {
+            const auto& it = map.find(str);
+
+            benchmark::DoNotOptimize(it != map.end());
+        }
+    }
+}
+BENCHMARK(QueryOrderedFlatMap)->DenseRange(8, 128, 8);
+
 static void IterateUnorderedMap(benchmark::State& state) {
-    StringCache stringCache;
+    auto& stringCache = StringCache::getGlobal();
     auto cachedStrings = makeRandomInternedStrings(stringCache, state.range(0), 10);
 
     std::unordered_map<StringBox, bool> map;
@@ -123,7 +176,7 @@ static void IterateUnorderedMap(benchmark::State& state) {
 BENCHMARK(IterateUnorderedMap)->DenseRange(8, 128, 8);
 
 static void IterateFlatMap(benchmark::State& state) {
-    StringCache stringCache;
+    auto& stringCache = StringCache::getGlobal();
     auto cachedStrings = makeRandomInternedStrings(stringCache, state.range(0), 10);
 
     Valdi::FlatMap<StringBox, bool> map;
@@ -140,4 +193,160 @@ static void IterateFlatMap(benchmark::State& state) {
 }
 BENCHMARK(IterateFlatMap)->DenseRange(8, 128, 8);
 
+static void IterateOrderedFlatMap(benchmark::State& state) {
+    auto& stringCache = StringCache::getGlobal();
+    auto cachedStrings = makeRandomInternedStrings(stringCache, state.range(0), 10);
+
+    Valdi::OrderedFlatMap<StringBox, bool> map;
+
+    for (const auto& str : cachedStrings) {
+        map[str] = true;
+    }
+
+    for (auto _ : state) {
+        for ([[maybe_unused]] const auto& it : map) {
+            benchmark::DoNotOptimize(it);
+        }
+    }
+}
+BENCHMARK(IterateOrderedFlatMap)->DenseRange(8, 128, 8);
+
+// Serializing a FlatMap in a stable order requires sorting its keys,
+// while an OrderedFlatMap can be serialized in insertion order as is.
+static void SortedKeysFlatMap(benchmark::State& state) {
+    auto& stringCache = StringCache::getGlobal();
+    auto cachedStrings = makeRandomInternedStrings(stringCache, state.range(0), 10);
+
+    Valdi::FlatMap<StringBox, bool> map;
+
+    for (const auto& str : cachedStrings) {
+        map[str] = true;
+    }
+
+    for (auto _ : state) {
+        std::vector<StringBox> keys;
+        keys.reserve(map.size());
+        for (const auto& it : map) {
+            keys.emplace_back(it.first);
+        }
+        std::sort(keys.begin(), keys.end(), [](const StringBox& left, const StringBox& right) -> bool {
+            return left.toStringView() < right.toStringView();
+        });
+
+        benchmark::DoNotOptimize(keys);
+    }
+}
+BENCHMARK(SortedKeysFlatMap)->DenseRange(8, 128, 8);
+
+static void OrderedKeysOrderedFlatMap(benchmark::State& state) {
+    auto& stringCache = StringCache::getGlobal();
+    auto cachedStrings = makeRandomInternedStrings(stringCache, state.range(0), 10);
+
+    Valdi::OrderedFlatMap<StringBox, bool> map;
+
+    for (const auto& str : cachedStrings) {
+        map[str] = true;
+    }
+
+    for (auto _ : state) {
+        std::vector<StringBox> keys;
+        keys.reserve(map.size());
+        for (const auto& it : map) {
+            keys.emplace_back(it.first);
+        }
+
+        benchmark::DoNotOptimize(keys);
+    }
+}
+BENCHMARK(OrderedKeysOrderedFlatMap)->DenseRange(8, 128, 8);
+
+// The Value benchmarks below are meant to be compared between builds with and without
+// --@valdi//bzl/runtime_flags:enable_nan_boxed_value.
+
+static Value makeMixedValue(size_t index) {
+    switch (index % 4) {
+        case 0:
+            return Value(static_cast<int32_t>(index));
+        case 1:
+            return Value(static_cast<double>(index) * 0.5);
+        case 2:
+            return Value(index % 2 == 0);
+        default:
+            return Value::undefined();
+    }
+}
+
+static Ref<ValueArray> makeMixedValueArray(size_t size) {
+    auto array = ValueArray::make(size);
+    for (size_t i = 0; i < size; i++) {
+        array->emplace(i, makeMixedValue(i));
+    }
+    return array;
+}
+
+static void CreateValueArray(benchmark::State& state) {
+    auto size = static_cast<size_t>(state.range(0));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(makeMixedValueArray(size));
+    }
+}
+BENCHMARK(CreateValueArray)->DenseRange(8, 128, 8);
+
+static void CopyValueArray(benchmark::State& state) {
+    auto size = static_cast<size_t>(state.range(0));
+    auto source = makeMixedValueArray(size);
+    // Mix in some refcounted values so that copies exercise retain/release
+    auto nested = makeMixedValueArray(4);
+    for (size_t i = 0; i < size; i += 8) {
+        source->emplace(i, Value(nested));
+    }
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(source->clone());
+    }
+}
+BENCHMARK(CopyValueArray)->DenseRange(8, 128, 8);
+
+static void CreateValueMap(benchmark::State& state) {
+    auto& stringCache = StringCache::getGlobal();
+    auto cachedStrings = makeRandomInternedStrings(stringCache, state.range(0), 10);
+
+    for (auto _ : state) {
+        auto map = makeShared<ValueMap>();
+        map->reserve(cachedStrings.size());
+
+        size_t index = 0;
+        for (const auto& str : cachedStrings) {
+            (*map)[str] = makeMixedValue(index++);
+        }
+
+        benchmark::DoNotOptimize(map);
+    }
+}
+BENCHMARK(CreateValueMap)->DenseRange(8, 128, 8);
+
+static void CopyValueMap(benchmark::State& state) {
+    auto& stringCache = StringCache::getGlobal();
+    auto cachedStrings = makeRandomInternedStrings(stringCache, state.range(0), 10);
+
+    auto source = makeShared<ValueMap>();
+    size_t index = 0;
+    for (const auto& str : cachedStrings) {
+        (*source)[str] = makeMixedValue(index++);
+    }
+
+    for (auto _ : state) {
+        auto map = makeShared<ValueMap>();
+        map->reserve(source->size());
+
+        for (const auto& it : *source) {
+            (*map)[it.first] = it.second;
+        }
+
+        benchmark::DoNotOptimize(map);
+    }
+}
+BENCHMARK(CopyValueMap)->DenseRange(8, 128, 8);
+
 BENCHMARK_MAIN();
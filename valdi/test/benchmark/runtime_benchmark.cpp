@@ -1,4 +1,7 @@
-#include "benchmark_utils.hpp"
+#include "benchmark/utils/benchmark_utils.hpp"
+#include "valdi/jsbridge/JavaScriptBridge.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptFunctionCallContext.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptRuntime.hpp"
 #include "valdi_test_utils.hpp"
 #include <benchmark/benchmark.h>
 
@@ -78,4 +81,95 @@ static void UpdateCSS(benchmark::State& state) {
 }
 BENCHMARK(UpdateCSS);
 
+// Resolves state.range(0) attribute ids, either with one native call per attribute
+// or with all the calls enqueued in the batched call buffer and dispatched at once.
+static const char* kAttributeIdsBenchmarkScript = R"(
+(function(count) {
+  const names = [];
+  for (let i = 0; i < count; i++) {
+    names.push('benchmarkAttribute' + i);
+  }
+
+  function direct() {
+    let sum = 0;
+    for (let i = 0; i < count; i++) {
+      sum += runtime.getAttributeId(names[i]);
+    }
+    return sum;
+  }
+
+  const functionId = runtime.registerBatchedFunction(runtime.getAttributeId);
+  const calls = new Float64Array(runtime.getBatchedCallBuffer());
+  const results = new Float64Array(runtime.getBatchedCallResultBuffer());
+
+  function batched() {
+    let position = 0;
+    for (let i = 0; i < count; i++) {
+      calls[position++] = functionId;
+      calls[position++] = 1;
+      calls[position++] = 1;
+      calls[position++] = i;
+    }
+    runtime.submitBatchedCalls(count, names);
+
+    let sum = 0;
+    for (let i = 0; i < count; i++) {
+      sum += results[i];
+    }
+    return sum;
+  }
+
+  return [direct, batched];
+})
+)";
+
+static void doAttributeIdsBench(size_t functionIndex, benchmark::State& state) {
+    Valdi::ConsoleLogger::getLogger().setMinLogType(Valdi::LogTypeWarn);
+
+    auto* jsBridge = Valdi::JavaScriptBridge::get(snap::valdi_core::JavaScriptEngineType::QuickJS);
+    auto mainQueue = Valdi::makeShared<Valdi::StandaloneMainQueue>();
+    auto standaloneRuntime = Valdi::ValdiStandaloneRuntime::create(false,
+                                                                   false,
+                                                                   false,
+                                                                   true,
+                                                                   true,
+                                                                   jsBridge,
+                                                                   mainQueue,
+                                                                   Valdi::makeShared<Valdi::InMemoryDiskCache>(),
+                                                                   nullptr,
+                                                                   Valdi::makeShared<Valdi::StandaloneResourceLoader>(),
+                                                                   nullptr);
+    mainQueue->flush();
+
+    standaloneRuntime->getRuntime().getJavaScriptRuntime()->dispatchOnJsThreadSync(nullptr, [&](const auto& jsEntry) {
+        auto& jsContext = jsEntry.jsContext;
+        auto& exceptionTracker = jsEntry.exceptionTracker;
+
+        auto factory = jsContext.evaluate(kAttributeIdsBenchmarkScript, "attribute_ids_benchmark.js", exceptionTracker);
+        auto count = jsContext.newNumber(static_cast<int32_t>(state.range(0)));
+        Valdi::JSFunctionCallContext factoryCallContext(jsContext, &count, 1, exceptionTracker);
+        auto functions = jsContext.callObjectAsFunction(factory.get(), factoryCallContext);
+        auto function = jsContext.getObjectPropertyForIndex(functions.get(), functionIndex, exceptionTracker);
+
+        for (auto _ : state) {
+            Valdi::JSFunctionCallContext callContext(jsContext, nullptr, 0, exceptionTracker);
+            benchmark::DoNotOptimize(jsContext.callObjectAsFunction(function.get(), callContext));
+        }
+
+        if (!exceptionTracker) {
+            state.SkipWithError(exceptionTracker.extractError().toString().c_str());
+        }
+    });
+}
+
+static void GetAttributeIds(benchmark::State& state) {
+    doAttributeIdsBench(0, state);
+}
+BENCHMARK(GetAttributeIds)->Arg(16)->Arg(256);
+
+static void GetAttributeIdsBatched(benchmark::State& state) {
+    doAttributeIdsBench(1, state);
+}
+BENCHMARK(GetAttributeIdsBatched)->Arg(16)->Arg(256);
+
 BENCHMARK_MAIN();
@@ -32,6 +32,52 @@ static void StringCacheMakeStringWarm(benchmark::State& state) {
 }
 BENCHMARK(StringCacheMakeStringWarm)->Range(8, 512);
 
+// Multiple threads interning the same set of strings, which are kept alive.
+static void StringCacheMakeStringConcurrentShared(benchmark::State& state) {
+    static std::vector<std::string> strings;
+    static std::vector<StringBox> cachedStrings;
+    auto& stringCache = StringCache::getGlobal();
+
+    // The setup runs on the first thread only, other threads wait for it at the start of the loop.
+    if (state.thread_index() == 0) {
+        strings = makeRandomStrings(32);
+        cachedStrings = internStrings(stringCache, strings);
+    }
+
+    for (auto _ : state) {
+        for (const auto& str : strings) {
+            benchmark::DoNotOptimize(stringCache.makeString(str));
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * strings.size()));
+
+    if (state.thread_index() == 0) {
+        cachedStrings.clear();
+    }
+}
+BENCHMARK(StringCacheMakeStringConcurrentShared)->Threads(1)->Threads(4)->Threads(8);
+
+// Multiple threads interning their own strings, which are released right away.
+// This exercises both the insertion and the removal paths.
+static void StringCacheMakeStringConcurrentDistinct(benchmark::State& state) {
+    // makeRandomStrings() is not thread safe, derive the strings from the thread index instead.
+    std::vector<std::string> strings;
+    for (size_t i = 0; i < 10; i++) {
+        strings.emplace_back("thread_" + std::to_string(state.thread_index()) + "_string_" + std::to_string(i));
+    }
+    auto& stringCache = StringCache::getGlobal();
+
+    for (auto _ : state) {
+        for (const auto& str : strings) {
+            benchmark::DoNotOptimize(stringCache.makeString(str));
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * strings.size()));
+}
+BENCHMARK(StringCacheMakeStringConcurrentDistinct)->Threads(1)->Threads(4)->Threads(8);
+
 // How long does it take to compare regular std::strings
 // Used as base
 static void RegularStringComparison(benchmark::State& state) {
@@ -0,0 +1,209 @@
+#include "benchmark/utils/benchmark_utils.hpp"
+#include <benchmark/benchmark.h>
+
+#include "valdi_core/cpp/Threading/TaskQueue.hpp"
+#include <algorithm>
+#include <deque>
+#include <random>
+
+using namespace Valdi;
+
+/**
+ Reference implementation of the previous TaskQueue design: a std::deque kept sorted
+ by execute time under a single mutex, with a linear scan on cancel.
+ Only the parts needed to compare enqueue/cancel/run costs are kept.
+ */
+class SortedDequeTaskQueue {
+public:
+    EnqueuedTask enqueue(DispatchFunction function) {
+        return enqueue(std::move(function), std::chrono::steady_clock::now());
+    }
+
+    EnqueuedTask enqueue(DispatchFunction function, std::chrono::steady_clock::duration delay) {
+        return enqueue(std::move(function), std::chrono::steady_clock::now() + delay);
+    }
+
+    EnqueuedTask enqueue(DispatchFunction function, std::chrono::steady_clock::time_point executeTime) {
+        EnqueuedTask enqueuedTask;
+        {
+            std::lock_guard<Mutex> lockGuard(_mutex);
+            enqueuedTask.id = ++_taskIdCounter;
+            Task task{enqueuedTask.id, std::move(function), executeTime};
+
+            auto it = std::upper_bound(_tasks.begin(), _tasks.end(), task, [](const Task& a, const Task& b) {
+                if (a.executeTime == b.executeTime) {
+                    return a.id < b.id;
+                }
+                return a.executeTime < b.executeTime;
+            });
+            _tasks.emplace(it, std::move(task));
+        }
+        _condition.notifyAll();
+        return enqueuedTask;
+    }
+
+    void cancel(task_id_t taskId) {
+        {
+            DispatchFunction toDelete;
+            std::lock_guard<Mutex> lockGuard(_mutex);
+            for (auto it = _tasks.begin(); it != _tasks.end(); ++it) {
+                if (it->id == taskId) {
+                    toDelete = std::move(it->function);
+                    _tasks.erase(it);
+                    break;
+                }
+            }
+        }
+        _condition.notifyAll();
+    }
+
+    bool runNextTask() {
+        DispatchFunction function;
+        {
+            std::lock_guard<Mutex> lockGuard(_mutex);
+            if (_tasks.empty() || _tasks.front().executeTime > std::chrono::steady_clock::now()) {
+                return false;
+            }
+            function = std::move(_tasks.front().function);
+            _tasks.pop_front();
+        }
+        function();
+        return true;
+    }
+
+    size_t flush() {
+        size_t ranTasks = 0;
+        while (runNextTask()) {
+            ranTasks++;
+        }
+        return ranTasks;
+    }
+
+private:
+    struct Task {
+        task_id_t id;
+        DispatchFunction function;
+        std::chrono::steady_clock::time_point executeTime;
+    };
+
+    Mutex _mutex;
+    ConditionVariable _condition;
+    task_id_t _taskIdCounter = 0;
+    std::deque<Task> _tasks;
+};
+
+constexpr size_t kTasksPerIteration = 64;
+
+// Producers enqueueing immediate tasks concurrently, drained once all producers are done.
+template<typename Queue>
+static void EnqueueFromProducers(benchmark::State& state) {
+    static Queue* queue = nullptr;
+    if (state.thread_index() == 0) {
+        queue = new Queue();
+    }
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < kTasksPerIteration; i++) {
+            queue->enqueue([]() {});
+        }
+    }
+
+    if (state.thread_index() == 0) {
+        queue->flush();
+        delete queue;
+        queue = nullptr;
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kTasksPerIteration));
+}
+BENCHMARK_TEMPLATE(EnqueueFromProducers, SortedDequeTaskQueue)->Threads(1)->Threads(4)->Iterations(20000);
+BENCHMARK_TEMPLATE(EnqueueFromProducers, TaskQueue)->Threads(1)->Threads(4)->Iterations(20000);
+
+// Producers enqueueing while the first thread acts as the consumer, like the JS and main threads do.
+template<typename Queue>
+static void EnqueueWhileConsuming(benchmark::State& state) {
+    static Queue* queue = nullptr;
+    if (state.thread_index() == 0) {
+        queue = new Queue();
+    }
+
+    for (auto _ : state) {
+        if (state.thread_index() == 0) {
+            queue->flush();
+        } else {
+            for (size_t i = 0; i < kTasksPerIteration; i++) {
+                queue->enqueue([]() {});
+            }
+        }
+    }
+
+    if (state.thread_index() == 0) {
+        queue->flush();
+        delete queue;
+        queue = nullptr;
+    }
+}
+// 1 consumer + 4 producers
+BENCHMARK_TEMPLATE(EnqueueWhileConsuming, SortedDequeTaskQueue)->Threads(5)->Iterations(20000);
+BENCHMARK_TEMPLATE(EnqueueWhileConsuming, TaskQueue)->Threads(5)->Iterations(20000);
+
+// Schedule N delayed tasks and cancel all of them in random order.
+template<typename Queue>
+static void CancelDelayedTasks(benchmark::State& state) {
+    auto count = static_cast<size_t>(state.range(0));
+    std::vector<task_id_t> taskIds;
+    taskIds.reserve(count);
+    std::mt19937 random(42);
+
+    for (auto _ : state) {
+        Queue queue;
+        taskIds.clear();
+        for (size_t i = 0; i < count; i++) {
+            taskIds.emplace_back(
+                queue.enqueue([]() {}, std::chrono::steady_clock::duration(std::chrono::seconds(1 + i % 7))).id);
+        }
+        std::shuffle(taskIds.begin(), taskIds.end(), random);
+
+        for (auto taskId : taskIds) {
+            queue.cancel(taskId);
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * count));
+}
+BENCHMARK_TEMPLATE(CancelDelayedTasks, SortedDequeTaskQueue)->Range(64, 4096);
+BENCHMARK_TEMPLATE(CancelDelayedTasks, TaskQueue)->Range(64, 4096);
+
+// Producers scheduling and cancelling delayed tasks concurrently, e.g. timeouts that get cleared.
+template<typename Queue>
+static void ScheduleAndCancelFromProducers(benchmark::State& state) {
+    static Queue* queue = nullptr;
+    if (state.thread_index() == 0) {
+        queue = new Queue();
+    }
+
+    std::vector<task_id_t> taskIds;
+    taskIds.reserve(kTasksPerIteration);
+
+    for (auto _ : state) {
+        taskIds.clear();
+        for (size_t i = 0; i < kTasksPerIteration; i++) {
+            taskIds.emplace_back(
+                queue->enqueue([]() {}, std::chrono::steady_clock::duration(std::chrono::seconds(1))).id);
+        }
+        for (auto taskId : taskIds) {
+            queue->cancel(taskId);
+        }
+    }
+
+    if (state.thread_index() == 0) {
+        delete queue;
+        queue = nullptr;
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * kTasksPerIteration));
+}
+BENCHMARK_TEMPLATE(ScheduleAndCancelFromProducers, SortedDequeTaskQueue)->Threads(4);
+BENCHMARK_TEMPLATE(ScheduleAndCancelFromProducers, TaskQueue)->Threads(4);
+
+BENCHMARK_MAIN();
@@ -1,6 +1,7 @@
 #include "benchmark_utils.hpp"
 
 #include <random>
+#include <sys/resource.h>
 
 std::vector<StringBox> internStrings(StringCache& stringCache, const std::vector<std::string>& strings) {
     std::vector<StringBox> cachedStrings;
@@ -45,3 +46,17 @@ std::vector<StringBox> makeRandomInternedStrings(StringCache& stringCache, size_
 
     return out;
 }
+
+void reportPeakRSS(benchmark::State& state) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    // Reported in bytes on Darwin
+    auto peakRSSBytes = static_cast<double>(usage.ru_maxrss);
+#else
+    // Reported in kilobytes on Linux
+    auto peakRSSBytes = static_cast<double>(usage.ru_maxrss) * 1024.0;
+#endif
+    state.counters["PeakRSS"] =
+        benchmark::Counter(peakRSSBytes, benchmark::Counter::kDefaults, benchmark::Counter::kIs1024);
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "valdi_core/cpp/Utils/StringCache.hpp"
+#include <benchmark/benchmark.h>
 #include <vector>
 
 using namespace Valdi;
@@ -9,3 +10,9 @@ std::vector<StringBox> internStrings(StringCache& stringCache, const std::vector
 std::string makeRandomString(size_t strLength);
 std::vector<std::string> makeRandomStrings(size_t strLength);
 std::vector<StringBox> makeRandomInternedStrings(StringCache& stringCache, size_t numberOfStrings, size_t strLength);
+
+/**
+ Reports the peak resident set size of the process. The peak is process wide and never decreases,
+ so benchmarks should be run one at a time through --benchmark_filter to compare them.
+ */
+void reportPeakRSS(benchmark::State& state);
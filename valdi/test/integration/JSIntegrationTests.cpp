@@ -1,8 +1,16 @@
 #include "JSBridgeTestFixture.hpp"
 #include "JSIntegrationTestsUtils.hpp"
 #include "utils/platform/TargetPlatform.hpp"
+#include "valdi/runtime/Attributes/AttributeIds.hpp"
+#include "valdi/runtime/CSS/StyleAttributesCache.hpp"
 #include "valdi/runtime/Interfaces/IJavaScriptBridge.hpp"
+#include "valdi/runtime/JavaScript/JSBatchedCallDispatcher.hpp"
 #include "valdi/runtime/JavaScript/JSFunctionWithCallable.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptRuntimeDeserializers.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptStringCache.hpp"
+#include "valdi/runtime/JavaScript/JavaScriptStructuredClone.hpp"
+#include "valdi/runtime/Rendering/RenderRequest.hpp"
+#include "valdi/standalone_runtime/InMemoryDiskCache.hpp"
 #include "valdi_core/cpp/Utils/ByteBuffer.hpp"
 #include "valdi_core/cpp/Utils/StaticString.hpp"
 #include <future>
@@ -833,6 +841,53 @@ TEST_P(JSContextFixture, canCallAsConstructor) {
     ASSERT_EQ(84, number);
 }
 
+TEST_P(JSContextFixture, canEvaluateWithBytecodeDiskCache) {
+    SKIP_IF_V8("Ticket: 2259");
+    MAIN_THREAD_INIT();
+    auto diskCache = makeShared<InMemoryDiskCache>();
+
+    auto evaluateAndCall = [&](const std::string& script) -> double {
+        auto wrapper = createWrapper();
+        auto jsEntry = wrapper.makeJsEntry();
+        auto& context = jsEntry.context;
+        auto& exceptionTracker = jsEntry.exceptionTracker;
+        context.setBytecodeDiskCache(diskCache);
+
+        auto func = context.evaluate(script, "test/cached.js", exceptionTracker);
+        jsEntry.checkException();
+
+        Valdi::JSFunctionCallContext params(context, nullptr, 0, exceptionTracker);
+        auto retValue = context.callObjectAsFunction(func.get(), params);
+        jsEntry.checkException();
+
+        auto number = context.valueToDouble(retValue.get(), exceptionTracker);
+        jsEntry.checkException();
+        return number;
+    };
+
+    // Cold, then warm
+    ASSERT_EQ(42, evaluateAndCall("(function() { return 40 + 2; })"));
+    ASSERT_EQ(42, evaluateAndCall("(function() { return 40 + 2; })"));
+
+    if (isQuickJS()) {
+        ASSERT_EQ(static_cast<size_t>(1), diskCache->getAll().size());
+    }
+
+    // The cached bytecode should not be used once the source changes
+    ASSERT_EQ(84, evaluateAndCall("(function() { return 80 + 4; })"));
+
+    if (isQuickJS()) {
+        // Entries whose bytecode got corrupted are compiled again instead of being deserialized
+        for (const auto& it : diskCache->getAll()) {
+            auto corrupted = makeShared<ByteBuffer>(it.second.begin(), it.second.end());
+            corrupted->data()[corrupted->size() - 1] ^= 0xFF;
+            ASSERT_TRUE(diskCache->store(Path(it.first.toStringView()), corrupted->toBytesView()));
+        }
+    }
+
+    ASSERT_EQ(84, evaluateAndCall("(function() { return 80 + 4; })"));
+}
+
 TEST_P(JSContextFixture, canRetrieveErrorFromNativeFunction) {
     SKIP_IF_V8("Ticket: 2259");
     MAIN_THREAD_INIT();
@@ -1821,6 +1876,591 @@ TEST_P(JSContextFixture, stackOverflowGuard) {
     }
 }
 
+TEST_P(JSContextFixture, canDispatchBatchedCalls) {
+    SKIP_IF_V8("Ticket: 2259");
+    MAIN_THREAD_INIT();
+    auto wrapper = createWrapper();
+    auto jsEntry = wrapper.makeJsEntry();
+    auto& context = jsEntry.context;
+    auto& exceptionTracker = jsEntry.exceptionTracker;
+
+    JSBatchedCallDispatcher dispatcher(context);
+
+    auto multiply = context.newFunction(
+        makeShared<JSFunctionWithCallable>(ReferenceInfoBuilder().withObject(STRING_LITERAL("multiply")),
+                                           [](auto& callContext) -> Valdi::JSValueRef {
+                                               auto left = callContext.getParameterAsDouble(0);
+                                               CHECK_CALL_CONTEXT(callContext);
+                                               auto right = callContext.getParameterAsDouble(1);
+                                               CHECK_CALL_CONTEXT(callContext);
+                                               return callContext.getContext().newNumber(left * right);
+                                           }),
+        exceptionTracker);
+    jsEntry.checkException();
+
+    auto length = context.newFunction(
+        makeShared<JSFunctionWithCallable>(ReferenceInfoBuilder().withObject(STRING_LITERAL("length")),
+                                           [](auto& callContext) -> Valdi::JSValueRef {
+                                               auto str = callContext.getParameterAsString(0);
+                                               CHECK_CALL_CONTEXT(callContext);
+                                               return callContext.getContext().newNumber(
+                                                   static_cast<int32_t>(str.length()));
+                                           }),
+        exceptionTracker);
+    jsEntry.checkException();
+
+    auto fail = context.newFunction(
+        makeShared<JSFunctionWithCallable>(ReferenceInfoBuilder().withObject(STRING_LITERAL("fail")),
+                                           [](auto& callContext) -> Valdi::JSValueRef {
+                                               return callContext.throwError(Error("Batched call failed"));
+                                           }),
+        exceptionTracker);
+    jsEntry.checkException();
+
+    auto submit = context.newFunction(
+        makeShared<JSFunctionWithCallable>(ReferenceInfoBuilder().withObject(STRING_LITERAL("submit")),
+                                           [&](auto& callContext) -> Valdi::JSValueRef {
+                                               auto callCount = callContext.getParameterAsInt(0);
+                                               CHECK_CALL_CONTEXT(callContext);
+                                               dispatcher.dispatch(static_cast<size_t>(callCount),
+                                                                   callContext.getParameter(1),
+                                                                   callContext.getExceptionTracker());
+                                               return callContext.getContext().newUndefined();
+                                           }),
+        exceptionTracker);
+    jsEntry.checkException();
+
+    auto globalObject = context.getGlobalObject(exceptionTracker);
+    jsEntry.checkException();
+
+    std::vector<std::pair<const char*, JSValueRef>> globals;
+    globals.emplace_back("multiplyId", dispatcher.registerFunction(multiply.get(), exceptionTracker));
+    globals.emplace_back("lengthId", dispatcher.registerFunction(length.get(), exceptionTracker));
+    globals.emplace_back("failId", dispatcher.registerFunction(fail.get(), exceptionTracker));
+    globals.emplace_back("callBuffer", dispatcher.getCallBuffer(exceptionTracker));
+    globals.emplace_back("resultBuffer", dispatcher.getResultBuffer(exceptionTracker));
+    globals.emplace_back("submit", std::move(submit));
+    jsEntry.checkException();
+
+    for (const auto& it : globals) {
+        context.setObjectProperty(globalObject.get(), it.first, it.second.get(), exceptionTracker);
+        jsEntry.checkException();
+    }
+
+    auto result = context.evaluate(R""""(
+        (() => {
+            const calls = new Float64Array(callBuffer);
+            const results = new Float64Array(resultBuffer);
+            let position = 0;
+            calls[position++] = multiplyId;
+            calls[position++] = 2;
+            calls[position++] = 0;
+            calls[position++] = 6;
+            calls[position++] = 7;
+            calls[position++] = lengthId;
+            calls[position++] = 1;
+            calls[position++] = 1;
+            calls[position++] = 0;
+            submit(2, ['hello']);
+            return [results[0], results[1]];
+        })()
+    )"""",
+                                   "unnamed.js",
+                                   exceptionTracker);
+    jsEntry.checkException();
+
+    auto value = jsValueToValue(context, result.get(), ReferenceInfoBuilder(), exceptionTracker);
+    jsEntry.checkException();
+
+    ASSERT_EQ(Value(ValueArray::make({Value(42.0), Value(5.0)})), value);
+
+    // A failed call does not prevent the following ones from being made, and its error is reported
+    result = context.evaluate(R""""(
+        (() => {
+            const calls = new Float64Array(callBuffer);
+            const results = new Float64Array(resultBuffer);
+            let position = 0;
+            calls[position++] = failId;
+            calls[position++] = 0;
+            calls[position++] = 0;
+            calls[position++] = multiplyId;
+            calls[position++] = 2;
+            calls[position++] = 0;
+            calls[position++] = 3;
+            calls[position++] = 4;
+            let error;
+            try {
+                submit(2, undefined);
+            } catch (e) {
+                error = e.message;
+            }
+            return [isNaN(results[0]), results[1], error];
+        })()
+    )"""",
+                              "unnamed.js",
+                              exceptionTracker);
+    jsEntry.checkException();
+
+    value = jsValueToValue(context, result.get(), ReferenceInfoBuilder(), exceptionTracker);
+    jsEntry.checkException();
+
+    const auto* results = value.getArray();
+    ASSERT_TRUE(results != nullptr);
+    ASSERT_EQ(static_cast<size_t>(3), results->size());
+    ASSERT_TRUE((*results)[0].toBool());
+    ASSERT_EQ(12.0, (*results)[1].toDouble());
+    ASSERT_NE(std::string::npos, (*results)[2].toStringBox().toStringView().find("Batched call failed"));
+
+    // Slots which cannot be cast to an index are rejected
+    result = context.evaluate(R""""(
+        (() => {
+            const calls = new Float64Array(callBuffer);
+            const errors = [];
+            for (const functionId of [NaN, -1, 1e300, 0.5]) {
+                calls[0] = functionId;
+                calls[1] = 0;
+                calls[2] = 0;
+                try {
+                    submit(1, undefined);
+                } catch (e) {
+                    errors.push(e.message);
+                }
+            }
+            calls[0] = lengthId;
+            calls[1] = 1;
+            calls[2] = 1;
+            calls[3] = 1e20;
+            try {
+                submit(1, ['hello']);
+            } catch (e) {
+                errors.push(e.message);
+            }
+            return errors.length;
+        })()
+    )"""",
+                              "unnamed.js",
+                              exceptionTracker);
+    jsEntry.checkException();
+
+    value = jsValueToValue(context, result.get(), ReferenceInfoBuilder(), exceptionTracker);
+    jsEntry.checkException();
+
+    ASSERT_EQ(5, value.toInt());
+
+    // Functions which are not implemented natively cannot be batched
+    auto jsFunction = context.evaluate("(() => 42)", "unnamed.js", exceptionTracker);
+    jsEntry.checkException();
+
+    auto functionId = dispatcher.registerFunction(jsFunction.get(), exceptionTracker);
+    jsEntry.checkException();
+
+    ASSERT_TRUE(context.isValueUndefined(functionId.get()));
+}
+
+TEST_P(JSContextFixture, canStructuredCloneWithTransfer) {
+    SKIP_IF_V8("Ticket: 2259");
+    MAIN_THREAD_INIT();
+    auto wrapper = createWrapper();
+    auto jsEntry = wrapper.makeJsEntry();
+    auto& context = jsEntry.context;
+    auto& exceptionTracker = jsEntry.exceptionTracker;
+
+    auto source = context.evaluate(R""""(
+        (() => {
+            const bytes = new Uint8Array([1, 2, 3, 4, 5, 6, 7, 8]);
+            globalThis.transferredBuffer = bytes.buffer;
+            return {
+                label: 'hello',
+                count: 3,
+                nested: [true, null, 1.5, { inner: 'world' }],
+                skipped: undefined,
+                bytes,
+                tail: bytes.subarray(6),
+                copied: new Uint16Array([42]),
+            };
+        })()
+    )"""",
+                                   "unnamed.js",
+                                   exceptionTracker);
+    jsEntry.checkException();
+
+    auto transferList = context.evaluate("[transferredBuffer]", "unnamed.js", exceptionTracker);
+    jsEntry.checkException();
+
+    auto structuredClone =
+        JavaScriptStructuredClone::serialize(context, source.get(), transferList.get(), exceptionTracker);
+    jsEntry.checkException();
+
+    ASSERT_TRUE(structuredClone != nullptr);
+    ASSERT_EQ(static_cast<size_t>(1), structuredClone->getTransferredBuffersCount());
+
+    auto cloned = structuredClone->deserialize(context, exceptionTracker);
+    jsEntry.checkException();
+
+    auto globalObject = context.getGlobalObject(exceptionTracker);
+    jsEntry.checkException();
+    context.setObjectProperty(globalObject.get(), "cloned", cloned.get(), exceptionTracker);
+    jsEntry.checkException();
+
+    auto result = context.evaluate(R""""(
+        [
+            cloned.label,
+            cloned.count,
+            cloned.nested,
+            'skipped' in cloned,
+            Array.from(cloned.bytes),
+            Array.from(cloned.tail),
+            cloned.copied instanceof Uint16Array ? cloned.copied[0] : -1,
+            transferredBuffer.byteLength,
+        ]
+    )"""",
+                                   "unnamed.js",
+                                   exceptionTracker);
+    jsEntry.checkException();
+
+    auto value = jsValueToValue(context, result.get(), ReferenceInfoBuilder(), exceptionTracker);
+    jsEntry.checkException();
+
+    auto inner = makeShared<ValueMap>();
+    (*inner)[STRING_LITERAL("inner")] = Value(STRING_LITERAL("world"));
+
+    // Only QuickJS supports detaching the transferred ArrayBuffer
+    auto expectedSourceLength = isQuickJS() ? 0.0 : 8.0;
+
+    ASSERT_EQ(Value(ValueArray::make({
+                  Value(STRING_LITERAL("hello")),
+                  Value(3),
+                  Value(ValueArray::make({Value(true), Value(), Value(1.5), Value(inner)})),
+                  Value(false),
+                  Value(ValueArray::make(
+                      {Value(1), Value(2), Value(3), Value(4), Value(5), Value(6), Value(7), Value(8)})),
+                  Value(ValueArray::make({Value(7), Value(8)})),
+                  Value(42),
+                  Value(expectedSourceLength),
+              })),
+              value);
+}
+
+TEST_P(JSContextFixture, structuredCloneDoesNotShareTransferredBufferWhenDetachIsUnsupported) {
+    SKIP_IF_V8("Ticket: 2259");
+    MAIN_THREAD_INIT();
+    auto wrapper = createWrapper();
+    auto jsEntry = wrapper.makeJsEntry();
+    auto& context = jsEntry.context;
+    auto& exceptionTracker = jsEntry.exceptionTracker;
+
+    // ArrayBuffer backed by native memory, which the clone would otherwise reference directly
+    const Byte bytes[] = {1, 2, 3, 4};
+    auto nativeBuffer = makeShared<ByteBuffer>(std::begin(bytes), std::end(bytes));
+    auto arrayBuffer = context.newArrayBuffer(nativeBuffer->toBytesView(), exceptionTracker);
+    jsEntry.checkException();
+
+    auto globalObject = context.getGlobalObject(exceptionTracker);
+    jsEntry.checkException();
+    context.setObjectProperty(globalObject.get(), "nativeBuffer", arrayBuffer.get(), exceptionTracker);
+    jsEntry.checkException();
+
+    auto source = context.evaluate("new Uint8Array(nativeBuffer)", "unnamed.js", exceptionTracker);
+    jsEntry.checkException();
+    auto transferList = context.evaluate("[nativeBuffer]", "unnamed.js", exceptionTracker);
+    jsEntry.checkException();
+
+    auto structuredClone =
+        JavaScriptStructuredClone::serialize(context, source.get(), transferList.get(), exceptionTracker);
+    jsEntry.checkException();
+    ASSERT_TRUE(structuredClone != nullptr);
+
+    // Only QuickJS supports detaching, the other engines keep the sender's ArrayBuffer usable
+    auto senderLength = context.evaluate(R""""(
+        (() => {
+            if (nativeBuffer.byteLength > 0) {
+                new Uint8Array(nativeBuffer)[0] = 42;
+            }
+            return nativeBuffer.byteLength;
+        })()
+    )"""",
+                                         "unnamed.js",
+                                         exceptionTracker);
+    jsEntry.checkException();
+
+    auto senderLengthValue = jsValueToValue(context, senderLength.get(), ReferenceInfoBuilder(), exceptionTracker);
+    jsEntry.checkException();
+    ASSERT_EQ(isQuickJS() ? 0 : 4, senderLengthValue.toInt());
+
+    auto cloned = structuredClone->deserialize(context, exceptionTracker);
+    jsEntry.checkException();
+    context.setObjectProperty(globalObject.get(), "cloned", cloned.get(), exceptionTracker);
+    jsEntry.checkException();
+
+    auto result = context.evaluate("Array.from(cloned)", "unnamed.js", exceptionTracker);
+    jsEntry.checkException();
+
+    auto value = jsValueToValue(context, result.get(), ReferenceInfoBuilder(), exceptionTracker);
+    jsEntry.checkException();
+
+    // Writes made by the sender after the transfer are not visible to the receiver
+    ASSERT_EQ(Value(ValueArray::make({Value(1), Value(2), Value(3), Value(4)})), value);
+}
+
+TEST_P(JSContextFixture, getObjectPropertyWithCacheFollowsShapeChanges) {
+    MAIN_THREAD_INIT();
+    auto wrapper = createWrapper();
+    auto jsEntry = wrapper.makeJsEntry();
+    auto& context = jsEntry.context;
+    auto& exceptionTracker = jsEntry.exceptionTracker;
+
+    auto objects = context.evaluate(R""""(
+        (() => {
+            const proto = { value: 4 };
+            const inherited = Object.create(proto);
+            return [{ other: 0, value: 1 }, { other: 0, value: 2 }, { value: 3 }, inherited, proto];
+        })()
+    )"""",
+                                    "unnamed.js",
+                                    exceptionTracker);
+    jsEntry.checkException();
+
+    auto propertyName = context.newPropertyName("value");
+    JSPropertyCache propertyCache;
+
+    auto readValue = [&](size_t index) -> int32_t {
+        auto object = context.getObjectPropertyForIndex(objects.get(), index, exceptionTracker);
+        jsEntry.checkException();
+        auto value =
+            context.getObjectPropertyWithCache(object.get(), propertyName.get(), propertyCache, exceptionTracker);
+        jsEntry.checkException();
+        auto intValue = context.valueToInt(value.get(), exceptionTracker);
+        jsEntry.checkException();
+        return intValue;
+    };
+
+    // Same shape
+    ASSERT_EQ(1, readValue(0));
+    ASSERT_EQ(2, readValue(1));
+    // Different shape
+    ASSERT_EQ(3, readValue(2));
+    // Property found in the prototype
+    ASSERT_EQ(4, readValue(3));
+    ASSERT_EQ(1, readValue(0));
+
+    // Changing the prototype's shape
+    auto proto = context.getObjectPropertyForIndex(objects.get(), 4, exceptionTracker);
+    jsEntry.checkException();
+    context.setObjectProperty(proto.get(), "added", context.newNumber(0).get(), exceptionTracker);
+    jsEntry.checkException();
+    context.setObjectProperty(proto.get(), "value", context.newNumber(5).get(), exceptionTracker);
+    jsEntry.checkException();
+    ASSERT_EQ(5, readValue(3));
+    ASSERT_EQ(5, readValue(3));
+
+    // Changing the object's shape
+    auto first = context.getObjectPropertyForIndex(objects.get(), 0, exceptionTracker);
+    jsEntry.checkException();
+    context.setObjectProperty(first.get(), "value", context.newNumber(6).get(), exceptionTracker);
+    jsEntry.checkException();
+    ASSERT_EQ(6, readValue(0));
+    context.setObjectProperty(first.get(), "extra", context.newNumber(0).get(), exceptionTracker);
+    jsEntry.checkException();
+    ASSERT_EQ(6, readValue(0));
+    ASSERT_EQ(2, readValue(1));
+}
+
+struct RenderRequestAttributesVisitor {
+    std::vector<StringBox> createdViewClasses;
+    std::vector<std::pair<AttributeId, Value>> attributes;
+    std::vector<const RenderRequestEntries::SetElementAttribute*> attributeEntries;
+
+    void visit(RenderRequestEntries::CreateElement& entry) {
+        createdViewClasses.emplace_back(entry.getViewClassName());
+    }
+
+    void visit(RenderRequestEntries::SetElementAttribute& entry) {
+        attributes.emplace_back(entry.getAttributeId(), entry.getAttributeValue());
+        attributeEntries.emplace_back(&entry);
+    }
+
+    template<typename T>
+    void visit(T& /*entry*/) {}
+};
+
+static std::string toJSArrayLiteral(const std::vector<uint32_t>& words) {
+    std::string out = "[";
+    for (size_t i = 0; i < words.size(); i++) {
+        if (i > 0) {
+            out += ", ";
+        }
+        out += std::to_string(words[i]);
+    }
+    out += "]";
+    return out;
+}
+
+// Writes the given descriptor words at the start of the transport buffer from JS, like the JS renderer does
+static int64_t writeTransportBuffer(JSEntry& jsEntry,
+                                    JavaScriptRuntimeDeserializers& deserializers,
+                                    const std::vector<uint32_t>& words) {
+    auto& context = jsEntry.context;
+    auto& exceptionTracker = jsEntry.exceptionTracker;
+
+    auto transportBuffer = deserializers.getTransportBuffer(exceptionTracker);
+    jsEntry.checkException();
+
+    auto writeFunction =
+        context.evaluate("(function(buffer) { const words = " + toJSArrayLiteral(words) +
+                             "; new Uint32Array(buffer).set(words); return words.length; })",
+                         "writeTransportBuffer.js",
+                         exceptionTracker);
+    jsEntry.checkException();
+
+    JSFunctionCallContext callContext(context, &transportBuffer, 1, exceptionTracker);
+    auto descriptorSize = context.callObjectAsFunction(writeFunction.get(), callContext);
+    jsEntry.checkException();
+
+    auto result = context.valueToInt(descriptorSize.get(), exceptionTracker);
+    jsEntry.checkException();
+    return static_cast<int64_t>(result);
+}
+
+TEST_P(JSContextFixture, renderRequestTransportBufferMatchesRawRenderRequest) {
+    MAIN_THREAD_INIT();
+    auto wrapper = createWrapper();
+    auto jsEntry = wrapper.makeJsEntry();
+    auto& context = jsEntry.context;
+    auto& exceptionTracker = jsEntry.exceptionTracker;
+
+    AttributeIds attributeIds;
+    StyleAttributesCache styleAttributesCache(attributeIds);
+    JavaScriptStringCache stringCache;
+    JavaScriptRuntimeDeserializers deserializers(context, stringCache, styleAttributesCache);
+
+    auto viewClassId = static_cast<uint32_t>(stringCache.store(STRING_LITERAL("View")));
+    auto enabledId = static_cast<uint32_t>(attributeIds.getIdForName("enabled"));
+    auto widthId = static_cast<uint32_t>(attributeIds.getIdForName("width"));
+    auto accessibilityLabelId = static_cast<uint32_t>(attributeIds.getIdForName("accessibilityLabel"));
+
+    constexpr uint32_t kElement = 1 << 8;
+    std::vector<uint32_t> words = {
+        // createElement
+        1 | kElement,
+        viewClassId,
+        // setRootElement
+        3 | kElement,
+        // setAttribute true
+        8 | kElement,
+        enabledId,
+        // setAttribute int
+        9 | kElement,
+        widthId,
+        42,
+        // setAttribute attached value
+        13 | kElement,
+        accessibilityLabelId,
+        0,
+    };
+
+    auto descriptorSize = writeTransportBuffer(jsEntry, deserializers, words);
+    ASSERT_EQ(static_cast<int64_t>(words.size()), descriptorSize);
+
+    auto values = context.evaluate("(['Attached label'])", "values.js", exceptionTracker);
+    jsEntry.checkException();
+    auto undefinedValue = context.newUndefined();
+
+    auto transportRequest = deserializers.deserializeRenderRequestFromTransportBuffer(
+        1, descriptorSize, values.get(), undefinedValue.get(), undefinedValue.get(), exceptionTracker);
+    jsEntry.checkException();
+    ASSERT_TRUE(transportRequest != nullptr);
+
+    RenderRequestAttributesVisitor visitor;
+    transportRequest->visitEntries(visitor);
+
+    ASSERT_EQ(static_cast<ContextId>(1), transportRequest->getContextId());
+    ASSERT_EQ(std::vector<StringBox>({STRING_LITERAL("View")}), visitor.createdViewClasses);
+    ASSERT_EQ(static_cast<size_t>(3), visitor.attributes.size());
+    ASSERT_EQ(std::make_pair(static_cast<AttributeId>(enabledId), Value(true)), visitor.attributes[0]);
+    ASSERT_EQ(std::make_pair(static_cast<AttributeId>(widthId), Value(42.0)), visitor.attributes[1]);
+    ASSERT_EQ(std::make_pair(static_cast<AttributeId>(accessibilityLabelId), Value(STRING_LITERAL("Attached label"))),
+              visitor.attributes[2]);
+
+    // The same descriptor submitted through submitRawRenderRequest() produces the same request
+    auto rawRequest = context.evaluate("({treeId: 1, descriptor: new Uint32Array(" + toJSArrayLiteral(words) +
+                                           "), descriptorSize: " + std::to_string(words.size()) +
+                                           ", values: ['Attached label'], visibilityObserver: undefined, "
+                                           "frameObserver: undefined})",
+                                       "rawRequest.js",
+                                       exceptionTracker);
+    jsEntry.checkException();
+
+    auto request = deserializers.deserializeRenderRequest(rawRequest.get(), ReferenceInfo(), exceptionTracker);
+    jsEntry.checkException();
+    ASSERT_TRUE(request != nullptr);
+
+    ASSERT_EQ(request->serialize(attributeIds), transportRequest->serialize(attributeIds));
+
+    // The buffer is reused by the next request, which can omit the values when it only holds primitives
+    descriptorSize = writeTransportBuffer(jsEntry, deserializers, {8 | kElement, enabledId});
+    auto nextRequest = deserializers.deserializeRenderRequestFromTransportBuffer(
+        1, descriptorSize, undefinedValue.get(), undefinedValue.get(), undefinedValue.get(), exceptionTracker);
+    jsEntry.checkException();
+    ASSERT_TRUE(nextRequest != nullptr);
+
+    RenderRequestAttributesVisitor nextVisitor;
+    nextRequest->visitEntries(nextVisitor);
+
+    ASSERT_TRUE(nextVisitor.createdViewClasses.empty());
+    ASSERT_EQ(static_cast<size_t>(1), nextVisitor.attributes.size());
+    ASSERT_EQ(std::make_pair(static_cast<AttributeId>(enabledId), Value(true)), nextVisitor.attributes[0]);
+}
+
+TEST_P(JSContextFixture, renderRequestTransportBufferResolvesInternedStrings) {
+    MAIN_THREAD_INIT();
+    auto wrapper = createWrapper();
+    auto jsEntry = wrapper.makeJsEntry();
+    auto& context = jsEntry.context;
+    auto& exceptionTracker = jsEntry.exceptionTracker;
+
+    AttributeIds attributeIds;
+    StyleAttributesCache styleAttributesCache(attributeIds);
+    JavaScriptStringCache stringCache;
+    JavaScriptRuntimeDeserializers deserializers(context, stringCache, styleAttributesCache);
+
+    auto red = STRING_LITERAL("red");
+    auto redId = static_cast<uint32_t>(stringCache.store(red));
+    auto colorId = static_cast<uint32_t>(attributeIds.getIdForName("color"));
+    // Injected from the parent
+    auto injectedColorHeader = colorId | (1u << 24);
+
+    constexpr uint32_t kElement = 2 << 8;
+    std::vector<uint32_t> words = {18 | kElement, injectedColorHeader, redId};
+
+    auto descriptorSize = writeTransportBuffer(jsEntry, deserializers, words);
+    auto undefinedValue = context.newUndefined();
+
+    auto request = deserializers.deserializeRenderRequestFromTransportBuffer(
+        1, descriptorSize, undefinedValue.get(), undefinedValue.get(), undefinedValue.get(), exceptionTracker);
+    jsEntry.checkException();
+    ASSERT_TRUE(request != nullptr);
+
+    RenderRequestAttributesVisitor visitor;
+    request->visitEntries(visitor);
+
+    ASSERT_EQ(static_cast<size_t>(1), visitor.attributeEntries.size());
+    const auto& entry = *visitor.attributeEntries[0];
+    ASSERT_EQ(static_cast<RawViewNodeId>(2), entry.getElementId());
+    ASSERT_EQ(static_cast<AttributeId>(colorId), entry.getAttributeId());
+    ASSERT_TRUE(entry.isInjectedFromParent());
+    ASSERT_EQ(Value(red), entry.getAttributeValue());
+    // The string is resolved from the cache, not copied
+    ASSERT_EQ(red.getInternedString().get(), entry.getAttributeValue().toStringBox().getInternedString().get());
+
+    // An unknown string id is rejected
+    descriptorSize = writeTransportBuffer(jsEntry, deserializers, {18 | kElement, colorId, redId + 1});
+    auto invalidRequest = deserializers.deserializeRenderRequestFromTransportBuffer(
+        1, descriptorSize, undefinedValue.get(), undefinedValue.get(), undefinedValue.get(), exceptionTracker);
+    ASSERT_TRUE(invalidRequest == nullptr);
+    ASSERT_FALSE(exceptionTracker);
+    exceptionTracker.clearError();
+}
+
 INSTANTIATE_TEST_SUITE_P(JSIntegrationTests,
                          JSContextFixture,
                          ::testing::Values(JavaScriptEngineTestCase::QuickJS,
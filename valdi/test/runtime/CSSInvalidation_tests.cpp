@@ -0,0 +1,268 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "ViewNodeTestsUtils.hpp"
+#include "valdi/runtime/CSS/CSSDocument.hpp"
+#include "valdi/valdi.pb.h"
+#include "gtest/gtest.h"
+
+using namespace Valdi;
+
+namespace ValdiTest {
+
+static Valdi::StyleNode* addNamedRule(google::protobuf::RepeatedPtrField<Valdi::NamedStyleNode>* rules,
+                                      const std::string& name) {
+    auto* rule = rules->Add();
+    rule->set_name(name);
+    return rule->mutable_node();
+}
+
+static void addOpacityStyle(Valdi::StyleNode& styleNode, double value) {
+    static int32_t styleId = 0;
+
+    auto* style = styleNode.add_styles();
+    auto* attribute = style->mutable_attribute();
+    attribute->set_type(Valdi::NodeAttribute_Type_NODE_ATTRIBUTE_TYPE_DOUBLE);
+    attribute->set_name("opacity");
+    attribute->set_double_value(value);
+    style->set_priority(10);
+    style->set_id(++styleId);
+    style->set_order(styleId);
+}
+
+class CSSTestsDependencies : public ViewNodeTestsDependencies {
+public:
+    Ref<CSSDocument> createDocument(const Valdi::StyleNode& styleNode) {
+        return makeShared<CSSDocument>(
+            ResourceId(STRING_LITERAL("test"), STRING_LITERAL("style.css")), styleNode, getAttributeIds());
+    }
+
+    Ref<ViewNode> createStyledView(const Ref<CSSDocument>& cssDocument, const char* cssClass) {
+        auto viewNode = createView();
+        setViewNodeAttribute(viewNode, "cssDocument", Value(cssDocument));
+        setViewNodeAttribute(viewNode, "class", Value(StringCache::getGlobal().makeStringFromLiteral(cssClass)));
+        return viewNode;
+    }
+
+    void setClass(const Ref<ViewNode>& viewNode, const char* cssClass) {
+        setViewNodeAttribute(viewNode, "class", Value(StringCache::getGlobal().makeStringFromLiteral(cssClass)));
+    }
+
+    void updateCSS(const Ref<ViewNode>& root) {
+        root->updateCSS(getViewTransactionScope(), nullptr);
+    }
+
+    Value getOpacity(const Ref<ViewNode>& viewNode) {
+        return viewNode->getAttributesApplier().getResolvedAttributeValue(
+            getAttributeIds().getIdForName(STRING_LITERAL("opacity")));
+    }
+};
+
+/**
+ .title { opacity: 1 }
+ <ancestorClass> .title { opacity: 0.5 }
+ */
+static Valdi::StyleNode makeDescendantStyleNode(const char* ancestorClass) {
+    Valdi::StyleNode styleNode;
+    auto* title = addNamedRule(styleNode.mutable_ruleindex()->mutable_class_rules(), "title");
+    addOpacityStyle(*title, 1);
+    addOpacityStyle(*addNamedRule(title->mutable_ruleindex()->mutable_ancestor_rules()->mutable_class_rules(),
+                                  ancestorClass),
+                    0.5);
+    return styleNode;
+}
+
+TEST(CSSInvalidation, restylesDescendantsWhenAncestorClassIsAddedOrRemoved) {
+    CSSTestsDependencies utils;
+    auto cssDocument = utils.createDocument(makeDescendantStyleNode("dark"));
+
+    auto root = utils.createRootView();
+    auto screen = utils.createStyledView(cssDocument, "screen");
+    auto container = utils.createStyledView(cssDocument, "container");
+    auto title = utils.createStyledView(cssDocument, "title");
+    root->appendChild(utils.getViewTransactionScope(), screen);
+    screen->appendChild(utils.getViewTransactionScope(), container);
+    container->appendChild(utils.getViewTransactionScope(), title);
+
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(1.0), utils.getOpacity(title));
+
+    utils.setClass(screen, "screen dark");
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(0.5), utils.getOpacity(title));
+
+    utils.setClass(screen, "screen");
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(1.0), utils.getOpacity(title));
+}
+
+TEST(CSSInvalidation, restylesDescendantsWhenAncestorKeyIsRemoved) {
+    CSSTestsDependencies utils;
+
+    // .title { opacity: 1 }
+    // #header .title, .dark .title { opacity: 0.5 }
+    auto styleNode = makeDescendantStyleNode("dark");
+    auto* titleRule = styleNode.mutable_ruleindex()->mutable_class_rules(0)->mutable_node();
+    addOpacityStyle(
+        *addNamedRule(titleRule->mutable_ruleindex()->mutable_ancestor_rules()->mutable_id_rules(), "header"), 0.5);
+    auto cssDocument = utils.createDocument(styleNode);
+
+    auto root = utils.createRootView();
+    auto header = utils.createStyledView(cssDocument, "");
+    auto title = utils.createStyledView(cssDocument, "title");
+    utils.setViewNodeAttribute(header, "id", Value(STRING_LITERAL("header")));
+    root->appendChild(utils.getViewTransactionScope(), header);
+    header->appendChild(utils.getViewTransactionScope(), title);
+
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(0.5), utils.getOpacity(title));
+
+    utils.setViewNodeAttribute(header, "id", Value(StringBox()));
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(1.0), utils.getOpacity(title));
+
+    utils.setClass(header, "dark");
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(0.5), utils.getOpacity(title));
+
+    utils.setClass(header, "");
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(1.0), utils.getOpacity(title));
+}
+
+TEST(CSSInvalidation, restylesDescendantsWhenSiblingsOfAncestorAreReordered) {
+    CSSTestsDependencies utils;
+
+    // .label { opacity: 1 }
+    // .item:nth-child(2n+1) .label { opacity: 0.5 }
+    Valdi::StyleNode styleNode;
+    auto* labelRule = addNamedRule(styleNode.mutable_ruleindex()->mutable_class_rules(), "label");
+    addOpacityStyle(*labelRule, 1);
+    auto* labelAncestorRules = labelRule->mutable_ruleindex()->mutable_ancestor_rules();
+    auto* itemRule = addNamedRule(labelAncestorRules->mutable_class_rules(), "item");
+    auto* oddItemRule = itemRule->mutable_ruleindex()->add_nth_child_rules();
+    oddItemRule->set_n(2);
+    oddItemRule->set_offset(1);
+    addOpacityStyle(*oddItemRule->mutable_node(), 0.5);
+    auto cssDocument = utils.createDocument(styleNode);
+
+    auto root = utils.createRootView();
+    auto list = utils.createStyledView(cssDocument, "list");
+    root->appendChild(utils.getViewTransactionScope(), list);
+
+    std::vector<Ref<ViewNode>> items;
+    std::vector<Ref<ViewNode>> labels;
+    for (size_t i = 0; i < 3; i++) {
+        auto item = utils.createStyledView(cssDocument, "item");
+        auto label = utils.createStyledView(cssDocument, "label");
+        list->appendChild(utils.getViewTransactionScope(), item);
+        item->appendChild(utils.getViewTransactionScope(), label);
+        items.emplace_back(item);
+        labels.emplace_back(label);
+    }
+
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(0.5), utils.getOpacity(labels[0]));
+    ASSERT_EQ(Value(1.0), utils.getOpacity(labels[1]));
+    ASSERT_EQ(Value(0.5), utils.getOpacity(labels[2]));
+
+    // Moving the second item first shifts the index of the first item
+    list->insertChildAt(utils.getViewTransactionScope(), items[1], 0);
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(1.0), utils.getOpacity(labels[0]));
+    ASSERT_EQ(Value(0.5), utils.getOpacity(labels[1]));
+    ASSERT_EQ(Value(0.5), utils.getOpacity(labels[2]));
+
+    // Removing the first item shifts the index of the remaining ones
+    items[1]->removeFromParent(utils.getViewTransactionScope());
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(0.5), utils.getOpacity(labels[0]));
+    ASSERT_EQ(Value(1.0), utils.getOpacity(labels[2]));
+}
+
+TEST(CSSInvalidation, restylesWhenMonitoredAttributeMatchedThroughAncestorRulesChanges) {
+    CSSTestsDependencies utils;
+
+    // .label { opacity: 1 }
+    // [state="on"] .label { opacity: 0.5 }
+    Valdi::StyleNode styleNode;
+    auto* labelRule = addNamedRule(styleNode.mutable_ruleindex()->mutable_class_rules(), "label");
+    addOpacityStyle(*labelRule, 1);
+    auto* stateRule = labelRule->mutable_ruleindex()->mutable_ancestor_rules()->add_attribute_rules();
+    stateRule->set_type(Valdi::CSSRuleIndex_AttributeRule_Type_EQUALS);
+    stateRule->mutable_attribute()->set_type(Valdi::NodeAttribute_Type_NODE_ATTRIBUTE_TYPE_STRING);
+    stateRule->mutable_attribute()->set_name("state");
+    stateRule->mutable_attribute()->set_str_value("on");
+    addOpacityStyle(*stateRule->mutable_node(), 0.5);
+    auto cssDocument = utils.createDocument(styleNode);
+
+    auto root = utils.createRootView();
+    auto item = utils.createStyledView(cssDocument, "item");
+    auto label = utils.createStyledView(cssDocument, "label");
+    root->appendChild(utils.getViewTransactionScope(), item);
+    item->appendChild(utils.getViewTransactionScope(), label);
+
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(1.0), utils.getOpacity(label));
+
+    // Attribute rules, including the ones nested in ancestor rules, are matched
+    // against the attributes of the styled node
+    utils.setViewNodeAttribute(label, "state", Value(STRING_LITERAL("on")));
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(0.5), utils.getOpacity(label));
+
+    utils.setViewNodeAttribute(label, "state", Value(STRING_LITERAL("off")));
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(1.0), utils.getOpacity(label));
+}
+
+TEST(CSSInvalidation, restylesSubtreeWhenReparented) {
+    CSSTestsDependencies utils;
+    auto cssDocument = utils.createDocument(makeDescendantStyleNode("dark"));
+
+    auto root = utils.createRootView();
+    auto darkContainer = utils.createStyledView(cssDocument, "dark");
+    auto lightContainer = utils.createStyledView(cssDocument, "light");
+    auto cell = utils.createStyledView(cssDocument, "cell");
+    auto title = utils.createStyledView(cssDocument, "title");
+    root->appendChild(utils.getViewTransactionScope(), darkContainer);
+    root->appendChild(utils.getViewTransactionScope(), lightContainer);
+    darkContainer->appendChild(utils.getViewTransactionScope(), cell);
+    cell->appendChild(utils.getViewTransactionScope(), title);
+
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(0.5), utils.getOpacity(title));
+
+    lightContainer->appendChild(utils.getViewTransactionScope(), cell);
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(1.0), utils.getOpacity(title));
+
+    darkContainer->appendChild(utils.getViewTransactionScope(), cell);
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(0.5), utils.getOpacity(title));
+}
+
+TEST(CSSInvalidation, restylesDescendantsWhenDocumentChanges) {
+    CSSTestsDependencies utils;
+    auto cssDocument = utils.createDocument(makeDescendantStyleNode("dark"));
+    auto otherDocument = utils.createDocument(makeDescendantStyleNode("dark"));
+
+    auto root = utils.createRootView();
+    auto container = utils.createStyledView(cssDocument, "dark");
+    auto title = utils.createStyledView(cssDocument, "title");
+    root->appendChild(utils.getViewTransactionScope(), container);
+    container->appendChild(utils.getViewTransactionScope(), title);
+
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(0.5), utils.getOpacity(title));
+
+    // The container is no longer an ancestor of the title within the title's document
+    utils.setViewNodeAttribute(container, "cssDocument", Value(otherDocument));
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(1.0), utils.getOpacity(title));
+
+    utils.setViewNodeAttribute(container, "cssDocument", Value(cssDocument));
+    utils.updateCSS(root);
+    ASSERT_EQ(Value(0.5), utils.getOpacity(title));
+}
+
+} // namespace ValdiTest
@@ -6,9 +6,13 @@
 //
 
 #include "valdi/runtime/JavaScript/JavaScriptHeapDumpBuilder.hpp"
+#include "valdi_core/cpp/Utils/DiskUtils.hpp"
+#include "valdi_core/cpp/Utils/Format.hpp"
 #include "valdi_core/cpp/Utils/StringCache.hpp"
 #include "valdi_core/cpp/Utils/ValueUtils.hpp"
+#include <fcntl.h>
 #include <gtest/gtest.h>
+#include <unistd.h>
 
 #define ASSERT_NO_EXCEPTION(__exceptionTracker__)                                                                      \
     if (!__exceptionTracker__) {                                                                                       \
@@ -196,4 +200,183 @@ TEST(JavaScriptHeapDumpBuilder, canMergeHeapDumps) {
     ASSERT_EQ(expectedJSONValue.value(), result.value());
 }
 
+static void populateHeapDump(JavaScriptHeapDumpBuilder& builder, size_t nodesCount) {
+    auto nextName = JavaScriptHeapEdgeIdentifier::named(STRING_LITERAL("next"));
+    for (uint64_t i = 1; i <= nodesCount; i++) {
+        builder.beginNode(JavaScriptHeapDumpNodeType::OBJECT, STRING_FORMAT("Object{}", i % 3), i, 16);
+        if (i < nodesCount) {
+            builder.appendEdge(JavaScriptHeapDumpEdgeType::PROPERTY, nextName, i + 1);
+        }
+        builder.appendEdgeToValue(JavaScriptHeapDumpEdgeType::ELEMENT,
+                                  JavaScriptHeapEdgeIdentifier::indexed(0),
+                                  JavaScriptHeapDumpNodeType::STRING,
+                                  static_cast<uint64_t>(0),
+                                  "value",
+                                  8);
+    }
+}
+
+TEST(JavaScriptHeapDumpBuilder, spilledHeapDumpMatchesInMemoryHeapDump) {
+    JavaScriptHeapDumpBuilder inMemoryBuilder;
+    populateHeapDump(inMemoryBuilder, 50);
+
+    JavaScriptHeapDumpBuilder spillingBuilder(4, Path());
+    populateHeapDump(spillingBuilder, 50);
+
+    auto expectedHeapDump = inMemoryBuilder.build();
+    auto heapDump = spillingBuilder.build();
+
+    ASSERT_EQ(expectedHeapDump.asStringView(), heapDump.asStringView());
+}
+
+TEST(JavaScriptHeapDumpBuilder, spillsIntoSpillDirectory) {
+    JavaScriptHeapDumpBuilder inMemoryBuilder;
+    populateHeapDump(inMemoryBuilder, 50);
+
+    auto spillDirectory = DiskUtils::temporaryFilePath();
+    ASSERT_TRUE(DiskUtils::makeDirectory(spillDirectory, true));
+
+    JavaScriptHeapDumpBuilder spillingBuilder(4, spillDirectory);
+    populateHeapDump(spillingBuilder, 50);
+
+    auto expectedHeapDump = inMemoryBuilder.build();
+    auto heapDump = spillingBuilder.build();
+
+    ASSERT_EQ(expectedHeapDump.asStringView(), heapDump.asStringView());
+    // Spill files are unlinked as soon as they are created
+    ASSERT_TRUE(DiskUtils::listDirectory(spillDirectory).empty());
+
+    DiskUtils::remove(spillDirectory);
+}
+
+TEST(JavaScriptHeapDumpBuilder, keepsEntriesInMemoryWhenSpillDirectoryIsNotWritable) {
+    JavaScriptHeapDumpBuilder inMemoryBuilder;
+    populateHeapDump(inMemoryBuilder, 50);
+
+    JavaScriptHeapDumpBuilder spillingBuilder(4, DiskUtils::temporaryFilePath().appending("missing"));
+    populateHeapDump(spillingBuilder, 50);
+
+    auto expectedHeapDump = inMemoryBuilder.build();
+    auto heapDump = spillingBuilder.build();
+
+    ASSERT_EQ(expectedHeapDump.asStringView(), heapDump.asStringView());
+}
+
+TEST(JavaScriptHeapDumpParser, canParseHeapDumpWrittenToFile) {
+    JavaScriptHeapDumpBuilder builder(4, Path());
+    populateHeapDump(builder, 50);
+
+    auto path = DiskUtils::temporaryFilePath();
+    auto fd = ::open(path.toString().c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    ASSERT_TRUE(fd >= 0);
+
+    JavaScriptHeapDumpFileOutput output(fd);
+    auto result = builder.build(output);
+    ::close(fd);
+    ASSERT_TRUE(result) << result.description();
+
+    SimpleExceptionTracker exceptionTracker;
+    JavaScriptHeapDumpParser parser(path, exceptionTracker);
+    DiskUtils::remove(path);
+    ASSERT_NO_EXCEPTION(exceptionTracker);
+
+    auto nodes = parser.getNodes();
+    ASSERT_EQ(static_cast<size_t>(100), nodes.size());
+
+    ASSERT_EQ(STRING_LITERAL("Object1"), nodes[0].getName());
+    auto edges = nodes[0].getEdges();
+    ASSERT_EQ(static_cast<size_t>(2), edges.size());
+    ASSERT_EQ(JavaScriptHeapEdgeIdentifier::named(STRING_LITERAL("next")), edges[0].getIdentifier());
+    ASSERT_EQ(STRING_LITERAL("Object2"), edges[0].getNode().getName());
+    ASSERT_EQ(STRING_LITERAL("value"), edges[1].getNode().getName());
+}
+
+class RecordingHeapDumpVisitor : public JavaScriptHeapDumpVisitor {
+public:
+    struct VisitedNode {
+        JavaScriptHeapDumpNodeType type;
+        StringBox name;
+        uint64_t id;
+        size_t selfSizeBytes;
+        std::vector<std::pair<JavaScriptHeapEdgeIdentifier, size_t>> edges;
+    };
+
+    std::vector<VisitedNode> nodes;
+
+    void visitNode(size_t nodeIndex,
+                   JavaScriptHeapDumpNodeType type,
+                   const StringBox& name,
+                   uint64_t id,
+                   size_t selfSizeBytes) override {
+        ASSERT_EQ(nodes.size(), nodeIndex);
+        nodes.emplace_back(VisitedNode{type, name, id, selfSizeBytes, {}});
+    }
+
+    void visitEdge(JavaScriptHeapDumpEdgeType /*type*/,
+                   const JavaScriptHeapEdgeIdentifier& identifier,
+                   size_t nodeIndex) override {
+        ASSERT_FALSE(nodes.empty());
+        nodes.back().edges.emplace_back(identifier, nodeIndex);
+    }
+};
+
+static Path writeHeapDumpToFile(std::string_view json) {
+    auto path = DiskUtils::temporaryFilePath();
+    DiskUtils::store(path, json);
+    return path;
+}
+
+TEST(JavaScriptHeapDumpParser, canVisitHeapDumpWrittenToFile) {
+    JavaScriptHeapDumpBuilder builder(4, Path());
+    populateHeapDump(builder, 50);
+    auto heapDump = builder.build();
+    auto path = writeHeapDumpToFile(heapDump.asStringView());
+
+    SimpleExceptionTracker exceptionTracker;
+    JavaScriptHeapDumpParser parser(path, exceptionTracker);
+    ASSERT_NO_EXCEPTION(exceptionTracker);
+
+    RecordingHeapDumpVisitor visitor;
+    JavaScriptHeapDumpParser::visit(path, visitor, exceptionTracker);
+    DiskUtils::remove(path);
+    ASSERT_NO_EXCEPTION(exceptionTracker);
+
+    auto nodes = parser.getNodes();
+    ASSERT_EQ(nodes.size(), visitor.nodes.size());
+
+    for (size_t i = 0; i < nodes.size(); i++) {
+        const auto& visitedNode = visitor.nodes[i];
+        ASSERT_EQ(nodes[i].getType(), visitedNode.type);
+        ASSERT_EQ(nodes[i].getName(), visitedNode.name);
+        ASSERT_EQ(nodes[i].getId(), visitedNode.id);
+        ASSERT_EQ(nodes[i].getSelfSizeBytes(), visitedNode.selfSizeBytes);
+
+        auto edges = nodes[i].getEdges();
+        ASSERT_EQ(edges.size(), visitedNode.edges.size());
+        for (size_t j = 0; j < edges.size(); j++) {
+            ASSERT_EQ(edges[j].getIdentifier(), visitedNode.edges[j].first);
+            ASSERT_EQ(&edges[j].getNode(), &nodes[visitedNode.edges[j].second]);
+        }
+    }
+}
+
+TEST(JavaScriptHeapDumpParser, visitFailsWhenNodesDoNotMatchSnapshot) {
+    std::string_view json =
+        R"({"snapshot":{"meta":{"node_fields":["type","name","id","self_size","edge_count","trace_node_id","detachedness"],"node_types":[["hidden","array","string","object","code","closure","regexp","number","native","synthetic","symbol","bigint","object shape"],"string","number","number","number","number","number"],"edge_fields":["type","name_or_index","to_node"],"edge_types":[["context","element","property","internal","hidden","shortcut","weak"],"string_or_number","node"]},"node_count":2,"edge_count":0,"trace_function_count":0},
+"nodes":[3,0,1,40,0,0,0],
+"edges":[],
+"strings":["Object"]}
+)";
+    auto path = writeHeapDumpToFile(json);
+
+    RecordingHeapDumpVisitor visitor;
+    SimpleExceptionTracker exceptionTracker;
+    JavaScriptHeapDumpParser::visit(path, visitor, exceptionTracker);
+    DiskUtils::remove(path);
+
+    ASSERT_FALSE(exceptionTracker);
+    exceptionTracker.clearError();
+    ASSERT_TRUE(visitor.nodes.empty());
+}
+
 } // namespace ValdiTest
@@ -0,0 +1,87 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi/runtime/JavaScript/JavaScriptStartupSnapshot.hpp"
+#include "valdi_core/cpp/Utils/StringCache.hpp"
+#include <gtest/gtest.h>
+
+using namespace Valdi;
+
+namespace ValdiTest {
+
+static BytesView makeBytesView(std::string_view str) {
+    auto bytes = makeShared<Bytes>();
+    bytes->assignData(reinterpret_cast<const Byte*>(str.data()), str.size());
+    return BytesView(bytes);
+}
+
+TEST(JavaScriptStartupSnapshot, canRoundTrip) {
+    auto engineKey = STRING_LITERAL("QuickJS-1.0");
+    JavaScriptStartupSnapshot recorder(engineKey);
+
+    recorder.addPreCompiledModule(
+        STRING_LITERAL("module/src/A"), makeBytesView("const a = 1;"), makeBytesView("bytecodeA"));
+    recorder.addPreCompiledModule(
+        STRING_LITERAL("module/src/B"), makeBytesView("const b = 2;"), makeBytesView("bytecodeB!"));
+
+    auto result = JavaScriptStartupSnapshot::deserialize(recorder.serialize(), engineKey);
+    ASSERT_TRUE(result) << result.description();
+
+    const auto& snapshot = result.value();
+    ASSERT_EQ(static_cast<size_t>(2), snapshot->size());
+
+    auto moduleA = snapshot->getPreCompiledModule(STRING_LITERAL("module/src/A"), makeBytesView("const a = 1;"));
+    ASSERT_TRUE(moduleA.has_value());
+    ASSERT_EQ("bytecodeA", moduleA.value().asStringView());
+
+    auto moduleB = snapshot->getPreCompiledModule(STRING_LITERAL("module/src/B"), makeBytesView("const b = 2;"));
+    ASSERT_TRUE(moduleB.has_value());
+    ASSERT_EQ("bytecodeB!", moduleB.value().asStringView());
+
+    ASSERT_FALSE(
+        snapshot->getPreCompiledModule(STRING_LITERAL("module/src/C"), makeBytesView("const a = 1;")).has_value());
+}
+
+TEST(JavaScriptStartupSnapshot, ignoresModuleWhenSourceChanged) {
+    JavaScriptStartupSnapshot snapshot(STRING_LITERAL("QuickJS-1.0"));
+
+    snapshot.addPreCompiledModule(
+        STRING_LITERAL("module/src/A"), makeBytesView("const a = 1;"), makeBytesView("bytecodeA"));
+
+    ASSERT_FALSE(
+        snapshot.getPreCompiledModule(STRING_LITERAL("module/src/A"), makeBytesView("const a = 2;")).has_value());
+}
+
+TEST(JavaScriptStartupSnapshot, ignoresRestoredModuleWhenSourceChanged) {
+    auto engineKey = STRING_LITERAL("QuickJS-1.0");
+    JavaScriptStartupSnapshot recorder(engineKey);
+
+    recorder.addPreCompiledModule(
+        STRING_LITERAL("module/src/A"), makeBytesView("const a = 1;"), makeBytesView("bytecodeA"));
+
+    auto result = JavaScriptStartupSnapshot::deserialize(recorder.serialize(), engineKey);
+    ASSERT_TRUE(result) << result.description();
+
+    const auto& snapshot = result.value();
+    ASSERT_TRUE(
+        snapshot->getPreCompiledModule(STRING_LITERAL("module/src/A"), makeBytesView("const a = 1;")).has_value());
+    ASSERT_FALSE(
+        snapshot->getPreCompiledModule(STRING_LITERAL("module/src/A"), makeBytesView("const b = 1;")).has_value());
+}
+
+TEST(JavaScriptStartupSnapshot, failsToDeserializeWithDifferentEngine) {
+    JavaScriptStartupSnapshot recorder(STRING_LITERAL("QuickJS-1.0"));
+
+    recorder.addPreCompiledModule(
+        STRING_LITERAL("module/src/A"), makeBytesView("const a = 1;"), makeBytesView("bytecodeA"));
+
+    auto result = JavaScriptStartupSnapshot::deserialize(recorder.serialize(), STRING_LITERAL("QuickJS-1.1"));
+    ASSERT_FALSE(result);
+}
+
+TEST(JavaScriptStartupSnapshot, failsToDeserializeInvalidData) {
+    auto result =
+        JavaScriptStartupSnapshot::deserialize(makeBytesView("not a snapshot"), STRING_LITERAL("QuickJS-1.0"));
+    ASSERT_FALSE(result);
+}
+
+} // namespace ValdiTest
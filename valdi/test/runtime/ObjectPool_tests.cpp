@@ -8,6 +8,7 @@
 #include "valdi_core/cpp/Utils/ObjectPool.hpp"
 #include "valdi_core/cpp/Utils/Value.hpp"
 #include <gtest/gtest.h>
+#include <thread>
 
 using namespace Valdi;
 
@@ -129,4 +130,66 @@ TEST(ObjectPool, canMoveObjects) {
     ASSERT_EQ(Value(), object2->get()->value);
 }
 
+struct MagazineObject {
+    int value = 0;
+};
+
+void cleanUpMagazineObject(MagazineObject& object) {
+    object.value = 0;
+}
+
+using ReusableMagazineObject = ObjectPoolEntry<MagazineObject, void (*)(MagazineObject&)>;
+
+TEST(ObjectPool, reusesObjectsFromThreadMagazine) {
+    auto& pool = ObjectPool<MagazineObject>::get();
+    auto statisticsBefore = pool.getStatistics();
+
+    int createdObjectsCount = 0;
+    auto factory = [&]() {
+        createdObjectsCount++;
+        return MagazineObject();
+    };
+
+    for (int i = 0; i < 10; i++) {
+        auto object = pool.getOrCreate(factory, &cleanUpMagazineObject);
+        object->value = i;
+    }
+
+    ASSERT_EQ(1, createdObjectsCount);
+
+    // Local hits are reported the next time the magazine goes to the shared pool
+    std::vector<ReusableMagazineObject> objects;
+    objects.emplace_back(pool.getOrCreate(factory, &cleanUpMagazineObject));
+    objects.emplace_back(pool.getOrCreate(factory, &cleanUpMagazineObject));
+
+    auto statistics = pool.getStatistics();
+    ASSERT_EQ(static_cast<uint64_t>(10), statistics.localHits - statisticsBefore.localHits);
+    ASSERT_EQ(static_cast<uint64_t>(2), statistics.misses - statisticsBefore.misses);
+}
+
+TEST(ObjectPool, objectsReleasedOnOtherThreadFlowBack) {
+    auto& pool = ObjectPool<MagazineObject>::get();
+
+    std::vector<ReusableMagazineObject> objects;
+    for (size_t i = 0; i < kObjectPoolMagazineCapacity * 2; i++) {
+        objects.emplace_back(pool.getOrCreate(&cleanUpMagazineObject));
+    }
+
+    // Releasing on another thread fills its magazine, which is given back
+    // to the shared pool when it overflows or when the thread exits.
+    std::thread thread([&]() { objects.clear(); });
+    thread.join();
+
+    auto statisticsBefore = pool.getStatistics();
+
+    for (size_t i = 0; i < kObjectPoolMagazineCapacity * 2; i++) {
+        objects.emplace_back(pool.getOrCreate(&cleanUpMagazineObject));
+    }
+    objects.clear();
+
+    auto statistics = pool.getStatistics();
+    ASSERT_EQ(statisticsBefore.misses, statistics.misses);
+    ASSERT_NE(statisticsBefore.sharedHits, statistics.sharedHits);
+}
+
 } // namespace ValdiTest
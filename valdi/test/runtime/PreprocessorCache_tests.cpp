@@ -0,0 +1,167 @@
+#include "valdi/runtime/Attributes/AttributeHandler.hpp"
+#include "valdi/runtime/Attributes/PreprocessorCache.hpp"
+#include "valdi_core/cpp/Attributes/ColorPalette.hpp"
+#include "valdi_core/cpp/Utils/StringCache.hpp"
+#include <gtest/gtest.h>
+
+using namespace Valdi;
+
+namespace ValdiTest {
+
+static int preprocessCallsCount = 0;
+
+static Result<Value> countingPreprocessor(const Value& value) {
+    preprocessCallsCount++;
+    return Value(value.toStringBox().append(STRING_LITERAL("_processed")));
+}
+
+TEST(PreprocessorCache, releasesValueWhenHandleIsReleased) {
+    PreprocessorCache cache;
+    auto key = PreprocessorCacheKey(Value(STRING_LITERAL("red")));
+
+    auto stored = cache.store(key, Value(42));
+    auto result = cache.get(key);
+
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(Value(42), result->value);
+
+    stored.handle = nullptr;
+    result = std::nullopt;
+
+    ASSERT_FALSE(cache.get(key).has_value());
+}
+
+TEST(PreprocessorCache, keepsRecentlyUsedValuesAlive) {
+    PreprocessorCache cache(PreprocessorCache::kShardsCount * 4);
+    auto key = PreprocessorCacheKey(Value(STRING_LITERAL("red")));
+
+    cache.store(key, Value(42));
+
+    auto result = cache.get(key);
+    ASSERT_TRUE(result.has_value());
+    ASSERT_EQ(Value(42), result->value);
+}
+
+TEST(PreprocessorCache, evictsLeastRecentlyUsedValues) {
+    PreprocessorCache cache(PreprocessorCache::kShardsCount);
+
+    for (int32_t i = 0; i < 1000; i++) {
+        cache.store(PreprocessorCacheKey(Value(i)), Value(i));
+    }
+
+    size_t aliveCount = 0;
+    for (int32_t i = 0; i < 1000; i++) {
+        if (cache.get(PreprocessorCacheKey(Value(i)))) {
+            aliveCount++;
+        }
+    }
+
+    ASSERT_LE(aliveCount, PreprocessorCache::kShardsCount);
+}
+
+TEST(PreprocessorCache, isolatesScopes) {
+    PreprocessorCache cache(PreprocessorCache::kShardsCount * 4);
+    auto value = Value(STRING_LITERAL("red"));
+
+    cache.store(PreprocessorCacheKey(1, value), Value(1));
+    cache.store(PreprocessorCacheKey(2, value), Value(2));
+
+    ASSERT_EQ(Value(1), cache.get(PreprocessorCacheKey(1, value))->value);
+    ASSERT_EQ(Value(2), cache.get(PreprocessorCacheKey(2, value))->value);
+    ASSERT_FALSE(cache.get(PreprocessorCacheKey(3, value)).has_value());
+
+    cache.clearScope(1);
+
+    ASSERT_FALSE(cache.get(PreprocessorCacheKey(1, value)).has_value());
+    ASSERT_EQ(Value(2), cache.get(PreprocessorCacheKey(2, value))->value);
+}
+
+TEST(PreprocessorCache, resolvesIdenticalChainsToTheSameScope) {
+    auto identityA = AttributePreprocessorIdentity::fromFunction(&countingPreprocessor, 1);
+    auto identityB = AttributePreprocessorIdentity::fromFunction(&countingPreprocessor, 2);
+
+    auto scopeA = PreprocessorCache::resolveScope({identityA});
+
+    ASSERT_NE(static_cast<size_t>(0), scopeA);
+    ASSERT_EQ(scopeA, PreprocessorCache::resolveScope({identityA}));
+    ASSERT_NE(scopeA, PreprocessorCache::resolveScope({identityB}));
+    ASSERT_NE(scopeA, PreprocessorCache::resolveScope({identityA, identityB}));
+}
+
+TEST(PreprocessorCache, releasesScopesOfDestroyedContexts) {
+    auto colorPalette = makeShared<ColorPalette>();
+    auto otherColorPalette = makeShared<ColorPalette>();
+
+    ASSERT_NE(colorPalette->getId(), otherColorPalette->getId());
+
+    auto identity = AttributePreprocessorIdentity::fromFunction(&countingPreprocessor, colorPalette->getId());
+    auto otherIdentity = AttributePreprocessorIdentity::fromFunction(&countingPreprocessor, otherColorPalette->getId());
+
+    auto scope = PreprocessorCache::resolveScope({identity});
+    auto otherScope = PreprocessorCache::resolveScope({otherIdentity});
+
+    const auto& cache = PreprocessorCache::getGlobal();
+    auto value = Value(STRING_LITERAL("releasesScopesOfDestroyedContexts"));
+    cache->store(PreprocessorCacheKey(scope, value), Value(1));
+    cache->store(PreprocessorCacheKey(otherScope, value), Value(2));
+
+    PreprocessorCache::releaseScopes(colorPalette->getId());
+
+    ASSERT_FALSE(cache->get(PreprocessorCacheKey(scope, value)).has_value());
+    ASSERT_EQ(Value(2), cache->get(PreprocessorCacheKey(otherScope, value))->value);
+
+    // Released scopes are never handed out again
+    auto newScope = PreprocessorCache::resolveScope({identity});
+    ASSERT_NE(scope, newScope);
+    ASSERT_NE(otherScope, newScope);
+    ASSERT_EQ(otherScope, PreprocessorCache::resolveScope({otherIdentity}));
+
+    PreprocessorCache::releaseScopes(otherColorPalette->getId());
+    ASSERT_FALSE(cache->get(PreprocessorCacheKey(otherScope, value)).has_value());
+}
+
+TEST(PreprocessorCache, sharesValuesBetweenHandlersWithIdentifiedPreprocessors) {
+    AttributeHandler handlerA(1, STRING_LITERAL("color"), nullptr, false, false);
+    handlerA.appendPreprocessor(&countingPreprocessor, false);
+    handlerA.setEnablePreprocessorCache(true);
+
+    AttributeHandler handlerB(2, STRING_LITERAL("color"), nullptr, false, false);
+    handlerB.appendPreprocessor(&countingPreprocessor, false);
+    handlerB.setEnablePreprocessorCache(true);
+
+    ASSERT_TRUE(handlerA.usesGlobalPreprocessorCache());
+    ASSERT_TRUE(handlerB.usesGlobalPreprocessorCache());
+
+    preprocessCallsCount = 0;
+    auto input = Value(STRING_LITERAL("sharesValuesBetweenHandlers"));
+
+    auto resultA = handlerA.preprocess(input);
+    auto resultB = handlerB.preprocess(input);
+
+    ASSERT_TRUE(resultA);
+    ASSERT_TRUE(resultB);
+    ASSERT_EQ(1, preprocessCallsCount);
+    ASSERT_EQ(resultA.value().value, resultB.value().value);
+    ASSERT_EQ(resultA.value().handle, resultB.value().handle);
+}
+
+TEST(PreprocessorCache, doesNotShareValuesOfUnidentifiedPreprocessors) {
+    AttributeHandler handler(1, STRING_LITERAL("color"), nullptr, false, false);
+    handler.appendPreprocessor(
+        AttributePreprocessor([](const Value& value) -> Result<Value> { return countingPreprocessor(value); }),
+        false);
+    handler.setEnablePreprocessorCache(true);
+
+    ASSERT_TRUE(handler.hasPreprocessorCache());
+    ASSERT_FALSE(handler.usesGlobalPreprocessorCache());
+
+    preprocessCallsCount = 0;
+    auto input = Value(STRING_LITERAL("doesNotShareValues"));
+
+    auto result = handler.preprocess(input);
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(handler.preprocess(input));
+    ASSERT_EQ(1, preprocessCallsCount);
+}
+
+} // namespace ValdiTest
@@ -0,0 +1,217 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi/runtime/Rendering/RenderRequestMerger.hpp"
+#include "valdi_core/cpp/Utils/StringCache.hpp"
+#include "valdi_core/cpp/Utils/ValueFunctionWithCallable.hpp"
+#include <gtest/gtest.h>
+
+using namespace Valdi;
+
+namespace ValdiTest {
+
+class DescribeEntryVisitor {
+public:
+    std::vector<std::string> descriptions;
+
+    void visit(RenderRequestEntries::CreateElement& entry) {
+        descriptions.emplace_back("create " + std::to_string(entry.getElementId()));
+    }
+
+    void visit(RenderRequestEntries::DestroyElement& entry) {
+        descriptions.emplace_back("destroy " + std::to_string(entry.getElementId()));
+    }
+
+    void visit(RenderRequestEntries::MoveElementToParent& entry) {
+        descriptions.emplace_back("move " + std::to_string(entry.getElementId()) + " to " +
+                                  std::to_string(entry.getParentElementId()));
+    }
+
+    void visit(RenderRequestEntries::SetRootElement& entry) {
+        descriptions.emplace_back("root " + std::to_string(entry.getElementId()));
+    }
+
+    void visit(RenderRequestEntries::SetElementAttribute& entry) {
+        descriptions.emplace_back("set " + std::to_string(entry.getElementId()) + "." +
+                                  std::to_string(entry.getAttributeId()) + "=" +
+                                  entry.getAttributeValue().toString());
+    }
+
+    void visit(RenderRequestEntries::StartAnimations& /*entry*/) {
+        descriptions.emplace_back("startAnimations");
+    }
+
+    void visit(RenderRequestEntries::EndAnimations& /*entry*/) {
+        descriptions.emplace_back("endAnimations");
+    }
+
+    void visit(RenderRequestEntries::CancelAnimation& /*entry*/) {
+        descriptions.emplace_back("cancelAnimation");
+    }
+
+    void visit(RenderRequestEntries::OnLayoutComplete& /*entry*/) {
+        descriptions.emplace_back("onLayoutComplete");
+    }
+};
+
+static std::vector<std::string> describe(const RenderRequest& renderRequest) {
+    DescribeEntryVisitor visitor;
+    renderRequest.visitEntries(visitor);
+    return visitor.descriptions;
+}
+
+static void appendCreate(RenderRequest& renderRequest, RawViewNodeId elementId) {
+    auto* entry = renderRequest.appendCreateElement();
+    entry->setElementId(elementId);
+    entry->setViewClassName(STRING_LITERAL("View"));
+}
+
+static void appendMove(RenderRequest& renderRequest, RawViewNodeId elementId, RawViewNodeId parentElementId) {
+    auto* entry = renderRequest.appendMoveElementToParent();
+    entry->setElementId(elementId);
+    entry->setParentElementId(parentElementId);
+}
+
+static void appendSet(RenderRequest& renderRequest, RawViewNodeId elementId, AttributeId attributeId, int32_t value) {
+    auto* entry = renderRequest.appendSetElementAttribute();
+    entry->setElementId(elementId);
+    entry->setAttributeId(attributeId);
+    entry->setAttributeValue(Value(value));
+}
+
+TEST(RenderRequestMerger, returnsSingleRequestAsIs) {
+    auto renderRequest = makeShared<RenderRequest>();
+    appendSet(*renderRequest, 1, 2, 3);
+
+    RenderRequestMerger merger;
+    merger.append(renderRequest);
+
+    ASSERT_EQ(renderRequest, merger.merge());
+}
+
+TEST(RenderRequestMerger, keepsLastAttributeWrite) {
+    auto first = makeShared<RenderRequest>();
+    appendSet(*first, 1, 10, 1);
+    appendSet(*first, 1, 11, 1);
+    auto second = makeShared<RenderRequest>();
+    appendSet(*second, 1, 10, 2);
+    appendSet(*second, 2, 10, 2);
+    auto third = makeShared<RenderRequest>();
+    appendSet(*third, 1, 10, 3);
+
+    RenderRequestMerger merger;
+    merger.append(first);
+    merger.append(second);
+    merger.append(third);
+    auto merged = merger.merge();
+
+    ASSERT_EQ(std::vector<std::string>({"set 1.11=1", "set 2.10=2", "set 1.10=3"}), describe(*merged));
+}
+
+TEST(RenderRequestMerger, keepsAttributeWritesInjectedFromParentSeparately) {
+    auto first = makeShared<RenderRequest>();
+    appendSet(*first, 1, 10, 1);
+    auto* injectedEntry = first->appendSetElementAttribute();
+    injectedEntry->setElementId(1);
+    injectedEntry->setAttributeId(10);
+    injectedEntry->setInjectedFromParent(true);
+    injectedEntry->setAttributeValue(Value(2));
+    auto second = makeShared<RenderRequest>();
+    appendSet(*second, 1, 10, 3);
+
+    RenderRequestMerger merger;
+    merger.append(first);
+    merger.append(second);
+    auto merged = merger.merge();
+
+    ASSERT_EQ(std::vector<std::string>({"set 1.10=2", "set 1.10=3"}), describe(*merged));
+}
+
+static Value makeObserverCallback() {
+    return Value(makeShared<ValueFunctionWithCallable>(
+        [](const ValueFunctionCallContext& /*callContext*/) -> Value { return Value(); }));
+}
+
+TEST(RenderRequestMerger, keepsLastObserversOfEachKind) {
+    auto firstVisibilityObserver = makeObserverCallback();
+    auto firstFrameObserver = makeObserverCallback();
+    auto secondVisibilityObserver = makeObserverCallback();
+
+    auto first = makeShared<RenderRequest>();
+    first->setVisibilityObserverCallback(firstVisibilityObserver);
+    first->setFrameObserverCallback(firstFrameObserver);
+    appendSet(*first, 1, 10, 1);
+    auto second = makeShared<RenderRequest>();
+    second->setVisibilityObserverCallback(secondVisibilityObserver);
+    appendSet(*second, 1, 11, 1);
+    auto third = makeShared<RenderRequest>();
+    appendSet(*third, 1, 12, 1);
+
+    RenderRequestMerger merger;
+    merger.append(first);
+    merger.append(second);
+    merger.append(third);
+    auto merged = merger.merge();
+
+    // Rendering the requests one by one would have replaced the first visibility
+    // observer, while the frame observer set by the first request stays registered.
+    ASSERT_EQ(secondVisibilityObserver, merged->getVisibilityObserverCallback());
+    ASSERT_EQ(firstFrameObserver, merged->getFrameObserverCallback());
+}
+
+TEST(RenderRequestMerger, dropsElementsCreatedAndDestroyed) {
+    auto first = makeShared<RenderRequest>();
+    appendCreate(*first, 5);
+    appendMove(*first, 5, 1);
+    appendSet(*first, 5, 10, 1);
+    appendSet(*first, 1, 10, 1);
+    auto second = makeShared<RenderRequest>();
+    second->appendDestroyElement()->setElementId(5);
+    second->appendDestroyElement()->setElementId(2);
+
+    RenderRequestMerger merger;
+    merger.append(first);
+    merger.append(second);
+    auto merged = merger.merge();
+
+    ASSERT_EQ(std::vector<std::string>({"set 1.10=1", "destroy 2"}), describe(*merged));
+}
+
+TEST(RenderRequestMerger, keepsDestroyedParentOfKeptChildren) {
+    auto first = makeShared<RenderRequest>();
+    appendCreate(*first, 5);
+    appendCreate(*first, 6);
+    appendMove(*first, 6, 5);
+    auto second = makeShared<RenderRequest>();
+    second->appendDestroyElement()->setElementId(5);
+
+    RenderRequestMerger merger;
+    merger.append(first);
+    merger.append(second);
+    auto merged = merger.merge();
+
+    ASSERT_EQ(std::vector<std::string>({"create 5", "create 6", "move 6 to 5", "destroy 5"}), describe(*merged));
+}
+
+TEST(RenderRequestMerger, doesNotFoldAttributesAcrossAnimations) {
+    auto first = makeShared<RenderRequest>();
+    appendSet(*first, 1, 10, 1);
+    auto second = makeShared<RenderRequest>();
+    second->appendStartAnimations();
+    appendSet(*second, 1, 10, 2);
+    second->appendEndAnimations();
+    auto third = makeShared<RenderRequest>();
+    appendSet(*third, 1, 10, 3);
+    appendSet(*third, 1, 10, 4);
+
+    RenderRequestMerger merger;
+    merger.append(first);
+    merger.append(second);
+    merger.append(third);
+    auto merged = merger.merge();
+
+    ASSERT_EQ(std::vector<std::string>(
+                  {"set 1.10=1", "startAnimations", "set 1.10=2", "endAnimations", "set 1.10=4"}),
+              describe(*merged));
+}
+
+} // namespace ValdiTest
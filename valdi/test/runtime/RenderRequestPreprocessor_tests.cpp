@@ -0,0 +1,87 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi/runtime/Attributes/AttributesManager.hpp"
+#include "valdi/runtime/Attributes/Yoga/Yoga.hpp"
+#include "valdi/runtime/Rendering/RenderRequestPreprocessor.hpp"
+#include "valdi/runtime/Views/GlobalViewFactories.hpp"
+#include "valdi/standalone_runtime/StandaloneViewManager.hpp"
+#include "valdi_core/cpp/Utils/ConsoleLogger.hpp"
+#include "valdi_core/cpp/Utils/StringCache.hpp"
+#include <gtest/gtest.h>
+
+using namespace Valdi;
+
+namespace ValdiTest {
+
+class RenderRequestPreprocessorTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        _viewManager.setRegisterCustomAttributes(true);
+        _attributesManager = std::make_unique<AttributesManager>(
+            _viewManager, _attributeIds, makeShared<ColorPalette>(), ConsoleLogger::getLogger(), Yoga::createConfig(0));
+        _viewFactories = makeShared<GlobalViewFactories>(*_attributesManager);
+        _preprocessor = makeShared<RenderRequestPreprocessor>(_viewFactories);
+    }
+
+    void appendCreateElement(RenderRequest& renderRequest, RawViewNodeId elementId, const char* viewClassName) {
+        auto* entry = renderRequest.appendCreateElement();
+        entry->setElementId(elementId);
+        entry->setViewClassName(STRING_LITERAL(viewClassName));
+    }
+
+    void appendSetAttribute(RenderRequest& renderRequest,
+                            RawViewNodeId elementId,
+                            const char* attributeName,
+                            const Value& value) {
+        auto* entry = renderRequest.appendSetElementAttribute();
+        entry->setElementId(elementId);
+        entry->setAttributeId(_attributeIds.getIdForName(STRING_LITERAL(attributeName)));
+        entry->setAttributeValue(value);
+    }
+
+    StandaloneViewManager _viewManager;
+    AttributeIds _attributeIds;
+    std::unique_ptr<AttributesManager> _attributesManager;
+    Ref<GlobalViewFactories> _viewFactories;
+    Ref<RenderRequestPreprocessor> _preprocessor;
+};
+
+TEST_F(RenderRequestPreprocessorTests, preprocessesCachedAttributesOfCreatedElements) {
+    _viewFactories->getViewFactory(STRING_LITERAL("SCValdiLabel"));
+
+    auto renderRequest = makeShared<RenderRequest>();
+    appendCreateElement(*renderRequest, 1, "SCValdiLabel");
+    appendSetAttribute(*renderRequest, 1, "value", Value(STRING_LITERAL("Hello")));
+    // Not preprocessed: the attribute has no cached preprocessor
+    appendSetAttribute(*renderRequest, 1, "numberOfLines", Value(2.0));
+    // Not preprocessed: undefined values are never preprocessed
+    appendSetAttribute(*renderRequest, 1, "value", Value::undefined());
+
+    ASSERT_EQ(static_cast<size_t>(1), _preprocessor->preprocess(*renderRequest));
+}
+
+TEST_F(RenderRequestPreprocessorTests, tracksElementsAcrossRequests) {
+    _viewFactories->getViewFactory(STRING_LITERAL("SCValdiLabel"));
+
+    auto firstRequest = makeShared<RenderRequest>();
+    appendCreateElement(*firstRequest, 1, "SCValdiLabel");
+    ASSERT_EQ(static_cast<size_t>(0), _preprocessor->preprocess(*firstRequest));
+
+    auto secondRequest = makeShared<RenderRequest>();
+    appendSetAttribute(*secondRequest, 1, "value", Value(STRING_LITERAL("Hello")));
+    secondRequest->appendDestroyElement()->setElementId(1);
+    appendSetAttribute(*secondRequest, 1, "value", Value(STRING_LITERAL("World")));
+    ASSERT_EQ(static_cast<size_t>(1), _preprocessor->preprocess(*secondRequest));
+}
+
+TEST_F(RenderRequestPreprocessorTests, skipsElementsWithoutViewFactory) {
+    auto renderRequest = makeShared<RenderRequest>();
+    appendCreateElement(*renderRequest, 1, "SCValdiLabel");
+    appendSetAttribute(*renderRequest, 1, "value", Value(STRING_LITERAL("Hello")));
+
+    // The view factory is never created from the preprocessor
+    ASSERT_EQ(static_cast<size_t>(0), _preprocessor->preprocess(*renderRequest));
+    ASSERT_EQ(nullptr, _viewFactories->findViewFactory(STRING_LITERAL("SCValdiLabel")));
+}
+
+} // namespace ValdiTest
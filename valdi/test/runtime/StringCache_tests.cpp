@@ -60,7 +60,7 @@ TEST(StringCache, canDeallocConcurrently) {
         StringBox str2;
         StringBox str3;
 
-        auto lock = cache.lock();
+        auto lock = cache.lock("StringToTest");
 
         queue1->async([&]() {
             // In Thread1, we release the string
@@ -80,4 +80,44 @@ TEST(StringCache, canDeallocConcurrently) {
     }
 }
 
+TEST(StringCache, canInternStringsConcurrently) {
+    auto& cache = StringCache::getGlobal();
+
+    std::vector<std::string> strings;
+    for (size_t i = 0; i < 64; i++) {
+        strings.emplace_back("ConcurrentString" + std::to_string(i));
+    }
+
+    std::vector<Ref<DispatchQueue>> queues;
+    std::vector<std::vector<StringBox>> results(4);
+    for (size_t i = 0; i < results.size(); i++) {
+        queues.emplace_back(DispatchQueue::create(STRING_FORMAT("Thread{}", i), ThreadQoSClassMax));
+    }
+
+    for (size_t i = 0; i < queues.size(); i++) {
+        queues[i]->async([&, i]() {
+            for (size_t j = 0; j < 100; j++) {
+                // Intern and release the strings repeatedly so that they go through the removal path
+                for (const auto& str : strings) {
+                    cache.makeString(str);
+                }
+            }
+            for (const auto& str : strings) {
+                results[i].emplace_back(cache.makeString(str));
+            }
+        });
+    }
+
+    for (const auto& queue : queues) {
+        queue->sync([]() {});
+    }
+
+    for (size_t i = 0; i < strings.size(); i++) {
+        for (const auto& result : results) {
+            ASSERT_EQ(strings[i], result[i].toStringView());
+            ASSERT_EQ(results[0][i].getInternedString(), result[i].getInternedString());
+        }
+    }
+}
+
 } // namespace ValdiTest
@@ -6,11 +6,15 @@
 //
 
 #include "valdi_core/cpp/Threading/TaskQueue.hpp"
+#include "valdi_core/cpp/Threading/ThreadPoolDispatchQueue.hpp"
 #include "valdi_core/cpp/Threading/ThreadedDispatchQueue.hpp"
+#include "valdi_core/cpp/Threading/WorkStealingTaskQueue.hpp"
+#include "valdi_core/cpp/Utils/ConcurrentHistogram.hpp"
 #include "valdi_core/cpp/Utils/ConsoleLogger.hpp"
 #include "valdi_core/cpp/Utils/StringCache.hpp"
 #include "valdi_core/cpp/Utils/TrackedLock.hpp"
 #include <gtest/gtest.h>
+#include <thread>
 
 using namespace Valdi;
 
@@ -88,6 +92,289 @@ TEST(TaskQueue, barrierDoesNotAllowOtherTaskToRun) {
     ASSERT_TRUE(innerTaskRan);
 }
 
+TEST(TaskQueue, runsDueTasksInOrderBeforeDelayedTasks) {
+    TaskQueue taskQueue;
+    std::vector<int> order;
+
+    auto now = std::chrono::steady_clock::now();
+    taskQueue.enqueue([&]() { order.emplace_back(3); }, now + std::chrono::milliseconds(20));
+    taskQueue.enqueue([&]() { order.emplace_back(0); });
+    taskQueue.enqueue([&]() { order.emplace_back(2); }, now + std::chrono::milliseconds(10));
+    // Tasks that are already due run in the order they were enqueued
+    taskQueue.enqueue([&]() { order.emplace_back(1); }, now - std::chrono::milliseconds(10));
+
+    while (order.size() < 4) {
+        taskQueue.runNextTask(std::chrono::steady_clock::now() + std::chrono::seconds(1));
+    }
+
+    ASSERT_EQ(std::vector<int>({0, 1, 2, 3}), order);
+}
+
+TEST(TaskQueue, canCancelDelayedAndImmediateTasks) {
+    TaskQueue taskQueue;
+    std::vector<int> ran;
+
+    std::vector<task_id_t> delayedTaskIds;
+    for (int i = 0; i < 100; i++) {
+        delayedTaskIds.emplace_back(taskQueue.enqueue([&ran, i]() { ran.emplace_back(i); }, std::chrono::milliseconds(1)).id);
+    }
+    auto immediateTaskId = taskQueue.enqueue([&]() { ran.emplace_back(-1); }).id;
+
+    for (size_t i = 0; i < delayedTaskIds.size(); i++) {
+        if (i != 42) {
+            taskQueue.cancel(delayedTaskIds[i]);
+        }
+    }
+    taskQueue.cancel(immediateTaskId);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    taskQueue.flush();
+
+    ASSERT_EQ(std::vector<int>({42}), ran);
+}
+
+class TestQueueListener : public IQueueListener {
+public:
+    std::atomic_int nonEmptyCount = 0;
+    std::atomic_int emptyCount = 0;
+
+    void onQueueEmpty() override {
+        emptyCount++;
+    }
+
+    void onQueueNonEmpty() override {
+        nonEmptyCount++;
+    }
+};
+
+TEST(TaskQueue, runsTasksFromConcurrentProducers) {
+    TaskQueue taskQueue;
+    auto listener = makeShared<TestQueueListener>();
+    taskQueue.setListener(listener);
+
+    constexpr size_t kProducers = 4;
+    constexpr size_t kTasksPerProducer = 10000;
+    std::atomic_size_t ranTasks = 0;
+
+    std::vector<Ref<Thread>> producers;
+    for (size_t i = 0; i < kProducers; i++) {
+        producers.emplace_back(Thread::create(STRING_LITERAL("Producer"), ThreadQoSClassNormal, [&]() {
+                                   for (size_t j = 0; j < kTasksPerProducer; j++) {
+                                       taskQueue.enqueue([&]() { ranTasks++; });
+                                   }
+                               }).value());
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (ranTasks < kProducers * kTasksPerProducer && std::chrono::steady_clock::now() < deadline) {
+        taskQueue.runNextTask(std::chrono::steady_clock::now() + std::chrono::milliseconds(10));
+    }
+
+    for (const auto& producer : producers) {
+        producer->join();
+    }
+
+    ASSERT_EQ(kProducers * kTasksPerProducer, ranTasks.load());
+    ASSERT_FALSE(taskQueue.runNextTask());
+    ASSERT_EQ(listener->nonEmptyCount.load(), listener->emptyCount.load());
+}
+
+TEST(TaskQueue, recordsInstrumentationWhenEnabled) {
+    TaskQueue taskQueue;
+    taskQueue.enqueue([]() {});
+    taskQueue.flush();
+    ASSERT_EQ(nullptr, taskQueue.getInstrumentation());
+
+    auto queueName = STRING_LITERAL("Instrumented Test Queue");
+    taskQueue.setInstrumentationEnabled(true, queueName);
+
+    for (size_t i = 0; i < 3; i++) {
+        taskQueue.enqueue([]() { std::this_thread::sleep_for(std::chrono::milliseconds(2)); });
+    }
+    ASSERT_EQ(static_cast<size_t>(3), taskQueue.flush());
+
+    auto statistics = DispatchQueueInstrumentation::getStatistics(queueName);
+    ASSERT_TRUE(statistics.has_value());
+    ASSERT_EQ(static_cast<size_t>(3), statistics->maxDepth);
+    ASSERT_EQ(static_cast<uint64_t>(3), statistics->waitTimeMicros.count);
+    ASSERT_EQ(static_cast<uint64_t>(3), statistics->runTimeMicros.count);
+    ASSERT_GE(statistics->runTimeMicros.getValueAtPercentile(50), static_cast<uint64_t>(2000));
+    // The last task waited for the first two to run
+    ASSERT_GE(statistics->waitTimeMicros.max, static_cast<uint64_t>(4000));
+
+    taskQueue.setInstrumentationEnabled(false, queueName);
+    taskQueue.enqueue([]() {});
+    taskQueue.flush();
+
+    ASSERT_EQ(static_cast<uint64_t>(3), DispatchQueueInstrumentation::getStatistics(queueName)->runTimeMicros.count);
+}
+
+TEST(ConcurrentHistogram, reportsPercentilesWithinPrecision) {
+    ConcurrentHistogram histogram;
+    for (uint64_t i = 1; i <= 1000; i++) {
+        histogram.record(i);
+    }
+
+    auto snapshot = histogram.snapshot();
+
+    ASSERT_EQ(static_cast<uint64_t>(1000), snapshot.count);
+    ASSERT_EQ(static_cast<uint64_t>(1000), snapshot.max);
+    ASSERT_DOUBLE_EQ(500.5, snapshot.getMean());
+
+    auto p50 = snapshot.getValueAtPercentile(50);
+    ASSERT_GE(p50, static_cast<uint64_t>(500));
+    ASSERT_LE(p50, static_cast<uint64_t>(500 * 1.125));
+    ASSERT_EQ(static_cast<uint64_t>(1000), snapshot.getValueAtPercentile(100));
+
+    for (size_t i = 0; i < ConcurrentHistogram::kBucketsCount; i++) {
+        ASSERT_EQ(i, ConcurrentHistogram::getBucketIndex(ConcurrentHistogram::getBucketHighestValue(i)));
+    }
+}
+
+TEST(ThreadPoolDispatchQueue, runsTasksConcurrently) {
+    auto dispatchQueue = makeShared<ThreadPoolDispatchQueue>(STRING_LITERAL("Test Pool"), ThreadQoSClassNormal, 4);
+
+    ASSERT_FALSE(dispatchQueue->hasThreadsRunning());
+
+    Mutex mutex;
+    ConditionVariable condition;
+    size_t runningTasks = 0;
+    size_t completedTasks = 0;
+
+    for (size_t i = 0; i < 4; i++) {
+        dispatchQueue->async([&]() {
+            std::unique_lock<Mutex> lock(mutex);
+            runningTasks++;
+            condition.notifyAll();
+            // Each task waits until all of them are running at the same time
+            while (runningTasks < 4) {
+                condition.wait(lock);
+            }
+            completedTasks++;
+            condition.notifyAll();
+        });
+    }
+
+    ASSERT_TRUE(dispatchQueue->hasThreadsRunning());
+
+    std::unique_lock<Mutex> lock(mutex);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (completedTasks < 4 && std::chrono::steady_clock::now() < deadline) {
+        condition.waitUntil(lock, deadline);
+    }
+
+    ASSERT_EQ(static_cast<size_t>(4), completedTasks);
+}
+
+TEST(ThreadPoolDispatchQueue, syncRunsOnPoolAndInlineWhenCurrent) {
+    auto dispatchQueue = makeShared<ThreadPoolDispatchQueue>(STRING_LITERAL("Test Pool"), ThreadQoSClassNormal, 2);
+
+    bool wasCurrent = false;
+    bool nestedSyncRan = false;
+    dispatchQueue->sync([&]() {
+        wasCurrent = dispatchQueue->isCurrent();
+        // Would deadlock if sync() did not run inline from a pool thread
+        dispatchQueue->sync([&]() { nestedSyncRan = true; });
+    });
+
+    ASSERT_TRUE(wasCurrent);
+    ASSERT_TRUE(nestedSyncRan);
+    ASSERT_FALSE(dispatchQueue->isCurrent());
+}
+
+TEST(ThreadPoolDispatchQueue, tracksConcurrentSyncTasks) {
+    auto dispatchQueue = makeShared<ThreadPoolDispatchQueue>(STRING_LITERAL("Test Pool"), ThreadQoSClassNormal, 2);
+
+    std::atomic_int runningTasks = 0;
+    std::atomic_bool releaseFirst = false;
+    std::atomic_bool releaseSecond = false;
+
+    auto runSync = [&](std::atomic_bool& release) {
+        dispatchQueue->sync([&]() {
+            runningTasks++;
+            while (!release) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    };
+
+    std::thread first([&]() { runSync(releaseFirst); });
+    std::thread second([&]() { runSync(releaseSecond); });
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (runningTasks < 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    EXPECT_EQ(2, runningTasks.load());
+    EXPECT_TRUE(dispatchQueue->isRunningSync());
+
+    releaseFirst = true;
+    first.join();
+
+    // The second task is still running
+    EXPECT_TRUE(dispatchQueue->isRunningSync());
+
+    releaseSecond = true;
+    second.join();
+
+    ASSERT_FALSE(dispatchQueue->isRunningSync());
+}
+
+TEST(ThreadPoolDispatchQueue, canCancelDelayedTasks) {
+    auto dispatchQueue = makeShared<ThreadPoolDispatchQueue>(STRING_LITERAL("Test Pool"), ThreadQoSClassNormal, 2);
+
+    std::atomic_int cancelledTaskRuns = 0;
+    std::atomic_int taskRuns = 0;
+
+    auto taskId = dispatchQueue->asyncAfter([&]() { cancelledTaskRuns++; }, std::chrono::milliseconds(20));
+    dispatchQueue->asyncAfter([&]() { taskRuns++; }, std::chrono::milliseconds(20));
+    dispatchQueue->cancel(taskId);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (taskRuns == 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    // Give a chance for the cancelled task to run if the cancel was ignored
+    std::this_thread::sleep_for(std::chrono::milliseconds(40));
+
+    ASSERT_EQ(1, taskRuns.load());
+    ASSERT_EQ(0, cancelledTaskRuns.load());
+}
+
+TEST(WorkStealingTaskQueue, cancelReturnsWhetherTaskWasRemoved) {
+    auto taskQueue = makeShared<WorkStealingTaskQueue>(1);
+
+    auto delayedTask = taskQueue->enqueue([]() {}, std::chrono::seconds(60));
+    auto immediateTask = taskQueue->enqueue([]() {});
+
+    ASSERT_TRUE(taskQueue->cancel(delayedTask.id));
+    // Already cancelled
+    ASSERT_FALSE(taskQueue->cancel(delayedTask.id));
+    // Immediate tasks cannot be cancelled
+    ASSERT_FALSE(taskQueue->cancel(immediateTask.id));
+
+    ASSERT_TRUE(taskQueue->runNextTask(0, std::chrono::steady_clock::now()));
+    ASSERT_FALSE(taskQueue->runNextTask(0, std::chrono::steady_clock::now()));
+
+    taskQueue->dispose();
+}
+
+TEST(ThreadPoolDispatchQueue, dropsPendingTasksOnTeardown) {
+    auto dispatchQueue = makeShared<ThreadPoolDispatchQueue>(STRING_LITERAL("Test Pool"), ThreadQoSClassNormal, 2);
+
+    bool didRun = false;
+    dispatchQueue->asyncAfter([&]() { didRun = true; }, std::chrono::seconds(60));
+    dispatchQueue->fullTeardown();
+
+    ASSERT_TRUE(dispatchQueue->isDisposed());
+    ASSERT_FALSE(dispatchQueue->hasThreadsRunning());
+
+    // sync() on a torn down pool should not block
+    dispatchQueue->sync([&]() { didRun = true; });
+    ASSERT_FALSE(didRun);
+}
+
 TEST(TrackedLock, canDropTrackedLocks) {
     auto mutex = makeShared<RecursiveMutex>();
     TrackedLock lock1(*mutex);
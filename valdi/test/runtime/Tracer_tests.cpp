@@ -1,5 +1,9 @@
+#include "valdi_core/cpp/Utils/ByteBuffer.hpp"
 #include "valdi_core/cpp/Utils/Trace.hpp"
+#include <algorithm>
 #include <gtest/gtest.h>
+#include <map>
+#include <thread>
 
 using namespace Valdi;
 
@@ -118,4 +122,102 @@ TEST(Tracer, onlyReturnsRecordingWhenLastRecorderEnd) {
     ASSERT_FALSE(tracer.isRecording());
 }
 
+TEST(Tracer, canRecordOperationsFromMultipleThreads) {
+    Tracer tracer;
+    auto start = std::chrono::steady_clock::now();
+
+    auto id = tracer.startRecording();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&, i]() {
+            for (int j = 0; j < 100; j++) {
+                tracer.append(j % 2 == 0 ? "even" : "odd", start, appendMs(start, i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    auto result = tracer.stopRecording(id);
+
+    ASSERT_EQ(static_cast<size_t>(400), result.size());
+
+    std::map<ThreadId, size_t> tracesByThread;
+    for (const auto& trace : result) {
+        tracesByThread[trace.threadId]++;
+    }
+    ASSERT_EQ(static_cast<size_t>(4), tracesByThread.size());
+    for (const auto& it : tracesByThread) {
+        ASSERT_EQ(static_cast<size_t>(100), it.second);
+    }
+
+    // Traces of a given thread are returned in the order they were appended
+    ASSERT_EQ("even", result[0].trace);
+    ASSERT_EQ("odd", result[1].trace);
+    ASSERT_EQ(0u, tracer.getDroppedTracesCount());
+}
+
+TEST(Tracer, dropsTracesWhenThreadBufferIsFull) {
+    Tracer tracer(8);
+    auto start = std::chrono::steady_clock::now();
+
+    auto id = tracer.startRecording();
+
+    for (int i = 0; i < 10; i++) {
+        tracer.append("hello", start, appendMs(start, i));
+    }
+
+    ASSERT_EQ(static_cast<size_t>(2), tracer.getDroppedTracesCount());
+
+    auto result = tracer.stopRecording(id);
+
+    ASSERT_EQ(static_cast<size_t>(8), result.size());
+    ASSERT_EQ(7.0, result[7].duration().milliseconds());
+
+    // Buffers are reset once the recording ends
+    id = tracer.startRecording();
+    tracer.append("world", start, appendMs(start, 1));
+    result = tracer.stopRecording(id);
+
+    ASSERT_EQ(static_cast<size_t>(1), result.size());
+    ASSERT_EQ("world", result[0].trace);
+}
+
+TEST(Tracer, scopedTraceRecordsNamesOfAllKinds) {
+    auto& tracer = Tracer::shared();
+    auto id = tracer.startRecording();
+
+    { ScopedTrace trace("literal"); }
+    { ScopedTrace trace(StringBox::fromCString("interned")); }
+    { ScopedTrace trace(getTraceName("dynamic", "name")); }
+
+    auto result = tracer.stopRecording(id);
+    // Other threads might be tracing concurrently on the shared tracer
+    result.erase(std::remove_if(result.begin(),
+                                result.end(),
+                                [](const auto& trace) { return trace.threadId != getCurrentThreadId(); }),
+                 result.end());
+
+    ASSERT_EQ(static_cast<size_t>(3), result.size());
+    ASSERT_EQ("literal", result[0].trace);
+    ASSERT_EQ("interned", result[1].trace);
+    ASSERT_EQ("dynamic.name", result[2].trace);
+}
+
+TEST(Tracer, canWriteChromeTraceJSON) {
+    auto start = TraceTimePoint(std::chrono::microseconds(1000));
+    std::vector<RecordedTrace> traces;
+    traces.emplace_back("Valdi.calculateLayout", start, start + std::chrono::microseconds(250), 3, 1);
+
+    ByteBuffer output;
+    writeChromeTraceJSON(traces, output);
+
+    ASSERT_EQ(
+        "{\"traceEvents\":[\n{\"name\":\"Valdi.calculateLayout\",\"cat\":\"valdi\",\"ph\":\"X\",\"ts\":1000.000000,"
+        "\"dur\":250.000000,\"pid\":0,\"tid\":3}\n],\"displayTimeUnit\":\"ms\"}",
+        output.toStringView());
+}
+
 } // namespace ValdiTest
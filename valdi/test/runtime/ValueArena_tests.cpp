@@ -0,0 +1,237 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi_core/cpp/Utils/ValueArena.hpp"
+#include "valdi_core/cpp/Utils/StringCache.hpp"
+#include "valdi_core/cpp/Utils/Value.hpp"
+#include "valdi_core/cpp/Utils/ValueArray.hpp"
+#include "valdi_core/cpp/Utils/ValueMap.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+
+using namespace Valdi;
+
+namespace ValdiTest {
+
+TEST(ValueArena, allocatesFromHeapWithoutScope) {
+    ValueArena arena;
+
+    auto array = ValueArray::make(4);
+    array->emplace(0, Value(42));
+
+    ASSERT_EQ(nullptr, ValueArena::current());
+    ASSERT_EQ(static_cast<size_t>(0), arena.getChunksAllocatedCount());
+    ASSERT_EQ(42, (*array)[0].toInt());
+}
+
+TEST(ValueArena, allocatesContainersFromCurrentArena) {
+    ValueArena arena;
+
+    {
+        ValueArenaScope scope(arena);
+        ASSERT_EQ(&arena, ValueArena::current());
+
+        for (size_t i = 0; i < 16; i++) {
+            auto array = ValueArray::make(4);
+            array->emplace(0, Value(static_cast<int32_t>(i)));
+
+            auto map = makeShared<ValueMap>();
+            (*map)[STRING_LITERAL("key")] = Value(array);
+        }
+    }
+
+    ASSERT_EQ(nullptr, ValueArena::current());
+    ASSERT_EQ(static_cast<size_t>(1), arena.getChunksAllocatedCount());
+    ASSERT_NE(static_cast<size_t>(0), arena.getBytesAllocated());
+}
+
+TEST(ValueArena, reusesChunkAcrossScopes) {
+    ValueArena arena;
+
+    for (size_t i = 0; i < 8; i++) {
+        ValueArenaScope scope(arena);
+        auto array = ValueArray::make(8);
+        array->emplace(0, Value(true));
+    }
+
+    ASSERT_EQ(static_cast<size_t>(1), arena.getChunksAllocatedCount());
+}
+
+TEST(ValueArena, escapedValuesOutliveScopeAndArena) {
+    Value escaped;
+
+    {
+        ValueArena arena;
+        {
+            ValueArenaScope scope(arena);
+            auto array = ValueArray::make(2);
+            array->emplace(0, Value(STRING_LITERAL("Hello")));
+            array->emplace(1, Value(7));
+            escaped = Value(array);
+        }
+
+        {
+            // The chunk is still used by the escaped array, it should not be rewound
+            ValueArenaScope scope(arena);
+            auto other = ValueArray::make(2);
+            other->emplace(0, Value(STRING_LITERAL("World")));
+            other->emplace(1, Value(8));
+        }
+
+        ASSERT_EQ(static_cast<size_t>(2), arena.getChunksAllocatedCount());
+    }
+
+    ASSERT_EQ("Hello", escaped.getArray()->begin()[0].toString());
+    ASSERT_EQ(7, escaped.getArray()->begin()[1].toInt());
+}
+
+TEST(ValueArena, copiedEscapedValuesDoNotRetainChunk) {
+    ValueArena arena;
+    Value escaped;
+
+    {
+        ValueArenaScope scope(arena);
+        auto map = makeShared<ValueMap>();
+        (*map)[STRING_LITERAL("value")] = Value(7);
+
+        auto array = ValueArray::make(2);
+        array->emplace(0, Value(STRING_LITERAL("Hello")));
+        array->emplace(1, Value(map));
+
+        ASSERT_TRUE(ValueArena::isArenaAllocated(array.get()));
+        ASSERT_TRUE(ValueArena::isArenaAllocated(map.get()));
+
+        escaped = ValueArena::copyToHeap(Value(array));
+    }
+
+    ASSERT_FALSE(ValueArena::isArenaAllocated(escaped.getArray()));
+    ASSERT_FALSE(ValueArena::isArenaAllocated(escaped.getArray()->begin()[1].getMap()));
+
+    {
+        // Nothing allocated from the chunk is alive anymore, it should be rewound
+        ValueArenaScope scope(arena);
+        auto other = ValueArray::make(2);
+        other->emplace(0, Value(true));
+    }
+
+    ASSERT_EQ(static_cast<size_t>(1), arena.getChunksAllocatedCount());
+    ASSERT_EQ("Hello", escaped.getArray()->begin()[0].toString());
+    ASSERT_EQ(7, escaped.getArray()->begin()[1].getMapValue("value").toInt());
+}
+
+TEST(ValueArena, copyToHeapKeepsHeapValues) {
+    auto map = makeShared<ValueMap>();
+    (*map)[STRING_LITERAL("value")] = Value(ValueArray::make({Value(1), Value(2)}));
+    auto value = Value(map);
+
+    auto copy = ValueArena::copyToHeap(value);
+
+    ASSERT_EQ(value.getMap(), copy.getMap());
+}
+
+TEST(ValueArena, canReleaseEscapedValuesFromOtherThread) {
+    Value escaped;
+
+    {
+        ValueArenaScope scope;
+        auto map = makeShared<ValueMap>();
+        (*map)[STRING_LITERAL("value")] = Value(1);
+        escaped = Value(map);
+    }
+
+    std::thread thread([value = std::move(escaped)]() mutable {
+        ASSERT_EQ(1, value.getMapValue("value").toInt());
+        value = Value();
+    });
+    thread.join();
+}
+
+TEST(ValueArena, allocatesMapEntriesFromCurrentArena) {
+    ValueArena arena;
+
+    {
+        ValueArenaScope scope(arena);
+        auto map = makeShared<ValueMap>();
+        // Large enough to also allocate the index table
+        for (size_t i = 0; i < 32; i++) {
+            (*map)[StringCache::getGlobal().makeString("key" + std::to_string(i))] = Value(static_cast<int32_t>(i));
+        }
+
+        ASSERT_TRUE(map->get_allocator().usesArena());
+        ASSERT_TRUE(ValueArena::isArenaAllocated(&*map->begin()));
+    }
+
+    ASSERT_EQ(static_cast<size_t>(1), arena.getChunksAllocatedCount());
+}
+
+TEST(ValueArena, keepsEntriesOfMapsCreatedOutsideOfArenaInHeap) {
+    ValueArena arena;
+    auto map = makeShared<ValueMap>();
+    ASSERT_FALSE(map->get_allocator().usesArena());
+
+    {
+        // A long lived map which is mutated during a pass should not retain the chunk
+        ValueArenaScope scope(arena);
+        for (size_t i = 0; i < 32; i++) {
+            (*map)[StringCache::getGlobal().makeString("key" + std::to_string(i))] = Value(static_cast<int32_t>(i));
+        }
+    }
+
+    ASSERT_FALSE(ValueArena::isArenaAllocated(&*map->begin()));
+    ASSERT_EQ(static_cast<size_t>(0), arena.getChunksAllocatedCount());
+    ASSERT_EQ(static_cast<size_t>(0), arena.getEscapedChunksCount());
+}
+
+TEST(ValueArena, countsChunksPinnedByEscapedValues) {
+    auto pinnedChunksCount = ValueArena::getPinnedChunksCount();
+    auto pinnedBytes = ValueArena::getPinnedBytes();
+    Value escaped;
+
+    {
+        ValueArena arena(1024);
+        {
+            ValueArenaScope scope(arena);
+            auto array = ValueArray::make(2);
+            array->emplace(0, Value(7));
+            escaped = Value(array);
+
+            // Fill the chunk, so that the escaped array is in a chunk which is no longer current
+            for (size_t i = 0; i < 64; i++) {
+                auto filler = ValueArray::make(8);
+            }
+        }
+
+        ASSERT_LT(static_cast<size_t>(1), arena.getChunksAllocatedCount());
+        ASSERT_EQ(static_cast<size_t>(1), arena.getEscapedChunksCount());
+        ASSERT_EQ(pinnedChunksCount + 1, ValueArena::getPinnedChunksCount());
+        ASSERT_EQ(pinnedBytes + 1024, ValueArena::getPinnedBytes());
+
+        {
+            // Passes which don't leak values don't pin more chunks
+            ValueArenaScope scope(arena);
+            auto other = ValueArray::make(8);
+        }
+
+        ASSERT_EQ(static_cast<size_t>(1), arena.getEscapedChunksCount());
+    }
+
+    ASSERT_EQ(7, escaped.getArray()->begin()[0].toInt());
+
+    escaped = Value();
+
+    ASSERT_EQ(pinnedChunksCount, ValueArena::getPinnedChunksCount());
+    ASSERT_EQ(pinnedBytes, ValueArena::getPinnedBytes());
+}
+
+TEST(ValueArena, nestedScopesRestorePreviousArena) {
+    ValueArena outer;
+    ValueArena inner;
+
+    ValueArenaScope outerScope(outer);
+    {
+        ValueArenaScope innerScope(inner);
+        ASSERT_EQ(&inner, ValueArena::current());
+    }
+    ASSERT_EQ(&outer, ValueArena::current());
+}
+
+} // namespace ValdiTest
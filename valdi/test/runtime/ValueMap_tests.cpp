@@ -0,0 +1,139 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi_core/cpp/Utils/StringCache.hpp"
+#include "valdi_core/cpp/Utils/Value.hpp"
+#include "valdi_core/cpp/Utils/ValueMap.hpp"
+#include "valdi_core/cpp/Utils/ValueUtils.hpp"
+#include <gtest/gtest.h>
+
+using namespace Valdi;
+
+namespace ValdiTest {
+
+static std::vector<StringBox> makeKeys(size_t count) {
+    std::vector<StringBox> keys;
+    for (size_t i = 0; i < count; i++) {
+        // Reverse the natural order, so that insertion order differs from sorted order
+        keys.emplace_back(StringCache::getGlobal().makeString("key" + std::to_string(count - i)));
+    }
+    return keys;
+}
+
+static std::vector<StringBox> getKeys(const ValueMap& map) {
+    std::vector<StringBox> keys;
+    for (const auto& it : map) {
+        keys.emplace_back(it.first);
+    }
+    return keys;
+}
+
+TEST(ValueMap, iteratesInInsertionOrder) {
+    for (size_t count : {3, 64}) {
+        auto keys = makeKeys(count);
+        ValueMap map;
+
+        for (size_t i = 0; i < keys.size(); i++) {
+            map[keys[i]] = Value(static_cast<int32_t>(i));
+        }
+
+        ASSERT_EQ(keys, getKeys(map));
+
+        for (size_t i = 0; i < keys.size(); i++) {
+            auto it = map.find(keys[i]);
+            ASSERT_NE(map.end(), it);
+            ASSERT_EQ(static_cast<int32_t>(i), it->second.toInt());
+        }
+    }
+}
+
+TEST(ValueMap, overwritingKeepsPosition) {
+    auto keys = makeKeys(3);
+    ValueMap map;
+    for (const auto& key : keys) {
+        map[key] = Value(true);
+    }
+
+    map[keys[0]] = Value(false);
+
+    ASSERT_EQ(keys, getKeys(map));
+    ASSERT_FALSE(map[keys[0]].toBool());
+}
+
+TEST(ValueMap, eraseKeepsOrderOfRemainingKeys) {
+    for (size_t count : {6, 64}) {
+        auto keys = makeKeys(count);
+        ValueMap map;
+        for (const auto& key : keys) {
+            map[key] = Value(key);
+        }
+
+        std::vector<StringBox> expectedKeys;
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (i % 3 == 0) {
+                ASSERT_EQ(static_cast<size_t>(1), map.erase(keys[i]));
+            } else {
+                expectedKeys.emplace_back(keys[i]);
+            }
+        }
+
+        ASSERT_EQ(expectedKeys, getKeys(map));
+        ASSERT_EQ(static_cast<size_t>(0), map.erase(keys[0]));
+        for (const auto& key : expectedKeys) {
+            ASSERT_EQ(Value(key), map[key]);
+        }
+        ASSERT_FALSE(map.contains(keys[0]));
+    }
+}
+
+TEST(ValueMap, equalityIgnoresOrder) {
+    auto keys = makeKeys(2);
+    ValueMap left;
+    left[keys[0]] = Value(1);
+    left[keys[1]] = Value(2);
+
+    ValueMap right;
+    right[keys[1]] = Value(2);
+    right[keys[0]] = Value(1);
+
+    ASSERT_EQ(left, right);
+
+    right[keys[0]] = Value(3);
+    ASSERT_NE(left, right);
+}
+
+TEST(ValueMap, hashIgnoresOrder) {
+    // Large enough to use the index table
+    auto keys = makeKeys(20);
+    auto left = makeShared<ValueMap>();
+    auto right = makeShared<ValueMap>();
+
+    for (size_t i = 0; i < keys.size(); i++) {
+        (*left)[keys[i]] = Value(static_cast<int32_t>(i));
+    }
+    for (size_t i = keys.size(); i > 0; i--) {
+        (*right)[keys[i - 1]] = Value(static_cast<int32_t>(i - 1));
+    }
+
+    ASSERT_EQ(*left, *right);
+    ASSERT_EQ(Value(left).hash(), Value(right).hash());
+
+    auto smallLeft = makeShared<ValueMap>();
+    (*smallLeft)[keys[0]] = Value(1);
+    (*smallLeft)[keys[1]] = Value(2);
+
+    auto smallRight = makeShared<ValueMap>();
+    (*smallRight)[keys[1]] = Value(2);
+    (*smallRight)[keys[0]] = Value(1);
+
+    ASSERT_EQ(Value(smallLeft), Value(smallRight));
+    ASSERT_EQ(Value(smallLeft).hash(), Value(smallRight).hash());
+}
+
+TEST(ValueMap, serializesInInsertionOrder) {
+    auto value =
+        Value().setMapValue("zebra", Value(STRING_LITERAL("1"))).setMapValue("apple", Value(STRING_LITERAL("2")));
+
+    ASSERT_EQ("{\"zebra\":\"1\",\"apple\":\"2\"}", valueToJsonString(value));
+}
+
+} // namespace ValdiTest
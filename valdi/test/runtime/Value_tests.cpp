@@ -11,7 +11,9 @@
 #include "valdi_core/cpp/Utils/ValueArray.hpp"
 #include "valdi_core/cpp/Utils/ValueFunctionWithCallable.hpp"
 #include "valdi_core/cpp/Utils/ValueUtils.hpp"
+#include <cmath>
 #include <gtest/gtest.h>
+#include <limits>
 
 using namespace Valdi;
 
@@ -93,6 +95,69 @@ TEST(Value, canHandleNumbers) {
     ASSERT_EQ(Value(numberInt), numberInt);
 }
 
+TEST(Value, preservesNumberLimits) {
+    ASSERT_EQ(std::numeric_limits<int32_t>::min(), Value(std::numeric_limits<int32_t>::min()).toInt());
+    ASSERT_EQ(std::numeric_limits<int32_t>::max(), Value(std::numeric_limits<int32_t>::max()).toInt());
+
+    // Longs outside of 47 bits are stored out of line when Value is NaN-boxed
+    auto bigLong = Value(std::numeric_limits<int64_t>::max());
+    ASSERT_TRUE(bigLong.isLong());
+    ASSERT_EQ(std::numeric_limits<int64_t>::max(), bigLong.toLong());
+    ASSERT_EQ(std::numeric_limits<int64_t>::min(), Value(std::numeric_limits<int64_t>::min()).toLong());
+    ASSERT_EQ(static_cast<int64_t>(-42), Value(static_cast<int64_t>(-42)).toLong());
+
+    auto bigLongCopy = bigLong;
+    ASSERT_EQ(bigLong, bigLongCopy);
+
+    for (auto aLong : {(static_cast<int64_t>(1) << 46) - 1,
+                       static_cast<int64_t>(1) << 46,
+                       -(static_cast<int64_t>(1) << 46),
+                       -(static_cast<int64_t>(1) << 46) - 1}) {
+        auto value = Value(aLong);
+        ASSERT_TRUE(value.isLong());
+        ASSERT_EQ(aLong, value.toLong());
+    }
+
+    ASSERT_TRUE(Value(-std::numeric_limits<double>::infinity()).isDouble());
+    ASSERT_EQ(-std::numeric_limits<double>::infinity(), Value(-std::numeric_limits<double>::infinity()).toDouble());
+
+    auto nan = Value(-std::numeric_limits<double>::quiet_NaN());
+    ASSERT_TRUE(nan.isDouble());
+    ASSERT_TRUE(std::isnan(nan.toDouble()));
+}
+
+TEST(Value, preservesTypeOfInlineValues) {
+    ASSERT_EQ(ValueType::Null, Value().getType());
+    ASSERT_EQ(ValueType::Undefined, Value::undefined().getType());
+    ASSERT_EQ(ValueType::Int, Value(static_cast<int32_t>(-1)).getType());
+    ASSERT_EQ(ValueType::Long, Value(static_cast<int64_t>(-1)).getType());
+    ASSERT_EQ(ValueType::Bool, Value(true).getType());
+    ASSERT_EQ(ValueType::Double, Value(-1.0).getType());
+    ASSERT_EQ(ValueType::Map, Value(makeShared<ValueMap>()).getType());
+    ASSERT_EQ(ValueType::Array, Value(ValueArray::make(0)).getType());
+}
+
+#if VALDI_NAN_BOXED_VALUE
+TEST(Value, restoresTopByteTagOfBoxedPointers) {
+    NaNBoxedPointerTag pointerTag;
+
+    // Android arm64 heap pointers carry a tag in their top byte
+    uint64_t taggedPointer = 0xB400007FDEADBEE0ULL;
+    auto addressBits = pointerTag.untag(taggedPointer);
+
+    ASSERT_EQ(static_cast<uint64_t>(0x0000007FDEADBEE0ULL), addressBits);
+    ASSERT_EQ(taggedPointer, pointerTag.retag(addressBits));
+    ASSERT_EQ(static_cast<uint64_t>(0xB4000071DEADBEE0ULL), pointerTag.retag(pointerTag.untag(0xB4000071DEADBEE0ULL)));
+    ASSERT_EQ(static_cast<uint64_t>(0), pointerTag.retag(0));
+
+    // Values hold the untagged address
+    auto array = ValueArray::make({Value(1)});
+    auto value = Value(array);
+    ASSERT_EQ(array.get(), value.getArray());
+    ASSERT_EQ(1, (*value.getArray())[0].toInt());
+}
+#endif
+
 TEST(Value, canHandleNullAndUndefined) {
     ASSERT_TRUE(Value().isNull());
     ASSERT_TRUE(Value::undefined().isUndefined());
@@ -0,0 +1,160 @@
+#include "ViewNodeTestsUtils.hpp"
+#include "valdi/runtime/Attributes/AttributeHandler.hpp"
+#include "valdi/runtime/Attributes/AttributeHandlerDelegate.hpp"
+#include "valdi/runtime/Attributes/BoundAttributes.hpp"
+#include "valdi/runtime/Attributes/ViewNodeAttributesApplier.hpp"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <functional>
+
+using namespace Valdi;
+
+namespace ValdiTest {
+
+class RecordingAttributeHandlerDelegate : public AttributeHandlerDelegate {
+public:
+    Result<Void> onApply(ViewTransactionScope& /*viewTransactionScope*/,
+                         ViewNode& /*viewNode*/,
+                         const Ref<View>& /*view*/,
+                         const StringBox& name,
+                         const Value& /*value*/,
+                         const Ref<Animator>& /*animator*/) override {
+        applied.emplace_back(name);
+        if (onApplyCallback) {
+            onApplyCallback(name);
+        }
+        return Void();
+    }
+
+    void onReset(ViewTransactionScope& /*viewTransactionScope*/,
+                 ViewNode& /*viewNode*/,
+                 const Ref<View>& /*view*/,
+                 const StringBox& name,
+                 const Ref<Animator>& /*animator*/) override {
+        reset.emplace_back(name);
+        if (onResetCallback) {
+            onResetCallback(name);
+        }
+    }
+
+    std::vector<StringBox> applied;
+    std::vector<StringBox> reset;
+    std::function<void(const StringBox&)> onApplyCallback;
+    std::function<void(const StringBox&)> onResetCallback;
+};
+
+static Ref<BoundAttributes> makeBoundAttributes(ViewNodeTestsDependencies& utils,
+                                                const Ref<AttributeHandlerDelegate>& delegate,
+                                                const std::vector<AttributeId>& ids) {
+    AttributeHandlerById handlers;
+    for (auto id : ids) {
+        handlers[id] = AttributeHandler(id, utils.getAttributeIds().getNameForId(id), delegate, nullptr, true, false);
+    }
+
+    return makeShared<BoundAttributes>(
+        STRING_LITERAL("UIView"), std::move(handlers), nullptr, nullptr, utils.getAttributeIds(), false);
+}
+
+static size_t countOf(const std::vector<StringBox>& names, const char* name) {
+    return static_cast<size_t>(
+        std::count_if(names.begin(), names.end(), [&](const StringBox& other) { return other == name; }));
+}
+
+TEST(ViewNodeAttributesApplier, updatesAttributesMutatedByHandlerDuringUpdate) {
+    ViewNodeTestsDependencies utils;
+    auto& scope = utils.getViewTransactionScope();
+    auto root = utils.createRootView();
+    ASSERT_TRUE(root->hasView());
+
+    auto& attributeIds = utils.getAttributeIds();
+    auto idA = attributeIds.getIdForName("reentrantUpdateA");
+    auto idB = attributeIds.getIdForName("reentrantUpdateB");
+    auto idC = attributeIds.getIdForName("reentrantUpdateC");
+    auto idD = attributeIds.getIdForName("reentrantUpdateD");
+    ASSERT_LT(idA, idB);
+    ASSERT_LT(idB, idC);
+    ASSERT_LT(idC, idD);
+
+    auto delegate = makeShared<RecordingAttributeHandlerDelegate>();
+    ViewNodeAttributesApplier applier(root.get());
+    applier.setBoundAttributes(makeBoundAttributes(utils, delegate, {idA, idB, idC, idD}));
+
+    const auto* owner = AttributeOwner::getNativeOverridenAttributeOwner();
+    applier.setAttribute(scope, idA, owner, Value(1.0), nullptr);
+    applier.setAttribute(scope, idB, owner, Value(2.0), nullptr);
+    applier.setAttribute(scope, idC, owner, Value(3.0), nullptr);
+
+    // Attributes requiring a view are only applied once the applier has one
+    ASSERT_TRUE(delegate->applied.empty());
+
+    // Applying the first attribute inserts an attribute and removes one which was not applied yet
+    delegate->onApplyCallback = [&](const StringBox& name) {
+        if (name == "reentrantUpdateA") {
+            applier.setAttribute(scope, idD, owner, Value(4.0), nullptr);
+            applier.removeAttribute(scope, idC, owner, nullptr);
+        }
+    };
+
+    applier.didAddView(scope, nullptr);
+
+    ASSERT_EQ(static_cast<size_t>(1), countOf(delegate->applied, "reentrantUpdateA"));
+    ASSERT_EQ(static_cast<size_t>(1), countOf(delegate->applied, "reentrantUpdateB"));
+    ASSERT_EQ(static_cast<size_t>(0), countOf(delegate->applied, "reentrantUpdateC"));
+    ASSERT_EQ(static_cast<size_t>(1), countOf(delegate->applied, "reentrantUpdateD"));
+    ASSERT_TRUE(delegate->reset.empty());
+
+    ASSERT_EQ(Value(1.0), applier.getResolvedAttributeValue(idA));
+    ASSERT_EQ(Value(2.0), applier.getResolvedAttributeValue(idB));
+    ASSERT_FALSE(applier.hasResolvedAttributeValue(idC));
+    ASSERT_EQ(Value(4.0), applier.getResolvedAttributeValue(idD));
+}
+
+TEST(ViewNodeAttributesApplier, removesAttributesOfOwnerMutatedByHandlerDuringRemoval) {
+    ViewNodeTestsDependencies utils;
+    auto& scope = utils.getViewTransactionScope();
+    auto root = utils.createRootView();
+    ASSERT_TRUE(root->hasView());
+
+    auto& attributeIds = utils.getAttributeIds();
+    auto idA = attributeIds.getIdForName("reentrantRemoveA");
+    auto idB = attributeIds.getIdForName("reentrantRemoveB");
+    auto idC = attributeIds.getIdForName("reentrantRemoveC");
+    auto idD = attributeIds.getIdForName("reentrantRemoveD");
+
+    auto delegate = makeShared<RecordingAttributeHandlerDelegate>();
+    ViewNodeAttributesApplier applier(root.get());
+    applier.setBoundAttributes(makeBoundAttributes(utils, delegate, {idA, idB, idC, idD}));
+    applier.didAddView(scope, nullptr);
+
+    const auto* owner = AttributeOwner::getNativeOverridenAttributeOwner();
+    const auto* otherOwner = AttributeOwner::getPlaceholderAttributeOwner();
+    applier.setAttribute(scope, idA, owner, Value(1.0), nullptr);
+    applier.setAttribute(scope, idB, owner, Value(2.0), nullptr);
+    applier.setAttribute(scope, idC, owner, Value(3.0), nullptr);
+
+    ASSERT_EQ(static_cast<size_t>(3), delegate->applied.size());
+
+    // Resetting the first attribute inserts an attribute and removes one which was not reset yet
+    delegate->onResetCallback = [&](const StringBox& name) {
+        if (name == "reentrantRemoveA") {
+            applier.setAttribute(scope, idD, otherOwner, Value(4.0), nullptr);
+            applier.removeAttribute(scope, idB, owner, nullptr);
+        }
+    };
+
+    ASSERT_TRUE(applier.removeAllAttributesForOwner(scope, owner, nullptr));
+
+    ASSERT_EQ(static_cast<size_t>(1), countOf(delegate->reset, "reentrantRemoveA"));
+    ASSERT_EQ(static_cast<size_t>(1), countOf(delegate->reset, "reentrantRemoveB"));
+    ASSERT_EQ(static_cast<size_t>(1), countOf(delegate->reset, "reentrantRemoveC"));
+    ASSERT_EQ(static_cast<size_t>(0), countOf(delegate->reset, "reentrantRemoveD"));
+    ASSERT_EQ(static_cast<size_t>(1), countOf(delegate->applied, "reentrantRemoveD"));
+
+    ASSERT_FALSE(applier.hasResolvedAttributeValue(idA));
+    ASSERT_FALSE(applier.hasResolvedAttributeValue(idB));
+    ASSERT_FALSE(applier.hasResolvedAttributeValue(idC));
+    ASSERT_EQ(Value(4.0), applier.getResolvedAttributeValue(idD));
+}
+
+} // namespace ValdiTest
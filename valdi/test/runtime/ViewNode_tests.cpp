@@ -1,5 +1,10 @@
 #include "ViewNodeTestsUtils.hpp"
+#include "valdi/runtime/Context/LayoutCache.hpp"
+#include "valdi/runtime/Views/DefaultMeasureDelegate.hpp"
+#include "valdi_core/cpp/Threading/DispatchQueue.hpp"
 #include "gtest/gtest.h"
+#include <condition_variable>
+#include <mutex>
 
 using namespace Valdi;
 
@@ -1790,6 +1795,292 @@ TEST(ViewNode, canHandleLazyLayout) {
     ASSERT_EQ(Frame(8, 8, 8, 8), child->getCalculatedFrame());
 }
 
+TEST(ViewNode, canReuseCachedLayoutOfIdenticalLazyLayouts) {
+    ViewNodeTestsDependencies utils;
+    auto layoutCache = makeShared<LayoutCache>(LayoutCache::kDefaultCapacity);
+    utils.getTree().setLayoutCache(layoutCache);
+
+    auto root = utils.createRootView();
+    auto container1 = utils.createLayout();
+    auto child1 = utils.createLayout();
+    auto container2 = utils.createLayout();
+    auto child2 = utils.createLayout();
+
+    container1->setPrefersLazyLayout(utils.getViewTransactionScope(), true);
+    container2->setPrefersLazyLayout(utils.getViewTransactionScope(), true);
+
+    root->appendChild(utils.getViewTransactionScope(), container1);
+    root->appendChild(utils.getViewTransactionScope(), container2);
+    container1->appendChild(utils.getViewTransactionScope(), child1);
+    container2->appendChild(utils.getViewTransactionScope(), child2);
+
+    utils.setViewNodeFrame(container1, 0, 0, 50, 50);
+    utils.setViewNodeFrame(container2, 50, 50, 50, 50);
+    utils.setViewNodeFrame(child1, 16, 16, 16, 16);
+    utils.setViewNodeFrame(child2, 16, 16, 16, 16);
+
+    root->performLayout(utils.getViewTransactionScope(), Size(100, 100), LayoutDirectionLTR);
+    root->updateVisibilityAndPerformUpdates(utils.getViewTransactionScope());
+
+    ASSERT_EQ(Frame(16, 16, 16, 16), child1->getCalculatedFrame());
+    ASSERT_EQ(Frame(16, 16, 16, 16), child2->getCalculatedFrame());
+
+    // The second lazy layout has the same content and constraints as the first one
+    ASSERT_EQ(static_cast<size_t>(1), layoutCache->getHitCount());
+
+    // Updating a subtree which was already laid out doesn't go through the cache
+    auto missCount = layoutCache->getMissCount();
+    utils.setViewNodeFrame(child2, 8, 8, 8, 8);
+    root->updateVisibilityAndPerformUpdates(utils.getViewTransactionScope());
+
+    ASSERT_EQ(Frame(16, 16, 16, 16), child1->getCalculatedFrame());
+    ASSERT_EQ(Frame(8, 8, 8, 8), child2->getCalculatedFrame());
+    ASSERT_EQ(static_cast<size_t>(1), layoutCache->getHitCount());
+    ASSERT_EQ(missCount, layoutCache->getMissCount());
+}
+
+class TestMeasureDelegate : public DefaultMeasureDelegate {
+public:
+    explicit TestMeasureDelegate(bool canCache) : _canCache(canCache) {}
+
+    Size onMeasure(const Ref<ValueMap>& attributes,
+                   float /*width*/,
+                   MeasureMode /*widthMode*/,
+                   float /*height*/,
+                   MeasureMode /*heightMode*/,
+                   bool /*isRightToLeft*/) override {
+        measureCount++;
+        const auto& it = attributes->find(STRING_LITERAL("value"));
+        auto width = it != attributes->end() ? it->second.toFloat() : 0.0f;
+        return Size(width, 10);
+    }
+
+    bool canMeasureConcurrently() const override {
+        return true;
+    }
+
+    bool canCacheMeasurement() const override {
+        return _canCache;
+    }
+
+    Value getMeasurementCacheEnvironment() const override {
+        return environment;
+    }
+
+    std::atomic<size_t> measureCount = 0;
+    Value environment;
+
+private:
+    bool _canCache;
+};
+
+static Ref<ViewNode> appendMeasuredLazyLayout(ViewNodeTestsDependencies& utils,
+                                              const Ref<ViewNode>& root,
+                                              double x,
+                                              double measuredWidth) {
+    auto container = utils.createLayout();
+    auto leaf = utils.createNode("MeasuredView");
+
+    container->setPrefersLazyLayout(utils.getViewTransactionScope(), true);
+    root->appendChild(utils.getViewTransactionScope(), container);
+    container->appendChild(utils.getViewTransactionScope(), leaf);
+
+    utils.setViewNodeFrame(container, x, 0, 50, 50);
+    utils.setViewNodeAttribute(leaf, "value", Value(measuredWidth));
+
+    return leaf;
+}
+
+TEST(ViewNode, canReuseCachedLayoutOfMeasuredLeaves) {
+    ViewNodeTestsDependencies utils;
+    auto measureDelegate = makeShared<TestMeasureDelegate>(true);
+    utils.getViewManager().registerMeasuredViewClass(STRING_LITERAL("MeasuredView"), measureDelegate);
+    auto layoutCache = makeShared<LayoutCache>(LayoutCache::kDefaultCapacity);
+    utils.getTree().setLayoutCache(layoutCache);
+
+    auto root = utils.createRootView();
+    auto leaf1 = appendMeasuredLazyLayout(utils, root, 0, 20);
+    auto leaf2 = appendMeasuredLazyLayout(utils, root, 50, 20);
+    auto leaf3 = appendMeasuredLazyLayout(utils, root, 100, 30);
+
+    root->performLayout(utils.getViewTransactionScope(), Size(150, 50), LayoutDirectionLTR);
+    root->updateVisibilityAndPerformUpdates(utils.getViewTransactionScope());
+
+    ASSERT_EQ(Frame(0, 0, 20, 10), leaf1->getCalculatedFrame());
+    ASSERT_EQ(Frame(0, 0, 20, 10), leaf2->getCalculatedFrame());
+    ASSERT_EQ(Frame(0, 0, 30, 10), leaf3->getCalculatedFrame());
+
+    // Only the second lazy layout has the same measured attributes as a previous one
+    ASSERT_EQ(static_cast<size_t>(1), layoutCache->getHitCount());
+}
+
+TEST(ViewNode, doesNotReuseCachedLayoutMeasuredInOtherEnvironment) {
+    ViewNodeTestsDependencies utils;
+    auto measureDelegate = makeShared<TestMeasureDelegate>(true);
+    measureDelegate->environment = Value(1.0);
+    utils.getViewManager().registerMeasuredViewClass(STRING_LITERAL("MeasuredView"), measureDelegate);
+    auto layoutCache = makeShared<LayoutCache>(LayoutCache::kDefaultCapacity);
+    utils.getTree().setLayoutCache(layoutCache);
+
+    auto root = utils.createRootView();
+    appendMeasuredLazyLayout(utils, root, 0, 20);
+
+    root->performLayout(utils.getViewTransactionScope(), Size(100, 50), LayoutDirectionLTR);
+    root->updateVisibilityAndPerformUpdates(utils.getViewTransactionScope());
+
+    ASSERT_EQ(static_cast<size_t>(1), layoutCache->size());
+
+    measureDelegate->environment = Value(2.0);
+    auto leaf = appendMeasuredLazyLayout(utils, root, 50, 20);
+
+    root->performLayout(utils.getViewTransactionScope(), Size(100, 50), LayoutDirectionLTR);
+    root->updateVisibilityAndPerformUpdates(utils.getViewTransactionScope());
+
+    ASSERT_EQ(Frame(0, 0, 20, 10), leaf->getCalculatedFrame());
+    ASSERT_EQ(static_cast<size_t>(0), layoutCache->getHitCount());
+    ASSERT_EQ(static_cast<size_t>(2), layoutCache->size());
+}
+
+TEST(ViewNode, doesNotCacheLayoutOfLeavesWithImpureMeasurements) {
+    ViewNodeTestsDependencies utils;
+    auto measureDelegate = makeShared<TestMeasureDelegate>(false);
+    utils.getViewManager().registerMeasuredViewClass(STRING_LITERAL("MeasuredView"), measureDelegate);
+    auto layoutCache = makeShared<LayoutCache>(LayoutCache::kDefaultCapacity);
+    utils.getTree().setLayoutCache(layoutCache);
+
+    auto root = utils.createRootView();
+    auto leaf1 = appendMeasuredLazyLayout(utils, root, 0, 20);
+    auto leaf2 = appendMeasuredLazyLayout(utils, root, 50, 20);
+
+    root->performLayout(utils.getViewTransactionScope(), Size(100, 50), LayoutDirectionLTR);
+    root->updateVisibilityAndPerformUpdates(utils.getViewTransactionScope());
+
+    ASSERT_EQ(Frame(0, 0, 20, 10), leaf1->getCalculatedFrame());
+    ASSERT_EQ(Frame(0, 0, 20, 10), leaf2->getCalculatedFrame());
+    ASSERT_EQ(static_cast<size_t>(0), layoutCache->getHitCount());
+    ASSERT_EQ(static_cast<size_t>(0), layoutCache->size());
+}
+
+/**
+ Blocks every measurement until another one is in flight, which only happens
+ when the lazy layouts are calculated concurrently.
+ */
+class ConcurrentTestMeasureDelegate : public TestMeasureDelegate {
+public:
+    ConcurrentTestMeasureDelegate() : TestMeasureDelegate(false) {}
+
+    Size onMeasure(const Ref<ValueMap>& attributes,
+                   float width,
+                   MeasureMode widthMode,
+                   float height,
+                   MeasureMode heightMode,
+                   bool isRightToLeft) override {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _inFlightCount++;
+            if (_inFlightCount > 1) {
+                _didMeasureConcurrently = true;
+                _condition.notify_all();
+            }
+
+            if (_waitsForConcurrentMeasure) {
+                // Bounded so that a layout calculated serially fails the test instead of hanging it
+                _condition.wait_for(lock, std::chrono::seconds(5), [&]() { return _didMeasureConcurrently; });
+            }
+        }
+
+        auto size = TestMeasureDelegate::onMeasure(attributes, width, widthMode, height, heightMode, isRightToLeft);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _inFlightCount--;
+        return size;
+    }
+
+    void setWaitsForConcurrentMeasure(bool waitsForConcurrentMeasure) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _waitsForConcurrentMeasure = waitsForConcurrentMeasure;
+    }
+
+    bool didMeasureConcurrently() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _didMeasureConcurrently;
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    size_t _inFlightCount = 0;
+    bool _waitsForConcurrentMeasure = false;
+    bool _didMeasureConcurrently = false;
+};
+
+TEST(ViewNode, canCalculateLazyLayoutsConcurrently) {
+    ViewNodeTestsDependencies utils;
+    auto measureDelegate = makeShared<ConcurrentTestMeasureDelegate>();
+    utils.getViewManager().registerMeasuredViewClass(STRING_LITERAL("MeasuredView"), measureDelegate);
+    utils.getTree().setLayoutQueue(
+        DispatchQueue::createPool(STRING_LITERAL("Valdi Layout Test"), ThreadQoSClassHigh, 2));
+
+    auto root = utils.createRootView();
+    auto leaf1 = appendMeasuredLazyLayout(utils, root, 0, 20);
+    auto leaf2 = appendMeasuredLazyLayout(utils, root, 50, 30);
+
+    root->performLayout(utils.getViewTransactionScope(), Size(100, 50), LayoutDirectionLTR);
+    root->updateVisibilityAndPerformUpdates(utils.getViewTransactionScope());
+
+    ASSERT_EQ(Frame(0, 0, 20, 10), leaf1->getCalculatedFrame());
+    ASSERT_EQ(Frame(0, 0, 30, 10), leaf2->getCalculatedFrame());
+
+    // Updating both visible lazy layouts should measure their leaves together
+    measureDelegate->setWaitsForConcurrentMeasure(true);
+    utils.setViewNodeAttribute(leaf1, "value", Value(24.0));
+    utils.setViewNodeAttribute(leaf2, "value", Value(34.0));
+
+    ASSERT_TRUE(root->isLazyLayoutDirty());
+
+    root->updateVisibilityAndPerformUpdates(utils.getViewTransactionScope());
+
+    ASSERT_FALSE(root->isLazyLayoutDirty());
+    ASSERT_TRUE(measureDelegate->didMeasureConcurrently());
+    ASSERT_EQ(Frame(0, 0, 24, 10), leaf1->getCalculatedFrame());
+    ASSERT_EQ(Frame(0, 0, 34, 10), leaf2->getCalculatedFrame());
+}
+
+TEST(ViewNode, concurrentLazyLayoutsUseLayoutCache) {
+    ViewNodeTestsDependencies utils;
+    auto measureDelegate = makeShared<TestMeasureDelegate>(true);
+    utils.getViewManager().registerMeasuredViewClass(STRING_LITERAL("MeasuredView"), measureDelegate);
+    auto layoutCache = makeShared<LayoutCache>(LayoutCache::kDefaultCapacity);
+    utils.getTree().setLayoutCache(layoutCache);
+    utils.getTree().setLayoutQueue(
+        DispatchQueue::createPool(STRING_LITERAL("Valdi Layout Test"), ThreadQoSClassHigh, 2));
+
+    auto root = utils.createRootView();
+    auto leaf1 = appendMeasuredLazyLayout(utils, root, 0, 20);
+    auto leaf2 = appendMeasuredLazyLayout(utils, root, 50, 30);
+
+    root->performLayout(utils.getViewTransactionScope(), Size(200, 50), LayoutDirectionLTR);
+    root->updateVisibilityAndPerformUpdates(utils.getViewTransactionScope());
+
+    ASSERT_EQ(static_cast<size_t>(0), layoutCache->getHitCount());
+    ASSERT_EQ(static_cast<size_t>(2), layoutCache->size());
+    size_t measureCount = measureDelegate->measureCount;
+
+    // Identical lazy layouts are restored from the cache instead of being measured again
+    auto leaf3 = appendMeasuredLazyLayout(utils, root, 100, 20);
+    auto leaf4 = appendMeasuredLazyLayout(utils, root, 150, 30);
+
+    root->performLayout(utils.getViewTransactionScope(), Size(200, 50), LayoutDirectionLTR);
+    root->updateVisibilityAndPerformUpdates(utils.getViewTransactionScope());
+
+    ASSERT_EQ(static_cast<size_t>(2), layoutCache->getHitCount());
+    ASSERT_EQ(measureCount, measureDelegate->measureCount.load());
+    ASSERT_EQ(Frame(0, 0, 20, 10), leaf1->getCalculatedFrame());
+    ASSERT_EQ(Frame(0, 0, 30, 10), leaf2->getCalculatedFrame());
+    ASSERT_EQ(Frame(0, 0, 20, 10), leaf3->getCalculatedFrame());
+    ASSERT_EQ(Frame(0, 0, 30, 10), leaf4->getCalculatedFrame());
+}
+
 // TODO(simon): This test fails because we are not currently able to recover from switching
 // from non lazyLayout to lazyLayout after layout attributes have been applied.
 TEST(ViewNode, DISABLED_canToggleLazyLayout) {
@@ -0,0 +1,74 @@
+#include "snap_drawing/cpp/Resources.hpp"
+#include "snap_drawing/cpp/Text/FontManager.hpp"
+#include "valdi/runtime/Attributes/AssetAttributes.hpp"
+#include "valdi/runtime/Attributes/AttributeIds.hpp"
+#include "valdi/snap_drawing/Layers/Classes/TextLayerClass.hpp"
+#include "valdi_core/cpp/Utils/ConsoleLogger.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace Valdi;
+using namespace snap::drawing;
+
+namespace ValdiTest {
+
+class TextMeasureDelegateTests : public ::testing::Test {
+protected:
+    void SetUp() override {
+        _fontManager = makeShared<FontManager>(ConsoleLogger::getLogger());
+        _resources = makeShared<Resources>(_fontManager, 2.0f, ConsoleLogger::getLogger());
+        _textLayerClass = makeShared<TextLayerClass>(_resources, nullptr);
+    }
+
+    Ref<FontManager> _fontManager;
+    Ref<Resources> _resources;
+    Ref<TextLayerClass> _textLayerClass;
+};
+
+TEST_F(TextMeasureDelegateTests, canCacheMeasurement) {
+    ASSERT_TRUE(_textLayerClass->canCacheMeasurement());
+    ASSERT_EQ(_textLayerClass->getMeasurementCacheEnvironment(), _textLayerClass->getMeasurementCacheEnvironment());
+}
+
+TEST_F(TextMeasureDelegateTests, environmentChangesWithDynamicType) {
+    auto environment = _textLayerClass->getMeasurementCacheEnvironment();
+
+    _resources->setDynamicTypeScale(1.5f);
+    auto scaledEnvironment = _textLayerClass->getMeasurementCacheEnvironment();
+    ASSERT_NE(environment, scaledEnvironment);
+
+    _resources->setRespectDynamicType(!_resources->getRespectDynamicType());
+    ASSERT_NE(scaledEnvironment, _textLayerClass->getMeasurementCacheEnvironment());
+}
+
+TEST_F(TextMeasureDelegateTests, environmentChangesWithDisplayScale) {
+    auto environment = _textLayerClass->getMeasurementCacheEnvironment();
+
+    _resources->setDisplayScale(3.0f);
+
+    ASSERT_NE(environment, _textLayerClass->getMeasurementCacheEnvironment());
+}
+
+TEST_F(TextMeasureDelegateTests, environmentChangesWhenTypefaceIsRegistered) {
+    auto environment = _textLayerClass->getMeasurementCacheEnvironment();
+
+    _fontManager->registerTypeface(STRING_LITERAL("TestFont"),
+                                   FontStyle(FontWidthNormal, FontWeightNormal, FontSlantUpright),
+                                   true,
+                                   BytesView());
+
+    ASSERT_NE(environment, _textLayerClass->getMeasurementCacheEnvironment());
+}
+
+TEST(AssetMeasureDelegate, cannotCacheMeasurement) {
+    AttributeIds attributeIds;
+    AttributeHandlerById handlers;
+    Ref<MeasureDelegate> measureDelegate;
+
+    AssetAttributes(attributeIds, snap::valdi_core::AssetOutputType::Image).bind(handlers, measureDelegate);
+
+    ASSERT_TRUE(measureDelegate != nullptr);
+    ASSERT_FALSE(measureDelegate->canCacheMeasurement());
+}
+
+} // namespace ValdiTest
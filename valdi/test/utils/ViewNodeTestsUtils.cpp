@@ -44,6 +44,10 @@ ViewNodeTree& ViewNodeTestsDependencies::getTree() const {
     return *_tree;
 }
 
+AttributeIds& ViewNodeTestsDependencies::getAttributeIds() {
+    return _attributesManager.getAttributeIds();
+}
+
 ViewTransactionScope& ViewNodeTestsDependencies::getViewTransactionScope() {
     return *_viewTransactionScope;
 }
@@ -29,6 +29,7 @@ public:
     ~ViewNodeTestsDependencies();
 
     ViewNodeTree& getTree() const;
+    AttributeIds& getAttributeIds();
 
     Ref<ViewNode> createNode(const char* viewClassName);
     Ref<ViewNode> createView();
@@ -7,6 +7,7 @@
 
 #include "valdi_core/cpp/Attributes/ColorPalette.hpp"
 #include "valdi_core/cpp/Utils/StringCache.hpp"
+#include <atomic>
 #include <fmt/format.h>
 
 namespace Valdi {
@@ -175,7 +176,12 @@ std::vector<std::pair<std::string_view, int64_t>> getDefaultColors() {
     };
 }
 
-ColorPalette::ColorPalette() {
+static uint64_t makeColorPaletteId() {
+    static std::atomic<uint64_t> kNextId = 1;
+    return kNextId.fetch_add(1, std::memory_order_relaxed);
+}
+
+ColorPalette::ColorPalette() : _id(makeColorPaletteId()) {
     for (const auto& it : getDefaultColors()) {
         setColorForName(StringCache::getGlobal().makeString(it.first), it.second);
     }
@@ -225,6 +231,10 @@ const FlatMap<StringBox, Color>& ColorPalette::getColors() const {
     return _colorByName;
 }
 
+uint64_t ColorPalette::getId() const {
+    return _id;
+}
+
 void ColorPalette::setListener(ColorPaletteListener* listener) {
     _listener = listener;
 }
@@ -77,11 +77,18 @@ public:
     std::optional<Color> getColorForName(const StringBox& name) const;
     const FlatMap<StringBox, Color>& getColors() const;
 
+    /**
+     Returns an id which uniquely identifies this palette for the lifetime of the process.
+     Unlike the address of the palette, the id is never reused after the palette is destroyed.
+     */
+    uint64_t getId() const;
+
     void updateColors(const FlatMap<StringBox, Color>& colors);
 
     void setListener(ColorPaletteListener* listener);
 
 private:
+    uint64_t _id;
     FlatMap<StringBox, Color> _colorByName;
     ColorPaletteListener* _listener = nullptr;
 
@@ -6,7 +6,9 @@
 //
 
 #include "valdi_core/cpp/Threading/DispatchQueue.hpp"
+#include "valdi_core/cpp/Threading/ThreadPoolDispatchQueue.hpp"
 #include "valdi_core/cpp/Threading/ThreadedDispatchQueue.hpp"
+#include <algorithm>
 #include <future>
 
 #if __APPLE__
@@ -40,10 +42,19 @@ Ref<DispatchQueue> DispatchQueue::createThreaded(const StringBox& name, ThreadQo
     return Valdi::makeShared<ThreadedDispatchQueue>(name, qosClass);
 }
 
+Ref<DispatchQueue> DispatchQueue::createPool(const StringBox& name, ThreadQoSClass qosClass, size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    return Valdi::makeShared<ThreadPoolDispatchQueue>(name, qosClass, threadCount);
+}
+
 void DispatchQueue::setQoSClass(ThreadQoSClass qosClass) {}
 
 void DispatchQueue::setDisableSyncCallsInCallingThread(bool disableSyncCallsInCallingThread) {}
 
+void DispatchQueue::setInstrumentationEnabled(bool instrumentationEnabled) {}
+
 static DispatchQueue* kMain = nullptr;
 
 void DispatchQueue::setMain(const Ref<DispatchQueue>& main) {
@@ -67,7 +78,12 @@ DispatchQueue* DispatchQueue::getCurrent() {
         return queue;
     }
 
-    return ThreadedDispatchQueue::getCurrent();
+    auto* threadedQueue = ThreadedDispatchQueue::getCurrent();
+    if (threadedQueue != nullptr) {
+        return threadedQueue;
+    }
+
+    return ThreadPoolDispatchQueue::getCurrent();
 }
 
 #else
@@ -77,7 +93,12 @@ Ref<DispatchQueue> DispatchQueue::create(const StringBox& name, ThreadQoSClass q
 }
 
 DispatchQueue* DispatchQueue::getCurrent() {
-    return ThreadedDispatchQueue::getCurrent();
+    auto* threadedQueue = ThreadedDispatchQueue::getCurrent();
+    if (threadedQueue != nullptr) {
+        return threadedQueue;
+    }
+
+    return ThreadPoolDispatchQueue::getCurrent();
 }
 
 #endif
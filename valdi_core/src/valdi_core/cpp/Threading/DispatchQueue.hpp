@@ -14,6 +14,7 @@
 #include "valdi_core/cpp/Utils/Function.hpp"
 #include "valdi_core/cpp/Utils/Shared.hpp"
 #include "valdi_core/cpp/Utils/StringBox.hpp"
+#include <atomic>
 #include <chrono>
 #include <string>
 #include <thread>
@@ -39,7 +40,7 @@ public:
      */
     virtual bool isCurrent() const = 0;
 
-    bool isRunningSync() const;
+    virtual bool isRunningSync() const;
 
     /**
      Synchronously flush the queue and destroy it
@@ -55,6 +56,10 @@ public:
     static Ref<DispatchQueue> create(const StringBox& name, ThreadQoSClass qosClass);
     // Create a DispatchQueue that is always backed by a single thread.
     static Ref<DispatchQueue> createThreaded(const StringBox& name, ThreadQoSClass qosClass);
+    // Create a concurrent DispatchQueue backed by threadCount threads which steal work from each other.
+    // Tasks are not serialized: only use it for independent tasks. A threadCount of 0 uses one thread
+    // per available core.
+    static Ref<DispatchQueue> createPool(const StringBox& name, ThreadQoSClass qosClass, size_t threadCount);
 
     static DispatchQueue* getCurrent();
     static DispatchQueue* getMain();
@@ -65,8 +70,15 @@ public:
 
     virtual void setDisableSyncCallsInCallingThread(bool disableSyncCallsInCallingThread);
 
+    /**
+     Enable recording of the wait time, run time and depth of the tasks, which
+     can then be retrieved through DispatchQueueInstrumentation using the queue name.
+     Not all queue implementations support it.
+     */
+    virtual void setInstrumentationEnabled(bool instrumentationEnabled);
+
 protected:
-    bool _runningSync = false;
+    std::atomic_bool _runningSync = false;
 };
 
 } // namespace Valdi
@@ -0,0 +1,112 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi_core/cpp/Threading/DispatchQueueInstrumentation.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+namespace Valdi {
+
+struct DispatchQueueInstrumentations {
+    std::mutex mutex;
+    std::vector<DispatchQueueInstrumentation*> instrumentations;
+};
+
+static DispatchQueueInstrumentations& getInstrumentations() {
+    // Leaked on purpose, queues can be destroyed during static destruction
+    static auto* instrumentations = new DispatchQueueInstrumentations();
+    return *instrumentations;
+}
+
+static uint64_t toMicroseconds(std::chrono::steady_clock::duration duration) {
+    auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    return microseconds > 0 ? static_cast<uint64_t>(microseconds) : 0;
+}
+
+void DispatchQueueStatistics::merge(const DispatchQueueStatistics& other) {
+    waitTimeMicros.merge(other.waitTimeMicros);
+    runTimeMicros.merge(other.runTimeMicros);
+    maxDepth = std::max(maxDepth, other.maxDepth);
+}
+
+DispatchQueueInstrumentation::DispatchQueueInstrumentation(const StringBox& name) : _name(name), _maxDepth(0) {
+    auto& instrumentations = getInstrumentations();
+    std::lock_guard<std::mutex> lock(instrumentations.mutex);
+    instrumentations.instrumentations.emplace_back(this);
+}
+
+DispatchQueueInstrumentation::~DispatchQueueInstrumentation() {
+    auto& instrumentations = getInstrumentations();
+    std::lock_guard<std::mutex> lock(instrumentations.mutex);
+    auto& all = instrumentations.instrumentations;
+    all.erase(std::remove(all.begin(), all.end(), this), all.end());
+}
+
+const StringBox& DispatchQueueInstrumentation::getName() const {
+    return _name;
+}
+
+void DispatchQueueInstrumentation::onTaskEnqueued(size_t depth) {
+    auto currentMax = _maxDepth.load(std::memory_order_relaxed);
+    while (depth > currentMax && !_maxDepth.compare_exchange_weak(currentMax, depth, std::memory_order_relaxed)) {
+    }
+}
+
+void DispatchQueueInstrumentation::onTaskStarted(std::chrono::steady_clock::duration waitTime) {
+    _waitTime.record(toMicroseconds(waitTime));
+}
+
+void DispatchQueueInstrumentation::onTaskCompleted(std::chrono::steady_clock::duration runTime) {
+    _runTime.record(toMicroseconds(runTime));
+}
+
+DispatchQueueStatistics DispatchQueueInstrumentation::getStatistics() const {
+    DispatchQueueStatistics statistics;
+    statistics.name = _name;
+    statistics.waitTimeMicros = _waitTime.snapshot();
+    statistics.runTimeMicros = _runTime.snapshot();
+    statistics.maxDepth = _maxDepth.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+std::vector<DispatchQueueStatistics> DispatchQueueInstrumentation::getAllStatistics() {
+    std::vector<DispatchQueueStatistics> allStatistics;
+
+    auto& instrumentations = getInstrumentations();
+    std::lock_guard<std::mutex> lock(instrumentations.mutex);
+    for (const auto* instrumentation : instrumentations.instrumentations) {
+        auto it = std::find_if(allStatistics.begin(), allStatistics.end(), [&](const auto& statistics) {
+            return statistics.name == instrumentation->getName();
+        });
+
+        if (it == allStatistics.end()) {
+            allStatistics.emplace_back(instrumentation->getStatistics());
+        } else {
+            it->merge(instrumentation->getStatistics());
+        }
+    }
+
+    return allStatistics;
+}
+
+std::optional<DispatchQueueStatistics> DispatchQueueInstrumentation::getStatistics(const StringBox& name) {
+    std::optional<DispatchQueueStatistics> output;
+
+    auto& instrumentations = getInstrumentations();
+    std::lock_guard<std::mutex> lock(instrumentations.mutex);
+    for (const auto* instrumentation : instrumentations.instrumentations) {
+        if (instrumentation->getName() != name) {
+            continue;
+        }
+
+        if (output) {
+            output->merge(instrumentation->getStatistics());
+        } else {
+            output = instrumentation->getStatistics();
+        }
+    }
+
+    return output;
+}
+
+} // namespace Valdi
@@ -0,0 +1,60 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "valdi_core/cpp/Utils/ConcurrentHistogram.hpp"
+#include "valdi_core/cpp/Utils/Shared.hpp"
+#include "valdi_core/cpp/Utils/StringBox.hpp"
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <vector>
+
+namespace Valdi {
+
+struct DispatchQueueStatistics {
+    StringBox name;
+    // Time between when a task was due and when it started running
+    HistogramSnapshot waitTimeMicros;
+    // Time spent running each task
+    HistogramSnapshot runTimeMicros;
+    // Highest number of tasks that were ready to run at the same time
+    size_t maxDepth = 0;
+
+    void merge(const DispatchQueueStatistics& other);
+};
+
+/**
+ Collects wait time, run time and depth statistics of the tasks of a dispatch queue.
+ Every instance is registered globally while alive so that statistics can be
+ retrieved by queue name, without holding onto the queues themselves.
+ */
+class DispatchQueueInstrumentation : public SimpleRefCountable {
+public:
+    explicit DispatchQueueInstrumentation(const StringBox& name);
+    ~DispatchQueueInstrumentation() override;
+
+    const StringBox& getName() const;
+
+    void onTaskEnqueued(size_t depth);
+    void onTaskStarted(std::chrono::steady_clock::duration waitTime);
+    void onTaskCompleted(std::chrono::steady_clock::duration runTime);
+
+    DispatchQueueStatistics getStatistics() const;
+
+    /**
+     Returns the statistics of every instrumented queue, queues sharing
+     the same name are combined.
+     */
+    static std::vector<DispatchQueueStatistics> getAllStatistics();
+
+    static std::optional<DispatchQueueStatistics> getStatistics(const StringBox& name);
+
+private:
+    StringBox _name;
+    ConcurrentHistogram _waitTime;
+    ConcurrentHistogram _runTime;
+    std::atomic_size_t _maxDepth;
+};
+
+} // namespace Valdi
@@ -0,0 +1,95 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include <atomic>
+
+namespace Valdi {
+
+/**
+ An intrusive, unbounded multi-producer single-consumer queue, based on Dmitry Vyukov's algorithm.
+ T must be default constructible and expose a "std::atomic<T*> next" member.
+
+ push() is lock-free and can be called from any thread. peek(), pop() and forEach() must only
+ be called from a single consumer at a time, which is typically ensured by a lock held by the consumer.
+ pop() can spuriously return nullptr while a producer is in the middle of a push(). Callers which know
+ that a node is available can retry.
+ The queue does not own its nodes.
+ */
+template<typename T>
+class MPSCQueue {
+public:
+    MPSCQueue() : _head(&_stub), _tail(&_stub) {}
+    MPSCQueue(const MPSCQueue& other) = delete;
+
+    void push(T* node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        auto* previous = _head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    T* peek() {
+        auto* tail = _tail;
+        if (tail == &_stub) {
+            auto* next = tail->next.load(std::memory_order_acquire);
+            if (next == nullptr) {
+                return nullptr;
+            }
+            _tail = next;
+            tail = next;
+        }
+
+        return tail;
+    }
+
+    T* pop() {
+        auto* tail = peek();
+        if (tail == nullptr) {
+            return nullptr;
+        }
+
+        auto* next = tail->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            _tail = next;
+            return tail;
+        }
+
+        if (tail != _head.load(std::memory_order_acquire)) {
+            // A producer is in the middle of a push
+            return nullptr;
+        }
+
+        // tail is the last node, push the stub behind it so that it can be detached.
+        push(&_stub);
+
+        next = tail->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            _tail = next;
+            return tail;
+        }
+
+        return nullptr;
+    }
+
+    /**
+     Iterate over the nodes currently reachable from the consumer side, in FIFO order.
+     Iteration stops when the callback returns false.
+     */
+    template<typename F>
+    void forEach(F&& callback) {
+        auto* node = peek();
+        while (node != nullptr) {
+            if (node != &_stub && !callback(node)) {
+                return;
+            }
+            node = node->next.load(std::memory_order_acquire);
+        }
+    }
+
+private:
+    std::atomic<T*> _head;
+    T* _tail;
+    T _stub;
+};
+
+} // namespace Valdi
@@ -10,28 +10,69 @@
 
 #include "valdi_core/cpp/Constants.hpp"
 
+#include <algorithm>
 #include <pthread.h>
+#include <thread>
 
 namespace Valdi {
 
+// Compact the delayed tasks heap once it has more tombstones than this
+// and more tombstones than live tasks.
+constexpr size_t kMinDelayedTasksTombstonesBeforeCompaction = 32;
+
+TaskQueue::Task::Task() = default;
+
 TaskQueue::Task::Task(task_id_t id,
                       DispatchFunction function,
                       std::chrono::steady_clock::time_point executeTime,
                       bool isBarrier)
     : id(id), function(std::move(function)), executeTime(executeTime), isBarrier(isBarrier) {}
 
-TaskQueue::TaskQueue() : _disposed(false) {}
+template<typename T>
+static bool isTaskBefore(const T& a, const T& b) {
+    if (a.executeTime == b.executeTime) {
+        return a.id < b.id;
+    }
+    return a.executeTime < b.executeTime;
+}
+
+template<typename T>
+static bool delayedTaskHeapComparator(const std::unique_ptr<T>& a, const std::unique_ptr<T>& b) {
+    // std::push_heap/pop_heap build a max heap, reverse the comparison to get the earliest task at the top
+    return isTaskBefore(*b, *a);
+}
+
+TaskQueue::TaskQueue()
+    : _disposed(false),
+      _first(true),
+      _taskIdCounter(0),
+      _immediateTasksCount(0),
+      _waitingConsumers(0),
+      _activeInstrumentation(nullptr) {}
 
 TaskQueue::~TaskQueue() {
     dispose();
+
+    // Release the tasks that might have been pushed concurrently with dispose()
+    while (_immediateTasksCount > 0) {
+        lockFreePopImmediateTask();
+    }
 }
 
 void TaskQueue::dispose() {
     if (!_disposed) {
         _disposed = true;
-        std::deque<Task> toDelete;
+        std::vector<std::unique_ptr<Task>> toDelete;
         _mutex.lock();
-        toDelete.swap(_tasks);
+        while (_immediateTasksCount > 0) {
+            toDelete.emplace_back(lockFreePopImmediateTask());
+        }
+        for (auto& task : _delayedTasks) {
+            toDelete.emplace_back(std::move(task));
+        }
+        _delayedTasks.clear();
+        _delayedTasksById.clear();
+        _delayedTasksTombstones = 0;
         _mutex.unlock();
         _condition.notifyAll();
     }
@@ -57,23 +98,15 @@ EnqueuedTask TaskQueue::enqueue(Valdi::DispatchFunction function, std::chrono::s
     return enqueue(std::move(function), std::chrono::steady_clock::now() + delay);
 }
 
-task_id_t TaskQueue::insertTask(DispatchFunction&& function,
-                                std::chrono::steady_clock::time_point executeTime,
-                                bool isBarrier) {
+task_id_t TaskQueue::pushImmediateTask(DispatchFunction&& function,
+                                       std::chrono::steady_clock::time_point executeTime,
+                                       bool isBarrier,
+                                       size_t* previousCount) {
     auto id = ++_taskIdCounter;
-
-    // Keep the tasks sorted by execute time
-    Task task(id, std::move(function), executeTime, isBarrier);
-
-    auto it = std::upper_bound(_tasks.begin(), _tasks.end(), task, [](const Task& a, const Task& b) {
-        if (a.executeTime == b.executeTime) {
-            return a.id < b.id;
-        }
-        return a.executeTime < b.executeTime;
-    });
-
-    _tasks.emplace(it, std::move(task));
-
+    _immediateTasks.push(new Task(id, std::move(function), executeTime, isBarrier));
+    // The count is only incremented once the task is fully pushed, consumers rely on it
+    // to know that pop() will eventually succeed.
+    *previousCount = _immediateTasksCount.fetch_add(1);
     return id;
 }
 
@@ -84,56 +117,201 @@ EnqueuedTask TaskQueue::enqueue(Valdi::DispatchFunction function, std::chrono::s
         return enqueuedTask;
     }
 
-    {
-        std::lock_guard<Mutex> lockGuard(_mutex);
+    if (_first.load(std::memory_order_relaxed)) {
+        enqueuedTask.isFirst = _first.exchange(false);
+    }
+
+    if (executeTime <= std::chrono::steady_clock::now()) {
+        size_t previousCount;
+        enqueuedTask.id = pushImmediateTask(std::move(function), executeTime, false, &previousCount);
 
-        enqueuedTask.id = insertTask(std::move(function), executeTime, false);
-        enqueuedTask.isFirst = _first;
-        _first = false;
+        auto* instrumentation = _activeInstrumentation.load(std::memory_order_relaxed);
+        if (instrumentation != nullptr) {
+            instrumentation->onTaskEnqueued(previousCount + 1);
+        }
 
-        if (_empty) {
-            _empty = false;
-            if (_listener != nullptr) {
-                _listener->onQueueNonEmpty();
+        // Only take the lock when the queue might transition from empty to non empty,
+        // or if a consumer needs to be woken up.
+        if (previousCount == 0 || _waitingConsumers.load() != 0) {
+            {
+                std::lock_guard<Mutex> lockGuard(_mutex);
+                lockFreeMarkNonEmpty();
             }
+            _condition.notifyAll();
         }
+
+        return enqueuedTask;
+    }
+
+    {
+        std::lock_guard<Mutex> lockGuard(_mutex);
+
+        auto id = ++_taskIdCounter;
+        auto task = std::make_unique<Task>(id, std::move(function), executeTime, false);
+        _delayedTasksById[id] = task.get();
+        _delayedTasks.emplace_back(std::move(task));
+        std::push_heap(_delayedTasks.begin(), _delayedTasks.end(), &delayedTaskHeapComparator<Task>);
+
+        enqueuedTask.id = id;
+        lockFreeMarkNonEmpty();
     }
 
     _condition.notifyAll();
     return enqueuedTask;
 }
 
+void TaskQueue::lockFreeMarkNonEmpty() {
+    if (_empty) {
+        _empty = false;
+        if (_listener != nullptr) {
+            _listener->onQueueNonEmpty();
+        }
+    }
+}
+
 void TaskQueue::cancel(Valdi::task_id_t taskId) {
     {
         DispatchFunction toDelete;
         std::lock_guard<Mutex> lockGuard(_mutex);
-        toDelete = lockFreeRemoveTask(taskId);
+        toDelete = lockFreeCancelTask(taskId);
     }
 
     _condition.notifyAll();
 }
 
-DispatchFunction TaskQueue::lockFreeRemoveTask(task_id_t taskId) {
-    for (auto i = _tasks.begin(); i != _tasks.end(); ++i) {
-        if (i->id == taskId) {
-            auto task = std::move(*i);
-            _tasks.erase(i);
-            return std::move(task.function);
+DispatchFunction TaskQueue::lockFreeCancelTask(task_id_t taskId) {
+    const auto& it = _delayedTasksById.find(taskId);
+    if (it != _delayedTasksById.end()) {
+        auto* task = it->second;
+        _delayedTasksById.erase(it);
+        task->cancelled = true;
+        auto function = std::move(task->function);
+        _delayedTasksTombstones++;
+        lockFreeCompactDelayedTasks();
+        return function;
+    }
+
+    // Immediate tasks are expected to be consumed quickly and are rarely cancelled,
+    // so we just look them up in the pending list.
+    DispatchFunction function;
+    _immediateTasks.forEach([&](Task* task) {
+        if (task->id == taskId) {
+            if (!task->cancelled) {
+                task->cancelled = true;
+                function = std::move(task->function);
+            }
+            return false;
         }
+        return true;
+    });
+
+    return function;
+}
+
+void TaskQueue::lockFreeCompactDelayedTasks() {
+    if (_delayedTasksTombstones < kMinDelayedTasksTombstonesBeforeCompaction ||
+        _delayedTasksTombstones < _delayedTasksById.size()) {
+        return;
     }
 
-    return DispatchFunction();
+    _delayedTasks.erase(std::remove_if(_delayedTasks.begin(),
+                                       _delayedTasks.end(),
+                                       [](const std::unique_ptr<Task>& task) { return task->cancelled; }),
+                        _delayedTasks.end());
+    std::make_heap(_delayedTasks.begin(), _delayedTasks.end(), &delayedTaskHeapComparator<Task>);
+    _delayedTasksTombstones = 0;
+}
+
+std::unique_ptr<TaskQueue::Task> TaskQueue::lockFreePopImmediateTask() {
+    Task* task;
+    // We only get here when we know that a task was pushed. pop() can fail spuriously
+    // if another producer is in the middle of pushing, in which case we just retry.
+    while ((task = _immediateTasks.pop()) == nullptr) {
+        std::this_thread::yield();
+    }
+    _immediateTasksCount.fetch_sub(1);
+    return std::unique_ptr<Task>(task);
+}
+
+TaskQueue::Task* TaskQueue::lockFreePeekImmediateTask() {
+    while (_immediateTasksCount.load() > 0) {
+        auto* task = _immediateTasks.peek();
+        if (task == nullptr) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        if (!task->cancelled) {
+            return task;
+        }
+
+        lockFreePopImmediateTask();
+    }
+
+    return nullptr;
+}
+
+TaskQueue::Task* TaskQueue::lockFreePeekDelayedTask() {
+    while (!_delayedTasks.empty()) {
+        auto* task = _delayedTasks.front().get();
+        if (!task->cancelled) {
+            return task;
+        }
+
+        std::pop_heap(_delayedTasks.begin(), _delayedTasks.end(), &delayedTaskHeapComparator<Task>);
+        _delayedTasks.pop_back();
+        _delayedTasksTombstones--;
+    }
+
+    return nullptr;
+}
+
+TaskQueue::Task* TaskQueue::lockFreePeekNextTask() {
+    auto* immediateTask = lockFreePeekImmediateTask();
+    auto* delayedTask = lockFreePeekDelayedTask();
+
+    if (immediateTask == nullptr) {
+        return delayedTask;
+    }
+    if (delayedTask == nullptr) {
+        return immediateTask;
+    }
+
+    return isTaskBefore(*delayedTask, *immediateTask) ? delayedTask : immediateTask;
+}
+
+std::unique_ptr<TaskQueue::Task> TaskQueue::lockFreePopTask(Task* task) {
+    if (!_delayedTasks.empty() && _delayedTasks.front().get() == task) {
+        std::pop_heap(_delayedTasks.begin(), _delayedTasks.end(), &delayedTaskHeapComparator<Task>);
+        auto delayedTask = std::move(_delayedTasks.back());
+        _delayedTasks.pop_back();
+        _delayedTasksById.erase(delayedTask->id);
+        return delayedTask;
+    }
+
+    return lockFreePopImmediateTask();
 }
 
 void TaskQueue::barrier(const DispatchFunction& function) {
     auto executeTime = std::chrono::steady_clock::now();
 
     std::unique_lock<Mutex> lockGuard(_mutex);
-    auto id = insertTask(DispatchFunction(), executeTime, true);
+    if (_disposed) {
+        return;
+    }
+
+    size_t previousCount;
+    auto id = pushImmediateTask(DispatchFunction(), executeTime, true, &previousCount);
+    lockFreeMarkNonEmpty();
+
+    while (!_disposed) {
+        auto* nextTask = lockFreePeekNextTask();
+        if (nextTask == nullptr) {
+            return;
+        }
 
-    while (!_tasks.empty()) {
         // Wait until we have no currently running tasks, and that the task at the front is our barrier task
-        if (_currentRunningTasks != 0 || _tasks.front().id != id) {
+        if (_currentRunningTasks != 0 || nextTask->id != id) {
             _condition.wait(lockGuard);
             continue;
         }
@@ -144,7 +322,7 @@ void TaskQueue::barrier(const DispatchFunction& function) {
         lockGuard.unlock();
         function();
         lockGuard.lock();
-        auto toDelete = lockFreeRemoveTask(id);
+        auto toDelete = lockFreePopTask(nextTask);
         _currentRunningTasks--;
         lockGuard.unlock();
         _condition.notifyAll();
@@ -154,10 +332,15 @@ void TaskQueue::barrier(const DispatchFunction& function) {
 
 DispatchFunction TaskQueue::nextTask(std::chrono::steady_clock::time_point maxTime, bool* shouldRun) {
     std::unique_lock<Mutex> lockGuard(_mutex);
-    bool hasTask = false;
+    Task* nextTask = nullptr;
+
+    // Let the producers know that they need to wake us up
+    _waitingConsumers.fetch_add(1);
 
     while (!_disposed) {
-        if (_tasks.empty()) {
+        nextTask = lockFreePeekNextTask();
+
+        if (nextTask == nullptr) {
             if (!_empty) {
                 _empty = true;
                 if (_listener != nullptr) {
@@ -188,8 +371,7 @@ DispatchFunction TaskQueue::nextTask(std::chrono::steady_clock::time_point maxTi
         }
 
         // Wait until the next task is ready to run
-        const auto& nextTask = _tasks.front();
-        if (VALDI_UNLIKELY(nextTask.isBarrier)) {
+        if (VALDI_UNLIKELY(nextTask->isBarrier)) {
             auto result = _condition.waitUntil(lockGuard, maxTime);
 
             if (result == std::cv_status::timeout) {
@@ -197,8 +379,8 @@ DispatchFunction TaskQueue::nextTask(std::chrono::steady_clock::time_point maxTi
             } else {
                 continue;
             }
-        } else if (nextTask.executeTime > std::chrono::steady_clock::now()) {
-            auto maxTimeToWait = std::min(maxTime, nextTask.executeTime);
+        } else if (nextTask->executeTime > std::chrono::steady_clock::now()) {
+            auto maxTimeToWait = std::min(maxTime, nextTask->executeTime);
 
             auto result = _condition.waitUntil(lockGuard, maxTimeToWait);
 
@@ -211,19 +393,22 @@ DispatchFunction TaskQueue::nextTask(std::chrono::steady_clock::time_point maxTi
         }
 
         // The next task is ready
-        hasTask = true;
-        break;
-    }
+        _waitingConsumers.fetch_sub(1);
 
-    DispatchFunction nextTaskFunction;
-    if (_disposed || !hasTask) {
-        *shouldRun = false;
-    } else {
-        nextTaskFunction = std::move(_tasks.front().function);
+        auto task = lockFreePopTask(nextTask);
         _currentRunningTasks++;
-        _tasks.pop_front();
+
+        auto* instrumentation = _activeInstrumentation.load(std::memory_order_relaxed);
+        if (instrumentation != nullptr) {
+            instrumentation->onTaskStarted(std::chrono::steady_clock::now() - task->executeTime);
+        }
+
+        return std::move(task->function);
     }
-    return nextTaskFunction;
+
+    _waitingConsumers.fetch_sub(1);
+    *shouldRun = false;
+    return DispatchFunction();
 }
 
 size_t TaskQueue::flush() {
@@ -251,7 +436,14 @@ bool TaskQueue::runNextTask(std::chrono::steady_clock::time_point maxTime) {
     auto shouldRun = true;
     auto task = nextTask(maxTime, &shouldRun);
     if (shouldRun) {
-        task();
+        auto* instrumentation = _activeInstrumentation.load(std::memory_order_relaxed);
+        if (instrumentation != nullptr) {
+            auto startTime = std::chrono::steady_clock::now();
+            task();
+            instrumentation->onTaskCompleted(std::chrono::steady_clock::now() - startTime);
+        } else {
+            task();
+        }
         // Dispose the task before notifying the condition,
         // to ensure that all retained objects by the task
         // are released.
@@ -282,6 +474,19 @@ void TaskQueue::setMaxConcurrentTasks(size_t maxConcurrentTasks) {
     _condition.notifyAll();
 }
 
+void TaskQueue::setInstrumentationEnabled(bool enabled, const StringBox& name) {
+    std::lock_guard<Mutex> lockGuard(_mutex);
+    if (enabled && _instrumentation == nullptr) {
+        _instrumentation = makeShared<DispatchQueueInstrumentation>(name);
+    }
+    _activeInstrumentation = enabled ? _instrumentation.get() : nullptr;
+}
+
+Ref<DispatchQueueInstrumentation> TaskQueue::getInstrumentation() const {
+    std::lock_guard<Mutex> lockGuard(_mutex);
+    return _instrumentation;
+}
+
 void TaskQueue::setListener(const Shared<IQueueListener>& listener) {
     std::lock_guard<Mutex> lockGuard(_mutex);
     _listener = listener;
@@ -8,14 +8,19 @@
 
 #pragma once
 
+#include "valdi_core/cpp/Threading/DispatchQueueInstrumentation.hpp"
 #include "valdi_core/cpp/Threading/IDispatchQueue.hpp"
 #include "valdi_core/cpp/Threading/IQueueListener.hpp"
+#include "valdi_core/cpp/Threading/MPSCQueue.hpp"
 #include "valdi_core/cpp/Threading/TaskId.hpp"
+#include "valdi_core/cpp/Utils/FlatMap.hpp"
 #include "valdi_core/cpp/Utils/Function.hpp"
 #include "valdi_core/cpp/Utils/Mutex.hpp"
 #include "valdi_core/cpp/Utils/Shared.hpp"
+#include <atomic>
 #include <chrono>
-#include <queue>
+#include <memory>
+#include <vector>
 
 namespace Valdi {
 
@@ -24,6 +29,12 @@ struct EnqueuedTask {
     bool isFirst = false;
 };
 
+/**
+ A queue of tasks ordered by execute time, drained by runNextTask()/flush().
+ Tasks that are due when enqueued are pushed into a lock-free MPSC queue and run in FIFO order,
+ so that producers do not contend with the consumers. Delayed tasks are kept in a timer heap
+ and cancelled in O(1) by leaving a tombstone.
+ */
 class TaskQueue : public IDispatchQueue {
 public:
     TaskQueue();
@@ -53,16 +64,28 @@ public:
 
     void setMaxConcurrentTasks(size_t maxConcurrentTasks);
 
+    /**
+     Start or stop recording the wait time, run time and depth of the tasks
+     into a DispatchQueueInstrumentation registered under the given name.
+     The instrumentation is created on first enable and kept afterwards,
+     so that statistics survive disabling and re-enabling it.
+     */
+    void setInstrumentationEnabled(bool enabled, const StringBox& name);
+    Ref<DispatchQueueInstrumentation> getInstrumentation() const;
+
     // For Testing Only
     Shared<IQueueListener> getListener() const;
 
 private:
     struct Task {
-        task_id_t id;
+        std::atomic<Task*> next = nullptr;
+        task_id_t id = 0;
         DispatchFunction function;
         std::chrono::steady_clock::time_point executeTime;
-        bool isBarrier;
+        bool isBarrier = false;
+        bool cancelled = false;
 
+        Task();
         Task(task_id_t id,
              DispatchFunction function,
              std::chrono::steady_clock::time_point executeTime,
@@ -70,23 +93,46 @@ private:
     };
 
     std::atomic_bool _disposed;
+    std::atomic_bool _first;
+    std::atomic<task_id_t> _taskIdCounter;
+
+    // Tasks that should run as soon as possible, pushed without taking the lock.
+    MPSCQueue<Task> _immediateTasks;
+    std::atomic_size_t _immediateTasksCount;
+    std::atomic_size_t _waitingConsumers;
+
     mutable Mutex _mutex;
     ConditionVariable _condition;
-    task_id_t _taskIdCounter{0};
-    std::deque<Task> _tasks;
+    // Binary min-heap of tasks scheduled in the future, ordered by execute time.
+    // Cancelled tasks are left in the heap as tombstones and skipped when they reach the top.
+    std::vector<std::unique_ptr<Task>> _delayedTasks;
+    FlatMap<task_id_t, Task*> _delayedTasksById;
+    size_t _delayedTasksTombstones = 0;
     bool _empty = true;
-    bool _first = true;
     size_t _currentRunningTasks = 0;
     size_t _maxConcurrentTasks = 1;
     Shared<IQueueListener> _listener;
+    Ref<DispatchQueueInstrumentation> _instrumentation;
+    // Points to _instrumentation while enabled. Read without the lock by producers and consumers,
+    // which is safe as _instrumentation is never released before the queue.
+    std::atomic<DispatchQueueInstrumentation*> _activeInstrumentation;
 
     DispatchFunction nextTask(std::chrono::steady_clock::time_point maxTime, bool* shouldRun);
 
-    task_id_t insertTask(DispatchFunction&& function,
-                         std::chrono::steady_clock::time_point executeTime,
-                         bool isBarrier);
+    task_id_t pushImmediateTask(DispatchFunction&& function,
+                                std::chrono::steady_clock::time_point executeTime,
+                                bool isBarrier,
+                                size_t* previousCount);
+
+    Task* lockFreePeekNextTask();
+    Task* lockFreePeekImmediateTask();
+    Task* lockFreePeekDelayedTask();
+    std::unique_ptr<Task> lockFreePopImmediateTask();
+    std::unique_ptr<Task> lockFreePopTask(Task* task);
+    void lockFreeMarkNonEmpty();
+    void lockFreeCompactDelayedTasks();
 
-    DispatchFunction lockFreeRemoveTask(task_id_t taskId);
+    DispatchFunction lockFreeCancelTask(task_id_t taskId);
 };
 
 } // namespace Valdi
@@ -0,0 +1,181 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi_core/cpp/Threading/ThreadPoolDispatchQueue.hpp"
+#include "valdi_core/cpp/Constants.hpp"
+#include "valdi_core/cpp/Utils/StringCache.hpp"
+#include <fmt/format.h>
+
+namespace Valdi {
+
+static thread_local ThreadPoolDispatchQueue* current = nullptr;
+
+/**
+ Signals the thread blocked in sync() once the task that holds it is destroyed,
+ which happens either after the task ran or when the queue dropped it during teardown.
+ */
+class ThreadPoolSyncCompletion : public SimpleRefCountable {
+public:
+    ~ThreadPoolSyncCompletion() override {
+        std::lock_guard<Mutex> guard(*_mutex);
+        *_completed = true;
+        _condition->notifyAll();
+    }
+
+    ThreadPoolSyncCompletion(Mutex* mutex, ConditionVariable* condition, bool* completed)
+        : _mutex(mutex), _condition(condition), _completed(completed) {}
+
+private:
+    Mutex* _mutex;
+    ConditionVariable* _condition;
+    bool* _completed;
+};
+
+ThreadPoolDispatchQueue::ThreadPoolDispatchQueue(const StringBox& name, ThreadQoSClass qosClass, size_t threadCount)
+    : _taskQueue(makeShared<WorkStealingTaskQueue>(threadCount)), _name(name), _qosClass(qosClass) {}
+
+ThreadPoolDispatchQueue::~ThreadPoolDispatchQueue() {
+    teardown();
+}
+
+void ThreadPoolDispatchQueue::sync(const DispatchFunction& function) {
+    if (isCurrent()) {
+        function();
+        return;
+    }
+
+    Mutex mutex;
+    ConditionVariable condition;
+    bool completed = false;
+
+    {
+        auto completion = makeShared<ThreadPoolSyncCompletion>(&mutex, &condition, &completed);
+        async([&function, this, completion]() {
+            _runningSyncCount.fetch_add(1);
+            function();
+            _runningSyncCount.fetch_sub(1);
+        });
+    }
+
+    std::unique_lock<Mutex> lock(mutex);
+    while (!completed) {
+        condition.wait(lock);
+    }
+}
+
+bool ThreadPoolDispatchQueue::isRunningSync() const {
+    return _runningSyncCount.load() > 0;
+}
+
+void ThreadPoolDispatchQueue::async(DispatchFunction function) {
+    auto task = _taskQueue->enqueue(std::move(function));
+
+    if (VALDI_UNLIKELY(task.isFirst)) {
+        startThreads();
+    }
+}
+
+task_id_t ThreadPoolDispatchQueue::asyncAfter(DispatchFunction function, std::chrono::steady_clock::duration delay) {
+    auto task = _taskQueue->enqueue(std::move(function), delay);
+
+    if (VALDI_UNLIKELY(task.isFirst)) {
+        startThreads();
+    }
+
+    return task.id;
+}
+
+void ThreadPoolDispatchQueue::cancel(task_id_t taskId) {
+    _taskQueue->cancel(taskId);
+}
+
+void ThreadPoolDispatchQueue::teardown() {
+    _taskQueue->dispose();
+    teardownThreads();
+}
+
+void ThreadPoolDispatchQueue::startThreads() {
+    std::lock_guard<Mutex> guard(_mutex);
+    SC_ASSERT(_threads.empty());
+
+    auto threadCount = _taskQueue->getWorkerCount();
+    _threads.reserve(threadCount);
+
+    for (size_t i = 0; i < threadCount; i++) {
+        auto threadResult = Thread::create(
+            STRING_FORMAT("{} #{}", _name.toStringView(), i),
+            _qosClass,
+            [self = this, taskQueue = _taskQueue, i]() { ThreadPoolDispatchQueue::handler(self, taskQueue, i); });
+        SC_ASSERT(threadResult.success(), threadResult.description());
+
+        _threads.emplace_back(threadResult.moveValue());
+    }
+}
+
+void ThreadPoolDispatchQueue::teardownThreads() {
+    std::vector<Ref<Thread>> threads;
+    {
+        std::lock_guard<Mutex> guard(_mutex);
+        threads = std::move(_threads);
+        _threads.clear();
+    }
+
+    for (const auto& thread : threads) {
+        // The pool can be torn down from one of its own threads, which cannot join itself.
+        if (thread.get() != Thread::getCurrent()) {
+            thread->join();
+        }
+    }
+}
+
+void ThreadPoolDispatchQueue::fullTeardown() {
+    teardown();
+}
+
+ThreadPoolDispatchQueue* ThreadPoolDispatchQueue::getCurrent() {
+    return current;
+}
+
+void ThreadPoolDispatchQueue::handler(ThreadPoolDispatchQueue* dispatchQueue,
+                                      const Ref<WorkStealingTaskQueue>& taskQueue,
+                                      size_t workerIndex) {
+    current = dispatchQueue;
+
+    while (!taskQueue->isDisposed()) {
+        taskQueue->runNextTask(workerIndex, std::chrono::steady_clock::now() + std::chrono::seconds(100000));
+    }
+}
+
+bool ThreadPoolDispatchQueue::isCurrent() const {
+    return this == getCurrent();
+}
+
+bool ThreadPoolDispatchQueue::isDisposed() const {
+    return _taskQueue->isDisposed();
+}
+
+bool ThreadPoolDispatchQueue::hasThreadsRunning() const {
+    std::lock_guard<Mutex> guard(_mutex);
+    return !_threads.empty();
+}
+
+size_t ThreadPoolDispatchQueue::getThreadCount() const {
+    return _taskQueue->getWorkerCount();
+}
+
+void ThreadPoolDispatchQueue::setListener(const Shared<IQueueListener>& listener) {
+    _taskQueue->setListener(listener);
+}
+
+Shared<IQueueListener> ThreadPoolDispatchQueue::getListener() const {
+    return _taskQueue->getListener();
+}
+
+void ThreadPoolDispatchQueue::setQoSClass(ThreadQoSClass qosClass) {
+    std::lock_guard<Mutex> guard(_mutex);
+    _qosClass = qosClass;
+    for (const auto& thread : _threads) {
+        thread->setQoSClass(qosClass);
+    }
+}
+
+} // namespace Valdi
@@ -0,0 +1,79 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "valdi_core/cpp/Threading/DispatchQueue.hpp"
+#include "valdi_core/cpp/Threading/Thread.hpp"
+#include "valdi_core/cpp/Threading/WorkStealingTaskQueue.hpp"
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+namespace Valdi {
+
+/**
+ A concurrent DispatchQueue backed by a fixed number of threads draining a WorkStealingTaskQueue.
+ Tasks submitted to this queue can run in parallel and in any order, it should only be used
+ for work that does not rely on the serial guarantees of ThreadedDispatchQueue.
+ The threads are started lazily on the first enqueued task.
+ */
+class ThreadPoolDispatchQueue : public DispatchQueue {
+public:
+    ThreadPoolDispatchQueue(const StringBox& name, ThreadQoSClass qosClass, size_t threadCount);
+    ~ThreadPoolDispatchQueue() override;
+
+    /**
+     Run the given function on one of the pool threads and wait for its completion.
+     When called from one of the pool threads, the function is run inline.
+     */
+    void sync(const DispatchFunction& function) final;
+    void async(DispatchFunction function) final;
+    task_id_t asyncAfter(DispatchFunction function, std::chrono::steady_clock::duration delay) final;
+    void cancel(task_id_t taskId) final;
+
+    /**
+     * Returns whether the current thread is one of the threads of this pool.
+     */
+    bool isCurrent() const final;
+
+    /**
+     * Returns whether a task submitted through sync() is running on any of the threads of this pool.
+     */
+    bool isRunningSync() const final;
+
+    void fullTeardown() final;
+
+    bool isDisposed() const;
+
+    bool hasThreadsRunning() const;
+
+    size_t getThreadCount() const;
+
+    void setListener(const Shared<IQueueListener>& listener) final;
+
+    void setQoSClass(ThreadQoSClass qosClass) final;
+
+    static ThreadPoolDispatchQueue* getCurrent();
+
+    // For Testing Only
+    Shared<IQueueListener> getListener() const final;
+
+private:
+    mutable Mutex _mutex;
+    std::vector<Ref<Thread>> _threads;
+    Ref<WorkStealingTaskQueue> _taskQueue;
+    StringBox _name;
+    ThreadQoSClass _qosClass;
+    // Sync tasks can run concurrently on the pool threads, a single flag would be
+    // cleared by the first one which completes
+    std::atomic<size_t> _runningSyncCount = 0;
+
+    static void handler(ThreadPoolDispatchQueue* dispatchQueue,
+                        const Ref<WorkStealingTaskQueue>& taskQueue,
+                        size_t workerIndex);
+    void teardown();
+    void startThreads();
+    void teardownThreads();
+};
+
+} // namespace Valdi
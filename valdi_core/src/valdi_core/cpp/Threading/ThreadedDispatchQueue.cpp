@@ -201,4 +201,8 @@ void ThreadedDispatchQueue::setDisableSyncCallsInCallingThread(bool disableSyncC
     _disableSyncCallsInCallingThread = disableSyncCallsInCallingThread;
 }
 
+void ThreadedDispatchQueue::setInstrumentationEnabled(bool instrumentationEnabled) {
+    _taskQueue->setInstrumentationEnabled(instrumentationEnabled, _name);
+}
+
 } // namespace Valdi
@@ -49,6 +49,8 @@ public:
 
     void setDisableSyncCallsInCallingThread(bool disableSyncCallsInCallingThread) override;
 
+    void setInstrumentationEnabled(bool instrumentationEnabled) override;
+
 private:
     mutable Mutex _mutex;
     Ref<Thread> _thread;
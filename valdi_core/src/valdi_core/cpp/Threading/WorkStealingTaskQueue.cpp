@@ -0,0 +1,304 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi_core/cpp/Threading/WorkStealingTaskQueue.hpp"
+#include "utils/debugging/Assert.hpp"
+#include <limits>
+
+namespace Valdi {
+
+static thread_local WorkStealingTaskQueue* currentQueue = nullptr;
+static thread_local size_t currentWorkerIndex = 0;
+
+WorkStealingTaskQueue::WorkStealingTaskQueue(size_t workerCount)
+    : _disposed(false),
+      _pendingTasks(0),
+      _sleepingWorkers(0),
+      _nextWorkerIndex(0),
+      _taskIdCounter(0),
+      _first(true),
+      _empty(true),
+      _nextDelayedTaskTime(std::numeric_limits<int64_t>::max()) {
+    workerCount = std::max(workerCount, static_cast<size_t>(1));
+    _workers.reserve(workerCount);
+    for (size_t i = 0; i < workerCount; i++) {
+        _workers.emplace_back(std::make_unique<Worker>());
+    }
+}
+
+WorkStealingTaskQueue::~WorkStealingTaskQueue() {
+    dispose();
+}
+
+void WorkStealingTaskQueue::dispose() {
+    if (_disposed.exchange(true)) {
+        return;
+    }
+
+    std::vector<std::deque<DispatchFunction>> tasksToDelete;
+    std::map<DelayedTaskKey, DispatchFunction> delayedTasksToDelete;
+
+    for (const auto& worker : _workers) {
+        std::lock_guard<Mutex> lockGuard(worker->mutex);
+        tasksToDelete.emplace_back(std::move(worker->tasks));
+        worker->tasks.clear();
+    }
+
+    {
+        std::lock_guard<Mutex> lockGuard(_mutex);
+        delayedTasksToDelete.swap(_delayedTasks);
+        _delayedTaskExecuteTimes.clear();
+    }
+
+    _condition.notifyAll();
+}
+
+EnqueuedTask WorkStealingTaskQueue::enqueue(DispatchFunction function) {
+    EnqueuedTask enqueuedTask;
+    if (_disposed) {
+        return enqueuedTask;
+    }
+
+    size_t workerIndex;
+    if (currentQueue == this) {
+        // Keep the task on the worker that produced it, other workers will steal it if they are idle.
+        workerIndex = currentWorkerIndex;
+    } else {
+        workerIndex = _nextWorkerIndex.fetch_add(1, std::memory_order_relaxed) % _workers.size();
+    }
+
+    {
+        auto& worker = *_workers[workerIndex];
+        std::lock_guard<Mutex> lockGuard(worker.mutex);
+        worker.tasks.emplace_back(std::move(function));
+    }
+
+    enqueuedTask.id = ++_taskIdCounter;
+    enqueuedTask.isFirst = _first.exchange(false);
+
+    _pendingTasks.fetch_add(1);
+
+    if (_empty.load() || _sleepingWorkers.load() > 0) {
+        {
+            std::lock_guard<Mutex> lockGuard(_mutex);
+            onTaskEnqueued();
+        }
+        _condition.notifyOne();
+    }
+
+    return enqueuedTask;
+}
+
+EnqueuedTask WorkStealingTaskQueue::enqueue(DispatchFunction function, std::chrono::steady_clock::duration delay) {
+    EnqueuedTask enqueuedTask;
+    if (_disposed) {
+        return enqueuedTask;
+    }
+
+    auto executeTime = std::chrono::steady_clock::now() + delay;
+
+    {
+        std::lock_guard<Mutex> lockGuard(_mutex);
+        enqueuedTask.id = ++_taskIdCounter;
+        enqueuedTask.isFirst = _first.exchange(false);
+
+        _delayedTasks.emplace(DelayedTaskKey(executeTime, enqueuedTask.id), std::move(function));
+        _delayedTaskExecuteTimes[enqueuedTask.id] = executeTime;
+        updateNextDelayedTaskTime();
+        onTaskEnqueued();
+    }
+
+    // The next delayed task might have changed, wake up everyone so that
+    // the sleeping workers can recompute their deadline.
+    _condition.notifyAll();
+
+    return enqueuedTask;
+}
+
+bool WorkStealingTaskQueue::cancel(task_id_t taskId) {
+    DispatchFunction toDelete;
+    {
+        std::lock_guard<Mutex> lockGuard(_mutex);
+        const auto& it = _delayedTaskExecuteTimes.find(taskId);
+        if (it == _delayedTaskExecuteTimes.end()) {
+            return false;
+        }
+
+        auto taskIt = _delayedTasks.find(DelayedTaskKey(it->second, taskId));
+        _delayedTaskExecuteTimes.erase(it);
+
+        if (taskIt == _delayedTasks.end()) {
+            return false;
+        }
+
+        toDelete = std::move(taskIt->second);
+        _delayedTasks.erase(taskIt);
+        updateNextDelayedTaskTime();
+    }
+
+    return true;
+}
+
+void WorkStealingTaskQueue::onTaskEnqueued() {
+    if (_empty) {
+        _empty = false;
+        if (_listener != nullptr) {
+            _listener->onQueueNonEmpty();
+        }
+    }
+}
+
+void WorkStealingTaskQueue::updateNextDelayedTaskTime() {
+    if (_delayedTasks.empty()) {
+        _nextDelayedTaskTime = std::numeric_limits<int64_t>::max();
+    } else {
+        _nextDelayedTaskTime = _delayedTasks.begin()->first.first.time_since_epoch().count();
+    }
+}
+
+DispatchFunction WorkStealingTaskQueue::popTask(size_t workerIndex) {
+    DispatchFunction task;
+
+    if (_pendingTasks.load() == 0) {
+        return task;
+    }
+
+    auto workerCount = _workers.size();
+
+    // Our own tasks are consumed in FIFO order, tasks from other workers
+    // are stolen from the back to limit contention with their owner.
+    for (size_t i = 0; i < workerCount; i++) {
+        auto& worker = *_workers[(workerIndex + i) % workerCount];
+        std::lock_guard<Mutex> lockGuard(worker.mutex);
+        if (worker.tasks.empty()) {
+            continue;
+        }
+
+        if (i == 0) {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        } else {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        }
+
+        _pendingTasks.fetch_sub(1);
+        break;
+    }
+
+    return task;
+}
+
+DispatchFunction WorkStealingTaskQueue::popDelayedTask(std::chrono::steady_clock::time_point now) {
+    DispatchFunction task;
+
+    if (now.time_since_epoch().count() < _nextDelayedTaskTime.load(std::memory_order_relaxed)) {
+        return task;
+    }
+
+    std::lock_guard<Mutex> lockGuard(_mutex);
+    if (_delayedTasks.empty()) {
+        return task;
+    }
+
+    auto it = _delayedTasks.begin();
+    if (it->first.first > now) {
+        return task;
+    }
+
+    _delayedTaskExecuteTimes.erase(it->first.second);
+    task = std::move(it->second);
+    _delayedTasks.erase(it);
+    updateNextDelayedTaskTime();
+
+    return task;
+}
+
+bool WorkStealingTaskQueue::waitForTask(std::chrono::steady_clock::time_point maxTime) {
+    std::unique_lock<Mutex> lockGuard(_mutex);
+    _sleepingWorkers.fetch_add(1);
+
+    auto hasTask = true;
+    while (!_disposed && _pendingTasks.load() == 0) {
+        auto now = std::chrono::steady_clock::now();
+        if (!_delayedTasks.empty() && _delayedTasks.begin()->first.first <= now) {
+            break;
+        }
+
+        if (now >= maxTime) {
+            hasTask = false;
+            break;
+        }
+
+        if (_delayedTasks.empty()) {
+            if (!_empty) {
+                _empty = true;
+                if (_listener != nullptr) {
+                    _listener->onQueueEmpty();
+                }
+            }
+            _condition.waitUntil(lockGuard, maxTime);
+        } else {
+            // Copy the deadline, the delayed task might be removed while we wait.
+            auto nextExecuteTime = std::min(maxTime, _delayedTasks.begin()->first.first);
+            _condition.waitUntil(lockGuard, nextExecuteTime);
+        }
+    }
+
+    _sleepingWorkers.fetch_sub(1);
+
+    return hasTask && !_disposed;
+}
+
+bool WorkStealingTaskQueue::runNextTask(size_t workerIndex, std::chrono::steady_clock::time_point maxTime) {
+    SC_ASSERT(workerIndex < _workers.size());
+
+    while (!_disposed) {
+        // Delayed tasks that are due take precedence, so that a constant stream of
+        // immediate tasks cannot starve them.
+        auto task = popDelayedTask(std::chrono::steady_clock::now());
+        if (!task) {
+            task = popTask(workerIndex);
+        }
+
+        if (task) {
+            auto* previousQueue = currentQueue;
+            auto previousWorkerIndex = currentWorkerIndex;
+            currentQueue = this;
+            currentWorkerIndex = workerIndex;
+
+            task();
+            // Release retained objects before returning, like TaskQueue does.
+            task = DispatchFunction();
+
+            currentQueue = previousQueue;
+            currentWorkerIndex = previousWorkerIndex;
+            return true;
+        }
+
+        if (!waitForTask(maxTime)) {
+            return false;
+        }
+    }
+
+    return false;
+}
+
+size_t WorkStealingTaskQueue::getWorkerCount() const {
+    return _workers.size();
+}
+
+bool WorkStealingTaskQueue::isDisposed() const {
+    return _disposed;
+}
+
+void WorkStealingTaskQueue::setListener(const Shared<IQueueListener>& listener) {
+    std::lock_guard<Mutex> lockGuard(_mutex);
+    _listener = listener;
+}
+
+Shared<IQueueListener> WorkStealingTaskQueue::getListener() const {
+    std::lock_guard<Mutex> lockGuard(_mutex);
+    return _listener;
+}
+
+} // namespace Valdi
@@ -0,0 +1,91 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "valdi_core/cpp/Threading/IQueueListener.hpp"
+#include "valdi_core/cpp/Threading/TaskId.hpp"
+#include "valdi_core/cpp/Threading/TaskQueue.hpp"
+#include "valdi_core/cpp/Utils/FlatMap.hpp"
+#include "valdi_core/cpp/Utils/Function.hpp"
+#include "valdi_core/cpp/Utils/Mutex.hpp"
+#include "valdi_core/cpp/Utils/Shared.hpp"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace Valdi {
+
+/**
+ A TaskQueue designed to be drained concurrently by a fixed number of workers.
+ Each worker owns a deque of immediate tasks. Tasks enqueued from a worker are pushed
+ into its own deque, tasks enqueued from any other thread are distributed round-robin.
+ A worker that runs out of tasks steals from the back of the other workers' deques.
+ Delayed tasks are kept in a single timer list shared by all the workers.
+ */
+class WorkStealingTaskQueue : public SimpleRefCountable {
+public:
+    explicit WorkStealingTaskQueue(size_t workerCount);
+    WorkStealingTaskQueue(const WorkStealingTaskQueue& other) = delete;
+    ~WorkStealingTaskQueue() override;
+
+    void dispose();
+
+    EnqueuedTask enqueue(DispatchFunction function);
+    EnqueuedTask enqueue(DispatchFunction function, std::chrono::steady_clock::duration delay);
+
+    /**
+     Cancel a delayed task and return whether it was removed. Tasks that are already
+     running or that were enqueued without a delay cannot be cancelled, in which case
+     false is returned.
+     */
+    bool cancel(task_id_t taskId);
+
+    /**
+     Run the next available task on the given worker, waiting up to maxTime
+     for one to become available. Returns whether a task was run.
+     */
+    bool runNextTask(size_t workerIndex, std::chrono::steady_clock::time_point maxTime);
+
+    size_t getWorkerCount() const;
+
+    bool isDisposed() const;
+    void setListener(const Shared<IQueueListener>& listener);
+
+    // For Testing Only
+    Shared<IQueueListener> getListener() const;
+
+private:
+    struct Worker {
+        Mutex mutex;
+        std::deque<DispatchFunction> tasks;
+    };
+
+    using DelayedTaskKey = std::pair<std::chrono::steady_clock::time_point, task_id_t>;
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    std::atomic_bool _disposed;
+    std::atomic_size_t _pendingTasks;
+    std::atomic_size_t _sleepingWorkers;
+    std::atomic_size_t _nextWorkerIndex;
+    std::atomic<task_id_t> _taskIdCounter;
+    std::atomic_bool _first;
+    std::atomic_bool _empty;
+    std::atomic<int64_t> _nextDelayedTaskTime;
+
+    mutable Mutex _mutex;
+    ConditionVariable _condition;
+    std::map<DelayedTaskKey, DispatchFunction> _delayedTasks;
+    FlatMap<task_id_t, std::chrono::steady_clock::time_point> _delayedTaskExecuteTimes;
+    Shared<IQueueListener> _listener;
+
+    DispatchFunction popTask(size_t workerIndex);
+    DispatchFunction popDelayedTask(std::chrono::steady_clock::time_point now);
+    bool waitForTask(std::chrono::steady_clock::time_point maxTime);
+    void onTaskEnqueued();
+    void updateNextDelayedTaskTime();
+};
+
+} // namespace Valdi
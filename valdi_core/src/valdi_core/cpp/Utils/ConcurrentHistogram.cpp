@@ -0,0 +1,119 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi_core/cpp/Utils/ConcurrentHistogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Valdi {
+
+// Values are grouped in 2^kSubBucketBits buckets per power of two
+static constexpr size_t kSubBucketBits = 3;
+static constexpr size_t kSubBucketsCount = 1 << kSubBucketBits;
+// Values below this are counted exactly
+static constexpr uint64_t kLinearValuesCount = 2 * kSubBucketsCount;
+static constexpr size_t kFirstLogExponent = 4;
+
+static size_t highestBitIndex(uint64_t value) {
+    size_t index = 0;
+    while (value >>= 1) {
+        index++;
+    }
+    return index;
+}
+
+uint64_t HistogramSnapshot::getValueAtPercentile(double percentile) const {
+    if (count == 0) {
+        return 0;
+    }
+
+    auto target = static_cast<uint64_t>(std::ceil((std::clamp(percentile, 0.0, 100.0) / 100.0) * count));
+    target = std::max(target, static_cast<uint64_t>(1));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= target) {
+            return std::min(ConcurrentHistogram::getBucketHighestValue(i), max);
+        }
+    }
+
+    return max;
+}
+
+double HistogramSnapshot::getMean() const {
+    if (count == 0) {
+        return 0;
+    }
+    return static_cast<double>(sum) / static_cast<double>(count);
+}
+
+void HistogramSnapshot::merge(const HistogramSnapshot& other) {
+    count += other.count;
+    sum += other.sum;
+    max = std::max(max, other.max);
+    if (buckets.size() < other.buckets.size()) {
+        buckets.resize(other.buckets.size(), 0);
+    }
+    for (size_t i = 0; i < other.buckets.size(); i++) {
+        buckets[i] += other.buckets[i];
+    }
+}
+
+ConcurrentHistogram::ConcurrentHistogram() : _sum(0), _max(0) {
+    for (auto& bucket : _buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+ConcurrentHistogram::~ConcurrentHistogram() = default;
+
+size_t ConcurrentHistogram::getBucketIndex(uint64_t value) {
+    if (value < kLinearValuesCount) {
+        return static_cast<size_t>(value);
+    }
+
+    auto exponent = highestBitIndex(value);
+    auto subBucket = static_cast<size_t>((value >> (exponent - kSubBucketBits)) & (kSubBucketsCount - 1));
+    return kLinearValuesCount + (exponent - kFirstLogExponent) * kSubBucketsCount + subBucket;
+}
+
+uint64_t ConcurrentHistogram::getBucketHighestValue(size_t index) {
+    if (index < kLinearValuesCount) {
+        return static_cast<uint64_t>(index);
+    }
+
+    auto exponent = (index - kLinearValuesCount) / kSubBucketsCount + kFirstLogExponent;
+    auto subBucket = static_cast<uint64_t>((index - kLinearValuesCount) % kSubBucketsCount);
+    auto shift = exponent - kSubBucketBits;
+    auto lowestValue = (kSubBucketsCount + subBucket) << shift;
+    return lowestValue + ((static_cast<uint64_t>(1) << shift) - 1);
+}
+
+void ConcurrentHistogram::record(uint64_t value) {
+    _buckets[getBucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    _sum.fetch_add(value, std::memory_order_relaxed);
+
+    auto currentMax = _max.load(std::memory_order_relaxed);
+    while (value > currentMax && !_max.compare_exchange_weak(currentMax, value, std::memory_order_relaxed)) {
+    }
+}
+
+HistogramSnapshot ConcurrentHistogram::snapshot() const {
+    HistogramSnapshot snapshot;
+    snapshot.buckets.resize(kBucketsCount);
+
+    // The buckets are read one by one while values might still be recorded,
+    // so the count is computed from them to keep the snapshot self consistent.
+    for (size_t i = 0; i < kBucketsCount; i++) {
+        auto bucketCount = _buckets[i].load(std::memory_order_relaxed);
+        snapshot.buckets[i] = bucketCount;
+        snapshot.count += bucketCount;
+    }
+    snapshot.sum = _sum.load(std::memory_order_relaxed);
+    snapshot.max = _max.load(std::memory_order_relaxed);
+
+    return snapshot;
+}
+
+} // namespace Valdi
@@ -0,0 +1,59 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "utils/base/NonCopyable.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Valdi {
+
+/**
+ A copy of the recorded values of a ConcurrentHistogram at some point in time.
+ */
+struct HistogramSnapshot {
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    std::vector<uint64_t> buckets;
+
+    /**
+     Returns the highest value equivalent to the value at the given percentile,
+     between 0 and 100. The result is within 12.5% of the actual value.
+     */
+    uint64_t getValueAtPercentile(double percentile) const;
+
+    double getMean() const;
+
+    void merge(const HistogramSnapshot& other);
+};
+
+/**
+ A log-linear histogram of unsigned integers, in the spirit of HdrHistogram.
+ Values below 16 are counted exactly, larger values are grouped in 8 linear
+ buckets per power of two. record() is lock-free and can be called from any thread.
+ */
+class ConcurrentHistogram : public snap::NonCopyable {
+public:
+    static constexpr size_t kBucketsCount = 16 + (64 - 4) * 8;
+
+    ConcurrentHistogram();
+    ~ConcurrentHistogram();
+
+    void record(uint64_t value);
+
+    HistogramSnapshot snapshot() const;
+
+    static size_t getBucketIndex(uint64_t value);
+    static uint64_t getBucketHighestValue(size_t index);
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketsCount> _buckets;
+    std::atomic<uint64_t> _sum;
+    std::atomic<uint64_t> _max;
+};
+
+} // namespace Valdi
@@ -12,7 +12,9 @@
 #include "valdi_core/cpp/Utils/StringCache.hpp"
 #include <cstdio>
 #include <dirent.h>
+#include <fcntl.h>
 #include <fstream>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
@@ -168,6 +170,47 @@ Result<BytesView> DiskUtils::loadFromFd(int fd) {
     return bytes->toBytesView();
 }
 
+class MappedFile : public SimpleRefCountable {
+public:
+    MappedFile(void* data, size_t size) : _data(data), _size(size) {}
+    ~MappedFile() override {
+        munmap(_data, _size);
+    }
+
+private:
+    void* _data;
+    size_t _size;
+};
+
+Result<BytesView> DiskUtils::mapFile(const Path& path) {
+    auto pathString = path.toString();
+    auto fd = ::open(pathString.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return Error(STRING_FORMAT("Unable to open file at {}: {}", pathString, strerror(errno)));
+    }
+
+    auto stat = statFromFd(fd);
+    if (!stat.isFile()) {
+        ::close(fd);
+        return Error(STRING_FORMAT("No file at {}", pathString));
+    }
+
+    if (stat.size() == 0) {
+        ::close(fd);
+        return BytesView();
+    }
+
+    auto* data = mmap(nullptr, stat.size(), PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping remains valid after the file descriptor is closed
+    ::close(fd);
+
+    if (data == MAP_FAILED) {
+        return Error(STRING_FORMAT("Unable to map file at {}: {}", pathString, strerror(errno)));
+    }
+
+    return BytesView(makeShared<MappedFile>(data, stat.size()), reinterpret_cast<const Byte*>(data), stat.size());
+}
+
 Result<Void> DiskUtils::store(const Path& path, const BytesView& bytes) {
     return store(path, bytes.asStringView());
 }
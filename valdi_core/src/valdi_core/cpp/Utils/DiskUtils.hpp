@@ -78,6 +78,13 @@ public:
 
     static Result<BytesView> loadFromFd(int fd);
 
+    /**
+     Maps the file at the given path in memory as read-only. The pages are loaded lazily
+     by the OS as they are accessed, and the mapping stays alive as long as the returned
+     BytesView or any copy of it is retained.
+     */
+    static Result<BytesView> mapFile(const Path& path);
+
     static Result<Void> store(const Path& path, const BytesView& bytes);
 
     static Result<Void> store(const Path& path, std::string_view bytes);
@@ -23,17 +23,28 @@ constexpr size_t alignUp(size_t size, size_t alignment) {
 
 template<typename T, typename ValueType>
 struct InlineContainerAllocator {
+    static constexpr size_t getAllocationSize(size_t size) {
+        return alignUp(sizeof(T), alignof(ValueType)) + (sizeof(ValueType) * size);
+    }
+
     template<typename... Args>
     T* allocateUnmanaged(size_t size, Args&&... args) {
         std::allocator<uint8_t> allocator;
 
-        auto allocSize = alignUp(sizeof(T), alignof(ValueType)) + (sizeof(ValueType) * size);
+        auto* arrayRegion = allocator.allocate(getAllocationSize(size));
 
-        auto* arrayRegion = allocator.allocate(allocSize);
+        return constructUnmanaged(arrayRegion, std::forward<Args>(args)...);
+    }
 
-        new (arrayRegion)(T)(std::forward<Args>(args)...);
+    /**
+     Construct the object inside a region of getAllocationSize() bytes
+     that was allocated by the caller.
+     */
+    template<typename... Args>
+    T* constructUnmanaged(void* region, Args&&... args) {
+        ::new (region)(T)(std::forward<Args>(args)...);
 
-        return reinterpret_cast<T*>(arrayRegion);
+        return reinterpret_cast<T*>(region);
     }
 
     template<typename... Args>
@@ -0,0 +1,44 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi_core/cpp/Utils/ObjectPool.hpp"
+
+namespace Valdi {
+
+ObjectPoolStatistics& ObjectPoolStatistics::operator+=(const ObjectPoolStatistics& other) {
+    localHits += other.localHits;
+    sharedHits += other.sharedHits;
+    misses += other.misses;
+    rebalances += other.rebalances;
+    return *this;
+}
+
+struct ObjectPoolStatisticsProviders {
+    std::mutex mutex;
+    std::vector<ObjectPoolStatisticsProvider*> providers;
+};
+
+static ObjectPoolStatisticsProviders& getProviders() {
+    // Leaked on purpose, the pools themselves are never destroyed
+    static auto* providers = new ObjectPoolStatisticsProviders();
+    return *providers;
+}
+
+ObjectPoolStatistics ObjectPoolStatisticsProvider::getGlobalStatistics() {
+    auto& providers = getProviders();
+    std::lock_guard<std::mutex> lock(providers.mutex);
+
+    ObjectPoolStatistics statistics;
+    for (auto* provider : providers.providers) {
+        statistics += provider->getStatistics();
+    }
+
+    return statistics;
+}
+
+void ObjectPoolStatisticsProvider::registerProvider(ObjectPoolStatisticsProvider* provider) {
+    auto& providers = getProviders();
+    std::lock_guard<std::mutex> lock(providers.mutex);
+    providers.providers.emplace_back(provider);
+}
+
+} // namespace Valdi
@@ -8,6 +8,8 @@
 #pragma once
 
 #include "utils/base/NonCopyable.hpp"
+#include <algorithm>
+#include <cstdint>
 #include <deque>
 #include <mutex>
 #include <utility>
@@ -18,15 +20,51 @@ namespace Valdi {
 template<typename T>
 class ObjectPoolInner;
 
+/**
+ The max number of objects that each thread keeps in its magazine
+ in front of a shared ObjectPool<T>.
+ */
+constexpr size_t kObjectPoolMagazineCapacity = 8;
+
 template<typename T>
 class ObjectPool {
 public:
     static ObjectPoolInner<T>& get() {
-        static auto innerPool = new ObjectPoolInner<T>();
+        static auto innerPool = new ObjectPoolInner<T>(kObjectPoolMagazineCapacity);
         return *innerPool;
     }
 };
 
+struct ObjectPoolStatistics {
+    // Objects reused from the calling thread's magazine, without taking the pool lock
+    uint64_t localHits = 0;
+    // Objects reused from the shared pool
+    uint64_t sharedHits = 0;
+    // Objects that had to be created because the pool was empty
+    uint64_t misses = 0;
+    // Number of times a magazine gave objects back to the shared pool
+    uint64_t rebalances = 0;
+
+    ObjectPoolStatistics& operator+=(const ObjectPoolStatistics& other);
+};
+
+class ObjectPoolStatisticsProvider {
+public:
+    virtual ~ObjectPoolStatisticsProvider() = default;
+
+    virtual ObjectPoolStatistics getStatistics() = 0;
+
+    /**
+     Returns the statistics of all the ObjectPool<T> pools of the process combined.
+     The local hits of each thread are only reported after it next accesses the
+     shared pool, so they can lag behind slightly.
+     */
+    static ObjectPoolStatistics getGlobalStatistics();
+
+protected:
+    static void registerProvider(ObjectPoolStatisticsProvider* provider);
+};
+
 template<typename T, typename Cleanup>
 struct ObjectPoolEntry {
     ObjectPoolEntry(T value, ObjectPoolInner<T>* pool, Cleanup cleanUpFunc)
@@ -94,9 +132,28 @@ private:
     }
 };
 
+/**
+ Per thread cache of objects in front of a shared ObjectPool<T>, which
+ lets threads recycle their own objects without contending on the pool lock.
+ */
 template<typename T>
-class ObjectPoolInner {
+struct ObjectPoolMagazine : public snap::NonCopyable {
+    explicit ObjectPoolMagazine(ObjectPoolInner<T>& pool) : pool(pool) {}
+
+    ~ObjectPoolMagazine() {
+        pool.drainMagazine(*this);
+    }
+
+    ObjectPoolInner<T>& pool;
+    std::vector<T> objects;
+    uint64_t localHits = 0;
+};
+
+template<typename T>
+class ObjectPoolInner : public ObjectPoolStatisticsProvider {
 public:
+    ObjectPoolInner() = default;
+
     template<typename Cleanup>
     ObjectPoolEntry<T, Cleanup> getOrCreate(Cleanup&& cleanup) {
         return getOrCreate([]() { return T(); }, std::forward<Cleanup>(cleanup));
@@ -104,12 +161,28 @@ public:
 
     template<typename Factory, typename Cleanup>
     ObjectPoolEntry<T, Cleanup> getOrCreate(Factory&& factory, Cleanup&& cleanup) {
+        if (_magazineCapacity > 0) {
+            auto& magazine = getMagazine();
+            if (!magazine.objects.empty()) {
+                magazine.localHits++;
+            } else if (!refillMagazine(magazine)) {
+                return ObjectPoolEntry<T, Cleanup>(factory(), this, cleanup);
+            }
+
+            T obj = std::move(magazine.objects.back());
+            magazine.objects.pop_back();
+
+            return ObjectPoolEntry<T, Cleanup>(std::move(obj), this, cleanup);
+        }
+
         std::lock_guard<std::mutex> lock(_mutex);
 
         if (_objects.empty()) {
+            _statistics.misses++;
             return ObjectPoolEntry<T, Cleanup>(factory(), this, cleanup);
         }
 
+        _statistics.sharedHits++;
         T obj = std::move(_objects.front());
         _objects.pop_front();
 
@@ -117,14 +190,93 @@ public:
     }
 
     void add(T object) {
+        if (_magazineCapacity > 0) {
+            auto& magazine = getMagazine();
+            if (magazine.objects.size() >= _magazineCapacity) {
+                rebalanceMagazine(magazine);
+            }
+            magazine.objects.emplace_back(std::move(object));
+            return;
+        }
+
         std::lock_guard<std::mutex> lock(_mutex);
 
         _objects.emplace_back(std::move(object));
     }
 
+    ObjectPoolStatistics getStatistics() override {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _statistics;
+    }
+
 private:
     std::deque<T> _objects;
     std::mutex _mutex;
+    size_t _magazineCapacity = 0;
+    ObjectPoolStatistics _statistics;
+
+    friend ObjectPool<T>;
+    friend ObjectPoolMagazine<T>;
+
+    // Only the process wide pools use magazines, as they are never destroyed
+    // and there is a single one per type.
+    explicit ObjectPoolInner(size_t magazineCapacity) : _magazineCapacity(magazineCapacity) {
+        registerProvider(this);
+    }
+
+    ObjectPoolMagazine<T>& getMagazine() {
+        static thread_local ObjectPoolMagazine<T> magazine(*this);
+        return magazine;
+    }
+
+    void flushMagazineStatistics(ObjectPoolMagazine<T>& magazine) {
+        _statistics.localHits += magazine.localHits;
+        magazine.localHits = 0;
+    }
+
+    // Moves half a magazine worth of objects from the shared pool into the magazine.
+    bool refillMagazine(ObjectPoolMagazine<T>& magazine) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        flushMagazineStatistics(magazine);
+
+        if (_objects.empty()) {
+            _statistics.misses++;
+            return false;
+        }
+
+        _statistics.sharedHits++;
+        auto count = std::max(static_cast<size_t>(1), std::min(_objects.size(), _magazineCapacity / 2));
+        for (size_t i = 0; i < count; i++) {
+            magazine.objects.emplace_back(std::move(_objects.front()));
+            _objects.pop_front();
+        }
+
+        return true;
+    }
+
+    // Gives the oldest half of a full magazine back to the shared pool, so that objects
+    // released on a different thread than the one they were taken from flow back.
+    void rebalanceMagazine(ObjectPoolMagazine<T>& magazine) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        flushMagazineStatistics(magazine);
+        _statistics.rebalances++;
+
+        auto count = magazine.objects.size() / 2;
+        for (size_t i = 0; i < count; i++) {
+            _objects.emplace_back(std::move(magazine.objects[i]));
+        }
+        magazine.objects.erase(magazine.objects.begin(), magazine.objects.begin() + count);
+    }
+
+    void drainMagazine(ObjectPoolMagazine<T>& magazine) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        flushMagazineStatistics(magazine);
+
+        for (auto& object : magazine.objects) {
+            _objects.emplace_back(std::move(object));
+        }
+        magazine.objects.clear();
+    }
 };
 
 template<typename T>
@@ -0,0 +1,351 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace Valdi {
+
+/**
+ A hash map which preserves insertion order, made of a dense array of entries
+ and of an open addressing index table pointing into it.
+ Iteration walks the entries array, so it is as cheap as iterating a vector and
+ yields the keys in the order they were inserted. Small maps don't have an index
+ table at all and are looked up by scanning the entries.
+ Keys are expected to have a cheap hash function, as the hash of an entry is
+ recomputed when the index table grows or when an entry is erased.
+ Erasing an entry is O(n) as the following entries are shifted to keep the order.
+ */
+template<typename Key,
+         typename Value,
+         typename Hash = std::hash<Key>,
+         typename KeyEqual = std::equal_to<Key>,
+         typename Allocator = std::allocator<std::pair<Key, Value>>>
+class OrderedFlatMap {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<Key, Value>;
+    using size_type = size_t;
+    using allocator_type = Allocator;
+    using iterator = typename std::vector<value_type, Allocator>::iterator;
+    using const_iterator = typename std::vector<value_type, Allocator>::const_iterator;
+
+    // Maps up to this size are looked up without an index table
+    static constexpr size_t kMaxLinearScanSize = 8;
+
+    OrderedFlatMap() = default;
+
+    OrderedFlatMap(std::initializer_list<value_type> values) {
+        reserve(values.size());
+        insert(values.begin(), values.end());
+    }
+
+    iterator begin() noexcept {
+        return _entries.begin();
+    }
+
+    iterator end() noexcept {
+        return _entries.end();
+    }
+
+    const_iterator begin() const noexcept {
+        return _entries.begin();
+    }
+
+    const_iterator end() const noexcept {
+        return _entries.end();
+    }
+
+    const_iterator cbegin() const noexcept {
+        return _entries.cbegin();
+    }
+
+    const_iterator cend() const noexcept {
+        return _entries.cend();
+    }
+
+    size_t size() const noexcept {
+        return _entries.size();
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return _entries.get_allocator();
+    }
+
+    bool empty() const noexcept {
+        return _entries.empty();
+    }
+
+    void clear() noexcept {
+        _entries.clear();
+        _indices.clear();
+    }
+
+    void reserve(size_t size) {
+        _entries.reserve(size);
+        if (size > kMaxLinearScanSize && getIndexCapacityForSize(size) > _indices.size()) {
+            rebuildIndices(getIndexCapacityForSize(size));
+        }
+    }
+
+    iterator find(const Key& key) {
+        return _entries.begin() + static_cast<std::ptrdiff_t>(findIndex(key));
+    }
+
+    const_iterator find(const Key& key) const {
+        return _entries.begin() + static_cast<std::ptrdiff_t>(findIndex(key));
+    }
+
+    bool contains(const Key& key) const {
+        return findIndex(key) != _entries.size();
+    }
+
+    size_t count(const Key& key) const {
+        return contains(key) ? 1 : 0;
+    }
+
+    Value& at(const Key& key) {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("OrderedFlatMap::at");
+        }
+        return it->second;
+    }
+
+    const Value& at(const Key& key) const {
+        auto it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("OrderedFlatMap::at");
+        }
+        return it->second;
+    }
+
+    Value& operator[](const Key& key) {
+        return try_emplace(key).first->second;
+    }
+
+    Value& operator[](Key&& key) {
+        return try_emplace(std::move(key)).first->second;
+    }
+
+    template<typename K, typename... Args>
+    std::pair<iterator, bool> try_emplace(K&& key, Args&&... args) {
+        auto index = findIndex(key);
+        if (index != _entries.size()) {
+            return std::make_pair(_entries.begin() + static_cast<std::ptrdiff_t>(index), false);
+        }
+
+        _entries.emplace_back(std::piecewise_construct,
+                              std::forward_as_tuple(std::forward<K>(key)),
+                              std::forward_as_tuple(std::forward<Args>(args)...));
+        onEntryAppended();
+
+        return std::make_pair(_entries.end() - 1, true);
+    }
+
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        value_type value(std::forward<Args>(args)...);
+        return try_emplace(std::move(value.first), std::move(value.second));
+    }
+
+    std::pair<iterator, bool> insert(const value_type& value) {
+        return try_emplace(value.first, value.second);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& value) {
+        return try_emplace(std::move(value.first), std::move(value.second));
+    }
+
+    template<typename InputIt>
+    void insert(InputIt first, InputIt last) {
+        for (; first != last; ++first) {
+            insert(*first);
+        }
+    }
+
+    template<typename V>
+    std::pair<iterator, bool> insert_or_assign(const Key& key, V&& value) {
+        auto it = find(key);
+        if (it != end()) {
+            it->second = std::forward<V>(value);
+            return std::make_pair(it, false);
+        }
+        return try_emplace(key, std::forward<V>(value));
+    }
+
+    /**
+     Erasing is O(n): the following entries are shifted down to keep the insertion order
+     and their positions in the index table are updated. Prefer building a new map over
+     erasing many keys from a large one.
+     */
+    size_t erase(const Key& key) {
+        auto index = findIndex(key);
+        if (index == _entries.size()) {
+            return 0;
+        }
+
+        eraseAt(index);
+        return 1;
+    }
+
+    iterator erase(const_iterator it) {
+        auto index = static_cast<size_t>(it - _entries.cbegin());
+        eraseAt(index);
+        return _entries.begin() + static_cast<std::ptrdiff_t>(index);
+    }
+
+    iterator erase(iterator it) {
+        return erase(const_iterator(it));
+    }
+
+    void swap(OrderedFlatMap& other) noexcept {
+        _entries.swap(other._entries);
+        _indices.swap(other._indices);
+    }
+
+    /**
+     Maps are equal if they contain the same entries, regardless of their order.
+     */
+    bool operator==(const OrderedFlatMap& other) const {
+        if (size() != other.size()) {
+            return false;
+        }
+
+        for (const auto& it : _entries) {
+            auto otherIt = other.find(it.first);
+            if (otherIt == other.end() || !(otherIt->second == it.second)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool operator!=(const OrderedFlatMap& other) const {
+        return !(*this == other);
+    }
+
+private:
+    using IndexType = uint32_t;
+    using IndexAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<IndexType>;
+    static constexpr IndexType kEmptySlot = UINT32_MAX;
+
+    std::vector<value_type, Allocator> _entries;
+    // Empty when the map is small enough to be scanned linearly
+    std::vector<IndexType, IndexAllocator> _indices;
+
+    static size_t getIndexCapacityForSize(size_t size) {
+        // Keep the load factor at or below 50%
+        size_t capacity = 16;
+        while (capacity < size * 2) {
+            capacity *= 2;
+        }
+        return capacity;
+    }
+
+    size_t getSlot(const Key& key) const {
+        return Hash()(key) & (_indices.size() - 1);
+    }
+
+    template<typename K>
+    size_t findIndex(const K& key) const {
+        if (_indices.empty()) {
+            KeyEqual equal;
+            size_t size = _entries.size();
+            for (size_t i = 0; i < size; i++) {
+                if (equal(_entries[i].first, key)) {
+                    return i;
+                }
+            }
+            return size;
+        }
+
+        auto mask = _indices.size() - 1;
+        KeyEqual equal;
+        for (auto slot = getSlot(key);; slot = (slot + 1) & mask) {
+            auto index = _indices[slot];
+            if (index == kEmptySlot) {
+                return _entries.size();
+            }
+            if (equal(_entries[index].first, key)) {
+                return index;
+            }
+        }
+    }
+
+    void insertIndex(IndexType index) {
+        auto mask = _indices.size() - 1;
+        auto slot = getSlot(_entries[index].first);
+        while (_indices[slot] != kEmptySlot) {
+            slot = (slot + 1) & mask;
+        }
+        _indices[slot] = index;
+    }
+
+    void rebuildIndices(size_t capacity) {
+        _indices.assign(capacity, kEmptySlot);
+        auto size = _entries.size();
+        for (size_t i = 0; i < size; i++) {
+            insertIndex(static_cast<IndexType>(i));
+        }
+    }
+
+    void onEntryAppended() {
+        auto size = _entries.size();
+        if (_indices.empty()) {
+            if (size > kMaxLinearScanSize) {
+                rebuildIndices(getIndexCapacityForSize(size));
+            }
+        } else if (size * 2 > _indices.size()) {
+            rebuildIndices(_indices.size() * 2);
+        } else {
+            insertIndex(static_cast<IndexType>(size - 1));
+        }
+    }
+
+    void eraseAt(size_t index) {
+        if (!_indices.empty()) {
+            removeIndex(index);
+            // Entries after the erased one are about to be shifted down by one
+            for (auto& slotIndex : _indices) {
+                if (slotIndex != kEmptySlot && slotIndex > index) {
+                    slotIndex--;
+                }
+            }
+        }
+
+        _entries.erase(_entries.begin() + static_cast<std::ptrdiff_t>(index));
+    }
+
+    void removeIndex(size_t index) {
+        auto mask = _indices.size() - 1;
+        auto slot = getSlot(_entries[index].first);
+        while (_indices[slot] != index) {
+            slot = (slot + 1) & mask;
+        }
+
+        // Backward shift deletion, so that lookups never need tombstones
+        auto hole = slot;
+        for (auto next = (hole + 1) & mask; _indices[next] != kEmptySlot; next = (next + 1) & mask) {
+            auto desiredSlot = getSlot(_entries[_indices[next]].first);
+            // Distance from the desired slot, accounting for wrap around
+            auto distanceFromHole = (hole - desiredSlot) & mask;
+            auto distanceFromNext = (next - desiredSlot) & mask;
+            if (distanceFromHole < distanceFromNext) {
+                _indices[hole] = _indices[next];
+                hole = next;
+            }
+        }
+        _indices[hole] = kEmptySlot;
+    }
+};
+
+} // namespace Valdi
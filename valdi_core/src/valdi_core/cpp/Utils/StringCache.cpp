@@ -57,20 +57,22 @@ StringBox StringCache::makeString(std::string_view strView) noexcept {
     }
 
     auto hash = StringBox::makeHash(strView);
+    auto mixedHash = makePHMapHash(hash);
+    auto& shard = getShard(mixedHash);
 
-    std::lock_guard<Mutex> guard(_mutex);
+    std::lock_guard<Mutex> guard(shard.mutex);
 
-    const auto& it = findEntry(strView, hash);
-    if (it != _table.end()) {
+    const auto& it = findEntry(shard, strView, mixedHash);
+    if (it != shard.table.end()) {
         auto locked = it->impl->lock();
         if (locked != nullptr) {
             return StringBox(Ref<InternedStringImpl>(std::move(locked)));
         } else {
-            _table.erase(it);
+            shard.table.erase(it);
         }
     }
 
-    return insertString(strView, hash);
+    return insertString(shard, strView, hash);
 }
 
 StringBox StringCache::makeStringFromUTF16(const char16_t* utf16String, size_t len) noexcept {
@@ -87,45 +89,59 @@ StringBox StringCache::makeStringFromCLiteral(const char* cStr) noexcept {
     return getGlobal().makeStringFromLiteral(cStr);
 }
 
-StringBox StringCache::insertString(std::string_view str, size_t hash) {
+StringCache::Shard& StringCache::getShard(size_t mixedHash) {
+    // The lowest bits are used by the shard table itself to place the entry,
+    // fold the higher bits like phmap's parallel_flat_hash_set does.
+    auto index = ((mixedHash >> 8) ^ (mixedHash >> 16) ^ (mixedHash >> 24)) % kShardsCount;
+    return _shards[index];
+}
+
+StringBox StringCache::insertString(Shard& shard, std::string_view str, size_t hash) {
     auto internedString = InternedStringImpl::make(str.data(), str.size(), hash);
 
-    _table.emplace(internedString.get());
+    shard.table.emplace(internedString.get());
 
     return StringBox(Ref<InternedStringImpl>(std::move(internedString)));
 }
 
 void StringCache::removeString(const InternedStringImpl* internedString) {
-    std::lock_guard<Mutex> guard(_mutex);
+    auto mixedHash = makePHMapHash(internedString->getHash());
+    auto& shard = getShard(mixedHash);
 
-    const auto& it = _table.find(internedString, makePHMapHash(internedString->getHash()));
-    if (it != _table.end()) {
-        _table.erase(it);
+    std::lock_guard<Mutex> guard(shard.mutex);
+
+    const auto& it = shard.table.find(internedString, mixedHash);
+    if (it != shard.table.end()) {
+        shard.table.erase(it);
     }
 }
 
-std::unique_lock<Mutex> StringCache::lock() {
-    return std::unique_lock<Mutex>(_mutex);
+std::unique_lock<Mutex> StringCache::lock(std::string_view str) {
+    return std::unique_lock<Mutex>(getShard(makePHMapHash(StringBox::makeHash(str))).mutex);
 }
 
 std::vector<StringBox> StringCache::all() const {
     std::vector<StringBox> out;
 
-    std::lock_guard<Mutex> guard(_mutex);
-    out.reserve(_table.size());
+    for (const auto& shard : _shards) {
+        std::lock_guard<Mutex> guard(shard.mutex);
+        out.reserve(out.size() + shard.table.size());
 
-    for (const auto& it : _table) {
-        auto locked = it.impl->lock();
-        if (locked != nullptr) {
-            out.emplace_back(Ref<InternedStringImpl>(std::move(locked)));
+        for (const auto& it : shard.table) {
+            auto locked = it.impl->lock();
+            if (locked != nullptr) {
+                out.emplace_back(Ref<InternedStringImpl>(std::move(locked)));
+            }
         }
     }
 
     return out;
 }
 
-StringCache::StringTable::const_iterator StringCache::findEntry(const std::string_view& str, size_t hash) const {
-    return _table.find(str, makePHMapHash(hash));
+StringCache::StringTable::const_iterator StringCache::findEntry(const Shard& shard,
+                                                                const std::string_view& str,
+                                                                size_t mixedHash) {
+    return shard.table.find(str, mixedHash);
 }
 
 } // namespace Valdi
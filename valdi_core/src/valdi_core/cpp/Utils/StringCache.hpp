@@ -11,6 +11,7 @@
 #include "valdi_core/cpp/Utils/InternedStringImpl.hpp"
 #include "valdi_core/cpp/Utils/Mutex.hpp"
 #include "valdi_core/cpp/Utils/StringBox.hpp"
+#include <array>
 
 #define STRING_LITERAL(str) Valdi::StringCache::makeStringFromCLiteral(str)
 #define STRING_FORMAT(__format, ...) Valdi::StringCache::getGlobal().makeString(fmt::format((__format), __VA_ARGS__))
@@ -88,9 +89,10 @@ public:
     StringBox makeStringFromUTF16(const char16_t* utf16String, size_t len) noexcept;
 
     /**
-     Exposed for tests only, DO NOT USE
+     Exposed for tests only, DO NOT USE.
+     Lock the shard which holds the given string.
      */
-    std::unique_lock<Mutex> lock();
+    std::unique_lock<Mutex> lock(std::string_view str);
 
     /**
      Returns all of the strings inside the StringCache
@@ -102,23 +104,37 @@ public:
     // Shortcut for getGlobal().makeStringFromLiteral()
     static StringBox makeStringFromCLiteral(const char* cStr) noexcept;
 
+    /**
+     Number of independently locked sub tables. Strings are dispatched into
+     shards using their hash, so that threads interning different strings
+     rarely contend on the same lock.
+     */
+    static constexpr size_t kShardsCount = 16;
+
 private:
     using StringTable =
         phmap::flat_hash_set<StringCacheEntry, StringCacheHash, StringCacheEqual, phmap::Allocator<StringCacheEntry>>;
 
-    StringTable _table;
-    mutable Mutex _mutex;
+    // Aligned to avoid false sharing between the locks of adjacent shards
+    struct alignas(64) Shard {
+        StringTable table;
+        mutable Mutex mutex;
+    };
+
+    std::array<Shard, kShardsCount> _shards;
 
     StringCache();
 
-    // Should be called with a lock already acquired
-    StringBox insertString(std::string_view str, size_t hash);
+    Shard& getShard(size_t mixedHash);
+
+    // Should be called with the shard lock already acquired
+    static StringBox insertString(Shard& shard, std::string_view str, size_t hash);
     // Should be called without a lock
     void removeString(const InternedStringImpl* internedString);
 
     friend InternedStringImpl;
 
-    StringTable::const_iterator findEntry(const std::string_view& str, size_t hash) const;
+    static StringTable::const_iterator findEntry(const Shard& shard, const std::string_view& str, size_t mixedHash);
 };
 
 } // namespace Valdi
@@ -6,8 +6,12 @@
 //
 
 #include "valdi_core/cpp/Utils/Trace.hpp"
+#include "valdi_core/cpp/Utils/ByteBuffer.hpp"
+#include "valdi_core/cpp/Utils/JSONWriter.hpp"
 #include "valdi_core/cpp/Utils/StringBox.hpp"
 
+#include <algorithm>
+
 namespace Valdi {
 
 std::string getTraceName(std::string_view prefix, const StringBox& suffix) {
@@ -28,7 +32,16 @@ TraceDuration RecordedTrace::duration() const {
     return TraceDuration(end - start);
 }
 
-ScopedTrace::ScopedTrace(const StringBox& trace) : _trace(trace.toStringView()), _snapTrace(_trace) {
+ScopedTrace::ScopedTrace(const char* trace) : _trace(trace), _snapTrace(_trace) {
+    begin();
+
+    if (Tracer::shared().isRecording()) {
+        _startTime = {std::chrono::steady_clock::now()};
+    }
+}
+
+ScopedTrace::ScopedTrace(const StringBox& trace)
+    : _traceString(trace), _trace(_traceString.getCStr()), _snapTrace(_trace) {
     begin();
 
     if (Tracer::shared().isRecording()) {
@@ -36,7 +49,8 @@ ScopedTrace::ScopedTrace(const StringBox& trace) : _trace(trace.toStringView()),
     }
 }
 
-ScopedTrace::ScopedTrace(std::string&& trace) : _trace(std::move(trace)), _snapTrace(_trace) {
+ScopedTrace::ScopedTrace(std::string&& trace)
+    : _traceStorage(std::move(trace)), _trace(_traceStorage.c_str()), _snapTrace(_trace) {
     begin();
 
     if (Tracer::shared().isRecording()) {
@@ -47,7 +61,7 @@ ScopedTrace::ScopedTrace(std::string&& trace) : _trace(std::move(trace)), _snapT
 ScopedTrace::~ScopedTrace() {
     if (_startTime) {
         auto endTime = std::chrono::steady_clock::now();
-        Tracer::shared().append(std::move(_trace), _startTime.value(), endTime);
+        Tracer::shared().append(_trace, _startTime.value(), endTime);
     }
 
     end();
@@ -67,7 +81,31 @@ void ScopedTrace::end() {
     _osEmitter.end(traceEnd);
 }
 
-Tracer::Tracer() = default;
+// Used to give a unique epoch to each set of thread buffers across all the Tracer instances
+static std::atomic_uint64_t kTraceBuffersEpochCounter = 0;
+
+struct CurrentThreadTraceBuffer {
+    uint64_t epoch = 0;
+    // Weak so that the buffer is freed as soon as the Tracer drops it when the recording ends,
+    // instead of staying alive until the thread exits or traces again.
+    Weak<TraceRingBuffer> buffer;
+};
+
+static thread_local CurrentThreadTraceBuffer currentThreadTraceBuffer;
+
+static int64_t toTraceTicks(const TraceTimePoint& timePoint) {
+    return static_cast<int64_t>(timePoint.time_since_epoch().count());
+}
+
+static TraceTimePoint fromTraceTicks(int64_t ticks) {
+    return TraceTimePoint(TraceTimePoint::duration(ticks));
+}
+
+Tracer::Tracer() : Tracer(kDefaultThreadBufferCapacity) {}
+
+Tracer::Tracer(size_t threadBufferCapacity)
+    : _buffersEpoch(++kTraceBuffersEpochCounter), _threadBufferCapacity(threadBufferCapacity) {}
+
 Tracer::~Tracer() = default;
 
 Tracer& Tracer::shared() {
@@ -75,13 +113,67 @@ Tracer& Tracer::shared() {
     return *kInstance;
 }
 
-void Tracer::append(std::string&& trace, const TraceTimePoint& start, const TraceTimePoint& end) {
+Ref<TraceRingBuffer> Tracer::getCurrentThreadBuffer() {
+    auto& current = currentThreadTraceBuffer;
+    if (current.epoch == _buffersEpoch.load(std::memory_order_acquire)) {
+        auto buffer = strongRef(current.buffer);
+        if (buffer != nullptr) {
+            return buffer;
+        }
+    }
+
     std::lock_guard<std::mutex> lock(_mutex);
-    if (_recorders.empty()) {
+    auto threadId = getCurrentThreadId();
+    auto& buffer = _threadBuffers[threadId];
+    if (buffer == nullptr) {
+        buffer = makeShared<TraceRingBuffer>(threadId, _threadBufferCapacity);
+    }
+
+    current.epoch = _buffersEpoch.load(std::memory_order_relaxed);
+    current.buffer = buffer.toWeak();
+
+    return buffer;
+}
+
+TraceNameId Tracer::getNameId(TraceRingBuffer& buffer, std::string_view name) {
+    auto& nameIdsCache = buffer.getNameIdsCache();
+    const auto& cacheIt = nameIdsCache.find(name);
+    if (cacheIt != nameIdsCache.end()) {
+        return cacheIt->second;
+    }
+
+    TraceNameId nameId;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        const auto& it = _nameIds.find(name);
+        if (it != _nameIds.end()) {
+            nameId = it->second;
+        } else {
+            nameId = static_cast<TraceNameId>(_names.size());
+            _names.emplace_back(name);
+            _nameIds[_names.back()] = nameId;
+        }
+    }
+
+    nameIdsCache[std::string(name)] = nameId;
+    return nameId;
+}
+
+void Tracer::append(std::string_view trace, const TraceTimePoint& start, const TraceTimePoint& end) {
+    if (!isRecording()) {
         return;
     }
 
-    _pendingTraces.emplace_back(std::move(trace), start, end, getCurrentThreadId(), _recordingSequence);
+    auto buffer = getCurrentThreadBuffer();
+
+    TraceEvent event;
+    event.startTicks = toTraceTicks(start);
+    event.endTicks = toTraceTicks(end);
+    event.recordingSequence = _recordingSequence.load(std::memory_order_relaxed);
+    event.nameId = getNameId(*buffer, trace);
+    event.threadId = buffer->getThreadId();
+
+    buffer->push(event);
 }
 
 size_t Tracer::startRecording() {
@@ -94,6 +186,33 @@ size_t Tracer::startRecording() {
     return sequence;
 }
 
+void Tracer::lockFreeCollectEvents() {
+    for (const auto& it : _threadBuffers) {
+        it.second->drain([&](const TraceEvent& event) { _pendingEvents.emplace_back(event); });
+    }
+}
+
+void Tracer::lockFreeResetBuffers() {
+    for (const auto& it : _threadBuffers) {
+        _droppedTraces += it.second->getDroppedEventsCount();
+    }
+
+    // Threads will lazily allocate a new buffer on their next trace
+    _buffersEpoch = ++kTraceBuffersEpochCounter;
+    _threadBuffers.clear();
+    _names.clear();
+    _nameIds.clear();
+    _pendingEvents.clear();
+}
+
+RecordedTrace Tracer::lockFreeMakeRecordedTrace(const TraceEvent& event) const {
+    return RecordedTrace(std::string(_names[event.nameId]),
+                         fromTraceTicks(event.startTicks),
+                         fromTraceTicks(event.endTicks),
+                         event.threadId,
+                         event.recordingSequence);
+}
+
 std::vector<RecordedTrace> Tracer::stopRecording(size_t recordingIdentifier) {
     std::lock_guard<std::mutex> lock(_mutex);
 
@@ -104,20 +223,29 @@ std::vector<RecordedTrace> Tracer::stopRecording(size_t recordingIdentifier) {
 
     _recorders.erase(it);
 
+    lockFreeCollectEvents();
+
+    std::vector<RecordedTrace> outTraces;
+
     // Simple case, we only have one recorder we can return all the recorded traces
     if (_recorders.empty()) {
         _recording = false;
-        return std::move(_pendingTraces);
+
+        outTraces.reserve(_pendingEvents.size());
+        for (const auto& event : _pendingEvents) {
+            outTraces.emplace_back(lockFreeMakeRecordedTrace(event));
+        }
+
+        lockFreeResetBuffers();
+        return outTraces;
     }
 
     // We still have one active recorder. We collect the traces that ocurreded with or after
     // this identifier
 
-    std::vector<RecordedTrace> outTraces;
-
-    for (const auto& trace : _pendingTraces) {
-        if (trace.recordingSequence >= recordingIdentifier) {
-            outTraces.emplace_back(trace);
+    for (const auto& event : _pendingEvents) {
+        if (event.recordingSequence >= recordingIdentifier) {
+            outTraces.emplace_back(lockFreeMakeRecordedTrace(event));
         }
     }
 
@@ -126,14 +254,76 @@ std::vector<RecordedTrace> Tracer::stopRecording(size_t recordingIdentifier) {
         // If the next lowest recording identifier is above the ending identifier,
         // we might have dangling traces to remove.
         // Remove all the traces that occured before the new lowest recording identifier.
-        auto newStartIt = _pendingTraces.begin();
-        while (newStartIt != _pendingTraces.end() && newStartIt->recordingSequence < lowestRecordingIdentifier) {
-            newStartIt++;
-        }
-        _pendingTraces.erase(_pendingTraces.begin(), newStartIt);
+        _pendingEvents.erase(std::remove_if(_pendingEvents.begin(),
+                                            _pendingEvents.end(),
+                                            [&](const TraceEvent& event) {
+                                                return event.recordingSequence < lowestRecordingIdentifier;
+                                            }),
+                             _pendingEvents.end());
     }
 
     return outTraces;
 }
 
+size_t Tracer::getDroppedTracesCount() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto droppedTraces = _droppedTraces;
+    for (const auto& it : _threadBuffers) {
+        droppedTraces += it.second->getDroppedEventsCount();
+    }
+    return droppedTraces;
+}
+
+void writeChromeTraceJSON(const std::vector<RecordedTrace>& traces, ByteBuffer& output) {
+    JSONWriter writer(output);
+
+    writer.writeBeginObject();
+    writer.writeProperty("traceEvents");
+    writer.writeBeginArray();
+
+    auto first = true;
+    for (const auto& trace : traces) {
+        if (first) {
+            first = false;
+        } else {
+            writer.writeComma();
+        }
+        writer.writeNewLine();
+
+        // Complete events, with timestamps and durations in microseconds
+        auto startMicros = std::chrono::duration<double, std::micro>(trace.start.time_since_epoch()).count();
+        auto durationMicros = std::chrono::duration<double, std::micro>(trace.end - trace.start).count();
+
+        writer.writeBeginObject();
+        writer.writeProperty("name");
+        writer.writeString(trace.trace);
+        writer.writeComma();
+        writer.writeProperty("cat");
+        writer.writeString("valdi");
+        writer.writeComma();
+        writer.writeProperty("ph");
+        writer.writeString("X");
+        writer.writeComma();
+        writer.writeProperty("ts");
+        writer.writeDouble(startMicros);
+        writer.writeComma();
+        writer.writeProperty("dur");
+        writer.writeDouble(durationMicros);
+        writer.writeComma();
+        writer.writeProperty("pid");
+        writer.writeInt(static_cast<int32_t>(0));
+        writer.writeComma();
+        writer.writeProperty("tid");
+        writer.writeInt(static_cast<int64_t>(trace.threadId));
+        writer.writeEndObject();
+    }
+
+    writer.writeNewLine();
+    writer.writeEndArray();
+    writer.writeComma();
+    writer.writeProperty("displayTimeUnit");
+    writer.writeString("ms");
+    writer.writeEndObject();
+}
+
 } // namespace Valdi
@@ -12,6 +12,8 @@
 #include "valdi_core/cpp/Threading/ThreadBase.hpp"
 #include "valdi_core/cpp/Utils/Defer.hpp"
 #include "valdi_core/cpp/Utils/Format.hpp"
+#include "valdi_core/cpp/Utils/StringBox.hpp"
+#include "valdi_core/cpp/Utils/TraceRingBuffer.hpp"
 
 #include <atomic>
 #include <mutex>
@@ -21,7 +23,7 @@
 
 namespace Valdi {
 
-class StringBox;
+class ByteBuffer;
 
 std::string getTraceName(std::string_view prefix, std::string_view suffix);
 std::string getTraceName(std::string_view prefix, const StringBox& suffix);
@@ -46,38 +48,79 @@ struct RecordedTrace {
     TraceDuration duration() const;
 };
 
+/**
+ Write the given traces as a Chrome trace event JSON document, which can be opened
+ in Perfetto or chrome://tracing.
+ */
+void writeChromeTraceJSON(const std::vector<RecordedTrace>& traces, ByteBuffer& output);
+
+/**
+ Records the traces emitted while at least one recording is active.
+ Each thread appends fixed size events into its own lock-free ring buffer,
+ the buffers are only collected when a recording is stopped.
+ */
 class Tracer {
 public:
+    static constexpr size_t kDefaultThreadBufferCapacity = 4096;
+
     Tracer();
+    explicit Tracer(size_t threadBufferCapacity);
     ~Tracer();
 
     inline bool isRecording() const {
-        return _recording;
+        return _recording.load(std::memory_order_relaxed);
     }
 
     size_t startRecording();
     std::vector<RecordedTrace> stopRecording(size_t recordingIdentifier);
 
-    void append(std::string&& trace, const TraceTimePoint& start, const TraceTimePoint& end);
+    void append(std::string_view trace, const TraceTimePoint& start, const TraceTimePoint& end);
+
+    /**
+     Returns how many traces were dropped because a thread buffer was full
+     since the first active recording started.
+     */
+    size_t getDroppedTracesCount() const;
 
     static Tracer& shared();
 
 private:
-    std::mutex _mutex;
+    mutable std::mutex _mutex;
     std::atomic_bool _recording = false;
-    size_t _recordingSequence = 0;
-    std::vector<RecordedTrace> _pendingTraces;
+    std::atomic_size_t _recordingSequence = 0;
+    // Changes every time the thread buffers are reset, so that threads
+    // can detect that their cached buffer is no longer in use.
+    std::atomic_uint64_t _buffersEpoch;
+    size_t _threadBufferCapacity;
+    size_t _droppedTraces = 0;
+    FlatMap<ThreadId, Ref<TraceRingBuffer>> _threadBuffers;
+    std::vector<std::string> _names;
+    FlatMap<std::string, TraceNameId> _nameIds;
+    std::vector<TraceEvent> _pendingEvents;
     std::vector<size_t> _recorders;
+
+    Ref<TraceRingBuffer> getCurrentThreadBuffer();
+    TraceNameId getNameId(TraceRingBuffer& buffer, std::string_view name);
+    void lockFreeCollectEvents();
+    void lockFreeResetBuffers();
+    RecordedTrace lockFreeMakeRecordedTrace(const TraceEvent& event) const;
 };
 
 class ScopedTrace {
 public:
+    /**
+     The given name must outlive the trace, which is the case for string literals.
+     */
+    explicit ScopedTrace(const char* trace);
     explicit ScopedTrace(const StringBox& trace);
     explicit ScopedTrace(std::string&& trace);
     ~ScopedTrace();
 
 protected:
-    std::string _trace;
+    // Only one of them holds the name, when it was not given as a literal
+    StringBox _traceString;
+    std::string _traceStorage;
+    const char* _trace;
     std::optional<TraceTimePoint> _startTime;
     snap::utils::debugging::ScopedTrace _snapTrace;
     snap::profiling::OsTraceEmitter _osEmitter;
@@ -0,0 +1,117 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "valdi_core/cpp/Threading/ThreadBase.hpp"
+#include "valdi_core/cpp/Utils/FlatMap.hpp"
+#include "valdi_core/cpp/Utils/Shared.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace Valdi {
+
+using TraceNameId = uint32_t;
+
+/**
+ A fixed size trace event, as stored in a TraceRingBuffer.
+ Ticks are steady_clock ticks, the name is resolved through the Tracer which recorded it.
+ */
+struct TraceEvent {
+    int64_t startTicks;
+    int64_t endTicks;
+    size_t recordingSequence;
+    TraceNameId nameId;
+    ThreadId threadId;
+};
+
+/**
+ A bounded single-producer single-consumer ring buffer of trace events.
+ The producer is the thread which owns the buffer, the consumer is the Tracer
+ when it collects the events. Events pushed while the buffer is full are dropped.
+ The Tracer owns the buffers, producer threads only keep a weak reference to theirs.
+ */
+class TraceRingBuffer : public SharedPtrRefCountable {
+public:
+    TraceRingBuffer(ThreadId threadId, size_t capacity)
+        : _threadId(threadId),
+          _mask(roundUpToPowerOfTwo(capacity) - 1),
+          _events(std::make_unique<TraceEvent[]>(_mask + 1)) {}
+
+    ThreadId getThreadId() const {
+        return _threadId;
+    }
+
+    size_t getCapacity() const {
+        return _mask + 1;
+    }
+
+    /**
+     Push an event into the buffer, returns false if the buffer was full.
+     Must only be called from the producer thread.
+     */
+    bool push(const TraceEvent& event) {
+        auto writeIndex = _writeIndex.load(std::memory_order_relaxed);
+        if (writeIndex - _readIndex.load(std::memory_order_acquire) > _mask) {
+            _droppedEvents.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        _events[writeIndex & _mask] = event;
+        _writeIndex.store(writeIndex + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     Call the given callback with all the events currently in the buffer, in the order they were
+     pushed, and remove them. Must only be called from a single consumer at a time.
+     */
+    template<typename F>
+    void drain(F&& callback) {
+        auto readIndex = _readIndex.load(std::memory_order_relaxed);
+        auto writeIndex = _writeIndex.load(std::memory_order_acquire);
+
+        while (readIndex != writeIndex) {
+            callback(_events[readIndex & _mask]);
+            readIndex++;
+        }
+
+        _readIndex.store(readIndex, std::memory_order_release);
+    }
+
+    size_t getDroppedEventsCount() const {
+        return _droppedEvents.load(std::memory_order_relaxed);
+    }
+
+    /**
+     Cache of the name ids resolved by the producer thread, so that the Tracer
+     only needs to be consulted the first time a name is seen on this thread.
+     Must only be used from the producer thread.
+     */
+    FlatMap<std::string, TraceNameId>& getNameIdsCache() {
+        return _nameIdsCache;
+    }
+
+private:
+    ThreadId _threadId;
+    size_t _mask;
+    std::unique_ptr<TraceEvent[]> _events;
+    FlatMap<std::string, TraceNameId> _nameIdsCache;
+    std::atomic_size_t _droppedEvents = 0;
+    // Kept on separate cache lines to avoid false sharing between the producer and the consumer
+    alignas(64) std::atomic_size_t _writeIndex = 0;
+    alignas(64) std::atomic_size_t _readIndex = 0;
+
+    static size_t roundUpToPowerOfTwo(size_t value) {
+        size_t out = 1;
+        while (out < value) {
+            out <<= 1;
+        }
+        return out;
+    }
+};
+
+} // namespace Valdi
@@ -8,6 +8,7 @@
 
 #include "valdi_core/cpp/Utils/Value.hpp"
 
+#include "valdi_core/cpp/Constants.hpp"
 #include "valdi_core/cpp/Utils/Format.hpp"
 #include "valdi_core/cpp/Utils/StaticString.hpp"
 #include "valdi_core/cpp/Utils/StringCache.hpp"
@@ -19,6 +20,7 @@
 #include "valdi_core/cpp/Utils/ValueTypedObject.hpp"
 #include "valdi_core/cpp/Utils/ValueTypedProxyObject.hpp"
 #include <cstdlib>
+#include <cstring>
 #include <fmt/format.h>
 #include <iostream>
 #include <sstream>
@@ -96,6 +98,152 @@ std::string valueTypeToString(ValueType weakValueType) {
  Constructors
  */
 
+#if VALDI_NAN_BOXED_VALUE
+
+namespace {
+
+/**
+ Holds the long values which don't fit in the 47 bits payload of a boxed Value.
+ */
+class HeapLong : public SimpleRefCountable {
+public:
+    explicit HeapLong(int64_t value) : value(value) {}
+
+    const int64_t value;
+};
+
+constexpr int64_t kMinInlineLong = -(static_cast<int64_t>(1) << 46);
+constexpr int64_t kMaxInlineLong = (static_cast<int64_t>(1) << 46) - 1;
+
+} // namespace
+
+NaNBoxedPointerTag NaNBoxedPointerTag::_global;
+
+uint64_t NaNBoxedPointerTag::untag(uint64_t pointerBits) noexcept {
+    auto tagBits = pointerBits & ~kAddressMask;
+    if (tagBits != 0) {
+        uint64_t expectedTagBits = 0;
+        if (!_tagBits.compare_exchange_strong(expectedTagBits, tagBits, std::memory_order_relaxed)) {
+            SC_ASSERT(expectedTagBits == tagBits, "NaN-boxed Value only supports a single pointer tag");
+        }
+    }
+
+    return pointerBits & kAddressMask;
+}
+
+uint64_t Value::makePointerPayload(const RefCountable* pointer) noexcept {
+    auto addressBits =
+        NaNBoxedPointerTag::getGlobal().untag(static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pointer)));
+    SC_ASSERT((addressBits & ~kPayloadMask) == 0, "Pointer does not fit in a NaN-boxed Value");
+    return addressBits;
+}
+
+Value::Value() noexcept = default;
+
+Value::Value(const Undefined& /*undefined*/) noexcept : _bits(makeBoxedBits(ValueType::Undefined, 0)) {}
+
+Value::Value(const Void& /*v*/) noexcept : _bits(makeBoxedBits(ValueType::Undefined, 0)) {}
+
+Value::~Value() noexcept {
+    if (isSharedStorage()) {
+        unsafeRelease(getStoragePointer());
+    }
+}
+
+Value::Value(int32_t anInt) noexcept
+    : _bits(makeBoxedBits(ValueType::Int, static_cast<uint64_t>(static_cast<uint32_t>(anInt)))) {}
+
+Value::Value(int64_t aLong) noexcept {
+    if (aLong >= kMinInlineLong && aLong <= kMaxInlineLong) {
+        _bits = makeBoxedBits(ValueType::Long, static_cast<uint64_t>(aLong));
+    } else {
+        auto* heapLong = new HeapLong(aLong);
+        unsafeRetain(heapLong);
+        _bits = makeBoxedBits(kHeapLongTag, makePointerPayload(heapLong));
+    }
+}
+
+Value::Value(double aDouble) noexcept {
+    if (VALDI_UNLIKELY(aDouble != aDouble)) {
+        _bits = kCanonicalNaN;
+    } else {
+        std::memcpy(&_bits, &aDouble, sizeof(double));
+    }
+}
+
+Value::Value(bool aBool) noexcept : _bits(makeBoxedBits(ValueType::Bool, aBool ? 1 : 0)) {}
+
+Value::Value(RefCountable* refCountable, ValueType valueType) noexcept {
+    if (refCountable != nullptr) {
+        _bits = makeBoxedBits(valueType, makePointerPayload(refCountable));
+
+        unsafeRetain(refCountable);
+    }
+}
+
+Value::Value(const Value& other) noexcept : _bits(other._bits) {
+    if (isSharedStorage()) {
+        unsafeRetain(getStoragePointer());
+    }
+}
+
+Value::Value(Value&& other) noexcept : _bits(other._bits) {
+    other._bits = makeBoxedBits(ValueType::Null, 0);
+}
+
+Value& Value::operator=(Value&& other) noexcept {
+    if (this != &other) {
+        if (isSharedStorage()) {
+            unsafeRelease(getStoragePointer());
+        }
+
+        _bits = other._bits;
+        other._bits = makeBoxedBits(ValueType::Null, 0);
+    }
+
+    return *this;
+}
+
+Value& Value::operator=(const Value& other) noexcept {
+    if (this != &other) {
+        if (isSharedStorage()) {
+            unsafeRelease(getStoragePointer());
+        }
+
+        _bits = other._bits;
+
+        if (isSharedStorage()) {
+            unsafeRetain(getStoragePointer());
+        }
+    }
+
+    return *this;
+}
+
+int32_t Value::getStorageInt() const noexcept {
+    return static_cast<int32_t>(static_cast<uint32_t>(getPayload()));
+}
+
+int64_t Value::getStorageLong() const noexcept {
+    if (getBoxedTag() == kHeapLongTag) {
+        return static_cast<const HeapLong*>(getStoragePointer())->value;
+    }
+    // Sign extend the 47 bits payload
+    return static_cast<int64_t>(getPayload() << 17) >> 17;
+}
+
+double Value::getStorageDouble() const noexcept {
+    double out;
+    std::memcpy(&out, &_bits, sizeof(double));
+    return out;
+}
+
+bool Value::getStorageBool() const noexcept {
+    return getPayload() != 0;
+}
+
+#else
+
 Value::Value() noexcept {
     _data.l = 0;
 }
@@ -132,43 +280,6 @@ Value::Value(bool aBool) noexcept : _type(ValueType::Bool) {
     _data.b = aBool ? true : false;
 }
 
-Value::Value(std::string_view aString) noexcept
-    : Value(StringCache::getGlobal().makeString(aString).getInternedString()) {}
-
-Value::Value(const StringBox& aString) noexcept : Value(aString.getInternedString()) {}
-
-Value::Value(const Error& anError) noexcept : Value(anError.getStorage().get(), ValueType::Error) {}
-
-Value::Value(const char* aString) noexcept
-    : Value(StringCache::getGlobal().makeStringFromLiteral(aString).getInternedString()) {}
-
-Value::Value(const Ref<ValueFunction>& aFunction) noexcept : Value(aFunction.get(), ValueType::Function) {}
-
-Value::Value(const Value& other) noexcept : _data(other._data), _type(other._type), _isShared(other._isShared) {
-    if (_isShared) {
-        unsafeRetain(_data.p);
-    }
-}
-
-Value::Value(const Ref<InternedStringImpl>& aString) noexcept : Value(aString.get(), ValueType::InternedString) {
-    _type = ValueType::InternedString;
-}
-
-Value::Value(const Ref<ValueMap>& aMap) noexcept : Value(aMap.get(), ValueType::Map) {}
-
-Value::Value(const Ref<ValueTypedObject>& aTypedObject) noexcept : Value(aTypedObject.get(), ValueType::TypedObject) {}
-
-Value::Value(const Ref<ValueTypedProxyObject>& aProxyObject) noexcept
-    : Value(aProxyObject.get(), ValueType::ProxyTypedObject) {}
-
-Value::Value(const Ref<ValdiObject>& aValdiObject) noexcept : Value(aValdiObject.get(), ValueType::ValdiObject) {}
-
-Value::Value(const Ref<ValueArray>& anArray) noexcept : Value(anArray.get(), ValueType::Array) {}
-
-Value::Value(const Ref<ValueTypedArray>& aTypedArray) noexcept : Value(aTypedArray.get(), ValueType::TypedArray) {}
-
-Value::Value(const Ref<StaticString>& aStaticString) noexcept : Value(aStaticString.get(), ValueType::StaticString) {}
-
 Value::Value(RefCountable* refCountable, ValueType valueType) noexcept {
     if (refCountable != nullptr) {
         _data.p = refCountable;
@@ -181,21 +292,18 @@ Value::Value(RefCountable* refCountable, ValueType valueType) noexcept {
     }
 }
 
+Value::Value(const Value& other) noexcept : _data(other._data), _type(other._type), _isShared(other._isShared) {
+    if (_isShared) {
+        unsafeRetain(_data.p);
+    }
+}
+
 Value::Value(Value&& other) noexcept : _data(other._data), _type(other._type), _isShared(other._isShared) {
     other._data.l = 0;
     other._type = ValueType::Null;
     other._isShared = false;
 }
 
-const Value& Value::undefinedRef() noexcept {
-    static auto undefined = Value::undefined();
-    return undefined;
-}
-
-/**
- Operator overloads
- */
-
 Value& Value::operator=(Value&& other) noexcept {
     if (this != &other) {
         if (_isShared) {
@@ -232,12 +340,68 @@ Value& Value::operator=(const Value& other) noexcept {
     return *this;
 }
 
+int32_t Value::getStorageInt() const noexcept {
+    return _data.i;
+}
+
+int64_t Value::getStorageLong() const noexcept {
+    return _data.l;
+}
+
+double Value::getStorageDouble() const noexcept {
+    return _data.d;
+}
+
+bool Value::getStorageBool() const noexcept {
+    return _data.b;
+}
+
+#endif
+
+Value::Value(std::string_view aString) noexcept
+    : Value(StringCache::getGlobal().makeString(aString).getInternedString()) {}
+
+Value::Value(const StringBox& aString) noexcept : Value(aString.getInternedString()) {}
+
+Value::Value(const Error& anError) noexcept : Value(anError.getStorage().get(), ValueType::Error) {}
+
+Value::Value(const char* aString) noexcept
+    : Value(StringCache::getGlobal().makeStringFromLiteral(aString).getInternedString()) {}
+
+Value::Value(const Ref<ValueFunction>& aFunction) noexcept : Value(aFunction.get(), ValueType::Function) {}
+
+Value::Value(const Ref<InternedStringImpl>& aString) noexcept : Value(aString.get(), ValueType::InternedString) {}
+
+Value::Value(const Ref<ValueMap>& aMap) noexcept : Value(aMap.get(), ValueType::Map) {}
+
+Value::Value(const Ref<ValueTypedObject>& aTypedObject) noexcept : Value(aTypedObject.get(), ValueType::TypedObject) {}
+
+Value::Value(const Ref<ValueTypedProxyObject>& aProxyObject) noexcept
+    : Value(aProxyObject.get(), ValueType::ProxyTypedObject) {}
+
+Value::Value(const Ref<ValdiObject>& aValdiObject) noexcept : Value(aValdiObject.get(), ValueType::ValdiObject) {}
+
+Value::Value(const Ref<ValueArray>& anArray) noexcept : Value(anArray.get(), ValueType::Array) {}
+
+Value::Value(const Ref<ValueTypedArray>& aTypedArray) noexcept : Value(aTypedArray.get(), ValueType::TypedArray) {}
+
+Value::Value(const Ref<StaticString>& aStaticString) noexcept : Value(aStaticString.get(), ValueType::StaticString) {}
+
+const Value& Value::undefinedRef() noexcept {
+    static auto undefined = Value::undefined();
+    return undefined;
+}
+
+/**
+ Operator overloads
+ */
+
 bool Value::operator==(const Value& other) const noexcept {
     if (this == &other) {
         return true;
     }
 
-    if (_type != other._type) {
+    if (getType() != other.getType()) {
         if (isNumber() && other.isNumber()) {
             // Automatically converts for number representable objects
             return toDouble() == other.toDouble();
@@ -256,13 +420,13 @@ bool Value::operator==(const Value& other) const noexcept {
         case ValueType::StaticString:
             return *getStaticString() == *other.getStaticString();
         case ValueType::Int:
-            return _data.i == other._data.i;
+            return getStorageInt() == other.getStorageInt();
         case ValueType::Long:
-            return _data.l == other._data.l;
+            return getStorageLong() == other.getStorageLong();
         case ValueType::Double:
-            return _data.d == other._data.d;
+            return getStorageDouble() == other.getStorageDouble();
         case ValueType::Bool:
-            return _data.b == other._data.b;
+            return getStorageBool() == other.getStorageBool();
         case ValueType::Map:
             return *getMap() == *other.getMap();
         case ValueType::Array:
@@ -288,7 +452,7 @@ bool Value::operator!=(const Value& other) const noexcept {
 
 bool Value::operator<(const Value& other) const noexcept {
     // TODO(simon): Implementation is incomplete
-    switch (_type) {
+    switch (getType()) {
         case ValueType::Null:
             return !other.isNull();
         case ValueType::Undefined:
@@ -498,7 +662,7 @@ std::vector<StringBox> Value::sortedMapKeys() const {
 bool Value::toBool() const noexcept {
     switch (getType()) {
         case ValueType::Bool:
-            return _data.b;
+            return getStorageBool();
         case ValueType::Int:
             return toInt() != 0;
         case ValueType::Double:
@@ -587,22 +751,8 @@ std::string Value::toString(bool indent) const {
                 out.append("{ ");
             }
 
-            const auto* map = getMap();
-
-            std::vector<std::pair<StringBox, Value>> values;
-            values.reserve(map->size());
-
-            for (const auto& it : *map) {
-                auto insertionIt =
-                    std::upper_bound(values.begin(), values.end(), it, [=](const auto& left, const auto& right) {
-                        return left.first.toStringView() < right.first.toStringView();
-                    });
-
-                values.emplace(insertionIt, it);
-            }
-
             auto hasAppended = false;
-            for (const auto& it : values) {
+            for (const auto& it : *getMap()) {
                 if (hasAppended) {
                     if (indent) {
                         out.append(",\n");
@@ -680,7 +830,7 @@ std::string Value::toString(bool indent) const {
 double Value::toDouble() const noexcept {
     switch (getType()) {
         case ValueType::Double:
-            return _data.d;
+            return getStorageDouble();
         case ValueType::InternedString:
         case ValueType::StaticString:
             return atof(toStringBox().getCStr()); // NOLINT(cert-err34-c)
@@ -696,16 +846,16 @@ float Value::toFloat() const noexcept {
 int32_t Value::toInt() const noexcept {
     switch (getType()) {
         case ValueType::Int:
-            return _data.i;
+            return getStorageInt();
         case ValueType::Double:
             return static_cast<int32_t>(toDouble());
         case ValueType::Long:
-            return static_cast<int32_t>(_data.l);
+            return static_cast<int32_t>(getStorageLong());
         case ValueType::InternedString:
         case ValueType::StaticString:
             return atoi(toStringBox().getCStr()); // NOLINT(cert-err34-c)
         case ValueType::Bool:
-            return static_cast<int32_t>(_data.i);
+            return static_cast<int32_t>(getStorageBool());
         default:
             return 0;
     }
@@ -714,36 +864,36 @@ int32_t Value::toInt() const noexcept {
 int64_t Value::toLong() const noexcept {
     switch (getType()) {
         case ValueType::Long:
-            return _data.l;
+            return getStorageLong();
         case ValueType::Int:
-            return static_cast<int64_t>(_data.i);
+            return static_cast<int64_t>(getStorageInt());
         case ValueType::Double:
             return static_cast<int64_t>(toDouble());
         case ValueType::InternedString:
         case ValueType::StaticString:
             return atoll(toStringBox().getCStr()); // NOLINT(cert-err34-c)
         case ValueType::Bool:
-            return static_cast<int64_t>(_data.b);
+            return static_cast<int64_t>(getStorageBool());
         default:
             return 0;
     }
 }
 
 ValueType Value::getType() const noexcept {
-    return _type;
+    return getStorageType();
 }
 
 bool Value::isNumber() const noexcept {
-    return _type == ValueType::Int || _type == ValueType::Double || _type == ValueType::Long ||
-           _type == ValueType::Bool;
+    auto type = getType();
+    return type == ValueType::Int || type == ValueType::Double || type == ValueType::Long || type == ValueType::Bool;
 }
 
 bool Value::isNull() const noexcept {
-    return _type == ValueType::Null;
+    return getType() == ValueType::Null;
 }
 
 bool Value::isUndefined() const noexcept {
-    return _type == ValueType::Undefined;
+    return getType() == ValueType::Undefined;
 }
 
 bool Value::isNullOrUndefined() const noexcept {
@@ -751,19 +901,19 @@ bool Value::isNullOrUndefined() const noexcept {
 }
 
 bool Value::isBool() const noexcept {
-    return _type == ValueType::Bool;
+    return getType() == ValueType::Bool;
 }
 
 bool Value::isDouble() const noexcept {
-    return _type == ValueType::Double;
+    return getType() == ValueType::Double;
 }
 
 bool Value::isInt() const noexcept {
-    return _type == ValueType::Int;
+    return getType() == ValueType::Int;
 }
 
 bool Value::isLong() const noexcept {
-    return _type == ValueType::Long;
+    return getType() == ValueType::Long;
 }
 
 bool Value::isString() const noexcept {
@@ -771,47 +921,47 @@ bool Value::isString() const noexcept {
 }
 
 bool Value::isInternedString() const noexcept {
-    return _type == ValueType::InternedString;
+    return getType() == ValueType::InternedString;
 }
 
 bool Value::isStaticString() const noexcept {
-    return _type == ValueType::StaticString;
+    return getType() == ValueType::StaticString;
 }
 
 bool Value::isMap() const noexcept {
-    return _type == ValueType::Map;
+    return getType() == ValueType::Map;
 }
 
 bool Value::isArray() const noexcept {
-    return _type == ValueType::Array;
+    return getType() == ValueType::Array;
 }
 
 bool Value::isError() const noexcept {
-    return _type == ValueType::Error;
+    return getType() == ValueType::Error;
 }
 
 bool Value::isTypedArray() const noexcept {
-    return _type == ValueType::TypedArray;
+    return getType() == ValueType::TypedArray;
 }
 
 bool Value::isFunction() const noexcept {
-    return _type == ValueType::Function;
+    return getType() == ValueType::Function;
 }
 
 bool Value::isTypedObject() const noexcept {
-    return _type == ValueType::TypedObject;
+    return getType() == ValueType::TypedObject;
 }
 
 bool Value::isProxyObject() const noexcept {
-    return _type == ValueType::ProxyTypedObject;
+    return getType() == ValueType::ProxyTypedObject;
 }
 
 bool Value::isValdiObject() const noexcept {
-    return _type == ValueType::ValdiObject;
+    return getType() == ValueType::ValdiObject;
 }
 
 size_t Value::hash() const {
-    switch (_type) {
+    switch (getType()) {
         case ValueType::Null:
         case ValueType::Undefined:
             return 0;
@@ -828,11 +978,15 @@ size_t Value::hash() const {
         case ValueType::Bool:
             return static_cast<size_t>(toBool());
         case ValueType::Map: {
+            // Maps compare equal regardless of their insertion order, so the entries
+            // need to be combined in an order independent way.
             std::size_t hash = 0;
 
             for (const auto& it : *getMap()) {
-                boost::hash_combine(hash, it.first.hash());
-                boost::hash_combine(hash, it.second.hash());
+                std::size_t entryHash = 0;
+                boost::hash_combine(entryHash, it.first.hash());
+                boost::hash_combine(entryHash, it.second.hash());
+                hash += entryHash;
             }
             return hash;
         }
@@ -12,13 +12,56 @@
 #include "valdi_core/cpp/Utils/InternedStringImpl.hpp"
 #include "valdi_core/cpp/Utils/Shared.hpp"
 #include "valdi_core/cpp/Utils/StringBox.hpp"
+#include <atomic>
 #include <cstdint>
 #include <ostream>
 #include <string>
 #include <vector>
 
+#ifndef VALDI_NAN_BOXED_VALUE
+#define VALDI_NAN_BOXED_VALUE 0
+#endif
+
+#if VALDI_NAN_BOXED_VALUE && defined(__ARM_FEATURE_MEMORY_TAGGING)
+#error "The NaN-boxed Value layout cannot hold pointers with per allocation memory tags"
+#endif
+
 namespace Valdi {
 
+#if VALDI_NAN_BOXED_VALUE
+/**
+ Removes and restores the tag that heap pointers carry in their top byte on platforms
+ with Top Byte Ignore, like Android arm64. A NaN-boxed Value only has room for the
+ address, so the tag is stripped when boxing and put back when unboxing.
+ All the tagged pointers of a process are expected to share one tag, which is the case
+ of Android's heap pointer tagging. Untagged pointers get the tag too once it is known,
+ which is harmless as the hardware ignores the top byte.
+ */
+class NaNBoxedPointerTag {
+public:
+    static constexpr uint64_t kTagShift = 56;
+    static constexpr uint64_t kAddressMask = (static_cast<uint64_t>(1) << kTagShift) - 1;
+
+    /**
+     Returns the address bits of the given pointer, recording its tag if it has one.
+     */
+    uint64_t untag(uint64_t pointerBits) noexcept;
+
+    /**
+     Returns the given address bits with the recorded tag, if any.
+     */
+    inline uint64_t retag(uint64_t addressBits) const noexcept {
+        return addressBits == 0 ? 0 : addressBits | _tagBits.load(std::memory_order_relaxed);
+    }
+
+    static NaNBoxedPointerTag& getGlobal() noexcept;
+
+private:
+    std::atomic<uint64_t> _tagBits = 0;
+    static NaNBoxedPointerTag _global;
+};
+#endif
+
 class Value;
 class ValueTypedArray;
 class ValueFunction;
@@ -155,20 +198,22 @@ public:
 
     template<typename T>
     Ref<T> getTypedRef() const noexcept {
-        if (!_isShared) {
+        auto* object = getObjectPointer();
+        if (object == nullptr) {
             return nullptr;
         }
 
-        return strongSmallRef(dynamic_cast<T*>(_data.p));
+        return strongSmallRef(dynamic_cast<T*>(object));
     }
 
     template<typename T>
     Ref<T> getUnsafeTypedRefPointer() const noexcept {
-        if (!_isShared) {
+        auto* object = getObjectPointer();
+        if (object == nullptr) {
             return nullptr;
         }
 
-        return Ref<T>(static_cast<T*>(_data.p));
+        return Ref<T>(static_cast<T*>(object));
     }
 
     /**
@@ -311,6 +356,76 @@ public:
     static Error invalidTypeError(ValueType expectedType, ValueType actualType);
 
 private:
+#if VALDI_NAN_BOXED_VALUE
+    /**
+     NaN-boxed layout, enabled with the //bzl/runtime_flags:enable_nan_boxed_value flag.
+     Doubles are stored as is, with NaNs canonicalized to a single positive quiet NaN.
+     Every other type is stored inside a negative quiet NaN, which occupies bits 51-63. The
+     ValueType is stored in bits 47-50 and the int, bool, long or pointer in the lower 47 bits.
+     Long values which don't fit in 47 bits are stored in a heap allocated box using the Double
+     tag, which is otherwise never boxed. Pointers must fit in 47 bits once their top byte tag,
+     if any, is removed by NaNBoxedPointerTag.
+     */
+    static constexpr uint64_t kBoxedMask = 0xFFF8000000000000ULL;
+    static constexpr uint64_t kTagMask = 0x0007800000000000ULL;
+    static constexpr uint64_t kPayloadMask = 0x00007FFFFFFFFFFFULL;
+    static constexpr uint64_t kTagShift = 47;
+    static_assert((kBoxedMask & kTagMask) == 0, "The ValueType tag must not overlap the boxed prefix");
+    static_assert((kTagMask & kPayloadMask) == 0, "The ValueType tag must not overlap the payload");
+    static_assert((kTagMask >> kTagShift) >= static_cast<uint64_t>(ValueType::ValdiObject),
+                  "All ValueType values must fit in the tag bits");
+    static constexpr uint64_t kCanonicalNaN = 0x7FF8000000000000ULL;
+    static constexpr ValueType kHeapLongTag = ValueType::Double;
+    static constexpr uint32_t kSharedTagsMask =
+        (1u << static_cast<uint32_t>(ValueType::InternedString)) |
+        (1u << static_cast<uint32_t>(ValueType::StaticString)) | (1u << static_cast<uint32_t>(kHeapLongTag)) |
+        (1u << static_cast<uint32_t>(ValueType::Map)) | (1u << static_cast<uint32_t>(ValueType::Array)) |
+        (1u << static_cast<uint32_t>(ValueType::TypedArray)) | (1u << static_cast<uint32_t>(ValueType::Function)) |
+        (1u << static_cast<uint32_t>(ValueType::Error)) | (1u << static_cast<uint32_t>(ValueType::TypedObject)) |
+        (1u << static_cast<uint32_t>(ValueType::ProxyTypedObject)) |
+        (1u << static_cast<uint32_t>(ValueType::ValdiObject));
+
+    static constexpr uint64_t makeBoxedBits(ValueType tag, uint64_t payload) noexcept {
+        return kBoxedMask | (static_cast<uint64_t>(tag) << kTagShift) | (payload & kPayloadMask);
+    }
+
+    uint64_t _bits = makeBoxedBits(ValueType::Null, 0);
+
+    inline bool isBoxed() const noexcept {
+        return (_bits & kBoxedMask) == kBoxedMask;
+    }
+
+    inline ValueType getBoxedTag() const noexcept {
+        return static_cast<ValueType>((_bits & kTagMask) >> kTagShift);
+    }
+
+    inline uint64_t getPayload() const noexcept {
+        return _bits & kPayloadMask;
+    }
+
+    inline bool isSharedStorage() const noexcept {
+        return isBoxed() && ((kSharedTagsMask >> static_cast<uint32_t>(getBoxedTag())) & 1u) != 0;
+    }
+
+    inline RefCountable* getStoragePointer() const noexcept {
+        return reinterpret_cast<RefCountable*>(
+            static_cast<uintptr_t>(NaNBoxedPointerTag::getGlobal().retag(getPayload())));
+    }
+
+    static uint64_t makePointerPayload(const RefCountable* pointer) noexcept;
+
+    inline ValueType getStorageType() const noexcept {
+        if (!isBoxed()) {
+            return ValueType::Double;
+        }
+        auto tag = getBoxedTag();
+        return tag == kHeapLongTag ? ValueType::Long : tag;
+    }
+
+    inline RefCountable* getObjectPointer() const noexcept {
+        return isSharedStorage() && getBoxedTag() != kHeapLongTag ? getStoragePointer() : nullptr;
+    }
+#else
     union {
         bool b;
         float f;
@@ -322,16 +437,46 @@ private:
     ValueType _type = ValueType::Null;
     bool _isShared = false;
 
+    inline bool isSharedStorage() const noexcept {
+        return _isShared;
+    }
+
+    inline RefCountable* getStoragePointer() const noexcept {
+        return _data.p;
+    }
+
+    inline ValueType getStorageType() const noexcept {
+        return _type;
+    }
+
+    inline RefCountable* getObjectPointer() const noexcept {
+        return _isShared ? _data.p : nullptr;
+    }
+#endif
+
     Value(RefCountable* refCountable, ValueType type) noexcept;
 
+    int32_t getStorageInt() const noexcept;
+    int64_t getStorageLong() const noexcept;
+    double getStorageDouble() const noexcept;
+    bool getStorageBool() const noexcept;
+
     template<class T>
     T* toPointer() const noexcept {
-        return static_cast<T*>(_data.p);
+        return static_cast<T*>(getStoragePointer());
     }
 
     static void onTypedValdiObjectError(const Ref<ValdiObject>& valdiObject, ExceptionTracker& exceptionTracker);
 };
 
+#if VALDI_NAN_BOXED_VALUE
+static_assert(sizeof(Value) == sizeof(uint64_t), "NaN-boxed Value should fit in 8 bytes");
+
+inline NaNBoxedPointerTag& NaNBoxedPointerTag::getGlobal() noexcept {
+    return _global;
+}
+#endif
+
 std::ostream& operator<<(std::ostream& os, const Value& value);
 std::ostream& operator<<(std::ostream& os, const ValueType& valueType);
 
@@ -0,0 +1,282 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#include "valdi_core/cpp/Utils/ValueArena.hpp"
+#include "valdi_core/cpp/Utils/InlineContainerAllocator.hpp"
+#include "valdi_core/cpp/Utils/Value.hpp"
+#include "valdi_core/cpp/Utils/ValueArray.hpp"
+#include "valdi_core/cpp/Utils/ValueMap.hpp"
+#include "valdi_core/cpp/Utils/ValueTypedObject.hpp"
+
+#include <atomic>
+#include <new>
+#include <optional>
+#include <vector>
+
+namespace Valdi {
+
+// Every allocation is prefixed with a pointer to the chunk it was allocated from,
+// or nullptr if it was allocated from the heap.
+static constexpr size_t kHeaderSize = sizeof(ValueArenaChunk*);
+static constexpr size_t kAlignment = alignof(ValueArenaChunk*);
+
+struct ValueArenaChunk {
+    // One retain for the arena while the chunk is used by a pass, plus one per live allocation.
+    std::atomic_size_t retainCount;
+    size_t capacity;
+    size_t offset = 0;
+    // Set by the arena before it gives up its retain, when allocations outlived the pass
+    bool pinned = false;
+
+    explicit ValueArenaChunk(size_t capacity) : retainCount(1), capacity(capacity) {}
+
+    uint8_t* data() {
+        return reinterpret_cast<uint8_t*>(this) + alignUp(sizeof(ValueArenaChunk), kAlignment);
+    }
+};
+
+static thread_local ValueArena* currentArena = nullptr;
+static std::atomic_size_t pinnedChunksCount = 0;
+static std::atomic_size_t pinnedBytes = 0;
+
+static ValueArenaChunk* allocateChunk(size_t capacity) {
+    auto* region = ::operator new(alignUp(sizeof(ValueArenaChunk), kAlignment) + capacity);
+    return new (region) ValueArenaChunk(capacity);
+}
+
+static void releaseChunk(ValueArenaChunk* chunk) {
+    if (chunk != nullptr && chunk->retainCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        if (chunk->pinned) {
+            pinnedChunksCount.fetch_sub(1, std::memory_order_relaxed);
+            pinnedBytes.fetch_sub(chunk->capacity, std::memory_order_relaxed);
+        }
+        chunk->~ValueArenaChunk();
+        ::operator delete(chunk);
+    }
+}
+
+ValueArena::ValueArena(size_t chunkSize) : _chunkSize(chunkSize) {}
+
+ValueArena::~ValueArena() {
+    for (auto* chunk : _retiredChunks) {
+        releaseChunk(chunk);
+    }
+    releaseChunk(_chunk);
+}
+
+void ValueArena::releaseAfterPass(ValueArenaChunk* chunk) {
+    if (chunk->retainCount.load(std::memory_order_acquire) > 1) {
+        // Values allocated from the chunk escaped the pass and now keep the whole chunk alive
+        chunk->pinned = true;
+        pinnedChunksCount.fetch_add(1, std::memory_order_relaxed);
+        pinnedBytes.fetch_add(chunk->capacity, std::memory_order_relaxed);
+        _escapedChunksCount++;
+    }
+
+    releaseChunk(chunk);
+}
+
+void ValueArena::reset() {
+    for (auto* chunk : _retiredChunks) {
+        releaseAfterPass(chunk);
+    }
+    _retiredChunks.clear();
+
+    if (_chunk == nullptr) {
+        return;
+    }
+
+    // Only the owning thread can add allocations to the chunk, so if we are
+    // the only one retaining it, nothing allocated from it is alive anymore.
+    if (_chunk->retainCount.load(std::memory_order_acquire) == 1) {
+        _chunk->offset = 0;
+    } else {
+        releaseAfterPass(_chunk);
+        _chunk = nullptr;
+    }
+}
+
+size_t ValueArena::getChunksAllocatedCount() const {
+    return _chunksAllocatedCount;
+}
+
+size_t ValueArena::getBytesAllocated() const {
+    return _bytesAllocated;
+}
+
+size_t ValueArena::getEscapedChunksCount() const {
+    return _escapedChunksCount;
+}
+
+void* ValueArena::doAllocate(size_t size) {
+    auto allocSize = alignUp(kHeaderSize + size, kAlignment);
+    // Big containers would waste most of a chunk, they are better off in the heap
+    if (allocSize > _chunkSize / 4) {
+        return nullptr;
+    }
+
+    if (_chunk == nullptr || _chunk->offset + allocSize > _chunk->capacity) {
+        if (_chunk != nullptr) {
+            // Values of the current pass might still use it, which is only known once the pass ends
+            _retiredChunks.emplace_back(_chunk);
+        }
+        _chunk = allocateChunk(_chunkSize);
+        _chunksAllocatedCount++;
+    }
+
+    auto* header = reinterpret_cast<ValueArenaChunk**>(_chunk->data() + _chunk->offset);
+    *header = _chunk;
+    _chunk->offset += allocSize;
+    _chunk->retainCount.fetch_add(1, std::memory_order_relaxed);
+    _bytesAllocated += allocSize;
+
+    return header + 1;
+}
+
+void* ValueArena::allocate(size_t size) {
+    auto* arena = currentArena;
+    if (arena != nullptr) {
+        auto* ptr = arena->doAllocate(size);
+        if (ptr != nullptr) {
+            return ptr;
+        }
+    }
+
+    return allocateFromHeap(size);
+}
+
+void* ValueArena::allocateFromHeap(size_t size) {
+    auto* header = static_cast<ValueArenaChunk**>(::operator new(kHeaderSize + size));
+    *header = nullptr;
+    return header + 1;
+}
+
+void ValueArena::deallocate(void* ptr) noexcept {
+    if (ptr == nullptr) {
+        return;
+    }
+
+    auto* header = static_cast<ValueArenaChunk**>(ptr) - 1;
+    auto* chunk = *header;
+    if (chunk == nullptr) {
+        ::operator delete(header);
+    } else {
+        releaseChunk(chunk);
+    }
+}
+
+bool ValueArena::isArenaAllocated(const void* ptr) {
+    return ptr != nullptr && *(static_cast<ValueArenaChunk* const*>(ptr) - 1) != nullptr;
+}
+
+static std::optional<Value> copyContainerToHeap(const Value& value);
+
+static bool copyItemsToHeap(const Value* begin, const Value* end, std::vector<std::optional<Value>>& output) {
+    auto hasCopy = false;
+    for (const auto* it = begin; it != end; it++) {
+        auto& copy = output.emplace_back(copyContainerToHeap(*it));
+        hasCopy |= copy.has_value();
+    }
+    return hasCopy;
+}
+
+// Returns a heap copy of the given value, or std::nullopt if it doesn't hold anything arena allocated
+static std::optional<Value> copyContainerToHeap(const Value& value) {
+    switch (value.getType()) {
+        case ValueType::Array: {
+            const auto* array = value.getArray();
+            std::vector<std::optional<Value>> items;
+            items.reserve(array->size());
+            if (!copyItemsToHeap(array->begin(), array->end(), items) && !ValueArena::isArenaAllocated(array)) {
+                return std::nullopt;
+            }
+
+            auto copy = ValueArray::make(array->size());
+            for (size_t i = 0; i < items.size(); i++) {
+                copy->emplace(i, items[i] ? std::move(*items[i]) : (*array)[i]);
+            }
+            return Value(copy);
+        }
+        case ValueType::Map: {
+            const auto* map = value.getMap();
+            auto hasCopy = ValueArena::isArenaAllocated(map);
+            std::vector<std::optional<Value>> items;
+            items.reserve(map->size());
+            for (const auto& it : *map) {
+                auto& copy = items.emplace_back(copyContainerToHeap(it.second));
+                hasCopy |= copy.has_value();
+            }
+            if (!hasCopy) {
+                return std::nullopt;
+            }
+
+            auto copy = makeShared<ValueMap>();
+            copy->reserve(map->size());
+            size_t i = 0;
+            for (const auto& it : *map) {
+                (*copy)[it.first] = items[i] ? std::move(*items[i]) : it.second;
+                i++;
+            }
+            return Value(copy);
+        }
+        case ValueType::TypedObject: {
+            const auto* typedObject = value.getTypedObject();
+            const auto* properties = typedObject->getProperties();
+            std::vector<std::optional<Value>> items;
+            items.reserve(typedObject->getPropertiesSize());
+            if (!copyItemsToHeap(properties, properties + typedObject->getPropertiesSize(), items) &&
+                !ValueArena::isArenaAllocated(typedObject)) {
+                return std::nullopt;
+            }
+
+            auto copy = ValueTypedObject::make(typedObject->getSchema());
+            for (size_t i = 0; i < items.size(); i++) {
+                copy->setProperty(i, items[i] ? std::move(*items[i]) : properties[i]);
+            }
+            return Value(copy);
+        }
+        default:
+            return std::nullopt;
+    }
+}
+
+Value ValueArena::copyToHeap(const Value& value) {
+    // Make sure the copies are not served from the arena again
+    auto* previousArena = currentArena;
+    currentArena = nullptr;
+    auto copy = copyContainerToHeap(value);
+    currentArena = previousArena;
+
+    return copy ? std::move(*copy) : value;
+}
+
+size_t ValueArena::getPinnedChunksCount() {
+    return pinnedChunksCount.load(std::memory_order_relaxed);
+}
+
+size_t ValueArena::getPinnedBytes() {
+    return pinnedBytes.load(std::memory_order_relaxed);
+}
+
+ValueArena* ValueArena::current() {
+    return currentArena;
+}
+
+ValueArena& ValueArena::getThreadLocal() {
+    static thread_local ValueArena threadArena;
+    return threadArena;
+}
+
+ValueArenaScope::ValueArenaScope() : ValueArenaScope(ValueArena::getThreadLocal()) {}
+
+ValueArenaScope::ValueArenaScope(ValueArena& arena) : _arena(&arena), _previousArena(currentArena) {
+    currentArena = _arena;
+}
+
+ValueArenaScope::~ValueArenaScope() {
+    currentArena = _previousArena;
+    if (_previousArena != _arena) {
+        _arena->reset();
+    }
+}
+
+} // namespace Valdi
@@ -0,0 +1,197 @@
+// Copyright © 2024 Snap, Inc. All rights reserved.
+
+#pragma once
+
+#include "utils/base/NonCopyable.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Valdi {
+
+struct ValueArenaChunk;
+class Value;
+
+/**
+ A bump allocator used for the short lived ValueArray, ValueMap and ValueTypedObject
+ instances, and for the entries of the ValueMap, created while converting render
+ requests and callback arguments.
+ Allocations are served from the arena which is current for the calling thread,
+ as set by a ValueArenaScope, and from the heap otherwise.
+
+ Values allocated from an arena can safely escape it: each allocation retains
+ the chunk it was carved from, so a chunk is only given back to the heap once the
+ arena moved on and every value allocated from it was destroyed. Deallocation
+ can happen from any thread. As a single escaped value keeps its whole chunk
+ alive, values which are stored beyond the pass that created them should be
+ moved out of the arena with copyToHeap(). Chunks which are kept alive by escaped
+ values once their pass ended are counted as pinned, see getPinnedChunksCount().
+ */
+class ValueArena : public snap::NonCopyable {
+public:
+    static constexpr size_t kDefaultChunkSize = 16 * 1024;
+
+    explicit ValueArena(size_t chunkSize = kDefaultChunkSize);
+    ~ValueArena();
+
+    /**
+     Rewind the arena. The current chunk is reused if no value allocated
+     from it is still alive, otherwise it is left to the escaped values.
+     */
+    void reset();
+
+    /**
+     Returns the number of chunks that this arena had to allocate so far.
+     */
+    size_t getChunksAllocatedCount() const;
+
+    /**
+     Returns the number of bytes that were served from this arena so far.
+     */
+    size_t getBytesAllocated() const;
+
+    /**
+     Returns the number of chunks that this arena had to leave to values which
+     escaped the pass that allocated them.
+     */
+    size_t getEscapedChunksCount() const;
+
+    /**
+     Allocate memory for a container, from the current arena if there is one,
+     from the heap otherwise. The returned memory is aligned for pointers and
+     must be freed with deallocate().
+     */
+    static void* allocate(size_t size);
+
+    /**
+     Allocate memory from the heap, ignoring the current arena. The returned memory
+     must be freed with deallocate().
+     */
+    static void* allocateFromHeap(size_t size);
+
+    /**
+     Free memory returned by allocate().
+     */
+    static void deallocate(void* ptr) noexcept;
+
+    /**
+     Returns whether the given pointer, as returned by allocate(), was served from an arena.
+     */
+    static bool isArenaAllocated(const void* ptr);
+
+    /**
+     Returns the given value where every ValueArray, ValueMap and ValueTypedObject
+     which was served from an arena, including nested ones, is copied into the heap.
+     Returns the value as is when it doesn't hold any arena allocated container.
+     */
+    static Value copyToHeap(const Value& value);
+
+    /**
+     Returns the number of chunks, across all threads, which are currently kept
+     alive only by values that escaped the pass which allocated them.
+     */
+    static size_t getPinnedChunksCount();
+
+    /**
+     Returns the total capacity in bytes of the pinned chunks.
+     */
+    static size_t getPinnedBytes();
+
+    /**
+     Returns the arena which is current for the calling thread, or nullptr.
+     */
+    static ValueArena* current();
+
+    /**
+     Returns the arena owned by the calling thread, creating it if needed.
+     */
+    static ValueArena& getThreadLocal();
+
+private:
+    size_t _chunkSize;
+    ValueArenaChunk* _chunk = nullptr;
+    // Full chunks of the current pass, released on reset()
+    std::vector<ValueArenaChunk*> _retiredChunks;
+    size_t _chunksAllocatedCount = 0;
+    size_t _bytesAllocated = 0;
+    size_t _escapedChunksCount = 0;
+
+    void releaseAfterPass(ValueArenaChunk* chunk);
+
+    void* doAllocate(size_t size);
+
+    friend class ValueArenaScope;
+};
+
+/**
+ Makes the given arena current for the calling thread until the scope is destroyed.
+ The arena is reset when the outermost scope using it ends, which typically
+ corresponds to the end of a render pass or of a JS entry.
+ */
+class ValueArenaScope : public snap::NonCopyable {
+public:
+    /**
+     Use the arena owned by the calling thread.
+     */
+    ValueArenaScope();
+    explicit ValueArenaScope(ValueArena& arena);
+    ~ValueArenaScope();
+
+private:
+    ValueArena* _arena;
+    ValueArena* _previousArena;
+};
+
+/**
+ A standard allocator serving memory through the ValueArena, used for the storage of ValueMap.
+ Whether the arena is used is decided when the allocator is created: containers created
+ while an arena is current allocate from it, others always allocate from the heap. This
+ keeps long lived containers which are mutated during a pass out of the arena.
+ */
+template<typename T>
+class ValueArenaAllocator {
+public:
+    using value_type = T;
+
+    static_assert(alignof(T) <= alignof(void*), "ValueArena only guarantees pointer alignment");
+
+    ValueArenaAllocator() noexcept : _useArena(ValueArena::current() != nullptr) {}
+
+    template<typename U>
+    // NOLINTNEXTLINE(google-explicit-constructor)
+    ValueArenaAllocator(const ValueArenaAllocator<U>& other) noexcept : _useArena(other.usesArena()) {}
+
+    T* allocate(size_t n) {
+        auto size = n * sizeof(T);
+        return static_cast<T*>(_useArena ? ValueArena::allocate(size) : ValueArena::allocateFromHeap(size));
+    }
+
+    void deallocate(T* ptr, size_t /*n*/) noexcept {
+        ValueArena::deallocate(ptr);
+    }
+
+    ValueArenaAllocator select_on_container_copy_construction() const noexcept {
+        // Copies follow the arena of the scope they are made in, not the one of their source
+        return ValueArenaAllocator();
+    }
+
+    bool usesArena() const noexcept {
+        return _useArena;
+    }
+
+    // Any ValueArenaAllocator can free memory allocated by another one
+    template<typename U>
+    bool operator==(const ValueArenaAllocator<U>& /*other*/) const noexcept {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const ValueArenaAllocator<U>& /*other*/) const noexcept {
+        return false;
+    }
+
+private:
+    bool _useArena;
+};
+
+} // namespace Valdi
@@ -7,6 +7,7 @@
 
 #include "valdi_core/cpp/Utils/ValueArray.hpp"
 #include "valdi_core/cpp/Utils/InlineContainerAllocator.hpp"
+#include "valdi_core/cpp/Utils/ValueArena.hpp"
 
 #include <algorithm>
 
@@ -129,6 +130,11 @@ Ref<ValueArray> ValueArray::make(const Value* begin, const Value* end) {
 
 Ref<ValueArray> ValueArray::make(size_t size) {
     InlineContainerAllocator<ValueArray, Value> allocator;
-    return allocator.allocate(size, size);
+    auto* region = ValueArena::allocate(allocator.getAllocationSize(size));
+    return Ref<ValueArray>(allocator.constructUnmanaged(region, size), AdoptRef());
+}
+
+void ValueArray::operator delete(void* ptr) {
+    ValueArena::deallocate(ptr);
 }
 } // namespace Valdi
@@ -52,6 +52,8 @@ public:
 
     static Ref<ValueArray> make(size_t size);
 
+    static void operator delete(void* ptr);
+
     static Ref<ValueArray> make(const Value* begin, const Value* end);
 
     static Ref<ValueArray> make(std::initializer_list<Value> values) {
@@ -6,9 +6,20 @@
 //
 
 #include "valdi_core/cpp/Utils/ValueMap.hpp"
+#include "valdi_core/cpp/Utils/ValueArena.hpp"
 
 namespace Valdi {
 
+static_assert(alignof(ValueMap) <= alignof(void*), "ValueArena only guarantees pointer alignment");
+
 ValueMap::~ValueMap() = default;
 
+void* ValueMap::operator new(size_t size) {
+    return ValueArena::allocate(size);
+}
+
+void ValueMap::operator delete(void* ptr) {
+    ValueArena::deallocate(ptr);
 }
+
+} // namespace Valdi
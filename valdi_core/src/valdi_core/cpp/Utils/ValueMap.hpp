@@ -8,14 +8,29 @@
 #pragma once
 
 #include "valdi_core/cpp/Utils/FlatMap.hpp"
+#include "valdi_core/cpp/Utils/OrderedFlatMap.hpp"
 #include "valdi_core/cpp/Utils/Shared.hpp"
 #include "valdi_core/cpp/Utils/Value.hpp"
+#include "valdi_core/cpp/Utils/ValueArena.hpp"
 
 namespace Valdi {
 
-class ValueMap : public SimpleRefCountable, public FlatMap<StringBox, Value> {
+/**
+ Iterates in insertion order, which matches the key order of the JS objects
+ the maps are converted from. Maps created while a ValueArena is current
+ allocate both themselves and their entries from it.
+ */
+class ValueMap : public SimpleRefCountable,
+                 public OrderedFlatMap<StringBox,
+                                       Value,
+                                       std::hash<StringBox>,
+                                       std::equal_to<StringBox>,
+                                       ValueArenaAllocator<std::pair<StringBox, Value>>> {
 public:
     ~ValueMap() override;
+
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr);
 };
 
 } // namespace Valdi
@@ -8,6 +8,7 @@
 #include "valdi_core/cpp/Utils/ValueTypedObject.hpp"
 #include "valdi_core/cpp/Schema/ValueSchema.hpp"
 #include "valdi_core/cpp/Utils/InlineContainerAllocator.hpp"
+#include "valdi_core/cpp/Utils/ValueArena.hpp"
 #include "valdi_core/cpp/Utils/ValueMap.hpp"
 #include <boost/functional/hash.hpp>
 
@@ -154,7 +155,12 @@ Ref<ValueMap> ValueTypedObject::toValueMap(bool ignoreUndefinedValues) const {
 
 Ref<ValueTypedObject> ValueTypedObject::make(const Ref<ClassSchema>& classSchema) {
     InlineContainerAllocator<ValueTypedObject, Value> allocator;
-    return allocator.allocate(classSchema->getPropertiesSize(), classSchema);
+    auto* region = ValueArena::allocate(allocator.getAllocationSize(classSchema->getPropertiesSize()));
+    return Ref<ValueTypedObject>(allocator.constructUnmanaged(region, classSchema), AdoptRef());
+}
+
+void ValueTypedObject::operator delete(void* ptr) {
+    ValueArena::deallocate(ptr);
 }
 
 } // namespace Valdi
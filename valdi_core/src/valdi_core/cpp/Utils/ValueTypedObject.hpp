@@ -70,6 +70,8 @@ public:
     bool operator!=(const ValueTypedObject& other) const;
 
     static Ref<ValueTypedObject> make(const Ref<ClassSchema>& classSchema);
+
+    static void operator delete(void* ptr);
     static Ref<ValueTypedObject> make(const Ref<ClassSchema>& classSchema, std::initializer_list<Value> properties) {
         auto typedObject = make(classSchema);
 
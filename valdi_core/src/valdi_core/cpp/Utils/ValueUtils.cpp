@@ -49,12 +49,10 @@ Ref<ByteBuffer> serializeValue(const Value& value) {
 
     const auto* map = value.getMap();
     if (map != nullptr) {
-        auto keys = value.sortedMapKeys();
+        for (const auto& it : *map) {
+            auto value = it.second.toStringBox();
 
-        for (const auto& key : keys) {
-            auto value = map->find(key)->second.toStringBox();
-
-            auto keyStrView = key.toStringView();
+            auto keyStrView = it.first.toStringView();
             auto valueStrView = value.toStringView();
 
             out->append(keyStrView.begin(), keyStrView.end());